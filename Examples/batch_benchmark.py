@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Range evaluation: row-at-a-time interpreter vs. the columnar batch engine (and NumExpr,
+when installed) on the range scenarios of Examples/benchmark.py.
+
+The batch engine runs each instruction over a block of inputs, so the per-point cost no
+longer includes instruction dispatch. Block sizes of 256 and 1024 lanes are compared.
+NumExpr is timed both the way benchmark.py calls it (once per point) and on the whole
+array at once, which is its best case.
+"""
+import timeit
+
+import numpy as np
+from solver import Solver
+
+try:
+    import numexpr as ne
+except ImportError:
+    ne = None
+
+TRIALS = 200
+
+
+def setup_solver(engine, lanes=None):
+    solver = Solver()
+    solver.use_cache(False)
+    solver.set_engine(engine)
+    if lanes:
+        solver.set_batch_size(lanes)
+    solver.declare_constant("pi", np.pi)
+    solver.declare_variable("y", 100)
+    solver.declare_function("f", ["x"], "x^2 + (2*x + 1)")
+    solver.declare_function("g", ["x", "y"], "x * y + x + y")
+    solver.declare_function("h", ["x"], "f(g(x, x))")
+    return solver
+
+
+def per_point_ns(fn, points, trials=TRIALS):
+    fn()
+    return timeit.timeit(fn, number=trials) / (trials * points) * 1e9
+
+
+def main():
+    scenarios = [
+        ("f(x)", "f(x)", "x**2 + 2*x + 1"),
+        ("h(x)", "h(x)", "(x * x + x + x)**2 + 2*(x * x + x + x) + 1"),
+        ("trig", "sin(x) * cos(x / 3) + exp(-x / 50)", "sin(x) * cos(x / 3) + exp(-x / 50)"),
+    ]
+    configurations = [
+        ("interpreter", setup_solver("interpreter")),
+        ("batch/256", setup_solver("batch", 256)),
+        ("batch/1024", setup_solver("batch", 1024)),
+    ]
+
+    for points in (1000, 100000):
+        values = list(np.linspace(1, 100, points))
+        array = np.asarray(values)
+        trials = TRIALS if points <= 1000 else 10
+
+        print(f"\n{points} points, ns per point")
+        header = "".join(f"{name:>14}" for name, _ in configurations)
+        if ne:
+            header += f"{'numexpr/pt':>14}{'numexpr/arr':>14}"
+        print(f"{'expression':<10}{header}")
+
+        for name, expression, numexpr_expression in scenarios:
+            expected = configurations[0][1].evaluate_range("x", values, expression)
+            row = ""
+            for _, solver in configurations:
+                assert solver.evaluate_range("x", values, expression) == expected
+                row += f"{per_point_ns(lambda: solver.evaluate_range('x', values, expression), points, trials):>14.1f}"
+            if ne:
+                per_call = min(points, 1000)
+                row += f"{per_point_ns(lambda: [ne.evaluate(numexpr_expression, local_dict={'x': v}) for v in values[:per_call]], per_call, 3):>14.1f}"
+                row += f"{per_point_ns(lambda: ne.evaluate(numexpr_expression, local_dict={'x': array}), points, trials):>14.1f}"
+            print(f"{name:<10}{row}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""
+Per-call latency of Solver.evaluate() on an already-parsed expression.
+
+Repeated evaluations of the current expression bind variables through slots resolved at
+compile time, so the cost of a call should not depend on how many variables are declared,
+and should only grow with the amount of arithmetic in the expression. The first table
+varies the number of declared variables; the second varies the expression size. Latencies
+are reported both raw and relative to evaluating a bare variable, which measures the fixed
+cost of the call itself (Python binding overhead included).
+"""
+import timeit
+
+from solver import Solver
+
+NUM_CALLS = 200000
+
+
+def per_call_ns(solver, expression, number=NUM_CALLS):
+    solver.evaluate(expression)  # parse and compile outside the timed region
+    seconds = timeit.timeit(lambda: solver.evaluate(expression), number=number)
+    return seconds / number * 1e9
+
+
+def make_solver(declared_variables):
+    solver = Solver()
+    solver.use_cache(False)  # measure evaluation, not the result cache
+    solver.declare_variable("x", 1.5)
+    solver.declare_variable("y", 2.5)
+    for i in range(declared_variables):
+        solver.declare_variable(f"v{i}", float(i))
+    return solver
+
+
+def polynomial(terms):
+    # x + x*y + x*y*x + ... with `terms` products
+    parts = []
+    for i in range(terms):
+        factors = ["x" if j % 2 == 0 else "y" for j in range(i + 1)]
+        parts.append("*".join(factors))
+    return " + ".join(parts)
+
+
+def main():
+    expression = "x * y + sin(x) - y / 3"
+
+    print("Latency vs. number of declared variables")
+    print(f"{'declared':>10} {'ns/call':>10} {'over bare call':>16}")
+    for declared in (0, 10, 100, 1000, 10000):
+        solver = make_solver(declared)
+        bare = per_call_ns(solver, "x")
+        cost = per_call_ns(solver, expression)
+        print(f"{declared:>10} {cost:>10.1f} {cost - bare:>16.1f}")
+
+    print()
+    print("Latency vs. expression size")
+    print(f"{'terms':>10} {'operators':>10} {'ns/call':>10} {'over bare call':>16}")
+    solver = make_solver(0)
+    bare = per_call_ns(solver, "x")
+    for terms in (1, 4, 16, 64):
+        expr = polynomial(terms)
+        operators = expr.count("*") + expr.count("+")
+        cost = per_call_ns(solver, expr, number=NUM_CALLS // max(1, terms // 4))
+        print(f"{terms:>10} {operators:>10} {cost:>10.1f} {cost - bare:>16.1f}")
+
+
+if __name__ == "__main__":
+    main()
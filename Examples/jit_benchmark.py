@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Bytecode interpreter vs. the native engines (x86-64 JIT and emitted C) on the expressions
+of Examples/benchmark.py.
+
+Each expression is compiled once outside the timed region, then evaluated repeatedly
+with the result cache disabled, so the numbers measure execution of the compiled
+program (plus the fixed cost of the Python call). The range benchmark evaluates f(x)
+over the same 1000 points as benchmark.py, which amortizes the call overhead and shows
+the per-point cost of each engine.
+"""
+import timeit
+
+import numpy as np
+from solver import Solver
+
+NUM_TRIALS = 100000
+RANGE_TRIALS = 200
+
+
+def setup_solver(engine):
+    solver = Solver()
+    solver.use_cache(False)
+    solver.set_engine(engine)
+    solver.declare_constant("pi", np.pi)
+    solver.declare_variable("x", 10)
+    solver.declare_variable("y", 100)
+    solver.declare_function("f", ["x"], "x^2 + (2*x + 1)")
+    solver.declare_function("g", ["x", "y"], "x * y + x + y")
+    solver.declare_function("h", ["x"], "f(g(x, x))")
+    return solver
+
+
+def time_scalar(solver, expression):
+    solver.evaluate(expression)  # compile outside the timed region
+    seconds = timeit.timeit(lambda: solver.evaluate(expression), number=NUM_TRIALS)
+    return seconds / NUM_TRIALS * 1e9
+
+
+def time_range(solver, variable, values, expression):
+    solver.evaluate_range(variable, values, expression)
+    seconds = timeit.timeit(lambda: solver.evaluate_range(variable, values, expression), number=RANGE_TRIALS)
+    return seconds / (RANGE_TRIALS * len(values)) * 1e9
+
+
+ENGINES = ["interpreter", "jit", "c"]
+
+
+def main():
+    solvers = {engine: setup_solver(engine) for engine in ENGINES}
+    interpreter = solvers["interpreter"]
+
+    scalar = [
+        ("Simple addition (2 + 2)", "2 + 2"),
+        ("Quadratic function f(10)", "f(10)"),
+        ("Function g(5, 5)", "g(5, 5)"),
+        ("Nested function h(2)", "h(2)"),
+        ("Trigonometric mix", "sin(x) * cos(y) + exp(x / y)"),
+    ]
+
+    header = "".join(f"{engine + ' ns':>16}" for engine in ENGINES)
+    print(f"{'benchmark':<40}{header}")
+    for description, expression in scalar:
+        expected = interpreter.evaluate(expression)
+        row = ""
+        for engine, solver in solvers.items():
+            assert solver.evaluate(expression) == expected
+            row += f"{time_scalar(solver, expression):>16.1f}"
+        print(f"{description + ' (per call)':<40}{row}")
+
+    values = list(np.linspace(1, 100, 1000))
+    for description, expression in [("f(x) over range", "f(x)"), ("h(x) over range", "h(x)")]:
+        expected = interpreter.evaluate_range("x", values, expression)
+        row = ""
+        for engine, solver in solvers.items():
+            assert solver.evaluate_range("x", values, expression) == expected
+            row += f"{time_range(solver, 'x', values, expression):>16.1f}"
+        print(f"{description + ' (per point)':<40}{row}")
+
+
+if __name__ == "__main__":
+    main()
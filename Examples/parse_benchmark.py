@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""
+Front-end throughput on long generated expressions, in tokens per second.
+
+Each expression is new to the solver, so nothing is served from the program cache. Two
+paths are timed: declaring a function (tokenize, shunting-yard, build the expression
+graph) and compiling an expression (the same, plus simplification and bytecode
+generation). Expressions mix names, literals with fractions, unary minus, calls and
+parentheses, so every branch of the lexer is exercised.
+"""
+import random
+import re
+import time
+
+from solver import Solver
+
+SIZES = (100, 1_000, 10_000, 50_000)
+TOKEN = re.compile(r"\d+(?:\.\d+)?|[A-Za-z_]\w*|[-+*/^(),]")
+
+
+def generate(terms, seed):
+    rng = random.Random(seed)
+    names = [f"v{i}" for i in range(32)]
+    parts = []
+    for _ in range(terms):
+        choice = rng.randrange(4)
+        if choice == 0:
+            parts.append(f"{rng.choice(names)} * {rng.randrange(1000)}.{rng.randrange(1000)}")
+        elif choice == 1:
+            parts.append(f"sin({rng.choice(names)}) ^ 2")
+        elif choice == 2:
+            parts.append(f"-({rng.choice(names)} - {rng.randrange(100)}) / 7")
+        else:
+            parts.append(f"max({rng.choice(names)}, -{rng.randrange(100)})")
+    return " + ".join(parts)
+
+
+def make_solver():
+    solver = Solver()
+    for i in range(32):
+        solver.declare_variable(f"v{i}", i * 0.5 + 1)
+    return solver
+
+
+def throughput(run, expressions):
+    tokens = sum(len(TOKEN.findall(e)) for e in expressions)
+    start = time.perf_counter()
+    for i, expression in enumerate(expressions):
+        run(i, expression)
+    seconds = time.perf_counter() - start
+    return tokens, tokens / seconds
+
+
+def main():
+    print(f"{'terms':>8} {'tokens':>10} {'declare (tok/s)':>18} {'compile (tok/s)':>18}")
+    for terms in SIZES:
+        repeats = max(1, 200_000 // (terms * 10))
+        expressions = [generate(terms, seed) for seed in range(repeats)]
+        solver = make_solver()
+        args = [f"v{i}" for i in range(32)]
+        tokens, declared = throughput(lambda i, e: solver.declare_function(f"bench{i}", args, e), expressions)
+        _, compiled = throughput(lambda i, e: solver.compile(e), expressions)
+        print(f"{terms:>8} {tokens // repeats:>10} {declared:>18,.0f} {compiled:>18,.0f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+"""
+Throughput of evaluate_range() on polynomials, with and without fast math.
+
+Without fast math every term pays for its own pow (only x^2 becomes a multiplication).
+With fast math the polynomial is rewritten in Horner form (Estrin form from degree 8)
+and the remaining powers become multiplications, so each degree costs one multiplication
+and one addition. Results may differ from the exact evaluation in the last bits.
+"""
+import time
+
+import numpy as np
+from solver import Solver
+
+N = 1_000_000
+
+SCENARIOS = [
+    ("quartic", "a*x^4 + b*x^3 + c*x^2 + d*x + f"),
+    ("sparse", "x^12 - 4*x^7 + 2*x^3 - 1"),
+    ("degree 10", " + ".join(f"{k + 1}*x^{k}" for k in range(10, 0, -1)) + " + 1"),
+    ("bivariate", "x^3*y + 2*x^2*y^2 - x*y^3 + y"),
+]
+
+
+def main():
+    xs = np.linspace(-1, 1, N)
+    out = np.empty(N)
+
+    for engine in ("interpreter", "jit", "batch"):
+        print(f"\n{engine}, {N} points, ns per point")
+        print(f"{'expression':<12}{'exact':>10}{'fast math':>12}{'instructions':>16}")
+        for name, expression in SCENARIOS:
+            row = ""
+            counts = []
+            for fast_math, width in ((False, 10), (True, 12)):
+                solver = Solver()
+                solver.use_cache(False)
+                solver.set_engine(engine)
+                solver.set_fast_math(fast_math)
+                for i, variable in enumerate("abcdfy"):
+                    solver.declare_variable(variable, 0.5 + i * 0.25)
+                counts.append(solver.compile(expression).instruction_count)
+                start = time.perf_counter()
+                solver.evaluate_range("x", xs, expression, threads=1, out=out)
+                row += f"{(time.perf_counter() - start) / N * 1e9:>{width}.1f}"
+            print(f"{name:<12}{row}{f'{counts[0]} -> {counts[1]}':>16}")
+
+
+if __name__ == "__main__":
+    main()
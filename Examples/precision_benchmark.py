@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""
+Throughput of evaluate_ranges() in each execution precision.
+
+Expressions are parsed and simplified once in the precision of the build; the compiled
+program then runs in the requested precision. long double goes through the x87 unit on
+x86-64 and cannot be vectorized, so double and float sweeps are expected to be faster on
+arithmetic-heavy expressions. Built-in functions are computed in long double in every
+precision, so transcendental-heavy expressions gain less.
+"""
+import time
+
+import numpy as np
+from solver import Solver
+
+N = 1000
+PRECISIONS = ("long double", "double", "float")
+
+SCENARIOS = [
+    ("polynomial", "x^2 * y + 3*x*y^2 - x / (y + 1)"),
+    ("transcendental", "sin(x * y) * exp(x - y)"),
+]
+
+
+def main():
+    xs = np.linspace(0, 2, N)
+    ys = np.linspace(1, 2, N)
+    out = np.empty((N, N))
+    points = N * N
+
+    for engine in ("interpreter", "jit", "batch"):
+        print(f"\n{engine}, {N} x {N} grid, ns per point")
+        print(f"{'expression':<50}" + "".join(f"{precision:>14}" for precision in PRECISIONS))
+        for name, expression in SCENARIOS:
+            row = ""
+            for precision in PRECISIONS:
+                solver = Solver()
+                solver.use_cache(False)
+                solver.set_engine(engine)
+                start = time.perf_counter()
+                solver.evaluate_ranges(["x", "y"], [xs, ys], expression, threads=1, out=out, precision=precision)
+                row += f"{(time.perf_counter() - start) / points * 1e9:>14.1f}"
+            print(f"{name + ': ' + expression:<50}{row}")
+
+
+if __name__ == "__main__":
+    main()
@@ -2,7 +2,93 @@
 Python bindings for the solver C++ math expression parsing and solving library.
 """
 from __future__ import annotations
-__all__ = ['Solver', 'SolverException', 'version']
+import numpy
+import typing
+__all__ = ['CompiledExpression', 'Solver', 'SolverException', 'SpecializedExpression', 'version']
+class CompiledExpression:
+    """
+    An immutable, self-contained compiled expression returned by
+    Solver::compile().
+    
+    The handle owns its program (with the constants and functions of the solver
+    folded in at compile time) and, for Engine::JIT and Engine::C, its native code.
+    It keeps no reference to the solver, so it stays valid and unchanged after later
+    declarations and after the solver is destroyed.
+    
+    Variables are not read from a symbol table: every call supplies the values of
+    the variables listed by variables(). Each call evaluates on a register file of
+    its own, so a single handle can be evaluated from many threads at once.
+    """
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    @typing.overload
+    def evaluate(self, values: dict[str, float]) -> float:
+        """
+        Evaluates the expression with variable values looked up by name.
+        
+        Names the expression does not read are ignored, so e.g. Solver::listVariables()
+        can be passed as is.
+        
+        Parameter ``values``:
+            Value of each variable, by name.
+        
+        Returns:
+            The value of the expression.
+        
+        Throws:
+            SolverException If a variable of the expression is missing, or on a runtime
+            error.
+        """
+    @typing.overload
+    def evaluate(self, values: list[float] = []) -> float:
+        """
+        Evaluates the expression with the given variable values.
+        
+        The GIL is released while the expression is evaluated.
+        
+        Parameter ``values``:
+            One value per entry of variables(), in the same order.
+        
+        Returns:
+            The value of the expression.
+        
+        Throws:
+            SolverException If the number of values is wrong, or on a runtime error
+            (e.g. division by zero).
+        """
+    @property
+    def engine(self) -> str:
+        """
+        The execution tier the expression was compiled for.
+        """
+    @property
+    def expression(self) -> str:
+        """
+        The source expression.
+        """
+    @property
+    def fma_count(self) -> int:
+        """
+        Number of those instructions that are fused multiply-adds (see
+        Solver::setFusedMultiplyAdd()).
+        """
+    @property
+    def instruction_count(self) -> int:
+        """
+        Number of instructions executed per evaluation.
+        """
+    @property
+    def precision(self) -> str:
+        """
+        The precision the expression is executed in.
+        """
+    @property
+    def variables(self) -> list[str]:
+        """
+        Names of the variables the expression reads, in the order evaluate() expects
+        their values.
+        """
 class Solver:
     """
     A class for evaluating mathematical expressions, managing variables, constants,
@@ -29,12 +115,38 @@ class Solver:
         """
     def clear_cache(self) -> None:
         """
-        Clears the solver's expression cache and function cache (if any).
+        Clears the solver's expression cache and program cache.
         
         This is a direct way to force the solver to discard all cached results. After
         calling, the next evaluations will re-parse and re-compute the expression
         outcomes from scratch.
         """
+    def compile(self, expression: str, engine: str | None = None, precision: str | None = None) -> CompiledExpression:
+        """
+        Compiles an expression into a reusable, thread-safe CompiledExpression.
+        
+        The expression is parsed, simplified and compiled once, with the constants and
+        functions declared so far; native code is generated up front for Engine::JIT and
+        Engine::C. The returned handle does not depend on the solver: later declarations
+        do not affect it, and it can be evaluated concurrently with caller-supplied
+        variable values while the solver keeps evaluating other expressions.
+        
+        Parameter ``expression``:
+            The mathematical expression to compile (e.g. "x^2 + y").
+        
+        Parameter ``engine``:
+            The execution tier to compile for; defaults to the one selected with
+            setEngine().
+        
+        Parameter ``precision``:
+            The precision to run in; defaults to the one selected with setPrecision().
+        
+        Returns:
+            The compiled expression.
+        
+        Throws:
+            SolverException If the expression cannot be parsed or compiled.
+        """
     def declare_constant(self, name: str, value: float) -> None:
         """
         Declares a constant in the symbol table.
@@ -86,14 +198,17 @@ class Solver:
         Parameter ``value``:
             The numeric value to assign to the variable.
         """
-    def evaluate(self, expression: str, debug: bool = False) -> float:
+    def evaluate(self, expression: str, debug: bool = False, engine: str | None = None, precision: str | None = None) -> float:
         """
         Evaluates a mathematical expression and returns its numeric result.
         
         - Internally, this calls setCurrentExpression() which parses the expression (or
         uses a cached parse if unchanged). - Then it checks the cache (if enabled) to
-        see if the expression result is already stored. - If not in cache, it evaluates
-        the expression in postfix form and stores the result if caching is on.
+        see if the expression result is already stored. - If not in cache, it runs the
+        compiled program on ``engine`` (or the solver's engine) and stores the result if
+        caching is on. - With tiering (see setTiering()), the call is counted (even when
+        its result comes from the cache) and may promote the expression to a higher
+        tier.
         
         Parameter ``expression``:
             A string representing the mathematical expression to evaluate (e.g. "3 + 4 *
@@ -103,6 +218,15 @@ class Solver:
             If true, prints debugging information such as the final postfix
             representation.
         
+        Parameter ``engine``:
+            The execution tier to use for this call; defaults to the one selected with
+            setEngine(), or to the engine of the expression's Tier if that is the
+            interpreter and it is tiered.
+        
+        Parameter ``precision``:
+            The precision to run the program in ("float", "double" or "long double");
+            defaults to the one selected with setPrecision().
+        
         Returns:
             The computed value of the expression.
         
@@ -130,7 +254,7 @@ class Solver:
         Throws:
             SolverException on parse errors, unknown symbols, etc.
         """
-    def evaluate_range(self, variable: str, values: list[float], expression: str, debug: bool = False) -> list[float]:
+    def evaluate_range(self, variable: str, values: list[float] | numpy.ndarray, expression: str, debug: bool = False, threads: int = 0, out: numpy.ndarray | None = None, precision: str | None = None) -> list[float] | numpy.ndarray:
         """
         Evaluates a mathematical expression for each value in a range of inputs for one
         variable.
@@ -140,6 +264,11 @@ class Solver:
         is set in the symbol table, and the same parsed/postfix expression is evaluated.
         This allows efficient bulk evaluation.
         
+        One-dimensional float32, float64 and long double arrays (anything supporting the
+        buffer protocol) are read in place, and the results are then returned as a new
+        float64 ndarray, or written into ``out`` if given. Lists are converted and a list
+        is returned. The GIL is released for the whole evaluation.
+        
         Parameter ``variable``:
             The name of the variable to iterate (e.g. "x").
         
@@ -153,6 +282,18 @@ class Solver:
             If true, prints debug info for the parsing phase (once) and indicates
             evaluations in a loop.
         
+        Parameter ``threads``:
+            Number of worker threads (0 uses the hardware concurrency). Results do not
+            depend on it.
+        
+        Parameter ``out``:
+            Optional writable float32, float64 or long double array of ``len(values)``
+            elements to write the results into. It is returned.
+        
+        Parameter ``precision``:
+            The precision to run the program in; defaults to the one selected with
+            setPrecision().
+        
         Returns:
             A vector of computed results, with one result per value in ``values.``
         
@@ -160,7 +301,7 @@ class Solver:
             SolverException If ``variable`` is invalid or if an error occurs during
             evaluation.
         """
-    def evaluate_ranges(self, variables: list[str], valuesSets: list[list[float]], expression: str, debug: bool = False) -> list[float]:
+    def evaluate_ranges(self, variables: list[str], valuesSets: list[list[float] | numpy.ndarray], expression: str, debug: bool = False, threads: int = 0, out: numpy.ndarray | None = None, precision: str | None = None) -> list[float] | numpy.ndarray:
         """
         Evaluates a single expression across multiple variables, each with a range of
         values.
@@ -173,6 +314,15 @@ class Solver:
         The result vector is returned in row-major order with respect to the input
         vectors in ``valuesSets,`` i.e., the last variable varies fastest.
         
+        The flat index space of the product is split into contiguous slices, one per
+        thread, and each thread writes its slice of the result vector with its own
+        evaluation state, so the results are bit-identical to a single-threaded
+        evaluation.
+        
+        Ranges given as arrays are read in place and the results are returned as a flat
+        float64 ndarray, or written into ``out`` if given; lists are converted and a list
+        is returned. The GIL is released for the whole evaluation.
+        
         Parameter ``variables``:
             A list of variable names, e.g., ["x", "y"].
         
@@ -186,6 +336,19 @@ class Solver:
         Parameter ``debug``:
             If true, prints debug info for parsing; does NOT print each evaluation.
         
+        Parameter ``threads``:
+            Number of worker threads (0 uses the hardware concurrency). Results do not
+            depend on it.
+        
+        Parameter ``out``:
+            Optional writable float32, float64 or long double array with one element
+            per combination, one-dimensional or C-contiguous (e.g. shaped like the
+            grid). It is returned.
+        
+        Parameter ``precision``:
+            The precision to run the program in; defaults to the one selected with
+            setPrecision().
+        
         Returns:
             A flat vector of results (size = product of the lengths of each range in
             ``valuesSets).``
@@ -194,6 +357,10 @@ class Solver:
             SolverException If a variable name is invalid, or expression parsing fails,
             etc.
         """
+    def get_batch_size(self) -> int:
+        """
+        Returns the number of inputs Engine::BATCH evaluates per block.
+        """
     def get_current_expression(self) -> str:
         """
         Retrieves the most recently set expression string.
@@ -203,6 +370,50 @@ class Solver:
         Returns:
             The current expression string.
         """
+    def get_engine(self) -> str:
+        """
+        Returns the execution tier selected with setEngine().
+        """
+    def get_equality_saturation(self) -> bool:
+        """
+        Returns whether the equality-saturation optimizer is enabled, see
+        setEqualitySaturation().
+        """
+    def get_fast_math(self) -> bool:
+        """
+        Returns whether fast math was enabled with setFastMath().
+        """
+    def get_fused_multiply_add(self) -> bool:
+        """
+        Returns whether multiply-adds are contracted, see setFusedMultiplyAdd().
+        """
+    def get_precision(self) -> str:
+        """
+        Returns the precision selected with setPrecision().
+        """
+    def get_program_cache_stats(self) -> dict[str, int]:
+        """
+        Returns the hit, miss, eviction and invalidation counters and the size of the
+        program cache.
+        
+        In Python, a dict with the keys ``hits``, ``misses``, ``evictions``,
+        ``invalidations``, ``entries`` and ``bytes``.
+        """
+    def get_tier_info(self, expression: str) -> dict[str, str | int | bool]:
+        """
+        Returns the tier of ``expression`` and its execution count.
+        
+        An expression without a compiled program reports the tier it would start at.
+        
+        In Python, a dict with the keys ``tier``, ``executions``, ``promoting`` and
+        ``pinned``.
+        """
+    def get_tiering(self) -> bool:
+        """
+        Returns the tiering policy, see setTiering().
+        
+        In Python, whether tiering is enabled.
+        """
     def list_constants(self) -> dict[str, float]:
         """
         Lists all declared constants.
@@ -223,6 +434,20 @@ class Solver:
         Returns:
             An unordered_map from variable name to double value.
         """
+    def pin_tier(self, expression: str, tier: str | None) -> None:
+        """
+        Pins ``expression`` to ``tier,`` or unpins it if ``tier`` is empty.
+        
+        A pinned expression is built at its tier and never promoted, whether tiering is
+        enabled or not. The program of ``expression`` is discarded so the next call
+        rebuilds it.
+        
+        Parameter ``expression``:
+            The expression string, as passed to evaluate().
+        
+        Parameter ``tier``:
+            The tier to pin it to, or std::nullopt to let the policy decide again.
+        """
     def print_function_expressions(self) -> None:
         """
         Prints expressions (postfix or inlined) for all registered functions to stdout.
@@ -230,6 +455,19 @@ class Solver:
         This can be useful for debugging or understanding how user-defined functions
         have been internally flattened to postfix representation.
         """
+    def set_batch_size(self, lanes: int) -> None:
+        """
+        Sets how many inputs Engine::BATCH evaluates per block.
+        
+        Larger blocks amortize per-instruction dispatch over more inputs, smaller ones
+        keep the working set (one column per register) in cache.
+        
+        Parameter ``lanes``:
+            Inputs per block (BatchProgram::DEFAULT_LANES by default).
+        
+        Throws:
+            SolverException If ``lanes`` is zero.
+        """
     def set_current_expression(self, expression: str, debug: bool = False) -> None:
         """
         Sets the expression to be evaluated and parses it into a postfix representation.
@@ -255,6 +493,166 @@ class Solver:
         of storing postfix tokens. If the expression is identical to the previously
         stored one (and the AST is valid), we skip re-building unless debug is true.
         """
+    def set_engine(self, engine: str) -> None:
+        """
+        Selects the execution tier used by evaluate() and the range evaluations.
+        
+        Engine::JIT compiles each expression to native x86-64 code the first time it is
+        run; Engine::C emits C and builds it with the system compiler, caching objects
+        on disk. Engine::BATCH evaluates range inputs a block at a time with the
+        columnar evaluator (scalar evaluations use the interpreter). Where native code cannot be generated, evaluation falls back to the
+        bytecode interpreter. All tiers produce identical results.
+        
+        Parameter ``engine``:
+            The engine to use (Engine::INTERPRETER by default).
+        """
+    def set_equality_saturation(self, enabled: bool, node_limit: int = 10000, iteration_limit: int = 30, time_limit: float = 0.02) -> None:
+        """
+        Enables the equality-saturation optimizer, for the expressions that run hottest.
+        
+        After simplification, every expression is optimized with saturate(): algebraic
+        identities (commutativity, associativity, the identities of 0, 1 and negation,
+        ...) are applied in every direction at once in an e-graph, and the cheapest
+        equivalent expression is kept, pow and transcendental calls counting most. This
+        finds rewrites the greedy rules miss, at a compile time bounded by ``limits.``
+        The identities hold in real arithmetic only, so results may differ in the last
+        bits (and regrouped intermediates may overflow or underflow differently), but
+        errors, domains and special values are kept. With fast math (see setFastMath())
+        distributivity, the power laws and the laws of exp, ln and sqrt are used as
+        well, factoring `a*(x + y) + b*(x + y)` into `(a + b)*(x + y)` and combining
+        `exp(a)*exp(b)` into `exp(a + b)`, although they do not keep them (`inf*0 +
+        inf*1` is NaN, `inf*(0 + 1)` is inf). Compiled programs and cached results are
+        discarded when the setting changes.
+        
+        Parameter ``enabled``:
+            Whether to run the optimizer (false by default).
+        
+        Parameter ``limits``:
+            Bounds on the e-graph size, the rounds of rewriting and the time spent per
+            expression.
+        """
+    def set_fast_math(self, enabled: bool) -> None:
+        """
+        Enables the simplifications that trade exactness for speed.
+        
+        By default expressions are only rewritten in ways that give the same result for
+        every input. With fast math, sums and products are also regrouped with their
+        constants folded, polynomials are evaluated in Horner or Estrin form, integer
+        powers are expanded into multiplications, `x^0.5` is evaluated with sqrt and
+        divisions by constants become multiplications by their reciprocal, so results
+        may differ in the last bits, overflow differently (`x*4*0.25` no longer
+        overflows for large x) and `0^-n` raises a division by zero. Products with 0
+        fold to 0, even where the other operand is infinite (NaN otherwise) or raises an
+        error. Compiled programs and cached results are discarded when the setting
+        changes.
+        
+        Parameter ``enabled``:
+            Whether to apply the inexact rewrites (false by default).
+        """
+    def set_fused_multiply_add(self, enabled: bool) -> None:
+        """
+        Enables contracting multiply-adds into fused multiply-adds.
+        
+        With it, after simplification every addition of a product is rewritten with fma
+        (see contractMultiplyAdds()), which every engine executes with one rounding:
+        `a*b + c` takes one instruction instead of two and is usually closer to the
+        exact value, but results change in the last bits. Compiled programs and cached
+        results are discarded when the setting changes.
+        
+        Parameter ``enabled``:
+            Whether to contract multiply-adds (false by default).
+        """
+    def set_precision(self, precision: str) -> None:
+        """
+        Selects the precision compiled programs are executed in.
+        
+        Expressions are always parsed and simplified in NUMBER_TYPE; the compiled
+        program is then run in ``precision`` on every engine, so throughput-critical
+        sweeps can run in double or float while audits keep the full precision of the
+        build. Results are returned as NUMBER_TYPE and written to range outputs in
+        their own element type.
+        
+        Parameter ``precision``:
+            The precision to use: "float", "double" or "long double" (the precision of
+            NUMBER_TYPE by default).
+        
+        Throws:
+            SolverException If ``precision`` is not a known precision.
+        """
+    def set_program_cache_size(self, entries: int, bytes: int = 0) -> None:
+        """
+        Bounds the program cache.
+        
+        The program cache keeps the parsed, simplified and compiled form of the most
+        recently used expressions (and their native code), so switching between
+        expressions does not re-parse them. It is independent of setUseCache(), which
+        only controls result caching. Entries are dropped when a constant or function
+        they refer to is declared.
+        
+        Parameter ``entries``:
+            Maximum number of expressions kept (DEFAULT_PROGRAM_CACHE_SIZE, 512, by
+            default; 0 disables the cache).
+        
+        Parameter ``bytes``:
+            Maximum estimated size of the kept entries in bytes (0 for no limit).
+        """
+    def set_tiering(self, enabled: bool, optimize_after: int = 100, native_after: int = 1000, native_engine: str = 'jit', background: bool = True) -> None:
+        """
+        Sets when expressions are promoted to a more expensive, faster Tier.
+        
+        With tiering enabled, an expression starts at Tier::BASELINE: it is compiled
+        without the simplifier, which pays off for formulas evaluated only a few times.
+        Every run of its program is counted (a range evaluation counts each point, and a
+        result served from the cache counts as a run); once the count reaches
+        ``policy.optimizeAfter`` the expression is rebuilt at Tier::OPTIMIZED, and once
+        it reaches ``policy.nativeAfter`` at Tier::NATIVE. With ``policy.background``
+        the rebuild is queued on a thread of the solver, which builds one at a time,
+        while the current tier keeps serving calls, and is switched to at the first call
+        after it is ready (a rebuild whose expression is dropped from the cache
+        meanwhile is skipped or discarded without waiting for it); otherwise it runs in
+        the call that crosses the threshold. While setEngine() selects
+        Engine::INTERPRETER, calls that do not name an engine run on the engine of the
+        tier (Engine::INTERPRETER below Tier::NATIVE); any other engine selected with
+        setEngine() is kept at every tier.
+        
+        Tiering does not change compile() and specialize(), which always simplify.
+        Compiled programs and cached results are discarded when the policy changes.
+        
+        Parameter ``policy``:
+            The thresholds and the native engine (tiering is disabled by default).
+        
+        In Python, the fields are keyword arguments: ``enabled``, ``optimize_after``,
+        ``native_after``, ``native_engine`` (an engine name) and ``background``.
+        """
+    def specialize(self, expression: str, fixed: list[str], engine: str | None = None, precision: str | None = None) -> SpecializedExpression:
+        """
+        Compiles an expression specialized on some of its variables held fixed.
+        
+        The variables in ``fixed`` are treated as constants at their current values, so
+        the whole simplifier runs on them and the residual program only computes what
+        depends on the other variables. When one of them is redeclared with a different
+        value, the returned handle rebuilds its residual on its next evaluation.
+        
+        Parameter ``expression``:
+            The mathematical expression to specialize (e.g. "a*x^2 + b*x + c").
+        
+        Parameter ``fixed``:
+            Names of the declared variables to hold fixed (e.g. {"a", "b", "c"}).
+        
+        Parameter ``engine``:
+            The execution tier to compile for; defaults to the one selected with
+            setEngine().
+        
+        Parameter ``precision``:
+            The precision to run in; defaults to the one selected with setPrecision().
+        
+        Returns:
+            The specialized expression, which must not outlive the solver.
+        
+        Throws:
+            SolverException If a fixed name is not a declared variable, or the
+            expression cannot be parsed or compiled.
+        """
     def use_cache(self, useCache: bool) -> None:
         """
         Toggles whether the solver uses its LRU cache.
@@ -268,6 +666,98 @@ class Solver:
         """
 class SolverException(Exception):
     pass
+class SpecializedExpression:
+    """
+    An expression compiled with some of its variables held fixed, returned by
+    Solver::specialize().
+    
+    The fixed variables are substituted by their current values before
+    simplification, so the whole optimizer (constant folding, function folding,
+    strength reduction and the opt-in rewrites) runs on them and the residual
+    program only computes what depends on the remaining inputs.
+    
+    Unlike a CompiledExpression, the handle refers to its solver: before each
+    evaluation it compares the values of the fixed variables in the solver with
+    those the residual was built with, and rebuilds the residual if one changed.
+    Constants and functions are those declared when the residual was (last) built.
+    The handle must not outlive its solver, and must not be evaluated from several
+    threads at once.
+    """
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    @typing.overload
+    def evaluate(self, values: dict[str, float]) -> float:
+        """
+        Evaluates the expression with input values looked up by name.
+        
+        Names that are not inputs (including the fixed variables) are ignored.
+        
+        Parameter ``values``:
+            Value of each input, by name.
+        
+        Returns:
+            The value of the expression.
+        
+        Throws:
+            SolverException If an input is missing, a fixed variable is no longer
+            declared, or on a runtime error.
+        """
+    @typing.overload
+    def evaluate(self, values: list[float] = []) -> float:
+        """
+        Evaluates the expression with the given input values and the current values of
+        the fixed variables.
+        
+        Parameter ``values``:
+            One value per entry of variables(), in the same order.
+        
+        Returns:
+            The value of the expression.
+        
+        Throws:
+            SolverException If the number of values is wrong, a fixed variable is no
+            longer declared, or on a runtime error.
+        """
+    @property
+    def engine(self) -> str:
+        """
+        The execution tier the residual is compiled for.
+        """
+    @property
+    def expression(self) -> str:
+        """
+        The source expression.
+        """
+    @property
+    def fixed(self) -> list[str]:
+        """
+        Names of the variables held fixed.
+        """
+    @property
+    def precision(self) -> str:
+        """
+        The precision the residual is executed in.
+        """
+    @property
+    def rebuild_count(self) -> int:
+        """
+        Number of times the residual was rebuilt after a fixed variable changed.
+        """
+    @property
+    def residual(self) -> CompiledExpression:
+        """
+        The residual program for the current values of the fixed variables, rebuilt
+        first if one changed.
+        
+        Its variables() are the inputs it still reads, a subset of variables().
+        """
+    @property
+    def variables(self) -> list[str]:
+        """
+        Names of the other variables the expression reads, in the order evaluate()
+        expects their values.
+        """
 def version() -> str:
     """
     Get the software version information.
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""
+Thread scaling of evaluate_ranges() on 2-D and 3-D parameter sweeps.
+
+The flat index space of the cartesian product is split into one contiguous slice per
+thread, so the sweep should scale with the number of cores until memory bandwidth (or
+the Python-side conversion of the inputs and results, which stays serial) dominates.
+Thread counts above os.cpu_count() are still run, to show the cost of oversubscription.
+"""
+import os
+import time
+
+import numpy as np
+from solver import Solver
+
+THREADS = [1, 2, 4, 8, 16, 32, 64]
+REPEATS = 3
+
+
+def best_of(fn, repeats=REPEATS):
+    best = float("inf")
+    for _ in range(repeats):
+        start = time.perf_counter()
+        fn()
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def main():
+    solver = Solver()
+    solver.use_cache(False)
+    solver.declare_function("f", ["x"], "x^2 + (2*x + 1)")
+    solver.declare_function("g", ["x", "y"], "x * y + x + y")
+
+    sweeps = [
+        ("2-D", ["x", "y"], [list(np.linspace(0, 10, 1000)), list(np.linspace(1, 2, 1000))],
+         "f(x) * sin(y) + g(x, y) / y"),
+        ("3-D", ["x", "y", "z"], [list(np.linspace(0, 1, 100))] * 3,
+         "exp(-(x^2 + y^2 + z^2)) * cos(x * y * z)"),
+    ]
+
+    print(f"cores available: {os.cpu_count()}")
+    for engine in ("interpreter", "batch"):
+        solver.set_engine(engine)
+        for name, variables, ranges, expression in sweeps:
+            points = int(np.prod([len(r) for r in ranges]))
+            reference = solver.evaluate_ranges(variables, ranges, expression, threads=1)
+            baseline = None
+            print(f"\n{engine}, {name} sweep ({points} points): {expression}")
+            print(f"{'threads':>8} {'seconds':>10} {'ns/point':>10} {'speedup':>8}")
+            for threads in THREADS:
+                results = solver.evaluate_ranges(variables, ranges, expression, threads=threads)
+                assert results == reference, "threaded results must be bit-identical"
+                seconds = best_of(lambda: solver.evaluate_ranges(variables, ranges, expression, threads=threads))
+                baseline = baseline or seconds
+                print(f"{threads:>8} {seconds:>10.3f} {seconds / points * 1e9:>10.1f} {baseline / seconds:>7.2f}x")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""
+Cost of cold and hot formulas with and without tiering.
+
+Cold formulas are evaluated once each: without tiering every one pays for the whole
+simplifier, with tiering it is compiled as parsed and interpreted. A hot formula is
+swept over many points: with tiering it starts at the baseline tier and is promoted to
+native code on a background thread (every point counts as an execution), so the later
+sweeps run at the speed of the JIT rather than of the interpreter.
+"""
+import time
+
+import numpy as np
+from solver import Solver
+
+COLD_FORMULAS = 2000
+HOT_SWEEPS = 200
+POINTS = 10000
+HOT = "(x + 1)^3 - 3*(x + 1)^2 + sin(x)^2 + cos(x)^2 + 0*y + x*y/y"
+
+
+def make_solver(tiering):
+    solver = Solver()
+    solver.use_cache(False)  # measure evaluation, not the result cache
+    solver.set_program_cache_size(COLD_FORMULAS)
+    solver.set_tiering(tiering)
+    solver.declare_variable("x", 1.5)
+    solver.declare_variable("y", 2.5)
+    return solver
+
+
+def cold(tiering):
+    solver = make_solver(tiering)
+    start = time.perf_counter()
+    for i in range(COLD_FORMULAS):
+        solver.evaluate(f"(x + {i})^2 - 2*x*{i} + 0*y + sin(x)*{i % 7}")
+    return (time.perf_counter() - start) / COLD_FORMULAS * 1e6
+
+
+def hot(tiering):
+    solver = make_solver(tiering)
+    xs = np.linspace(-1, 1, POINTS)
+    out = np.empty(POINTS)
+    start = time.perf_counter()
+    for _ in range(HOT_SWEEPS):
+        solver.evaluate_range("x", xs, HOT, threads=1, out=out)
+    elapsed = (time.perf_counter() - start) / (HOT_SWEEPS * POINTS) * 1e9
+    return elapsed, solver.get_tier_info(HOT)["tier"]
+
+
+def main():
+    print(f"{'':<10}{'cold (us per formula)':>24}{'hot (ns per point)':>20}{'hot tier':>12}")
+    for tiering in (False, True):
+        latency, tier = hot(tiering)
+        print(f"{'tiered' if tiering else 'default':<10}{cold(tiering):>24.1f}{latency:>20.1f}{tier:>12}")
+
+
+if __name__ == "__main__":
+    main()
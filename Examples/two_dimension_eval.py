@@ -17,21 +17,15 @@ def main():
 
     expression = "x^3 + y^4"
 
+    # The results are written straight into Z, in row-major order (the last variable
+    # varies fastest), so Z[i, j] is the value at (x_vals[i], y_vals[j]).
+    Z = np.empty((len(x_vals), len(y_vals)))
     try:
-        results = solver.evaluate_ranges(
-            ["x", "y"],
-            [x_vals.tolist(), y_vals.tolist()],
-            expression,
-            debug=False
-        )
+        solver.evaluate_ranges(["x", "y"], [x_vals, y_vals], expression, out=Z)
     except SolverException as e:
         print(f"Error evaluating expression '{expression}': {e}")
         return
 
-    # The results come back as a single flat array of length len(x_vals)*len(y_vals).
-    # We reshape to (len(x_vals), len(y_vals)) for plotting on a grid.
-    Z = np.array(results).reshape(len(x_vals), len(y_vals))
-
     # Create meshgrid for plotting
     X, Y = np.meshgrid(x_vals, y_vals)
 
@@ -1,15 +1,153 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include "solver.h"
 #include "exception.h"
 #include "docstrings.h"
 
 namespace py = pybind11;
 
+namespace {
+
+// Maps a buffer's element format to an ArrayView element type, if it has one.
+std::optional<ArrayView::Type> elementType(const py::buffer_info& info) {
+    std::string format = info.format;
+    if (!format.empty() && (format[0] == '@' || format[0] == '=')) {
+        format.erase(0, 1);
+    }
+    if (format == "f" && info.itemsize == sizeof(float)) return ArrayView::Type::FLOAT32;
+    if (format == "d" && info.itemsize == sizeof(double)) return ArrayView::Type::FLOAT64;
+    if (format == "g" && info.itemsize == sizeof(long double)) return ArrayView::Type::LONG_DOUBLE;
+    return std::nullopt;
+}
+
+// A range argument. One-dimensional float32, float64 and long double buffers are read in
+// place; anything else (a list, an integer array, ...) is converted to a vector as before.
+struct RangeArgument {
+    explicit RangeArgument(const py::handle& values) {
+        isArray = PyObject_CheckBuffer(values.ptr());
+        if (isArray) {
+            buffer = py::reinterpret_borrow<py::buffer>(values).request();
+            const auto type = elementType(buffer);
+            if (buffer.ndim == 1 && type) {
+                view = ArrayView(buffer.ptr, static_cast<size_t>(buffer.shape[0]), buffer.strides[0], *type);
+                return;
+            }
+        }
+        copy = values.cast<std::vector<NUMBER_TYPE>>();
+        view = ArrayView(copy);
+    }
+
+    py::buffer_info buffer;
+    std::vector<NUMBER_TYPE> copy;
+    ArrayView view;
+    bool isArray = false;
+};
+
+// The output of a range evaluation: the caller's out= buffer, a new float64 ndarray when
+// the inputs are arrays, or a list when they are not.
+struct RangeResult {
+    RangeResult(const py::object& out, size_t size, bool array) {
+        if (!out.is_none()) {
+            buffer = py::reinterpret_borrow<py::buffer>(out).request(true);
+            const auto type = elementType(buffer);
+            if (!type) {
+                throw SolverException("Unsupported out element type '" + buffer.format + "'; expected float32, float64 or long double.");
+            }
+            const py::ssize_t stride = buffer.ndim == 1 ? buffer.strides[0] : buffer.itemsize;
+            py::ssize_t expected = buffer.itemsize;
+            for (py::ssize_t d = buffer.ndim; d-- > 0;) {
+                if (buffer.ndim > 1 && buffer.strides[d] != expected) {
+                    throw SolverException("out must be one-dimensional or C-contiguous.");
+                }
+                expected *= buffer.shape[d];
+            }
+            view = ArrayView(buffer.ptr, static_cast<size_t>(buffer.size), stride, *type);
+            object = out;
+        }
+        else if (array) {
+            py::array_t<double> created(static_cast<py::ssize_t>(size));
+            view = ArrayView(created.mutable_data(), size, sizeof(double), ArrayView::Type::FLOAT64);
+            object = std::move(created);
+        }
+        else {
+            copy.resize(size);
+            view = ArrayView(copy);
+        }
+    }
+
+    py::object result() const { return object ? object : py::cast(copy); }
+
+    py::buffer_info buffer;
+    std::vector<NUMBER_TYPE> copy;
+    ArrayView view;
+    py::object object;
+};
+
+} // namespace
+
 void bind_solver(py::module_ &m) {
     // Register the custom exception type so that Python code can catch SolverException
     py::register_exception<SolverException>(m, "SolverException");
 
+    py::class_<CompiledExpression>(m, "CompiledExpression", DOC(CompiledExpression))
+        .def("evaluate",
+             [](const CompiledExpression& self, const std::unordered_map<std::string, NUMBER_TYPE>& values) {
+                 py::gil_scoped_release release;
+                 return self.evaluate(values);
+             },
+             py::arg("values"),
+             DOC(CompiledExpression, evaluate_2))
+
+        .def("evaluate",
+             [](const CompiledExpression& self, const std::vector<NUMBER_TYPE>& values) {
+                 py::gil_scoped_release release;
+                 return self.evaluate(values);
+             },
+             py::arg("values") = std::vector<NUMBER_TYPE>(),
+             DOC(CompiledExpression, evaluate))
+
+        .def_property_readonly("expression", &CompiledExpression::expression, DOC(CompiledExpression, expression))
+        .def_property_readonly("variables", &CompiledExpression::variables, DOC(CompiledExpression, variables))
+        .def_property_readonly("engine",
+             [](const CompiledExpression& self) { return engineToString(self.engine()); },
+             DOC(CompiledExpression, engine))
+        .def_property_readonly("precision",
+             [](const CompiledExpression& self) { return precisionToString(self.precision()); },
+             DOC(CompiledExpression, precision))
+        .def_property_readonly("instruction_count", &CompiledExpression::instructionCount,
+             DOC(CompiledExpression, instructionCount))
+        .def_property_readonly("fma_count", &CompiledExpression::fusedMultiplyAddCount,
+             DOC(CompiledExpression, fusedMultiplyAddCount));
+
+    // Not thread-safe: evaluation may rebuild the residual through the solver, so the GIL is kept
+    py::class_<SpecializedExpression>(m, "SpecializedExpression", DOC(SpecializedExpression))
+        .def("evaluate",
+             py::overload_cast<const std::unordered_map<std::string, NUMBER_TYPE>&>(&SpecializedExpression::evaluate),
+             py::arg("values"),
+             DOC(SpecializedExpression, evaluate_2))
+
+        .def("evaluate",
+             py::overload_cast<const std::vector<NUMBER_TYPE>&>(&SpecializedExpression::evaluate),
+             py::arg("values") = std::vector<NUMBER_TYPE>(),
+             DOC(SpecializedExpression, evaluate))
+
+        .def_property_readonly("expression", &SpecializedExpression::expression, DOC(SpecializedExpression, expression))
+        .def_property_readonly("fixed", &SpecializedExpression::fixed, DOC(SpecializedExpression, fixed))
+        .def_property_readonly("variables", &SpecializedExpression::variables, DOC(SpecializedExpression, variables))
+        .def_property_readonly("engine",
+             [](const SpecializedExpression& self) { return engineToString(self.engine()); },
+             DOC(SpecializedExpression, engine))
+        .def_property_readonly("precision",
+             [](const SpecializedExpression& self) { return precisionToString(self.precision()); },
+             DOC(SpecializedExpression, precision))
+        // A copy, as a rebuild replaces the residual
+        .def_property_readonly("residual",
+             [](SpecializedExpression& self) { return self.residual(); },
+             DOC(SpecializedExpression, residual))
+        .def_property_readonly("rebuild_count", &SpecializedExpression::rebuildCount,
+             DOC(SpecializedExpression, rebuildCount));
+
     // Expose the Solver class to Python
     py::class_<Solver>(m, "Solver", DOC(Solver))
         // Constructor
@@ -35,11 +173,41 @@ void bind_solver(py::module_ &m) {
              DOC(Solver, declareVariable))
 
         .def("evaluate",
-             &Solver::evaluate, 
+             [](Solver& self, const std::string& expression, bool debug, const std::optional<std::string>& engine,
+                const std::optional<std::string>& precision) {
+                 return self.evaluate(expression, debug, engine ? std::optional<Engine>(engineFromString(*engine)) : std::nullopt,
+                                      precision ? std::optional<Precision>(precisionFromString(*precision)) : std::nullopt);
+             },
              py::arg("expression"),
              py::arg("debug") = false,
+             py::arg("engine") = py::none(),
+             py::arg("precision") = py::none(),
              DOC(Solver, evaluate))
 
+        .def("compile",
+             [](Solver& self, const std::string& expression, const std::optional<std::string>& engine,
+                const std::optional<std::string>& precision) {
+                 return self.compile(expression, engine ? std::optional<Engine>(engineFromString(*engine)) : std::nullopt,
+                                     precision ? std::optional<Precision>(precisionFromString(*precision)) : std::nullopt);
+             },
+             py::arg("expression"),
+             py::arg("engine") = py::none(),
+             py::arg("precision") = py::none(),
+             DOC(Solver, compile))
+
+        .def("specialize",
+             [](Solver& self, const std::string& expression, const std::vector<std::string>& fixed,
+                const std::optional<std::string>& engine, const std::optional<std::string>& precision) {
+                 return self.specialize(expression, fixed, engine ? std::optional<Engine>(engineFromString(*engine)) : std::nullopt,
+                                        precision ? std::optional<Precision>(precisionFromString(*precision)) : std::nullopt);
+             },
+             py::arg("expression"),
+             py::arg("fixed"),
+             py::arg("engine") = py::none(),
+             py::arg("precision") = py::none(),
+             py::keep_alive<0, 1>(),
+             DOC(Solver, specialize))
+
         .def("evaluate_ast",
              &Solver::evaluateAST, 
              py::arg("expression"),
@@ -48,19 +216,59 @@ void bind_solver(py::module_ &m) {
 
         
         .def("evaluate_range",
-             &Solver::evaluateForRange,
+             [](Solver& self, const std::string& variable, const py::object& values, const std::string& expression,
+                bool debug, size_t threads, const py::object& out, const std::optional<std::string>& precision) {
+                 const std::optional<Precision> selected = precision ? std::optional<Precision>(precisionFromString(*precision)) : std::nullopt;
+                 RangeArgument range(values);
+                 RangeResult results(out, range.view.size(), range.isArray);
+                 // The Solver is only touched with the GIL held; the sweep runs on copied state
+                 const std::function<void()> sweep = self.prepareRange(variable, range.view, expression, results.view, debug, threads, selected);
+                 {
+                     py::gil_scoped_release release;
+                     sweep();
+                 }
+                 return results.result();
+             },
              py::arg("variable"),
              py::arg("values"),
              py::arg("expression"),
              py::arg("debug") = false,
+             py::arg("threads") = 0,
+             py::arg("out") = py::none(),
+             py::arg("precision") = py::none(),
              DOC(Solver, evaluateForRange))
 
         .def("evaluate_ranges",
-             &Solver::evaluateForRanges,
+             [](Solver& self, const std::vector<std::string>& variables, const py::sequence& valuesSets,
+                const std::string& expression, bool debug, size_t threads, const py::object& out,
+                const std::optional<std::string>& precision) {
+                 const std::optional<Precision> selected = precision ? std::optional<Precision>(precisionFromString(*precision)) : std::nullopt;
+                 std::vector<RangeArgument> ranges;
+                 ranges.reserve(valuesSets.size());
+                 std::vector<ArrayView> views;
+                 size_t total = 1;
+                 bool array = false;
+                 for (const py::handle& values : valuesSets) {
+                     ranges.emplace_back(values);
+                     views.push_back(ranges.back().view);
+                     total *= ranges.back().view.size();
+                     array = array || ranges.back().isArray;
+                 }
+                 RangeResult results(out, total, array);
+                 const std::function<void()> sweep = self.prepareRanges(variables, views, expression, results.view, debug, threads, selected);
+                 {
+                     py::gil_scoped_release release;
+                     sweep();
+                 }
+                 return results.result();
+             },
              py::arg("variables"),
              py::arg("valuesSets"),
              py::arg("expression"),
              py::arg("debug") = false,
+             py::arg("threads") = 0,
+             py::arg("out") = py::none(),
+             py::arg("precision") = py::none(),
              DOC(Solver, evaluateForRanges))
 
         .def("declare_function",
@@ -79,6 +287,121 @@ void bind_solver(py::module_ &m) {
              py::arg("useCache"),
              DOC(Solver, setUseCache))
 
+        .def("set_program_cache_size",
+             &Solver::setProgramCacheSize,
+             py::arg("entries"),
+             py::arg("bytes") = 0,
+             DOC(Solver, setProgramCacheSize))
+
+        .def("get_program_cache_stats",
+             [](const Solver& self) {
+                 const ProgramCacheStats stats = self.getProgramCacheStats();
+                 py::dict result;
+                 result["hits"] = stats.hits;
+                 result["misses"] = stats.misses;
+                 result["evictions"] = stats.evictions;
+                 result["invalidations"] = stats.invalidations;
+                 result["entries"] = stats.entries;
+                 result["bytes"] = stats.bytes;
+                 return result;
+             },
+             DOC(Solver, getProgramCacheStats))
+
+        .def("set_engine",
+             [](Solver& self, const std::string& engine) { self.setEngine(engineFromString(engine)); },
+             py::arg("engine"),
+             DOC(Solver, setEngine))
+
+        .def("get_engine",
+             [](const Solver& self) { return engineToString(self.getEngine()); },
+             DOC(Solver, getEngine))
+
+        .def("set_precision",
+             [](Solver& self, const std::string& precision) { self.setPrecision(precisionFromString(precision)); },
+             py::arg("precision"),
+             DOC(Solver, setPrecision))
+
+        .def("get_precision",
+             [](const Solver& self) { return precisionToString(self.getPrecision()); },
+             DOC(Solver, getPrecision))
+
+        .def("set_fast_math",
+             &Solver::setFastMath,
+             py::arg("enabled"),
+             DOC(Solver, setFastMath))
+
+        .def("get_fast_math",
+             &Solver::getFastMath,
+             DOC(Solver, getFastMath))
+
+        .def("set_fused_multiply_add",
+             &Solver::setFusedMultiplyAdd,
+             py::arg("enabled"),
+             DOC(Solver, setFusedMultiplyAdd))
+
+        .def("get_fused_multiply_add",
+             &Solver::getFusedMultiplyAdd,
+             DOC(Solver, getFusedMultiplyAdd))
+
+        .def("set_equality_saturation",
+             [](Solver& self, bool enabled, size_t nodeLimit, size_t iterationLimit, double timeLimit) {
+                 self.setEqualitySaturation(enabled, SaturationLimits{ nodeLimit, iterationLimit, timeLimit });
+             },
+             py::arg("enabled"),
+             py::arg("node_limit") = SaturationLimits{}.nodeLimit,
+             py::arg("iteration_limit") = SaturationLimits{}.iterationLimit,
+             py::arg("time_limit") = SaturationLimits{}.timeLimit,
+             DOC(Solver, setEqualitySaturation))
+
+        .def("get_equality_saturation",
+             &Solver::getEqualitySaturation,
+             DOC(Solver, getEqualitySaturation))
+
+        .def("set_tiering",
+             [](Solver& self, bool enabled, size_t optimizeAfter, size_t nativeAfter, const std::string& nativeEngine, bool background) {
+                 self.setTiering(TieringPolicy{ enabled, optimizeAfter, nativeAfter, engineFromString(nativeEngine), background });
+             },
+             py::arg("enabled"),
+             py::arg("optimize_after") = TieringPolicy{}.optimizeAfter,
+             py::arg("native_after") = TieringPolicy{}.nativeAfter,
+             py::arg("native_engine") = engineToString(TieringPolicy{}.nativeEngine),
+             py::arg("background") = TieringPolicy{}.background,
+             DOC(Solver, setTiering))
+
+        .def("get_tiering",
+             [](const Solver& self) { return self.getTiering().enabled; },
+             DOC(Solver, getTiering))
+
+        .def("pin_tier",
+             [](Solver& self, const std::string& expression, const std::optional<std::string>& tier) {
+                 self.pinTier(expression, tier ? std::optional<Tier>(tierFromString(*tier)) : std::nullopt);
+             },
+             py::arg("expression"),
+             py::arg("tier"),
+             DOC(Solver, pinTier))
+
+        .def("get_tier_info",
+             [](Solver& self, const std::string& expression) {
+                 const TierInfo info = self.getTierInfo(expression);
+                 py::dict result;
+                 result["tier"] = tierToString(info.tier);
+                 result["executions"] = info.executions;
+                 result["promoting"] = info.promoting;
+                 result["pinned"] = info.pinned;
+                 return result;
+             },
+             py::arg("expression"),
+             DOC(Solver, getTierInfo))
+
+        .def("set_batch_size",
+             &Solver::setBatchSize,
+             py::arg("lanes"),
+             DOC(Solver, setBatchSize))
+
+        .def("get_batch_size",
+             &Solver::getBatchSize,
+             DOC(Solver, getBatchSize))
+
         .def("list_constants", 
              &Solver::listConstants,
              DOC(Solver, listConstants))
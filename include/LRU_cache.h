@@ -5,7 +5,8 @@
 template<typename Key, typename Value>
 class LRUCache {
 public:
-    explicit LRUCache(size_t maxSize) : maxSize(maxSize) {}
+    // maxWeight bounds the total weight of the entries as well (0 means no bound)
+    explicit LRUCache(size_t maxSize, size_t maxWeight = 0) : maxSize(maxSize), maxWeight(maxWeight) {}
 
     Value* get(const Key& key) {
         auto it = cacheMap.find(key);
@@ -14,35 +15,83 @@ public:
         }
         // Move the accessed item to the front of the list
         cacheList.splice(cacheList.begin(), cacheList, it->second);
-        return &(it->second->second);
+        return &(it->second->second.value);
     }
 
-    void put(const Key& key, Value value) {
+    // Inserts or replaces key; returns the number of entries evicted to make room
+    size_t put(const Key& key, Value value, size_t weight = 1) {
         auto it = cacheMap.find(key);
         if (it != cacheMap.end()) {
             // Key exists, move it to the front and update the value
             cacheList.splice(cacheList.begin(), cacheList, it->second);
-            it->second->second = std::move(value);
-            return;
+            totalWeight = totalWeight - it->second->second.weight + weight;
+            it->second->second = { std::move(value), weight };
+            return evict(1);
         }
-        if (cacheList.size() == maxSize) {
-            // Cache is full, remove the least recently used (LRU) element
-            auto last = cacheList.back();
-            cacheMap.erase(last.first);
-            cacheList.pop_back();
+        if (maxSize == 0) {
+            return 0;
         }
-        // Insert new key-value pair at the front
-        cacheList.emplace_front(key, std::move(value));
+        // Insert new key-value pair at the front, then drop the least recently used entries
+        cacheList.emplace_front(key, Entry{ std::move(value), weight });
         cacheMap[key] = cacheList.begin();
+        totalWeight += weight;
+        return evict(1);
+    }
+
+    // Removes every entry for which pred(key, value) is true; returns how many were removed
+    template<typename Pred>
+    size_t eraseIf(Pred pred) {
+        size_t erased = 0;
+        for (auto it = cacheList.begin(); it != cacheList.end();) {
+            if (pred(it->first, it->second.value)) {
+                totalWeight -= it->second.weight;
+                cacheMap.erase(it->first);
+                it = cacheList.erase(it);
+                ++erased;
+            } else {
+                ++it;
+            }
+        }
+        return erased;
+    }
+
+    // Changes the bounds, evicting entries that no longer fit; returns how many were evicted
+    size_t resize(size_t newMaxSize, size_t newMaxWeight = 0) {
+        maxSize = newMaxSize;
+        maxWeight = newMaxWeight;
+        return evict(0);
     }
 
     void clear() {
         cacheList.clear();
         cacheMap.clear();
+        totalWeight = 0;
     }
 
+    size_t size() const { return cacheList.size(); }
+    size_t weight() const { return totalWeight; }
+
 private:
+    struct Entry {
+        Value value;
+        size_t weight;
+    };
+
+    // Drops least recently used entries until the bounds hold, keeping at least `keep` entries
+    size_t evict(size_t keep) {
+        size_t evicted = 0;
+        while (cacheList.size() > keep && (cacheList.size() > maxSize || (maxWeight != 0 && totalWeight > maxWeight))) {
+            totalWeight -= cacheList.back().second.weight;
+            cacheMap.erase(cacheList.back().first);
+            cacheList.pop_back();
+            ++evicted;
+        }
+        return evicted;
+    }
+
     size_t maxSize;
-    std::list<std::pair<Key, Value>> cacheList; // Most recently used at the front
-    std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator> cacheMap;
+    size_t maxWeight;
+    size_t totalWeight = 0;
+    std::list<std::pair<Key, Entry>> cacheList; // Most recently used at the front
+    std::unordered_map<Key, typename std::list<std::pair<Key, Entry>>::iterator> cacheMap;
 };
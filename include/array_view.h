@@ -0,0 +1,79 @@
+#pragma once
+
+#include "pch.h"
+
+/**
+ * @class ArrayView
+ * @brief A strided, typed view of numbers in memory owned by someone else.
+ *
+ * Range evaluation reads its inputs from and writes its results to views, so it can work
+ * directly on caller buffers (e.g. NumPy arrays exposed through the buffer protocol) of
+ * float, double or long double elements. Values are converted to and from the precision of
+ * the evaluation one element at a time, exactly as a static_cast would, and the view never
+ * owns its memory.
+ */
+class ArrayView {
+public:
+    /// Element type of the viewed memory.
+    enum class Type { FLOAT32, FLOAT64, LONG_DOUBLE };
+
+    ArrayView() = default;
+
+    /**
+     * @brief Views \p size elements of type \p type starting at \p data, \p stride bytes apart.
+     */
+    ArrayView(void* data, size_t size, ptrdiff_t stride, Type type)
+        : bytes(static_cast<char*>(data)), count(size), step(stride), kind(type) {}
+
+    /**
+     * @brief Views the elements of \p values.
+     */
+    explicit ArrayView(const std::vector<NUMBER_TYPE>& values)
+        : ArrayView(const_cast<NUMBER_TYPE*>(values.data()), values.size(), sizeof(NUMBER_TYPE), typeOf<NUMBER_TYPE>()) {}
+
+    /// Number of elements.
+    size_t size() const { return count; }
+
+    /// Returns element \p i converted to NUMBER_TYPE.
+    NUMBER_TYPE operator[](size_t i) const { return get<NUMBER_TYPE>(i); }
+
+    /// Returns element \p i converted to \p T.
+    template <typename T>
+    T get(size_t i) const {
+        const char* p = bytes + static_cast<ptrdiff_t>(i) * step;
+        switch (kind) {
+            case Type::FLOAT32: return static_cast<T>(*reinterpret_cast<const float*>(p));
+            case Type::FLOAT64: return static_cast<T>(*reinterpret_cast<const double*>(p));
+            default: return static_cast<T>(*reinterpret_cast<const long double*>(p));
+        }
+    }
+
+    /// Stores \p value, converted to the element type, as element \p i.
+    template <typename T>
+    void set(size_t i, T value) const {
+        char* p = bytes + static_cast<ptrdiff_t>(i) * step;
+        switch (kind) {
+            case Type::FLOAT32: *reinterpret_cast<float*>(p) = static_cast<float>(value); break;
+            case Type::FLOAT64: *reinterpret_cast<double*>(p) = static_cast<double>(value); break;
+            default: *reinterpret_cast<long double*>(p) = static_cast<long double>(value); break;
+        }
+    }
+
+    /// The element type matching the C++ type \p T.
+    template <typename T>
+    static constexpr Type typeOf() {
+        if constexpr (std::is_same_v<T, float>) {
+            return Type::FLOAT32;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return Type::FLOAT64;
+        } else {
+            return Type::LONG_DOUBLE;
+        }
+    }
+
+private:
+    char* bytes = nullptr;          ///< First element.
+    size_t count = 0;               ///< Number of elements.
+    ptrdiff_t step = 0;             ///< Distance between elements, in bytes.
+    Type kind = Type::FLOAT64;      ///< Element type.
+};
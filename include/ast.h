@@ -6,40 +6,66 @@
 #include "token.h"
 #include "function.h"
 #include "symbol_table.h"
+#include "expression_graph.h"
 
 /**
  * @struct ASTNode
- * @brief A node in the abstract syntax tree (AST) built from a flattened postfix expression.
+ * @brief A node in the abstract syntax tree (AST), stored by value in its SyntaxTree.
  *
  * Each node holds:
- * - A Token (NUMBER, VARIABLE, OPERATOR, or FUNCTION).
- * - A list of children (for operators, typically 2 children; for a function, 'argCount' children).
- * 
- * Note: This uses raw pointers for children; you will need to manage memory (delete) manually.
+ * - Its kind (NUMBER, VARIABLE, OPERATOR, or FUNCTION) and, for a NUMBER, its value in binary.
+ * - The index of its first child and the number of children (for operators, 2; for a
+ *   function, 'argCount'). The children of a node are stored next to each other.
+ * - For a VARIABLE or FUNCTION, the index of its name in the tree's name table.
+ *
+ * A node may also carry a value slot: a node with \p slot set stores its value there when
+ * evaluated, and a (childless) node with \p reuse set stands for a repeated subtree and
+ * reads the stored value instead of recomputing it.
  */
 struct ASTNode
 {
-    Token token;                ///< The token for this node (e.g., {OPERATOR, "+"} or {VARIABLE, "x"}).
-    std::vector<ASTNode*> children;  ///< Child pointers. For binary operators, typically size=2. For a function, size=argCount.
+    NUMBER_TYPE value = 0;      ///< The value (NUMBER nodes only).
+    TokenType type = NUMBER;    ///< NUMBER, VARIABLE, OPERATOR or FUNCTION.
+    OperatorType op = OperatorType::UNKNOWN;  ///< The operator (OPERATOR nodes only).
+    uint32_t name = 0;          ///< Index of the variable or function name in SyntaxTree::name() (VARIABLE and FUNCTION nodes).
+    uint32_t first = 0;         ///< Index of the first child.
+    uint32_t count = 0;         ///< Number of children.
+    int32_t slot = -1;          ///< Value slot this node's value is stored in, or -1.
+    int32_t reuse = -1;         ///< Value slot this node reads instead of being evaluated, or -1.
+};
 
-    /**
-     * @brief Constructor that initializes the node with a Token.
-     * @param t The Token to store in this ASTNode.
-     */
-    explicit ASTNode(const Token &t) : token(t) {}
+/**
+ * @class SyntaxTree
+ * @brief An AST stored in one contiguous array of nodes, with the root at index 0.
+ *
+ * Nodes refer to their children by 32-bit index and numbers are kept in binary, so
+ * evaluating the tree walks one array and parses no strings. The node array is sized
+ * exactly when the tree is built, so building and destroying it costs a single
+ * allocation (plus the table of distinct variable and function names).
+ */
+class SyntaxTree {
+public:
+    /// The node at \p index (0 is the root).
+    const ASTNode& operator[](uint32_t index) const { return nodes[index]; }
 
-    /**
-     * @brief Destructor that deletes all children (recursively).
-     *
-     * Because we store raw pointers, we must ensure we clean them up
-     * to avoid memory leaks.
-     */
-    ~ASTNode()
-    {
-        for (ASTNode* child : children) {
-            delete child;
-        }
-    }
+    /// Number of nodes.
+    size_t size() const { return nodes.size(); }
+
+    /// The variable or function name of \p node.
+    const std::string& name(const ASTNode& node) const { return names[node.name]; }
+
+    /// Number of value slots the nodes store to and read from.
+    uint32_t slotCount() const { return slots; }
+
+    /// Estimated heap footprint of the tree in bytes.
+    size_t byteSize() const;
+
+private:
+    friend class SyntaxTreeBuilder;
+
+    std::vector<ASTNode> nodes;         ///< All nodes; the children of a node are contiguous.
+    std::vector<std::string> names;     ///< Distinct variable and function names.
+    uint32_t slots = 0;                 ///< Number of value slots.
 };
 
 
@@ -48,30 +74,46 @@ namespace AST {
     /**
      * @brief Builds an AST from a flattened postfix expression.
      *
-     * @param postfix   The flattened postfix tokens (no user-defined FUNCTION tokens remain).
-     * @param functions Map of function name to Function struct (for predefined functions).
-     * @return A pointer to the root ASTNode of the constructed tree. Caller is responsible for deleting it.
+     * @param postfix   The flattened postfix tokens.
+     * @param pool      The pool the tokens refer to.
+     * @param functions Map of function name to Function struct (user-defined functions are inlined).
+     * @return The constructed tree.
      * @throws SolverException if there's a mismatch in the stack usage, unknown function, etc.
      */
-    ASTNode* buildASTFromPostfix(const std::vector<Token> &postfix, const std::unordered_map<std::string, Function> &functions);
+    SyntaxTree buildASTFromPostfix(const std::vector<Token> &postfix, const TokenPool &pool, const std::unordered_map<std::string, Function> &functions);
+
+    /**
+     * @brief Builds an AST from the expression under \p root in \p graph.
+     *
+     * A node of the graph used in several places (e.g. an argument inlined into every use
+     * of a parameter) is built in full at its first use in evaluation order, which gets a
+     * value slot; its later uses become leaves reading that slot. The AST therefore has one
+     * node per graph node plus one leaf per additional use, and each subexpression is
+     * evaluated once.
+     *
+     * @param graph The expression graph (user functions inlined, usually simplified).
+     * @param root  Root of the expression.
+     * @return The constructed tree.
+     */
+    SyntaxTree buildASTFromGraph(const ExpressionGraph& graph, NodeId root);
 
     /**
      * @brief Public-facing function to pretty-print the AST from its root.
-     * 
-     * @param root Pointer to the root ASTNode of the tree.
+     *
+     * @param tree The tree to print.
      */
-    void printAST(const ASTNode* root);
+    void printAST(const SyntaxTree& tree);
 
     /**
      * @brief Recursively evaluates a simplified AST.
      *
-     * @param node         Pointer to the root AST node (must not be null).
+     * @param tree         The tree to evaluate.
      * @param symbolTable  The symbol table for looking up variables.
      * @param functions    Map of predefined functions (for FUNCTION nodes).
      * @return The numeric result of evaluating the AST.
-     * @throws SolverException If an unknown operator or function is encountered, 
+     * @throws SolverException If an unknown operator or function is encountered,
      *         or if division by zero occurs, etc.
      */
-    NUMBER_TYPE evaluateAST(const ASTNode* node, const SymbolTable& symbolTable, const std::unordered_map<std::string, Function>& functions);
+    NUMBER_TYPE evaluateAST(const SyntaxTree& tree, const SymbolTable& symbolTable, const std::unordered_map<std::string, Function>& functions);
 
 }
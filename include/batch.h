@@ -0,0 +1,73 @@
+#pragma once
+
+#include "pch.h"
+#include "program.h"
+
+/**
+ * @class BatchProgram
+ * @brief Columnar evaluator that runs a Program over a block of inputs at a time, in the precision \p T.
+ *
+ * Every register of the program becomes a column of lanes() values, and each instruction
+ * is executed once per block as a tight loop over its columns. The loops for + - * / and
+ * pow are plain element-wise loops the compiler can vectorize, and built-in functions are
+ * dispatched once per block instead of once per element. Constant and declared-variable
+ * columns are filled by load() and only the range variables are rewritten per block.
+ *
+ * Results are bit-identical to running Program::run<T>() once per lane. Columns of
+ * doubles and floats are what lets the element-wise loops vectorize. Lanes that fail
+ * (division by zero, or a callback throwing SolverException) are reported by errors() with
+ * the message the scalar evaluation would have raised.
+ */
+template <typename T>
+class BatchProgram {
+public:
+    /// Default number of lanes per block.
+    static constexpr size_t DEFAULT_LANES = 256;
+
+    /**
+     * @brief Prepares a columnar copy of \p program.
+     *
+     * @param program The compiled program.
+     * @param lanes Number of inputs evaluated per block (must be at least 1).
+     */
+    explicit BatchProgram(const Program& program, size_t lanes = DEFAULT_LANES);
+
+    /// Number of inputs evaluated per block.
+    size_t lanes() const { return laneCount; }
+
+    /**
+     * @brief Broadcasts the constant and variable registers of \p registers into their columns.
+     *
+     * @param registers A register file prepared as for Program::run<T>().
+     */
+    void load(const T* registers);
+
+    /**
+     * @brief Returns the column of register \p reg, for the caller to fill with per-lane inputs.
+     */
+    T* column(uint32_t reg) { return &columns[static_cast<size_t>(reg) * laneCount]; }
+
+    /**
+     * @brief Runs the program over the first \p count lanes.
+     *
+     * @param count Number of lanes to evaluate (at most lanes()).
+     * @return The result column; lanes listed in errors() hold unspecified values.
+     * @throws Any exception other than SolverException raised by a callback.
+     */
+    const T* run(size_t count);
+
+    /**
+     * @brief The lanes of the last run() that failed, in lane order, with their error message.
+     */
+    const std::vector<std::pair<size_t, std::string>>& errors() const { return failures; }
+
+private:
+    void fail(size_t lane, const std::string& message);
+    void call(const Instruction& ins, size_t count);
+
+    Program program;                                        ///< The program being evaluated.
+    size_t laneCount;                                       ///< Lanes per block.
+    std::vector<T> columns;                                 ///< registerCount() columns of laneCount values.
+    std::vector<uint8_t> failed;                            ///< Per-lane failure flag for the current run.
+    std::vector<std::pair<size_t, std::string>> failures;   ///< Failed lanes of the last run.
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "pch.h"
+#include "program.h"
+#include "native_code.h"
+
+/**
+ * @class CProgram
+ * @brief A Program compiled to native code through an emitted C translation unit, for the precision \p T.
+ *
+ * The program is printed as a single C function over the register file, built into a shared
+ * object with the system C compiler (\c $CC, or \c cc) and loaded with dlopen(). Shared
+ * objects are cached on disk, keyed by a hash of the generated source, the compiler and its
+ * flags, so a restarted process reuses the objects it already built. The cache lives in
+ * \c $SOLVER_CACHE_DIR, or \c solver under \c $XDG_CACHE_HOME or \c ~/.cache.
+ *
+ * Floating point contraction is disabled, so results are bit-identical to Program::run<T>().
+ */
+template <typename T>
+class CProgram : public TypedNativeCode<T> {
+public:
+    /**
+     * @brief Returns true if the platform can load shared objects at run time.
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Compiles \p program (or loads it from the on-disk cache).
+     *
+     * @throws SolverException If the compiler fails or the shared object cannot be loaded.
+     */
+    explicit CProgram(const Program& program);
+
+    /**
+     * @brief Unloads the shared object.
+     */
+    ~CProgram() override;
+
+    CProgram(const CProgram&) = delete;
+    CProgram& operator=(const CProgram&) = delete;
+
+    T run(T* registers) const override;
+
+    /**
+     * @brief Returns the C translation unit generated for \p program.
+     */
+    static std::string emitSource(const Program& program);
+
+    /**
+     * @brief Returns the directory compiled objects are cached in.
+     */
+    static std::string cacheDirectory();
+
+    /// Path of the loaded shared object.
+    const std::string& libraryPath() const { return path; }
+
+    /// True if the shared object was found in the cache rather than compiled.
+    bool loadedFromCache() const { return cached; }
+
+private:
+    using Invoke = int (*)(const void*, const T*, uint32_t, T*);
+    using EntryPoint = int (*)(T*, const void* const*, Invoke);
+
+    std::vector<FunctionCallback> callbacks;    ///< Callbacks referenced by the generated code.
+    std::vector<const void*> callbackTable;     ///< Pointers to callbacks, passed to the generated code.
+    void* handle = nullptr;                     ///< dlopen() handle.
+    EntryPoint entry = nullptr;                 ///< The generated function.
+    uint32_t result = 0;                        ///< Result register.
+    std::string path;                           ///< Path of the shared object.
+    bool cached = false;                        ///< Whether the object came from the cache.
+};
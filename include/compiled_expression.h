@@ -0,0 +1,89 @@
+#pragma once
+
+#include "pch.h"
+#include "program.h"
+#include "engine.h"
+#include "precision.h"
+#include "native_code.h"
+
+/**
+ * @class CompiledExpression
+ * @brief An immutable, self-contained compiled expression returned by Solver::compile().
+ *
+ * The handle owns its program (with the constants and functions of the solver folded in
+ * at compile time) and, for Engine::JIT and Engine::C, its native code. It keeps no
+ * reference to the solver, so it stays valid and unchanged after later declarations and
+ * after the solver is destroyed.
+ *
+ * Variables are not read from a symbol table: every call supplies the values of the
+ * variables listed by variables(). Each call evaluates on a register file of its own, so
+ * a single handle can be evaluated from many threads at once.
+ */
+class CompiledExpression {
+public:
+    /// The source expression.
+    const std::string& expression() const { return source; }
+
+    /// Names of the variables the expression reads, in the order evaluate() expects their values.
+    const std::vector<std::string>& variables() const { return compiled.variableNames(); }
+
+    /// The execution tier the expression was compiled for.
+    Engine engine() const { return tier; }
+
+    /// The precision the expression is executed in.
+    Precision precision() const { return scalar; }
+
+    /// The compiled program.
+    const Program& program() const { return compiled; }
+
+    /// Number of instructions executed per evaluation.
+    size_t instructionCount() const { return compiled.instructions().size(); }
+
+    /// Number of those instructions that are fused multiply-adds (see Solver::setFusedMultiplyAdd()).
+    size_t fusedMultiplyAddCount() const {
+        return std::count_if(compiled.instructions().begin(), compiled.instructions().end(),
+                             [](const Instruction& ins) { return ins.op == OpCode::FMA; });
+    }
+
+    /**
+     * @brief Evaluates the expression with the given variable values.
+     *
+     * @param values One value per entry of variables(), in the same order.
+     * @return The value of the expression.
+     * @throws SolverException If the number of values is wrong, or on a runtime error (e.g. division by zero).
+     */
+    NUMBER_TYPE evaluate(const std::vector<NUMBER_TYPE>& values) const;
+
+    /// Same as evaluate(const std::vector<NUMBER_TYPE>&), for braced lists of values.
+    NUMBER_TYPE evaluate(std::initializer_list<NUMBER_TYPE> values) const {
+        return evaluate(std::vector<NUMBER_TYPE>(values));
+    }
+
+    /**
+     * @brief Evaluates the expression with variable values looked up by name.
+     *
+     * Names the expression does not read are ignored, so e.g. Solver::listVariables() can
+     * be passed as is.
+     *
+     * @param values Value of each variable, by name.
+     * @return The value of the expression.
+     * @throws SolverException If a variable of the expression is missing, or on a runtime error.
+     */
+    NUMBER_TYPE evaluate(const std::unordered_map<std::string, NUMBER_TYPE>& values) const;
+
+private:
+    friend class Solver;
+
+    CompiledExpression(std::string expression, Program program, Engine engine, Precision precision,
+                       std::shared_ptr<const NativeCode> native);
+
+    /// Runs the program in precision \p T with variables() bound to \p values.
+    template <typename T>
+    T run(const NUMBER_TYPE* values) const;
+
+    std::string source;                         ///< The source expression.
+    Program compiled;                           ///< The compiled program.
+    Engine tier;                                ///< Engine the expression was compiled for.
+    Precision scalar;                           ///< Precision the program runs in.
+    std::shared_ptr<const NativeCode> native;   ///< Native code for compiled (nullptr for the interpreter).
+};
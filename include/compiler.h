@@ -3,7 +3,35 @@
 #include "pch.h"
 #include "token.h"
 #include "function.h"
+#include "program.h"
+#include "expression_graph.h"
 #include "exception.h"         // Defines SolverException
 
 
-EvalFunc compilePostfix(const std::vector<Token>& tokens, const std::unordered_map<std::string, Function>& functions);
+/**
+ * @brief Compiles the expression under \p root in \p graph into a register-based bytecode Program.
+ *
+ * Constants and variables are assigned fixed registers and every reachable operator and
+ * function node becomes one instruction, so a subexpression shared by several parents is
+ * computed once. The resulting program is verified before it is returned.
+ *
+ * @param graph     The expression graph (user functions inlined, usually simplified).
+ * @param root      Root of the expression.
+ * @param functions Map of function name to Function (for predefined function callbacks).
+ * @return The compiled program.
+ * @throws SolverException If the graph references an unknown function or one without a callback.
+ */
+Program compileGraph(const ExpressionGraph& graph, NodeId root, const std::unordered_map<std::string, Function>& functions);
+
+/**
+ * @brief Compiles a flattened postfix expression into a register-based bytecode Program.
+ *
+ * The tokens are added to an ExpressionGraph and compiled with compileGraph().
+ *
+ * @param tokens    The flattened (and usually simplified) postfix tokens.
+ * @param pool      The pool the tokens refer to.
+ * @param functions Map of function name to Function (for predefined function callbacks).
+ * @return The compiled program.
+ * @throws SolverException If the postfix is malformed or references an unknown function.
+ */
+Program compilePostfix(const std::vector<Token>& tokens, const TokenPool& pool, const std::unordered_map<std::string, Function>& functions);
@@ -2,6 +2,7 @@
 
 #include "pch.h"
 #include "token.h"
+#include "token_pool.h"
 #include "function.h"
 #include "exception.h"
 
@@ -14,17 +15,17 @@
 #define CYAN "\033[36m"
 
 
-inline std::string postfixToInfix(const std::vector<Token>& tokens, const std::unordered_map<std::string, Function>& functions) {
+inline std::string postfixToInfix(const std::vector<Token>& tokens, const TokenPool& pool, const std::unordered_map<std::string, Function>& functions) {
     std::stack<std::string> stack;
 
     for (const auto& token : tokens) {
         if (token.type == TokenType::NUMBER || token.type == TokenType::VARIABLE) {
             // Push numbers or variables directly onto the stack
-            stack.push(token.value);
+            stack.push(pool.text(token));
         } else if (token.type == TokenType::OPERATOR) {
             // Pop the top two elements for binary operators
             if (stack.size() < 2) {
-                throw SolverException("Invalid postfix expression: insufficient operands for operator '" + token.value + "'");
+                throw SolverException("Invalid postfix expression: insufficient operands for operator '" + pool.name(token.id) + "'");
             }
             std::string right = stack.top();
             stack.pop();
@@ -32,19 +33,20 @@ inline std::string postfixToInfix(const std::vector<Token>& tokens, const std::u
             stack.pop();
 
             // Combine into an infix expression and push back
-            std::string infix = "(" + left + " " + token.value + " " + right + ")";
+            std::string infix = "(" + left + " " + pool.name(token.id) + " " + right + ")";
             stack.push(infix);
         } else if (token.type == TokenType::FUNCTION) {
             // Retrieve the function definition
-            auto it = functions.find(token.value);
+            const std::string& name = pool.name(token.id);
+            auto it = functions.find(name);
             if (it == functions.end()) {
-                throw SolverException("Unknown function: '" + token.value + "'");
+                throw SolverException("Unknown function: '" + name + "'");
             }
             const Function& function = it->second;
 
             // Ensure sufficient arguments are available
             if (stack.size() < function.argCount) {
-                throw SolverException("Invalid postfix expression: insufficient arguments for function '" + token.value + "'");
+                throw SolverException("Invalid postfix expression: insufficient arguments for function '" + name + "'");
             }
 
             // Pop arguments from the stack in reverse order
@@ -55,7 +57,7 @@ inline std::string postfixToInfix(const std::vector<Token>& tokens, const std::u
             }
 
             // Build the function call representation
-            std::string functionCall = token.value + "(";
+            std::string functionCall = name + "(";
             for (size_t i = 0; i < args.size(); ++i) {
                 functionCall += args[i];
                 if (i < args.size() - 1) {
@@ -75,9 +77,9 @@ inline std::string postfixToInfix(const std::vector<Token>& tokens, const std::u
     return stack.top();
 }
 
-inline void printInfix(const std::vector<Token>& tokens, const std::unordered_map<std::string, Function>& functions) {
+inline void printInfix(const std::vector<Token>& tokens, const TokenPool& pool, const std::unordered_map<std::string, Function>& functions) {
     try {
-        std::string infix = postfixToInfix(tokens, functions);
+        std::string infix = postfixToInfix(tokens, pool, functions);
         std::cout << infix << std::endl;
     } catch (const SolverException& e) {
         std::cerr << "Error converting postfix to infix: " << e.what() << std::endl;
@@ -97,11 +99,11 @@ inline std::string tokenTypeToString(TokenType type) {
     }
 }
 
-inline void printTokens(const std::vector<Token>& tokens) {
+inline void printTokens(const std::vector<Token>& tokens, const TokenPool& pool) {
     std::cout << "[";
     for (size_t i = 0; i < tokens.size(); ++i) {
         const Token& token = tokens[i];
-        std::cout << "{Type: " << tokenTypeToString(token.type) << ", Value: \"" << token.value << "\"}";
+        std::cout << "{Type: " << tokenTypeToString(token.type) << ", Value: \"" << pool.text(token) << "\"}";
         if (i != tokens.size() - 1) {
             std::cout << ", ";
         }
@@ -109,9 +111,9 @@ inline void printTokens(const std::vector<Token>& tokens) {
     std::cout << "]" << std::endl;
 }
 
-inline void printPostfix(const std::vector<Token>& tokens) {
+inline void printPostfix(const std::vector<Token>& tokens, const TokenPool& pool) {
     for (size_t i = 0; i < tokens.size(); ++i) {
-        std::cout << tokens[i].value;
+        std::cout << pool.text(tokens[i]);
         if (i != tokens.size() - 1) {
             std::cout << " ";
         }
@@ -24,40 +24,66 @@
 
 
 static const char *__doc_ASTNode =
-R"doc(A node in the abstract syntax tree (AST) built from a flattened postfix
-expression.
+R"doc(A node in the abstract syntax tree (AST), stored by value in its SyntaxTree.
 
-Each node holds: - A Token (NUMBER, VARIABLE, OPERATOR, or FUNCTION). - A list
-of children (for operators, typically 2 children; for a function, 'argCount'
-children).
+Each node holds: - Its kind (NUMBER, VARIABLE, OPERATOR, or FUNCTION) and, for a
+NUMBER, its value in binary. - The index of its first child and the number of
+children (for operators, 2; for a function, 'argCount'). The children of a node
+are stored next to each other. - For a VARIABLE or FUNCTION, the index of its
+name in the tree's name table.
 
-Note: This uses raw pointers for children; you will need to manage memory
-(delete) manually.)doc";
+A node may also carry a value slot: a node with ``slot`` set stores its value
+there when evaluated, and a (childless) node with ``reuse`` set stands for a
+repeated subtree and reads the stored value instead of recomputing it.)doc";
 
-static const char *__doc_ASTNode_ASTNode =
-R"doc(Constructor that initializes the node with a Token.
+static const char *__doc_ASTNode_count = R"doc(Number of children.)doc";
 
-Parameter ``t``:
-    The Token to store in this ASTNode.)doc";
+static const char *__doc_ASTNode_first = R"doc(Index of the first child.)doc";
 
-static const char *__doc_ASTNode_children =
-R"doc(Child pointers. For binary operators, typically size=2. For a function,
-size=argCount.)doc";
+static const char *__doc_ASTNode_name =
+R"doc(Index of the variable or function name in SyntaxTree::name() (VARIABLE and
+FUNCTION nodes).)doc";
 
-static const char *__doc_ASTNode_token = R"doc(The token for this node (e.g., {OPERATOR, "+"} or {VARIABLE, "x"}).)doc";
+static const char *__doc_ASTNode_op = R"doc(The operator (OPERATOR nodes only).)doc";
+
+static const char *__doc_ASTNode_reuse = R"doc(Value slot this node reads instead of being evaluated, or -1.)doc";
+
+static const char *__doc_ASTNode_slot = R"doc(Value slot this node's value is stored in, or -1.)doc";
+
+static const char *__doc_ASTNode_type = R"doc(NUMBER, VARIABLE, OPERATOR or FUNCTION.)doc";
+
+static const char *__doc_ASTNode_value = R"doc(The value (NUMBER nodes only).)doc";
+
+static const char *__doc_AST_buildASTFromGraph =
+R"doc(Builds an AST from the expression under ``root`` in ``graph``.
+
+A node of the graph used in several places (e.g. an argument inlined into every
+use of a parameter) is built in full at its first use in evaluation order, which
+gets a value slot; its later uses become leaves reading that slot. The AST
+therefore has one node per graph node plus one leaf per additional use, and each
+subexpression is evaluated once.
+
+Parameter ``graph``:
+    The expression graph (user functions inlined, usually simplified).
+
+Parameter ``root``:
+    Root of the expression.
+
+Returns:
+    The constructed tree.)doc";
 
 static const char *__doc_AST_buildASTFromPostfix =
 R"doc(Builds an AST from a flattened postfix expression.
 
 Parameter ``postfix``:
-    The flattened postfix tokens (no user-defined FUNCTION tokens remain).
+    The flattened postfix tokens.
 
 Parameter ``functions``:
-    Map of function name to Function struct (for predefined functions).
+    Map of function name to Function struct (user-defined functions are
+    inlined).
 
 Returns:
-    A pointer to the root ASTNode of the constructed tree. Caller is responsible
-    for deleting it.
+    The constructed tree.
 
 Throws:
     SolverException if there's a mismatch in the stack usage, unknown function,
@@ -66,8 +92,8 @@ Throws:
 static const char *__doc_AST_evaluateAST =
 R"doc(Recursively evaluates a simplified AST.
 
-Parameter ``node``:
-    Pointer to the root AST node (must not be null).
+Parameter ``tree``:
+    The tree to evaluate.
 
 Parameter ``symbolTable``:
     The symbol table for looking up variables.
@@ -85,28 +111,72 @@ Throws:
 static const char *__doc_AST_printAST =
 R"doc(Public-facing function to pretty-print the AST from its root.
 
-Parameter ``root``:
-    Pointer to the root ASTNode of the tree.)doc";
+Parameter ``tree``:
+    The tree to print.)doc";
 
-static const char *__doc_AddZeroRule = R"doc()doc";
+static const char *__doc_CompiledExpression =
+R"doc(An immutable, self-contained compiled expression returned by
+Solver::compile().
 
-static const char *__doc_AddZeroRule_apply = R"doc()doc";
+The handle owns its program (with the constants and functions of the solver
+folded in at compile time) and, for Engine::JIT and Engine::C, its native code.
+It keeps no reference to the solver, so it stays valid and unchanged after later
+declarations and after the solver is destroyed.
 
-static const char *__doc_AssociativeAddRule = R"doc()doc";
+Variables are not read from a symbol table: every call supplies the values of
+the variables listed by variables(). Each call evaluates on a register file of
+its own, so a single handle can be evaluated from many threads at once.)doc";
 
-static const char *__doc_AssociativeAddRule_apply = R"doc()doc";
+static const char *__doc_CompiledExpression_engine = R"doc(The execution tier the expression was compiled for.)doc";
 
-static const char *__doc_AssociativeMultRule = R"doc()doc";
+static const char *__doc_CompiledExpression_evaluate =
+R"doc(Evaluates the expression with the given variable values.
 
-static const char *__doc_AssociativeMultRule_apply = R"doc()doc";
+The GIL is released while the expression is evaluated.
 
-static const char *__doc_ConstantFoldingRule = R"doc()doc";
+Parameter ``values``:
+    One value per entry of variables(), in the same order.
 
-static const char *__doc_ConstantFoldingRule_apply = R"doc()doc";
+Returns:
+    The value of the expression.
+
+Throws:
+    SolverException If the number of values is wrong, or on a runtime error
+    (e.g. division by zero).)doc";
+
+static const char *__doc_CompiledExpression_evaluate_2 =
+R"doc(Evaluates the expression with variable values looked up by name.
 
-static const char *__doc_DivOneRule = R"doc()doc";
+Names the expression does not read are ignored, so e.g. Solver::listVariables()
+can be passed as is.
+
+Parameter ``values``:
+    Value of each variable, by name.
+
+Returns:
+    The value of the expression.
+
+Throws:
+    SolverException If a variable of the expression is missing, or on a runtime
+    error.)doc";
 
-static const char *__doc_DivOneRule_apply = R"doc()doc";
+static const char *__doc_CompiledExpression_expression = R"doc(The source expression.)doc";
+
+static const char *__doc_CompiledExpression_fusedMultiplyAddCount =
+R"doc(Number of those instructions that are fused multiply-adds (see
+Solver::setFusedMultiplyAdd()).)doc";
+
+static const char *__doc_CompiledExpression_instructionCount = R"doc(Number of instructions executed per evaluation.)doc";
+
+static const char *__doc_CompiledExpression_precision = R"doc(The precision the expression is executed in.)doc";
+
+static const char *__doc_CompiledExpression_variables =
+R"doc(Names of the variables the expression reads, in the order evaluate() expects
+their values.)doc";
+
+static const char *__doc_ConstantFoldingRule = R"doc()doc";
+
+static const char *__doc_ConstantFoldingRule_apply = R"doc()doc";
 
 static const char *__doc_Function = R"doc()doc";
 
@@ -128,9 +198,11 @@ static const char *__doc_Function_argCount = R"doc()doc";
 
 static const char *__doc_Function_argumentNames = R"doc()doc";
 
-static const char *__doc_Function_callback = R"doc()doc";
+static const char *__doc_Function_body = R"doc()doc";
 
-static const char *__doc_Function_inlinedPostfix = R"doc()doc";
+static const char *__doc_Function_bodyRoot = R"doc()doc";
+
+static const char *__doc_Function_callback = R"doc()doc";
 
 static const char *__doc_Function_isPredefined = R"doc()doc";
 
@@ -150,13 +222,9 @@ static const char *__doc_LRUCache_maxSize = R"doc()doc";
 
 static const char *__doc_LRUCache_put = R"doc()doc";
 
-static const char *__doc_MultOneRule = R"doc()doc";
-
-static const char *__doc_MultOneRule_apply = R"doc()doc";
+static const char *__doc_NumberHash = R"doc(Hash of a number consistent with SameNumber.)doc";
 
-static const char *__doc_MultZeroRule = R"doc()doc";
-
-static const char *__doc_MultZeroRule_apply = R"doc()doc";
+static const char *__doc_NumberHash_operator_call = R"doc()doc";
 
 static const char *__doc_OperatorType = R"doc()doc";
 
@@ -195,7 +263,7 @@ static const char *__doc_Postfix_getPrecedence =
 R"doc(Retrieves the precedence level of a given operator.
 
 Parameter ``op``:
-    The operator as a string.
+    The operator.
 
 Returns:
     Integer representing the precedence level.)doc";
@@ -233,7 +301,7 @@ static const char *__doc_Postfix_isLeftAssociative =
 R"doc(Determines if an operator is left-associative.
 
 Parameter ``op``:
-    The operator as a string.
+    The operator.
 
 Returns:
     True if the operator is left-associative, false otherwise.)doc";
@@ -322,6 +390,11 @@ static const char *__doc_Profiler_Utils_CleanedString_data = R"doc()doc";
 
 static const char *__doc_Profiler_Utils_cleanup_output_string = R"doc()doc";
 
+static const char *__doc_SameNumber =
+R"doc(Number equality that tells -0 from 0 and treats NaN as equal to itself.)doc";
+
+static const char *__doc_SameNumber_operator_call = R"doc()doc";
+
 static const char *__doc_SimplificationEngine = R"doc()doc";
 
 static const char *__doc_SimplificationEngine_add_rule = R"doc(Add a new simplification rule.)doc";
@@ -329,23 +402,21 @@ static const char *__doc_SimplificationEngine_add_rule = R"doc(Add a new simplif
 static const char *__doc_SimplificationEngine_simplify =
 R"doc(Simplify the full postfix token sequence.
 
-This function repeatedly applies all simplification rules on every sub-
-expression (by “rebuilding” the expression via a stack) until no rule makes any
-further change or a maximum number of passes is reached.
+The expression is simplified as an ExpressionGraph (see the overload below) and
+expanded back to postfix.
 
 Parameter ``input``:
     The original postfix token vector.
 
+Parameter ``pool``:
+    The pool the tokens refer to.
+
 Parameter ``functions``:
     A table of functions (needed for function rules).
 
 Returns:
     The fully simplified postfix token vector.)doc";
 
-static const char *__doc_SimplificationEngine_simplifyPass =
-R"doc(A single pass that traverses the full expression and applies rules where
-possible.)doc";
-
 static const char *__doc_SimplificationRule = R"doc()doc";
 
 static const char *__doc_SimplificationRule_apply =
@@ -357,77 +428,26 @@ Parameter ``input``:
 Parameter ``output``:
     The simplified tokens if the rule applies.
 
+Parameter ``pool``:
+    The pool the tokens refer to; new numbers are added to it.
+
 Returns:
     true if the rule was applied; false otherwise.)doc";
 
-static const char *__doc_Simplification_replaceConstantSymbols =
-R"doc(Replaces tokens that refer to constants with NUMBER tokens in a postfix
-sequence.
-
-If a token is of type VARIABLE but the symbol table indicates it is actually a
-constant, we convert that token’s type to NUMBER and set its value to the
-constant’s numeric string.
+static const char *__doc_Simplification_simplifyPostfix =
+R"doc(Simplifies a postfix expression with the solver's rule set.
 
 Parameter ``postfix``:
-    The flattened postfix tokens (after flattenPostfix).
-
-Parameter ``symbolTable``:
-    The symbol table (holds variables and constants).
-
-Returns:
-    A new vector of tokens where any constant references have been inlined as
-    numbers.)doc";
-
-static const char *__doc_Simplification_simplifyAST =
-R"doc(Recursively simplifies the AST in place, applying constant folding and basic
-algebraic identities.
+    The postfix tokens.
 
-Parameter ``node``:
-    The current AST node to simplify (may be modified in place).
+Parameter ``pool``:
+    The pool the tokens refer to; folded numbers are added to it.
 
 Parameter ``functions``:
-    A map of predefined functions (for function folding).
+    The map of function names to Function definitions.
 
 Returns:
-    The (possibly replaced) pointer to the simplified AST node. If a node is
-    replaced, the old pointer is deleted.)doc";
-
-static const char *__doc_Simplification_simplifyPostfix = R"doc()doc";
-
-static const char *__doc_Simplification_singlePassSimplify =
-R"doc(Performs a single pass of local folding/simplification on a fully flattened
-postfix expression.
-
-Parameter ``postfix``:
-    The input postfix tokens (flattened).
-
-Parameter ``functions``:
-    The map of function names to Function definitions (for predefined funcs).
-
-Parameter ``changed``:
-    Set to true if any folding/simplification occurred during this pass, false
-    otherwise.
-
-Returns:
-    A (possibly) simplified postfix sequence after one pass.)doc";
-
-static const char *__doc_Simplification_trySimplifyBinary =
-R"doc(Attempts to simplify a binary operation (leftExpr op rightExpr) using local
-rules.
-
-Parameter ``leftExpr``:
-    Postfix tokens for the left operand (often a single token).
-
-Parameter ``rightExpr``:
-    Postfix tokens for the right operand (often a single token).
-
-Parameter ``opToken``:
-    The operator token (e.g. +, -, *, /, ^).
-
-Returns:
-    A new postfix token vector that represents the simplified expression.)doc";
-
-static const char *__doc_Simplification_trySimplifyFunction = R"doc()doc";
+    The simplified postfix tokens.)doc";
 
 static const char *__doc_Solver =
 R"doc(A class for evaluating mathematical expressions, managing variables, constants,
@@ -464,7 +484,7 @@ Parameter ``exprCacheSize``:
 static const char *__doc_Solver_cacheEnabled = R"doc(Flag indicating whether expression caching is currently active.)doc";
 
 static const char *__doc_Solver_clearCache =
-R"doc(Clears the solver's expression cache and function cache (if any).
+R"doc(Clears the solver's expression cache and program cache.
 
 This is a direct way to force the solver to discard all cached results. After
 calling, the next evaluations will re-parse and re-compute the expression
@@ -478,6 +498,31 @@ static const char *__doc_Solver_currentExpressionPostfix = R"doc(The most recent
 
 static const char *__doc_Solver_currentPostfix = R"doc(The parsed (and flattened) postfix tokens corresponding to currentExpression.)doc";
 
+static const char *__doc_Solver_compile =
+R"doc(Compiles an expression into a reusable, thread-safe CompiledExpression.
+
+The expression is parsed, simplified and compiled once, with the constants and
+functions declared so far; native code is generated up front for Engine::JIT and
+Engine::C. The returned handle does not depend on the solver: later declarations
+do not affect it, and it can be evaluated concurrently with caller-supplied
+variable values while the solver keeps evaluating other expressions.
+
+Parameter ``expression``:
+    The mathematical expression to compile (e.g. "x^2 + y").
+
+Parameter ``engine``:
+    The execution tier to compile for; defaults to the one selected with
+    setEngine().
+
+Parameter ``precision``:
+    The precision to run in; defaults to the one selected with setPrecision().
+
+Returns:
+    The compiled expression.
+
+Throws:
+    SolverException If the expression cannot be parsed or compiled.)doc";
+
 static const char *__doc_Solver_declareConstant =
 R"doc(Declares a constant in the symbol table.
 
@@ -531,8 +576,11 @@ R"doc(Evaluates a mathematical expression and returns its numeric result.
 
 - Internally, this calls setCurrentExpression() which parses the expression (or
 uses a cached parse if unchanged). - Then it checks the cache (if enabled) to
-see if the expression result is already stored. - If not in cache, it evaluates
-the expression in postfix form and stores the result if caching is on.
+see if the expression result is already stored. - If not in cache, it runs the
+compiled program on ``engine`` (or the solver's engine) and stores the result if
+caching is on. - With tiering (see setTiering()), the call is counted (even when
+its result comes from the cache) and may promote the expression to a higher
+tier.
 
 Parameter ``expression``:
     A string representing the mathematical expression to evaluate (e.g. "3 + 4 *
@@ -542,6 +590,15 @@ Parameter ``debug``:
     If true, prints debugging information such as the final postfix
     representation.
 
+Parameter ``engine``:
+    The execution tier to use for this call; defaults to the one selected with
+    setEngine(), or to the engine of the expression's Tier if that is the
+    interpreter and it is tiered.
+
+Parameter ``precision``:
+    The precision to run the program in ("float", "double" or "long double");
+    defaults to the one selected with setPrecision().
+
 Returns:
     The computed value of the expression.
 
@@ -577,6 +634,11 @@ This method is similar to evaluate(), but it iterates over the provided vector
 is set in the symbol table, and the same parsed/postfix expression is evaluated.
 This allows efficient bulk evaluation.
 
+One-dimensional float32, float64 and long double arrays (anything supporting the
+buffer protocol) are read in place, and the results are then returned as a new
+float64 ndarray, or written into ``out`` if given. Lists are converted and a list
+is returned. The GIL is released for the whole evaluation.
+
 Parameter ``variable``:
     The name of the variable to iterate (e.g. "x").
 
@@ -590,6 +652,18 @@ Parameter ``debug``:
     If true, prints debug info for the parsing phase (once) and indicates
     evaluations in a loop.
 
+Parameter ``threads``:
+    Number of worker threads (0 uses the hardware concurrency). Results do not
+    depend on it.
+
+Parameter ``out``:
+    Optional writable float32, float64 or long double array of ``len(values)``
+    elements to write the results into. It is returned.
+
+Parameter ``precision``:
+    The precision to run the program in; defaults to the one selected with
+    setPrecision().
+
 Returns:
     A vector of computed results, with one result per value in ``values.``
 
@@ -609,6 +683,15 @@ output vector.
 The result vector is returned in row-major order with respect to the input
 vectors in ``valuesSets,`` i.e., the last variable varies fastest.
 
+The flat index space of the product is split into contiguous slices, one per
+thread, and each thread writes its slice of the result vector with its own
+evaluation state, so the results are bit-identical to a single-threaded
+evaluation.
+
+Ranges given as arrays are read in place and the results are returned as a flat
+float64 ndarray, or written into ``out`` if given; lists are converted and a list
+is returned. The GIL is released for the whole evaluation.
+
 Parameter ``variables``:
     A list of variable names, e.g., ["x", "y"].
 
@@ -622,6 +705,19 @@ Parameter ``expression``:
 Parameter ``debug``:
     If true, prints debug info for parsing; does NOT print each evaluation.
 
+Parameter ``threads``:
+    Number of worker threads (0 uses the hardware concurrency). Results do not
+    depend on it.
+
+Parameter ``out``:
+    Optional writable float32, float64 or long double array with one element
+    per combination, one-dimensional or C-contiguous (e.g. shaped like the
+    grid). It is returned.
+
+Parameter ``precision``:
+    The precision to run the program in; defaults to the one selected with
+    setPrecision().
+
 Returns:
     A flat vector of results (size = product of the lengths of each range in
     ``valuesSets).``
@@ -651,6 +747,8 @@ Parameter ``args``:
 Returns:
     A std::size_t representing a unique hash key.)doc";
 
+static const char *__doc_Solver_getBatchSize = R"doc(Returns the number of inputs Engine::BATCH evaluates per block.)doc";
+
 static const char *__doc_Solver_getCurrentExpression =
 R"doc(Retrieves the most recently set expression string.
 
@@ -659,6 +757,38 @@ This is simply the raw expression as last passed to setCurrentExpression().
 Returns:
     The current expression string.)doc";
 
+static const char *__doc_Solver_getEngine = R"doc(Returns the execution tier selected with setEngine().)doc";
+
+static const char *__doc_Solver_getEqualitySaturation =
+R"doc(Returns whether the equality-saturation optimizer is enabled, see
+setEqualitySaturation().)doc";
+
+static const char *__doc_Solver_getFastMath = R"doc(Returns whether fast math was enabled with setFastMath().)doc";
+
+static const char *__doc_Solver_getFusedMultiplyAdd = R"doc(Returns whether multiply-adds are contracted, see setFusedMultiplyAdd().)doc";
+
+static const char *__doc_Solver_getPrecision = R"doc(Returns the precision selected with setPrecision().)doc";
+
+static const char *__doc_Solver_getProgramCacheStats =
+R"doc(Returns the hit, miss, eviction and invalidation counters and the size of the
+program cache.
+
+In Python, a dict with the keys ``hits``, ``misses``, ``evictions``,
+``invalidations``, ``entries`` and ``bytes``.)doc";
+
+static const char *__doc_Solver_getTierInfo =
+R"doc(Returns the tier of ``expression`` and its execution count.
+
+An expression without a compiled program reports the tier it would start at.
+
+In Python, a dict with the keys ``tier``, ``executions``, ``promoting`` and
+``pinned``.)doc";
+
+static const char *__doc_Solver_getTiering =
+R"doc(Returns the tiering policy, see setTiering().
+
+In Python, whether tiering is enabled.)doc";
+
 static const char *__doc_Solver_invalidateCaches =
 R"doc(Invalidates solver caches if caching is enabled.
 
@@ -684,42 +814,71 @@ Returns:
     An unordered_map from variable name to double value.)doc";
 
 static const char *__doc_Solver_parse =
-R"doc(Parses a mathematical expression from string to postfix.
+R"doc(Parses a mathematical expression into a simplified expression graph.
 
-The process includes tokenizing, converting tokens to postfix notation, and
-flattening (inlining any user-defined functions). If ``debug`` is set, it may
-print intermediate steps.
+The process includes tokenizing, converting tokens to postfix notation, adding
+the postfix to an ExpressionGraph (inlining user-defined functions and
+substituting constants) and, unless ``optimized`` is false, simplifying it with
+optimize(). If ``debug`` is set, it prints the expression before and after
+simplification.
 
 Parameter ``expression``:
     The input mathematical expression (in infix).
 
+Parameter ``graph``:
+    Receives the nodes of the expression that are reachable from the returned
+    root.
+
 Parameter ``debug``:
-    If true, prints debug information about the tokenization/postfix steps.
+    If true, prints debug information about the parsing steps.
+
+Parameter ``dependencies``:
+    If given, receives the names the expression and its inlined functions refer
+    to.
+
+Parameter ``fixed``:
+    If given, variables substituted by their current values before
+    simplification.
+
+Parameter ``optimized``:
+    Whether to simplify the expression (false for Tier::BASELINE).
 
 Returns:
-    A vector of Tokens representing the flattened postfix form.
+    The root of the simplified expression in ``graph.``
 
 Throws:
     SolverException If a syntax error or unknown function is encountered.)doc";
 
-static const char *__doc_Solver_parseAST =
-R"doc(Parses a mathematical expression from string to postfix.
+static const char *__doc_Solver_pinTier =
+R"doc(Pins ``expression`` to ``tier,`` or unpins it if ``tier`` is empty.
 
-The process includes tokenizing, converting tokens to postfix notation, and
-flattening (inlining any user-defined functions). If ``debug`` is set, it may
-print intermediate steps.
+A pinned expression is built at its tier and never promoted, whether tiering is
+enabled or not. The program of ``expression`` is discarded so the next call
+rebuilds it.
 
 Parameter ``expression``:
-    The input mathematical expression (in infix).
+    The expression string, as passed to evaluate().
 
-Parameter ``debug``:
-    If true, prints debug information about the tokenization/postfix steps.
+Parameter ``tier``:
+    The tier to pin it to, or std::nullopt to let the policy decide again.)doc";
 
-Returns:
-    A vector of Tokens representing the flattened postfix form.
+static const char *__doc_Solver_prepareRange =
+R"doc(Prepares evaluateForRange() and returns the sweep, to be run later.
+
+The expression is parsed, its tier advanced and the declared variables loaded
+here. The returned function only reads state copied out of the Solver, so it may
+run while other threads use the Solver (the Python bindings release the GIL
+around it). ``values`` and ``results`` must outlive it.
 
 Throws:
-    SolverException If a syntax error or unknown function is encountered.)doc";
+    SolverException As evaluateForRange(), on preparation.)doc";
+
+static const char *__doc_Solver_prepareRanges =
+R"doc(Prepares evaluateForRanges() and returns the sweep, to be run later (see
+prepareRange()).
+
+Throws:
+    SolverException As evaluateForRanges(), on preparation.)doc";
 
 static const char *__doc_Solver_printFunctionExpressions =
 R"doc(Prints expressions (postfix or inlined) for all registered functions to stdout.
@@ -754,6 +913,18 @@ Parameter ``argCount``:
 Throws:
     SolverException If a function with the same name already exists.)doc";
 
+static const char *__doc_Solver_setBatchSize =
+R"doc(Sets how many inputs Engine::BATCH evaluates per block.
+
+Larger blocks amortize per-instruction dispatch over more inputs, smaller ones
+keep the working set (one column per register) in cache.
+
+Parameter ``lanes``:
+    Inputs per block (BatchProgram::DEFAULT_LANES by default).
+
+Throws:
+    SolverException If ``lanes`` is zero.)doc";
+
 static const char *__doc_Solver_setCurrentExpression =
 R"doc(Sets the expression to be evaluated and parses it into a postfix representation.
 
@@ -777,6 +948,130 @@ This is similar to setCurrentExpression() but constructs an AST pipeline instead
 of storing postfix tokens. If the expression is identical to the previously
 stored one (and the AST is valid), we skip re-building unless debug is true.)doc";
 
+static const char *__doc_Solver_setEngine =
+R"doc(Selects the execution tier used by evaluate() and the range evaluations.
+
+Engine::JIT compiles each expression to native x86-64 code the first time it is
+run; Engine::C emits C and builds it with the system compiler, caching objects
+on disk. Engine::BATCH evaluates range inputs a block at a time with the
+columnar evaluator (scalar evaluations use the interpreter). Where native code cannot be generated, evaluation falls back to the
+bytecode interpreter. All tiers produce identical results.
+
+Parameter ``engine``:
+    The engine to use (Engine::INTERPRETER by default).)doc";
+
+static const char *__doc_Solver_setEqualitySaturation =
+R"doc(Enables the equality-saturation optimizer, for the expressions that run hottest.
+
+After simplification, every expression is optimized with saturate(): algebraic
+identities (commutativity, associativity, the identities of 0, 1 and negation,
+...) are applied in every direction at once in an e-graph, and the cheapest
+equivalent expression is kept, pow and transcendental calls counting most. This
+finds rewrites the greedy rules miss, at a compile time bounded by ``limits.``
+The identities hold in real arithmetic only, so results may differ in the last
+bits (and regrouped intermediates may overflow or underflow differently), but
+errors, domains and special values are kept. With fast math (see setFastMath())
+distributivity, the power laws and the laws of exp, ln and sqrt are used as
+well, factoring `a*(x + y) + b*(x + y)` into `(a + b)*(x + y)` and combining
+`exp(a)*exp(b)` into `exp(a + b)`, although they do not keep them (`inf*0 +
+inf*1` is NaN, `inf*(0 + 1)` is inf). Compiled programs and cached results are
+discarded when the setting changes.
+
+Parameter ``enabled``:
+    Whether to run the optimizer (false by default).
+
+Parameter ``limits``:
+    Bounds on the e-graph size, the rounds of rewriting and the time spent per
+    expression.)doc";
+
+static const char *__doc_Solver_setFastMath =
+R"doc(Enables the simplifications that trade exactness for speed.
+
+By default expressions are only rewritten in ways that give the same result for
+every input. With fast math, sums and products are also regrouped with their
+constants folded, polynomials are evaluated in Horner or Estrin form, integer
+powers are expanded into multiplications, `x^0.5` is evaluated with sqrt and
+divisions by constants become multiplications by their reciprocal, so results
+may differ in the last bits, overflow differently (`x*4*0.25` no longer
+overflows for large x) and `0^-n` raises a division by zero. Products with 0
+fold to 0, even where the other operand is infinite (NaN otherwise) or raises an
+error. Compiled programs and cached results are discarded when the setting
+changes.
+
+Parameter ``enabled``:
+    Whether to apply the inexact rewrites (false by default).)doc";
+
+static const char *__doc_Solver_setFusedMultiplyAdd =
+R"doc(Enables contracting multiply-adds into fused multiply-adds.
+
+With it, after simplification every addition of a product is rewritten with fma
+(see contractMultiplyAdds()), which every engine executes with one rounding:
+`a*b + c` takes one instruction instead of two and is usually closer to the
+exact value, but results change in the last bits. Compiled programs and cached
+results are discarded when the setting changes.
+
+Parameter ``enabled``:
+    Whether to contract multiply-adds (false by default).)doc";
+
+static const char *__doc_Solver_setPrecision =
+R"doc(Selects the precision compiled programs are executed in.
+
+Expressions are always parsed and simplified in NUMBER_TYPE; the compiled
+program is then run in ``precision`` on every engine, so throughput-critical
+sweeps can run in double or float while audits keep the full precision of the
+build. Results are returned as NUMBER_TYPE and written to range outputs in
+their own element type.
+
+Parameter ``precision``:
+    The precision to use: "float", "double" or "long double" (the precision of
+    NUMBER_TYPE by default).
+
+Throws:
+    SolverException If ``precision`` is not a known precision.)doc";
+
+static const char *__doc_Solver_setProgramCacheSize =
+R"doc(Bounds the program cache.
+
+The program cache keeps the parsed, simplified and compiled form of the most
+recently used expressions (and their native code), so switching between
+expressions does not re-parse them. It is independent of setUseCache(), which
+only controls result caching. Entries are dropped when a constant or function
+they refer to is declared.
+
+Parameter ``entries``:
+    Maximum number of expressions kept (DEFAULT_PROGRAM_CACHE_SIZE, 512, by
+    default; 0 disables the cache).
+
+Parameter ``bytes``:
+    Maximum estimated size of the kept entries in bytes (0 for no limit).)doc";
+
+static const char *__doc_Solver_setTiering =
+R"doc(Sets when expressions are promoted to a more expensive, faster Tier.
+
+With tiering enabled, an expression starts at Tier::BASELINE: it is compiled
+without the simplifier, which pays off for formulas evaluated only a few times.
+Every run of its program is counted (a range evaluation counts each point, and a
+result served from the cache counts as a run); once the count reaches
+``policy.optimizeAfter`` the expression is rebuilt at Tier::OPTIMIZED, and once
+it reaches ``policy.nativeAfter`` at Tier::NATIVE. With ``policy.background``
+the rebuild is queued on a thread of the solver, which builds one at a time,
+while the current tier keeps serving calls, and is switched to at the first call
+after it is ready (a rebuild whose expression is dropped from the cache
+meanwhile is skipped or discarded without waiting for it); otherwise it runs in
+the call that crosses the threshold. While setEngine() selects
+Engine::INTERPRETER, calls that do not name an engine run on the engine of the
+tier (Engine::INTERPRETER below Tier::NATIVE); any other engine selected with
+setEngine() is kept at every tier.
+
+Tiering does not change compile() and specialize(), which always simplify.
+Compiled programs and cached results are discarded when the policy changes.
+
+Parameter ``policy``:
+    The thresholds and the native engine (tiering is disabled by default).
+
+In Python, the fields are keyword arguments: ``enabled``, ``optimize_after``,
+``native_after``, ``native_engine`` (an engine name) and ``background``.)doc";
+
 static const char *__doc_Solver_setUseCache =
 R"doc(Toggles whether the solver uses its LRU cache.
 
@@ -787,8 +1082,39 @@ retroactively recover old cached values.
 Parameter ``useCache``:
     Pass true to enable expression caching, false to disable it.)doc";
 
+static const char *__doc_Solver_specialize =
+R"doc(Compiles an expression specialized on some of its variables held fixed.
+
+The variables in ``fixed`` are treated as constants at their current values, so
+the whole simplifier runs on them and the residual program only computes what
+depends on the other variables. When one of them is redeclared with a different
+value, the returned handle rebuilds its residual on its next evaluation.
+
+Parameter ``expression``:
+    The mathematical expression to specialize (e.g. "a*x^2 + b*x + c").
+
+Parameter ``fixed``:
+    Names of the declared variables to hold fixed (e.g. {"a", "b", "c"}).
+
+Parameter ``engine``:
+    The execution tier to compile for; defaults to the one selected with
+    setEngine().
+
+Parameter ``precision``:
+    The precision to run in; defaults to the one selected with setPrecision().
+
+Returns:
+    The specialized expression, which must not outlive the solver.
+
+Throws:
+    SolverException If a fixed name is not a declared variable, or the
+    expression cannot be parsed or compiled.)doc";
+
 static const char *__doc_Solver_symbolTable = R"doc(Symbol table for all declared variables and constants (manages their values).)doc";
 
+static const char *__doc_Solver_tokenPool =
+R"doc(Names and literal values referred to by the tokens of every expression parsed.)doc";
+
 static const char *__doc_Solver_validateFunctionDependencies =
 R"doc(Validates that a user-defined function's dependencies are valid.
 
@@ -804,9 +1130,70 @@ Parameter ``args``:
 Throws:
     SolverException If an invalid argument name or reference is encountered.)doc";
 
-static const char *__doc_SubZeroRule = R"doc()doc";
+static const char *__doc_SpecializedExpression =
+R"doc(An expression compiled with some of its variables held fixed, returned by
+Solver::specialize().
+
+The fixed variables are substituted by their current values before
+simplification, so the whole optimizer (constant folding, function folding,
+strength reduction and the opt-in rewrites) runs on them and the residual
+program only computes what depends on the remaining inputs.
+
+Unlike a CompiledExpression, the handle refers to its solver: before each
+evaluation it compares the values of the fixed variables in the solver with
+those the residual was built with, and rebuilds the residual if one changed.
+Constants and functions are those declared when the residual was (last) built.
+The handle must not outlive its solver, and must not be evaluated from several
+threads at once.)doc";
+
+static const char *__doc_SpecializedExpression_engine = R"doc(The execution tier the residual is compiled for.)doc";
+
+static const char *__doc_SpecializedExpression_evaluate =
+R"doc(Evaluates the expression with the given input values and the current values of
+the fixed variables.
 
-static const char *__doc_SubZeroRule_apply = R"doc()doc";
+Parameter ``values``:
+    One value per entry of variables(), in the same order.
+
+Returns:
+    The value of the expression.
+
+Throws:
+    SolverException If the number of values is wrong, a fixed variable is no
+    longer declared, or on a runtime error.)doc";
+
+static const char *__doc_SpecializedExpression_evaluate_2 =
+R"doc(Evaluates the expression with input values looked up by name.
+
+Names that are not inputs (including the fixed variables) are ignored.
+
+Parameter ``values``:
+    Value of each input, by name.
+
+Returns:
+    The value of the expression.
+
+Throws:
+    SolverException If an input is missing, a fixed variable is no longer
+    declared, or on a runtime error.)doc";
+
+static const char *__doc_SpecializedExpression_expression = R"doc(The source expression.)doc";
+
+static const char *__doc_SpecializedExpression_fixed = R"doc(Names of the variables held fixed.)doc";
+
+static const char *__doc_SpecializedExpression_precision = R"doc(The precision the residual is executed in.)doc";
+
+static const char *__doc_SpecializedExpression_rebuildCount = R"doc(Number of times the residual was rebuilt after a fixed variable changed.)doc";
+
+static const char *__doc_SpecializedExpression_residual =
+R"doc(The residual program for the current values of the fixed variables, rebuilt
+first if one changed.
+
+Its variables() are the inputs it still reads, a subset of variables().)doc";
+
+static const char *__doc_SpecializedExpression_variables =
+R"doc(Names of the other variables the expression reads, in the order evaluate()
+expects their values.)doc";
 
 static const char *__doc_SymbolEntry = R"doc()doc";
 
@@ -856,12 +1243,80 @@ static const char *__doc_SymbolType_CONSTANT = R"doc()doc";
 
 static const char *__doc_SymbolType_VARIABLE = R"doc()doc";
 
+static const char *__doc_SyntaxTree =
+R"doc(An AST stored in one contiguous array of nodes, with the root at index 0.
+
+Nodes refer to their children by 32-bit index and numbers are kept in binary,
+so evaluating the tree walks one array and parses no strings. The node array is
+sized exactly when the tree is built, so building and destroying it costs a
+single allocation (plus the table of distinct variable and function names).)doc";
+
+static const char *__doc_SyntaxTreeBuilder = R"doc()doc";
+
+static const char *__doc_SyntaxTree_byteSize = R"doc(Estimated heap footprint of the tree in bytes.)doc";
+
+static const char *__doc_SyntaxTree_name = R"doc(The variable or function name of ``node``.)doc";
+
+static const char *__doc_SyntaxTree_names = R"doc(Distinct variable and function names.)doc";
+
+static const char *__doc_SyntaxTree_nodes = R"doc(All nodes; the children of a node are contiguous.)doc";
+
+static const char *__doc_SyntaxTree_operator_array = R"doc(The node at ``index`` (0 is the root).)doc";
+
+static const char *__doc_SyntaxTree_size = R"doc(Number of nodes.)doc";
+
+static const char *__doc_SyntaxTree_slotCount = R"doc(Number of value slots the nodes store to and read from.)doc";
+
+static const char *__doc_SyntaxTree_slots = R"doc(Number of value slots.)doc";
+
 static const char *__doc_Token =
 R"doc(Represents a token in a mathematical expression.
 
-When the token is a number, the numeric value is precomputed and stored in the
-numericValue field. This saves us from having to call std::stold() during
-evaluation.)doc";
+A token holds no text: ``id`` refers to its TokenPool, as the index of the value
+in the constant pool for a NUMBER and as the interned symbol for any other
+token. Names, operators and delimiters therefore compare as integers, and
+copying a token copies 8 bytes.)doc";
+
+static const char *__doc_TokenPool =
+R"doc(The names and literal values the tokens of a Solver refer to.
+
+Names (variables, functions, and the text of operators and delimiters) are
+interned once and get a SymbolId, and numbers are stored once each in a constant
+pool, so a Token only carries a 32-bit id. The operators, parentheses, comma and
+unary negation have fixed ids, which lets the parser recognise them without
+looking at any text.
+
+Ids stay valid for the lifetime of the pool.)doc";
+
+static const char *__doc_TokenPool_TokenPool = R"doc()doc";
+
+static const char *__doc_TokenPool_constant =
+R"doc(Returns the constant pool index of ``value``, adding it if needed.)doc";
+
+static const char *__doc_TokenPool_constants = R"doc(Value -> constant pool index.)doc";
+
+static const char *__doc_TokenPool_intern = R"doc(Returns the id of ``name``, interning it if needed.)doc";
+
+static const char *__doc_TokenPool_name = R"doc(The name of symbol ``id``.)doc";
+
+static const char *__doc_TokenPool_names = R"doc(Name of each symbol (a deque keeps them in place).)doc";
+
+static const char *__doc_TokenPool_number = R"doc(The value at constant pool index ``index``.)doc";
+
+static const char *__doc_TokenPool_numberToken = R"doc(A NUMBER token for ``value``.)doc";
+
+static const char *__doc_TokenPool_numbers = R"doc(The constant pool.)doc";
+
+static const char *__doc_TokenPool_operatorSymbol = R"doc(The symbol id of operator ``op``.)doc";
+
+static const char *__doc_TokenPool_operatorToken = R"doc(An OPERATOR token for ``op``.)doc";
+
+static const char *__doc_TokenPool_symbolToken = R"doc(A VARIABLE or FUNCTION token named ``name``.)doc";
+
+static const char *__doc_TokenPool_symbols = R"doc(Name -> symbol id; views into names.)doc";
+
+static const char *__doc_TokenPool_text =
+R"doc(The text of ``token``: its name, or its value for a NUMBER.)doc";
 
 static const char *__doc_TokenType =
 R"doc(@enum TokenType Represents the type of a token in a mathematical expression.
@@ -887,41 +1342,47 @@ static const char *__doc_Token_Token = R"doc()doc";
 
 static const char *__doc_Token_Token_2 = R"doc()doc";
 
-static const char *__doc_Token_numericValue = R"doc(Precomputed numeric value (only valid if type == NUMBER))doc";
+static const char *__doc_Token_id =
+R"doc(Constant pool index (NUMBER) or symbol id (other tokens) in the TokenPool)doc";
 
 static const char *__doc_Token_op = R"doc(Operator type (only valid if type == OPERATOR))doc";
 
-static const char *__doc_Token_type = R"doc(The type of the token)doc";
+static const char *__doc_Token_operator_eq = R"doc()doc";
 
-static const char *__doc_Token_value = R"doc(The textual representation (for non-operator tokens))doc";
+static const char *__doc_Token_type = R"doc(The type of the token)doc";
 
 static const char *__doc_Tokenizer =
 R"doc(A static utility class for tokenizing mathematical expressions.
 
-The Tokenizer class provides functions to convert a mathematical expression
-string into a series of tokens (numbers, variables, operators, etc.) using
-regular expressions.)doc";
-
-static const char *__doc_Tokenizer_handleNumberToken = R"doc()doc";
-
-static const char *__doc_Tokenizer_handleOperatorToken = R"doc()doc";
-
-static const char *__doc_Tokenizer_handleVariableOrFunctionToken = R"doc()doc";
-
-static const char *__doc_Tokenizer_isUnaryContext = R"doc()doc";
+The Tokenizer class converts a mathematical expression string into a series of
+tokens (numbers, variables, operators, etc.) in a single hand-written scan,
+checking the syntax as it goes.)doc";
 
-static const char *__doc_Tokenizer_processMatch = R"doc()doc";
+static const char *__doc_Tokenizer_handleNumberToken =
+R"doc(Appends the NUMBER token of ``value,`` merged into a preceding negation unless
+``next`` is '^'.)doc";
 
 static const char *__doc_Tokenizer_tokenize =
 R"doc(Tokenizes a mathematical expression into tokens.
 
+Numbers are digits with an optional fractional part and are converted with
+std::from_chars; names are a letter or underscore followed by letters, digits or
+underscores, and are function calls when the next non-blank character is '('. A
+'-' where an operand is expected is a negation.
+
 Parameter ``equation``:
     The equation to tokenize.
 
+Parameter ``pool``:
+    Receives the names and numbers the tokens refer to.
+
 Returns:
-    A vector of tokens representing the equation.)doc";
+    A vector of tokens representing the equation.
 
-static const char *__doc_Tokenizer_tokenizeUsingRegex = R"doc()doc";
+Throws:
+    SolverException On an unknown character, an operator or comma where an
+    operand is expected, or unbalanced parentheses, with the position of the
+    offending character; or if the expression is empty or ends with an operator.)doc";
 
 static const char *__doc_Validator_isValidName =
 R"doc(Validates whether a given name is a valid identifier.
@@ -942,8 +1403,14 @@ Returns:
 static const char *__doc_Validator_isValidSyntax =
 R"doc(Validate the syntax of the given expression.
 
+This is the check Tokenizer::tokenize() makes while scanning, without keeping
+the tokens.
+
 Parameter ``expression``:
-    The expression to validate.)doc";
+    The expression to validate.
+
+Throws:
+    SolverException Describing the first syntax error and its position.)doc";
 
 static const char *__doc__unnamed_class_at_include_exception_h_12_7 =
 R"doc(Custom exception class for handling errors in the Solver class.
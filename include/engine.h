@@ -0,0 +1,43 @@
+#pragma once
+
+#include "pch.h"
+
+/**
+ * @enum Engine
+ * @brief The execution tiers a compiled expression can run on.
+ *
+ * Every tier computes bit-identical results; they only differ in how the compiled
+ * program is executed.
+ */
+enum class Engine {
+    INTERPRETER,    ///< The portable bytecode interpreter (always available).
+    JIT,            ///< Native x86-64 machine code; falls back to the interpreter where unsupported.
+    C,              ///< C emitted per expression and built by the system compiler (objects cached on disk).
+    BATCH           ///< Columnar evaluation of range inputs a block at a time (scalar calls use the interpreter).
+};
+
+/**
+ * @brief Parses an engine name ("interpreter", "jit", "c" or "batch").
+ *
+ * @throws SolverException If \p name is not a known engine.
+ */
+inline Engine engineFromString(const std::string& name) {
+    if (name == "interpreter") return Engine::INTERPRETER;
+    if (name == "jit") return Engine::JIT;
+    if (name == "c") return Engine::C;
+    if (name == "batch") return Engine::BATCH;
+    throw SolverException("Unknown engine '" + name + "'. Expected 'interpreter', 'jit', 'c' or 'batch'.");
+}
+
+/**
+ * @brief Returns the name of \p engine, as accepted by engineFromString().
+ */
+inline std::string engineToString(Engine engine) {
+    switch (engine) {
+        case Engine::INTERPRETER: return "interpreter";
+        case Engine::JIT: return "jit";
+        case Engine::C: return "c";
+        case Engine::BATCH: return "batch";
+    }
+    return "unknown";
+}
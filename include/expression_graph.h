@@ -0,0 +1,145 @@
+#pragma once
+
+#include "pch.h"
+#include "token.h"
+#include "token_pool.h"
+#include "exception.h"
+
+struct Function;
+class SymbolTable;
+
+/// Index of a node in an ExpressionGraph.
+using NodeId = uint32_t;
+
+/// The symbol of \p op ("+", "-", "*", "/" or "^").
+const char* operatorSymbol(OperatorType op);
+
+/**
+ * @struct GraphNode
+ * @brief One node of an ExpressionGraph.
+ *
+ * A leaf is a NUMBER or a VARIABLE. An OPERATOR or FUNCTION node applies its operator or
+ * (predefined) function to \p children, which were always created before it.
+ */
+struct GraphNode {
+    TokenType type;                 ///< NUMBER, VARIABLE, OPERATOR or FUNCTION.
+    OperatorType op;                ///< The operator (OPERATOR nodes only).
+    NUMBER_TYPE number;             ///< The value (NUMBER nodes only).
+    std::string name;               ///< Variable or function name, or the operator's symbol.
+    std::vector<NodeId> children;   ///< Operands, in order.
+    size_t hash;                    ///< Structural hash, computed once when the node is created.
+};
+
+/**
+ * @class ExpressionGraph
+ * @brief Hash-consed expression DAG, the representation expressions are simplified and compiled from.
+ *
+ * Nodes are interned: creating a node equal to an existing one (same kind, the same
+ * operator, name or value, and the same children) returns the existing id. Two
+ * subexpressions are therefore structurally equal exactly when their ids are equal, and
+ * every distinct subexpression is stored once however often it occurs. Inlining a user
+ * function shares its arguments between the uses of its parameters instead of copying
+ * them, so nested functions take memory proportional to their distinct subexpressions
+ * rather than to the expanded expression.
+ *
+ * Nodes are never removed: rewriting a node (e.g. in the simplifier) creates a new one and
+ * leaves the old one unreachable from the new root.
+ */
+class ExpressionGraph {
+public:
+    /// Returns the NUMBER node of \p value (NaN and -0 are kept distinct from other values).
+    NodeId number(NUMBER_TYPE value);
+
+    /// Returns the VARIABLE node named \p name.
+    NodeId variable(const std::string& name);
+
+    /// Returns the node applying \p op to \p left and \p right.
+    NodeId binary(OperatorType op, NodeId left, NodeId right);
+
+    /// Returns the node calling the predefined function \p name with \p arguments.
+    NodeId call(const std::string& name, std::vector<NodeId> arguments);
+
+    /// Returns the node applying the operator or function of node \p id to \p operands instead of its children.
+    NodeId withChildren(NodeId id, std::vector<NodeId> operands);
+
+    /**
+     * @brief Returns the node of \p token applied to \p operands (none for a NUMBER or VARIABLE token).
+     * @param pool The pool \p token refers to.
+     * @throws SolverException If \p token is not a NUMBER, VARIABLE, OPERATOR or FUNCTION token.
+     */
+    NodeId add(const Token& token, const TokenPool& pool, std::vector<NodeId> operands = {});
+
+    /**
+     * @brief Adds a postfix expression, inlining the calls to user-defined functions.
+     *
+     * Each distinct call (same function, same argument nodes) is inlined once, and each
+     * distinct symbol is looked up once.
+     *
+     * @param postfix   Postfix tokens, e.g. from Postfix::shuntingYard().
+     * @param pool      The pool the tokens refer to.
+     * @param functions Function table; user-defined functions are inlined from their body graph.
+     * @param constants If given, variables it declares as constants become NUMBER nodes.
+     * @param names     If given, receives the names of the variables, constants and functions
+     *                  referred to, including those in inlined bodies.
+     * @return The root of the expression.
+     * @throws SolverException On an unknown function or a malformed postfix expression.
+     */
+    NodeId addPostfix(const std::vector<Token>& postfix, const TokenPool& pool, const std::unordered_map<std::string, Function>& functions,
+                      const SymbolTable* constants = nullptr, std::unordered_set<std::string>* names = nullptr);
+
+    /**
+     * @brief Copies the expression under \p root in \p source into this graph.
+     *
+     * Variables named in \p parameters are replaced by the corresponding \p arguments; the
+     * others are handled as in addPostfix().
+     *
+     * @return The root of the copy.
+     */
+    NodeId copy(const ExpressionGraph& source, NodeId root,
+                const std::vector<std::string>& parameters = {}, const std::vector<NodeId>& arguments = {},
+                const SymbolTable* constants = nullptr, std::unordered_set<std::string>* names = nullptr);
+
+    /// The node \p id.
+    const GraphNode& operator[](NodeId id) const { return nodes[id]; }
+
+    /// Number of nodes in the graph (reachable or not).
+    size_t size() const { return nodes.size(); }
+
+    /// Whether \p id is a NUMBER or VARIABLE node.
+    bool isLeaf(NodeId id) const { return nodes[id].children.empty(); }
+
+    /// The token of node \p id alone (without its operands), with its name or value added to \p pool.
+    Token token(NodeId id, TokenPool& pool) const;
+
+    /**
+     * @brief The nodes reachable from \p root, each once, in evaluation order.
+     *
+     * Operands come before the nodes that use them, in left-to-right order, so the last
+     * entry is \p root.
+     */
+    std::vector<NodeId> reachable(NodeId root) const;
+
+    /**
+     * @brief Expands the expression under \p root into postfix tokens.
+     *
+     * A shared node is expanded at each of its uses, so the result can be exponentially
+     * larger than the graph.
+     */
+    std::vector<Token> toPostfix(NodeId root, TokenPool& pool) const;
+
+    /// Estimated heap footprint of the graph in bytes.
+    size_t byteSize() const;
+
+private:
+    /// Returns the id of a node equal to \p node, adding it if there is none.
+    NodeId intern(GraphNode node);
+
+    /// Doubles the index and re-inserts its entries.
+    void growIndex();
+
+    static constexpr NodeId EMPTY_SLOT = std::numeric_limits<NodeId>::max();
+
+    std::vector<GraphNode> nodes;
+    /// Open-addressing table of (hash, id) for every node, linearly probed; a power of two in size.
+    std::vector<std::pair<size_t, NodeId>> index;
+};
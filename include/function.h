@@ -3,25 +3,67 @@
 
 #include "pch.h"
 #include "token.h"
+#include "expression_graph.h"
 
 using FunctionCallback = std::function<NUMBER_TYPE(const std::vector<NUMBER_TYPE>&)>;
 
+// Identifies the solver's built-in functions, so back ends can lower them without going through the callback
+enum class Builtin {
+    NONE,   // Not a built-in (user callback)
+    NEG,
+    SIN,
+    COS,
+    TAN,
+    EXP,
+    LN,
+    LOG,
+    SQRT,
+    ABS,
+    MAX,
+    MIN,
+    FMA
+};
+
+// Value of a built-in in precision T. Everything but max, min and fma is computed in long
+// double and rounded once to T, for every T; the callbacks in registerBuiltInFunctions
+// and every back end compute exactly this. fma rounds once in T, so it is compiled to its
+// own opcode (OpCode::FMA) rather than called, and has no case here.
+template <typename T>
+T builtinValue(Builtin builtin, const T* args) {
+    switch (builtin) {
+        case Builtin::NEG:  return -args[0];
+        case Builtin::SIN:  return static_cast<T>(std::sinl(args[0]));
+        case Builtin::COS:  return static_cast<T>(std::cosl(args[0]));
+        case Builtin::TAN:  return static_cast<T>(std::tanl(args[0]));
+        case Builtin::EXP:  return static_cast<T>(std::expl(args[0]));
+        case Builtin::LN:   return static_cast<T>(std::logl(args[0]));
+        case Builtin::LOG:  return static_cast<T>(std::logl(args[0]) / std::logl(args[1]));
+        case Builtin::SQRT: return static_cast<T>(std::sqrtl(args[0]));
+        case Builtin::ABS:  return std::abs(args[0]);
+        case Builtin::MAX:  return std::max(args[0], args[1]);
+        case Builtin::MIN:  return std::min(args[0], args[1]);
+        default:            return std::nan("");
+    }
+}
+
 struct Function {
     FunctionCallback callback;              // For predefined functions
-    std::vector<Token> inlinedPostfix;      // Postfix expression for user-defined functions
+    std::shared_ptr<const ExpressionGraph> body;  // Body of a user-defined function, with the functions it calls inlined
+    NodeId bodyRoot;                        // Root of the body in `body`
     std::vector<std::string> argumentNames; // Names of the arguments
     size_t argCount;                        // Number of arguments
     bool isPredefined;                      // Flag for predefined functions
+    Builtin builtin = Builtin::NONE;        // Which built-in this is, if any
 
     // Default Constructor
     Function()
-        : callback(nullptr), inlinedPostfix(), argumentNames(), argCount(0), isPredefined(true) {}
+        : callback(nullptr), body(), bodyRoot(0), argumentNames(), argCount(0), isPredefined(true) {}
 
     // Constructor for predefined functions
     Function(FunctionCallback cb, size_t argCnt)
-        : callback(std::move(cb)), inlinedPostfix(), argumentNames(), argCount(argCnt), isPredefined(true) {}
+        : callback(std::move(cb)), body(), bodyRoot(0), argumentNames(), argCount(argCnt), isPredefined(true) {}
 
     // Constructor for user-defined functions
-    Function(std::vector<Token> postfix, std::vector<std::string> args)
-        : callback(nullptr), inlinedPostfix(std::move(postfix)), argumentNames(std::move(args)), argCount(argumentNames.size()), isPredefined(false) {}
+    Function(std::shared_ptr<const ExpressionGraph> graph, NodeId root, std::vector<std::string> args)
+        : callback(nullptr), body(std::move(graph)), bodyRoot(root), argumentNames(std::move(args)), argCount(argumentNames.size()), isPredefined(false) {}
 };
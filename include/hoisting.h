@@ -0,0 +1,123 @@
+#pragma once
+
+#include "pch.h"
+#include "program.h"
+#include "array_view.h"
+
+/**
+ * @class HoistedSweep
+ * @brief Splits a Program evaluated over a cartesian product into tabulated invariants and a per-point residual.
+ *
+ * \p T is the precision the sweep runs in; tables hold values of that type.
+ *
+ * Every instruction is classified by the set of range dimensions it depends on (the union
+ * of the dimensions of its operands). An instruction whose set is small enough that its
+ * distinct values number at most half the points of the sweep is hoisted: it is computed
+ * once per distinct combination of its own dimensions, and the values other parts of the
+ * program read are stored in a table indexed by those dimensions. In `sin(x) * exp(y)`
+ * over an N x M grid, `sin(x)` is evaluated N times and `exp(y)` M times instead of N*M.
+ *
+ * What is left is the residual program: the instructions that depend on (nearly) every
+ * range dimension, reading the hoisted values from extra input registers. It is an
+ * ordinary Program, so any engine can run it. The residual register file is laid out as
+ * [constants | variables | hoisted inputs | temporaries]; constant and variable registers
+ * keep their indices from the original program.
+ *
+ * Since the same instructions run on the same inputs, results are bit-identical to
+ * running the original program once per point.
+ */
+template <typename T>
+class HoistedSweep {
+public:
+    /**
+     * @brief Classifies the instructions of \p program for a sweep over \p ranges.
+     *
+     * @param program The compiled program.
+     * @param slots Register of each range variable (-1 for ranges the program does not read).
+     * @param ranges The values of each range variable; the viewed memory must outlive this object.
+     */
+    HoistedSweep(const Program& program, const std::vector<int>& slots,
+                 const std::vector<ArrayView>& ranges);
+
+    /// Number of instructions moved out of the per-point program.
+    size_t hoistedCount() const { return hoisted; }
+
+    /**
+     * @brief Evaluates the hoisted instructions and fills their tables.
+     *
+     * @param registers The loaded register file of the original program (constants and declared variables).
+     * @throws SolverException If a hoisted instruction fails for any combination; callers
+     *         then evaluate the original program point by point to report errors per point.
+     */
+    void tabulate(const T* registers);
+
+    /// The per-point program.
+    const Program& residual() const { return rest; }
+
+    /// Whether each instruction of the original program is hoisted; residual() depends on nothing else.
+    const std::vector<uint8_t>& hoistedInstructions() const { return lifted; }
+
+    /**
+     * @brief Prepares a register file for residual() from the loaded register file of the original program.
+     */
+    std::vector<T> residualRegisters(const T* registers) const;
+
+    /**
+     * @brief Writes the range values and hoisted inputs of the combination \p indices into \p registers.
+     *
+     * @param registers A register file prepared by residualRegisters().
+     * @param indices Index into each range.
+     */
+    void bind(T* registers, const std::vector<size_t>& indices) const {
+        bind(indices, [registers](uint32_t reg, T value) { registers[reg] = value; });
+    }
+
+    /**
+     * @brief Calls \p store(register, value) for every range value and hoisted input of the combination \p indices.
+     */
+    template <typename Store>
+    void bind(const std::vector<size_t>& indices, Store&& store) const {
+        for (size_t d = 0; d < ranges.size(); ++d) {
+            if (slots[d] >= 0) {
+                store(static_cast<uint32_t>(slots[d]), ranges[d].template get<T>(indices[d]));
+            }
+        }
+        for (const Import& input : inputs) {
+            store(input.reg, tables[input.table][offset(input.table, indices)]);
+        }
+    }
+
+private:
+    /// A hoisted value read by another piece of the program, and the register it is read from.
+    struct Import {
+        uint32_t table;     ///< Index of the table holding the value.
+        uint32_t reg;       ///< Register of the importing program.
+    };
+
+    /// Hoisted instructions sharing one set of dimensions, compiled into a program of their own.
+    struct Group {
+        uint32_t mask;                          ///< The range dimensions the group depends on.
+        Program program;                        ///< The group's instructions, one temporary each.
+        std::vector<Import> inputs;             ///< Values the group reads from other groups.
+        std::vector<std::pair<uint32_t, uint32_t>> outputs;  ///< (temporary register, table) of exported values.
+    };
+
+    Program extract(const Program& program, const std::vector<uint32_t>& members, uint32_t resultProducer,
+                    const std::vector<int>& exported, std::vector<Import>& imports);
+    size_t offset(uint32_t table, const std::vector<size_t>& indices) const;
+    size_t tableSize(uint32_t mask) const;
+
+    std::vector<int> slots;                                 ///< Register of each range variable.
+    std::vector<ArrayView> ranges;                          ///< Values of each range variable.
+    std::vector<std::vector<uint32_t>> producers;           ///< Producing instruction of each operand (UINT32_MAX for non-temporaries).
+    std::vector<uint32_t> masks;                            ///< Dimensions each instruction depends on.
+    std::vector<uint8_t> lifted;                            ///< Whether each instruction is hoisted.
+    std::vector<Group> groups;                              ///< Hoisted groups, in dependency order.
+    std::vector<uint32_t> tableMasks;                       ///< Dimensions of each table.
+    std::vector<std::vector<size_t>> strides;               ///< Per-table stride of each dimension (0 if absent).
+    std::vector<std::vector<T>> tables;                     ///< Hoisted values, indexed by their dimensions (last fastest).
+    std::vector<Import> inputs;                             ///< Hoisted values read by the residual program.
+    Program rest;                                           ///< The residual program.
+    uint32_t base = 0;                                      ///< First temporary register of the original program.
+    size_t hoisted = 0;                                     ///< Number of hoisted instructions.
+};
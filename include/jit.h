@@ -0,0 +1,60 @@
+#pragma once
+
+#include "pch.h"
+#include "program.h"
+#include "native_code.h"
+
+/**
+ * @class JitProgram
+ * @brief Native x86-64 machine code compiled from a Program, for the precision \p T.
+ *
+ * The generated function takes the program's register file as its only argument, so
+ * constants and variables are read from the same slots the interpreter uses. Arithmetic
+ * is emitted inline, the transcendental built-ins are called directly in the C math
+ * library, and any other callback goes through a small trampoline. The code lives in its
+ * own mmap'd page, which is made executable (and read-only) once written.
+ *
+ * Results are bit-identical to Program::run<T>(), including the errors it raises. Long
+ * double arithmetic uses the x87 unit, double and float arithmetic uses SSE.
+ */
+template <typename T>
+class JitProgram : public TypedNativeCode<T> {
+public:
+    /**
+     * @brief Returns true if native code can be generated on this platform.
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Compiles \p program to native code.
+     *
+     * The program's callbacks are copied, so the JitProgram does not reference \p program
+     * after construction.
+     *
+     * @throws SolverException If the platform is unsupported or the code cannot be mapped.
+     */
+    explicit JitProgram(const Program& program);
+
+    /**
+     * @brief Releases the executable page.
+     */
+    ~JitProgram() override;
+
+    JitProgram(const JitProgram&) = delete;
+    JitProgram& operator=(const JitProgram&) = delete;
+
+    T run(T* registers) const override;
+
+    /// Size of the generated machine code in bytes.
+    size_t codeSize() const { return size; }
+
+private:
+    using EntryPoint = int (*)(T*);
+
+    std::vector<FunctionCallback> callbacks;    ///< Callbacks referenced by the generated code.
+    void* memory = nullptr;                     ///< The mapped code page(s).
+    size_t mapped = 0;                          ///< Size of the mapping.
+    size_t size = 0;                            ///< Size of the generated code.
+    EntryPoint entry = nullptr;                 ///< Start of the generated function.
+    uint32_t result = 0;                        ///< Result register.
+};
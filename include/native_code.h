@@ -0,0 +1,68 @@
+#pragma once
+
+#include "pch.h"
+#include "precision.h"
+
+/**
+ * @class NativeCode
+ * @brief A Program compiled to machine code by one of the native back ends.
+ *
+ * Native code is compiled for one precision and runs through the TypedNativeCode of that
+ * precision; this base only lets code of different precisions be owned together.
+ */
+class NativeCode {
+public:
+    virtual ~NativeCode() = default;
+
+    /// The precision the code was compiled for.
+    virtual Precision precision() const = 0;
+};
+
+/**
+ * @class TypedNativeCode
+ * @brief Native code compiled for the scalar type \p T.
+ *
+ * Native code runs against the same register file as Program::run<T>() and must produce
+ * bit-identical results, raising the same errors.
+ */
+template <typename T>
+class TypedNativeCode : public NativeCode {
+public:
+    Precision precision() const override { return precisionOf<T>(); }
+
+    /**
+     * @brief Executes the native code against a prepared register file.
+     *
+     * @param registers Register file laid out as for Program::run().
+     * @return The value of the result register.
+     * @throws SolverException On division by zero; exceptions thrown by callbacks are rethrown as is.
+     */
+    virtual T run(T* registers) const = 0;
+};
+
+namespace NativeCodeDetail {
+
+/// Status codes returned by generated functions.
+enum Status : int {
+    OK = 0,
+    DIVISION_BY_ZERO = 1,
+    CALLBACK_FAILED = 2
+};
+
+/**
+ * @brief Calls \p callback with \p argc arguments from \p args and stores the result in \p out.
+ *
+ * The arguments are passed to the callback as NUMBER_TYPE and the result is rounded to T,
+ * as Program::run<T>() does. Generated code has no unwind information, so exceptions must
+ * never propagate through it. An exception thrown by the callback is parked and
+ * CALLBACK_FAILED returned instead; raise() rethrows it once control is back in C++.
+ */
+template <typename T>
+int invokeCallback(const void* callback, const T* args, uint32_t argc, T* out);
+
+/**
+ * @brief Throws the error corresponding to a non-OK \p status.
+ */
+[[noreturn]] void raise(int status);
+
+} // namespace NativeCodeDetail
@@ -11,15 +11,23 @@
 #include <stack>
 #include <memory>
 #include <cctype>
-#include <regex>
 #include <sstream>
 #include <iostream>
 #include <iomanip>
 #include <iterator> 
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include <list>
+#include <map>
 #include <future>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <optional>
+#include <tuple>
 
 #include <Python.h>
 
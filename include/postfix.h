@@ -2,6 +2,7 @@
 
 #include "pch.h"
 #include "token.h"
+#include "token_pool.h"
 #include "function.h"
 #include "exception.h"
 #include "symbol_table.h"
@@ -15,9 +16,9 @@ namespace Postfix {
      */
     std::vector<Token> shuntingYard(const std::vector<Token>& tokens);
 
-    NUMBER_TYPE evaluatePostfix(const std::vector<Token>& postfixQueue, const SymbolTable& symbolTable, const std::unordered_map<std::string, Function>& functions);
+    NUMBER_TYPE evaluatePostfix(const std::vector<Token>& postfixQueue, const TokenPool& pool, const SymbolTable& symbolTable, const std::unordered_map<std::string, Function>& functions);
 
-    std::vector<Token> flattenPostfix(const std::vector<Token>& postfixQueue, const std::unordered_map<std::string, Function>& functions);
+    std::vector<Token> flattenPostfix(const std::vector<Token>& postfixQueue, TokenPool& pool, const std::unordered_map<std::string, Function>& functions);
 
     /**
      * @brief Manages the operator stack according to precedence and associativity rules.
@@ -29,17 +30,17 @@ namespace Postfix {
 
     /**
      * @brief Retrieves the precedence level of a given operator.
-     * @param op The operator as a string.
+     * @param op The operator.
      * @return Integer representing the precedence level.
      */
-    int getPrecedence(const std::string& op);
+    int getPrecedence(OperatorType op);
 
     /**
      * @brief Determines if an operator is left-associative.
-     * @param op The operator as a string.
+     * @param op The operator.
      * @return True if the operator is left-associative, false otherwise.
      */
-    bool isLeftAssociative(const std::string& op);
+    bool isLeftAssociative(OperatorType op);
 
     /**
      * @brief Handles closing parentheses in the Shunting Yard algorithm.
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "pch.h"
+
+/**
+ * @enum Precision
+ * @brief The scalar type compiled programs are executed in.
+ *
+ * Parsing, simplification and the symbol table work in NUMBER_TYPE, the widest precision
+ * of the build. A compiled program can be executed in any precision: its constants and
+ * inputs are rounded once to the execution type, and every operation then runs in that
+ * type, exactly as in a build whose NUMBER_TYPE is that type. Built-in functions are
+ * computed in long double and rounded once, as they are in every build.
+ */
+enum class Precision {
+    FLOAT,          ///< 32-bit IEEE float (SIMD-friendly, fastest).
+    DOUBLE,         ///< 64-bit IEEE double.
+    LONG_DOUBLE     ///< The platform's long double (x87 extended precision on x86-64).
+};
+
+/**
+ * @brief The Precision of the C++ type \p T.
+ */
+template <typename T>
+constexpr Precision precisionOf() {
+    if constexpr (std::is_same_v<T, float>) {
+        return Precision::FLOAT;
+    } else if constexpr (std::is_same_v<T, double>) {
+        return Precision::DOUBLE;
+    } else {
+        static_assert(std::is_same_v<T, long double>, "Unsupported scalar type");
+        return Precision::LONG_DOUBLE;
+    }
+}
+
+/// The precision of NUMBER_TYPE, used unless another one is selected.
+constexpr Precision DEFAULT_PRECISION = precisionOf<NUMBER_TYPE>();
+
+/**
+ * @brief Calls \p f with a value of the C++ type of \p precision (float, double or long double).
+ *
+ * Used to instantiate templated evaluation code for a precision chosen at run time.
+ */
+template <typename F>
+decltype(auto) withPrecision(Precision precision, F&& f) {
+    switch (precision) {
+        case Precision::FLOAT: return f(float{});
+        case Precision::DOUBLE: return f(double{});
+        default: return f(static_cast<long double>(0));
+    }
+}
+
+/**
+ * @brief Parses a precision name ("float", "double" or "long double").
+ *
+ * @throws SolverException If \p name is not a known precision.
+ */
+inline Precision precisionFromString(const std::string& name) {
+    if (name == "float") return Precision::FLOAT;
+    if (name == "double") return Precision::DOUBLE;
+    if (name == "long double") return Precision::LONG_DOUBLE;
+    throw SolverException("Unknown precision '" + name + "'. Expected 'float', 'double' or 'long double'.");
+}
+
+/**
+ * @brief Returns the name of \p precision, as accepted by precisionFromString().
+ */
+inline std::string precisionToString(Precision precision) {
+    switch (precision) {
+        case Precision::FLOAT: return "float";
+        case Precision::DOUBLE: return "double";
+        case Precision::LONG_DOUBLE: return "long double";
+    }
+    return "unknown";
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "pch.h"
+#include "token.h"
+#include "function.h"
+#include "exception.h"
+
+/**
+ * @enum OpCode
+ * @brief The operations understood by the bytecode interpreter.
+ *
+ * Every instruction reads its operands from registers and writes its result to a
+ * register, so there is no implicit evaluation stack at run time.
+ */
+enum class OpCode : uint8_t {
+    ADD,    ///< dst = a + b
+    SUB,    ///< dst = a - b
+    MUL,    ///< dst = a * b
+    DIV,    ///< dst = a / b (throws on division by zero)
+    POW,    ///< dst = pow(a, b)
+    NEG,    ///< dst = -a
+    CALL,   ///< dst = callbacks[fn](argPool[a .. a + b))
+    FMA     ///< dst = fma(a, b, c), a * b + c rounded once
+};
+
+/**
+ * @struct Instruction
+ * @brief A single three-address instruction over virtual registers.
+ *
+ * Operands are register indices resolved at compile time. For CALL, \p a is an
+ * offset into the program's argument pool and \p b is the number of arguments.
+ */
+struct Instruction {
+    OpCode op;          ///< The operation to perform.
+    uint32_t dst;       ///< Destination register.
+    uint32_t a;         ///< First operand register (or argument pool offset for CALL).
+    uint32_t b;         ///< Second operand register (or argument count for CALL).
+    uint32_t fn;        ///< Callback index (only valid for CALL).
+    uint32_t c;         ///< Third operand register (only valid for FMA).
+};
+
+/**
+ * @class Program
+ * @brief A compiled expression: flat bytecode over a fixed-size register file.
+ *
+ * The register file is laid out as [constants | variables | temporaries]. Constants are
+ * preloaded from the program, variable registers are filled by the caller before running,
+ * and temporaries hold intermediate results. A program is immutable once built; all
+ * mutable evaluation state lives in the register file the caller passes to run(), so a
+ * single program can be shared between evaluations.
+ */
+class Program {
+public:
+    Program() = default;
+
+    /**
+     * @brief Prepares a register file for this program.
+     *
+     * Resizes \p registers to registerCount() and copies the constant pool, rounded to T,
+     * into the constant registers. Variable registers are zeroed and must be bound before run().
+     *
+     * @tparam T The precision the program will run in (float, double or long double).
+     * @param registers The register file to initialize.
+     */
+    template <typename T>
+    void initRegisters(std::vector<T>& registers) const;
+
+    /**
+     * @brief Executes the program against a prepared register file.
+     *
+     * Every operation is performed in T. Built-in functions are computed as builtinValue<T>();
+     * other callbacks receive their arguments as NUMBER_TYPE and their result is rounded to T.
+     *
+     * @tparam T The precision to run in (float, double or long double).
+     * @param registers Pointer to registerCount() registers with constants and variables set.
+     * @return The value of the result register.
+     * @throws SolverException On division by zero or if a function callback fails.
+     */
+    template <typename T>
+    T run(T* registers) const;
+
+    /**
+     * @brief Checks the structural invariants of the program.
+     *
+     * Every operand must reference an existing register, every destination must be a
+     * temporary register, and every CALL must reference a valid callback and argument range.
+     *
+     * @throws SolverException If the program is malformed.
+     */
+    void verify() const;
+
+    /**
+     * @brief Returns the register holding the variable \p name, or -1 if the program does not read it.
+     */
+    int variableRegister(const std::string& name) const;
+
+    /// Names of the variables read by the program, in register order.
+    const std::vector<std::string>& variableNames() const { return variables; }
+
+    /// Index of the first variable register.
+    uint32_t variableBase() const { return static_cast<uint32_t>(constants.size()); }
+
+    /// Index of the first temporary register.
+    uint32_t tempBase() const { return static_cast<uint32_t>(constants.size() + variables.size()); }
+
+    /// Total number of registers the program needs (constants, variables and temporaries).
+    uint32_t registerCount() const { return tempBase() + maxDepth; }
+
+    /// The register that holds the result once run() returns.
+    uint32_t resultRegister() const { return result; }
+
+    /// The instruction stream.
+    const std::vector<Instruction>& instructions() const { return code; }
+
+    /// Initial values of the constant registers (in NUMBER_TYPE; round them to the execution precision).
+    const std::vector<NUMBER_TYPE>& constantValues() const { return constants; }
+
+    /// Argument registers referenced by CALL instructions.
+    const std::vector<uint32_t>& argumentPool() const { return argPool; }
+
+    /// Callbacks referenced by CALL instructions.
+    const std::vector<FunctionCallback>& callbackTable() const { return callbacks; }
+
+    /// Which built-in each callback implements (Builtin::NONE for user callbacks).
+    const std::vector<Builtin>& callbackBuiltins() const { return builtins; }
+
+    /// Estimated heap footprint of the program in bytes.
+    size_t byteSize() const;
+
+    /// Prints a human readable listing of the program to stdout.
+    void disassemble() const;
+
+private:
+    friend class ProgramBuilder;
+    template <typename> friend class HoistedSweep;
+
+    std::vector<NUMBER_TYPE> constants;             ///< Initial values of the constant registers.
+    std::vector<std::string> variables;             ///< Variable names, one per variable register.
+    std::vector<Instruction> code;                  ///< The instruction stream.
+    std::vector<uint32_t> argPool;                  ///< Argument registers referenced by CALL instructions.
+    std::vector<FunctionCallback> callbacks;        ///< Callbacks referenced by CALL instructions.
+    std::vector<std::string> callbackNames;         ///< Function names, parallel to callbacks (for diagnostics).
+    std::vector<Builtin> builtins;                  ///< Built-in identity, parallel to callbacks.
+    uint32_t maxDepth = 0;                          ///< Number of temporary registers (verified maximum depth).
+    uint32_t result = 0;                            ///< Result register.
+};
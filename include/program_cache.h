@@ -0,0 +1,126 @@
+#pragma once
+
+#include "pch.h"
+#include "token.h"
+#include "program.h"
+#include "engine.h"
+#include "precision.h"
+#include "native_code.h"
+#include "ast.h"
+#include "expression_graph.h"
+#include "tiering.h"
+
+/**
+ * @struct TierPromotion
+ * @brief A CachedProgram rebuilt at a higher tier, built without access to the Solver so it can run on another thread.
+ */
+struct TierPromotion {
+    Tier tier = Tier::OPTIMIZED;                    ///< The tier reached.
+    std::optional<ExpressionGraph> graph;           ///< The optimized expression, if the entry was at Tier::BASELINE.
+    NodeId root = 0;                                ///< Root of the expression in graph.
+    Program program;                                ///< The program of the tier (the native code refers to it).
+    std::unique_ptr<NativeCode> native;             ///< Native code at Tier::NATIVE (nullptr if compilation failed).
+    Engine engine = Engine::JIT;                    ///< The engine native was compiled for (TieringPolicy::nativeEngine).
+    Precision precision = DEFAULT_PRECISION;        ///< The precision native was compiled for.
+};
+
+/**
+ * @struct PendingPromotion
+ * @brief A TierPromotion being built, shared by its CachedProgram and the PromotionQueue building it.
+ *
+ * The queue only holds it while building it, so dropping the entry (when it is evicted or
+ * the cache is cleared) does not wait for the build: a queued one is skipped, a running one
+ * has its result discarded.
+ */
+struct PendingPromotion {
+    std::atomic<bool> ready = false;                ///< Whether the build finished (promoted or error is set).
+    std::optional<TierPromotion> promoted;          ///< The promotion, if the build succeeded.
+    std::exception_ptr error;                       ///< What the build threw, if it failed.
+
+    /**
+     * @brief Runs \p build and stores what it returns or throws, then marks the promotion ready.
+     */
+    void complete(const std::function<TierPromotion()>& build);
+};
+
+/**
+ * @class PromotionQueue
+ * @brief The thread that builds a Solver's background promotions, one at a time.
+ *
+ * The thread is started by the first push(). The destructor drops the promotions not
+ * started yet and waits for the one being built, so no build outlives its Solver.
+ */
+class PromotionQueue {
+public:
+    PromotionQueue() = default;
+    PromotionQueue(const PromotionQueue&) = delete;
+    PromotionQueue& operator=(const PromotionQueue&) = delete;
+    ~PromotionQueue();
+
+    /**
+     * @brief Queues \p build, whose result goes to \p pending unless it is dropped first.
+     */
+    void push(const std::shared_ptr<PendingPromotion>& pending, std::function<TierPromotion()> build);
+
+private:
+    void work();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::pair<std::weak_ptr<PendingPromotion>, std::function<TierPromotion()>>> jobs;
+    bool stopping = false;
+    std::thread worker;
+};
+
+/**
+ * @struct CachedProgram
+ * @brief Everything the Solver derives from one expression string, kept in its program cache.
+ *
+ * The simplified expression graph is built on first use by either pipeline; the program
+ * and the AST are derived from it on first use by the pipeline that needs them (evaluate()
+ * and the range evaluations need the program, evaluateAST() the AST). Native code is
+ * compiled lazily per engine and precision.
+ *
+ * An entry is only valid for the constants and functions it was built with: constants
+ * are folded and user functions inlined at parse time. \p dependencies lists every name
+ * the expression (or an inlined function body) refers to, so declaring one of them drops
+ * the entry.
+ *
+ * With tiering (see Solver::setTiering()) the entry counts its executions, and is rebuilt
+ * at a higher tier by a TierPromotion; the current tier keeps serving until it is ready.
+ */
+struct CachedProgram {
+    bool parsed = false;                                            ///< Whether graph and root are built.
+    ExpressionGraph graph;                                          ///< The expression, inlined and simplified unless at Tier::BASELINE (only its reachable nodes).
+    NodeId root = 0;                                                ///< Root of the expression in graph.
+    bool compiled = false;                                          ///< Whether program is built.
+    Program program;                                                ///< The bytecode compiled from graph.
+    std::map<std::pair<Engine, Precision>, std::shared_ptr<const NativeCode>> native;  ///< Native code per engine and precision, shared with prepared sweeps (nullptr if compilation failed).
+    std::map<std::tuple<Engine, Precision, std::vector<int>, std::vector<uint8_t>>, std::shared_ptr<const NativeCode>> residualNative;  ///< Native code of hoisted sweeps, per engine, precision, range slots and hoisted instructions (see HoistedSweep).
+    std::optional<SyntaxTree> ast;                                  ///< The AST built from graph, if built yet.
+    std::unordered_set<std::string> dependencies;                   ///< Names of the constants, variables and functions referred to.
+    std::size_t resultKey = 0;                                      ///< Result cache key of the expression.
+    Tier tier = Tier::OPTIMIZED;                                    ///< The tier graph and program are built for.
+    std::optional<Tier> pinned;                                     ///< The tier pinned with Solver::pinTier(), if any.
+    size_t executions = 0;                                          ///< Times the program ran.
+    std::shared_ptr<PendingPromotion> promotion;                    ///< The promotion being built, if any.
+    bool promotionFailed = false;                                   ///< Whether a promotion failed (the entry then stays at its tier).
+
+    /**
+     * @brief Estimated heap footprint of the entry in bytes (native code excluded).
+     */
+    size_t byteSize() const;
+};
+
+/**
+ * @struct ProgramCacheStats
+ * @brief Counters of the Solver's program cache.
+ */
+struct ProgramCacheStats {
+    size_t hits = 0;            ///< Expressions found already parsed and compiled.
+    size_t misses = 0;          ///< Expressions that had to be parsed and compiled.
+    size_t evictions = 0;       ///< Entries dropped to stay within the size limits.
+    size_t invalidations = 0;   ///< Entries dropped because a name they depend on was (re)declared.
+    size_t entries = 0;         ///< Entries currently cached.
+    size_t bytes = 0;           ///< Estimated size of the cached entries in bytes.
+};
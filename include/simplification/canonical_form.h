@@ -0,0 +1,30 @@
+#pragma once
+
+#include "pch.h"
+#include "expression_graph.h"
+
+/**
+ * @brief Puts the sums and products under \p root in a canonical form.
+ *
+ * By default only exact rewrites are made: the two operands of every addition and
+ * multiplication are put in a canonical order, so `y + x` and `x + y` get the same node,
+ * and through hash-consing the same program.
+ *
+ * With \p fastMath, each maximal sum (of "+", "-" and negations) and each maximal product
+ * (of "*" and "/") is flattened into its terms, with a sign or an exponent of +-1 each.
+ * Its constants are folded (the factors and the divisors of a product apart), its other
+ * terms are sorted into the canonical order, and it is rebuilt as a balanced tree:
+ * `2 + x + 3 + y` becomes `(x + y) + 5` and `2*x*3` becomes `x * 6`. Regrouping changes
+ * how results round, and may overflow where the original did not or the other way round
+ * (`(x + 1e16) - 1e16` becomes `x`, `y*4*0.25` becomes `y` even for y = 1e308); the balanced
+ * tree keeps the error of a long sum close to that of pairwise summation. A subexpression
+ * used more than once is not flattened into its users, so shared subexpressions stay
+ * shared. A constant divisor of 0 is kept as a term, so the division still fails when
+ * evaluated, but a product with a factor of 0 becomes 0.
+ *
+ * @param graph The graph holding the expression; rewritten nodes are added to it.
+ * @param root  Root of the expression.
+ * @param fastMath Whether to apply the rewrites that are not exact.
+ * @return The root of the normalized expression.
+ */
+NodeId canonicalizeSumsAndProducts(ExpressionGraph& graph, NodeId root, bool fastMath = false);
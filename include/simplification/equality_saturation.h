@@ -0,0 +1,76 @@
+#pragma once
+
+#include "pch.h"
+#include "function.h"
+#include "expression_graph.h"
+
+// Cost model of saturate(), in rough multiples of an addition
+constexpr double ARITHMETIC_COST = 1;       ///< +, -, *, negation, abs, max, min and fma.
+constexpr double DIVISION_COST = 4;
+constexpr double SQRT_COST = 4;
+constexpr double CALL_COST = 30;            ///< Transcendental functions and other callbacks.
+constexpr double POW_COST = 40;             ///< A pow that strength reduction keeps.
+
+/**
+ * @struct SaturationLimits
+ * @brief Bounds on the work of saturate(), so compile time stays predictable.
+ */
+struct SaturationLimits {
+    size_t nodeLimit = 10000;       ///< Most e-nodes the e-graph may grow to.
+    size_t iterationLimit = 30;     ///< Most rounds of rule application.
+    double timeLimit = 0.02;        ///< Most seconds spent applying rules.
+
+    bool operator==(const SaturationLimits&) const = default;
+};
+
+/**
+ * @struct SaturationReport
+ * @brief What saturate() did, for debug output.
+ */
+struct SaturationReport {
+    size_t iterations = 0;          ///< Rounds of rule application run.
+    size_t nodes = 0;               ///< E-nodes in the final e-graph.
+    size_t classes = 0;             ///< E-classes in the final e-graph.
+    bool saturated = false;         ///< Whether a round added nothing (rather than a limit stopping it).
+    double costBefore = 0;          ///< Cost of the input expression.
+    double costAfter = 0;           ///< Cost of the returned expression.
+};
+
+/**
+ * @brief Optimizes the expression under \p root by equality saturation.
+ *
+ * The expression is loaded into an e-graph (classes of equivalent subexpressions), and
+ * algebraic identities are applied to every subexpression at once, round after round,
+ * adding each rewritten form to the class of the form it came from instead of replacing it:
+ * commutativity and associativity, and the identities for 0, 1 and negation; with
+ * \p fastMath also distributivity in both directions, the power laws and the laws of exp,
+ * ln and sqrt. Classes whose operands are all constant are folded. Rounds stop when one adds
+ * nothing new (the e-graph is saturated) or when a limit of \p limits is reached.
+ *
+ * The cheapest expression of the root's class is then extracted, each node costing its
+ * operation (see the *_COST constants; integer powers cost the multiplications strength
+ * reduction turns them into) plus its operands. Unlike the greedy rules of simplifyGraph(),
+ * a rewrite that costs more on its own (e.g. expanding a product) is kept when it leads to
+ * a cheaper form.
+ *
+ * The identities hold in real arithmetic only, so results may differ in the last bits, and
+ * a regrouped intermediate result may overflow or underflow where the original did not or
+ * the other way round. Without \p fastMath they keep errors, domains and special values
+ * otherwise. The identities that do not are only used with \p fastMath: `a - a` to 0 (NaN
+ * for infinite a), `a*(b + c)` to `a*b + a*c` (NaN for infinite a, b = 0 and c = 1),
+ * `a / b / c` to `a / (b*c)` (fails where b*c underflows), `sqrt(a)` to
+ * `a^0.5` (differs at -0 and -inf), `ln(a) + ln(b)` to `ln(a*b)` (defined for negative a
+ * and b, overflows for large ones), and the other power, exp and ln laws.
+ *
+ * @param graph     The graph holding the expression; extracted nodes are added to it.
+ * @param root      Root of the expression.
+ * @param functions The map of function names to Function definitions; rules calling a
+ *                  function are only used if it is the built-in.
+ * @param fastMath  Whether to also use the identities that change errors, domains or special values,
+ *                  and cost integer powers as the multiplications fast math turns them into.
+ * @param limits    Bounds on the size of the e-graph and the time spent.
+ * @param report    If not null, receives what was done.
+ * @return The root of the cheapest equivalent expression, or \p root if none is cheaper.
+ */
+NodeId saturate(ExpressionGraph& graph, NodeId root, const std::unordered_map<std::string, Function>& functions, bool fastMath,
+                const SaturationLimits& limits = {}, SaturationReport* report = nullptr);
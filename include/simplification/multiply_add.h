@@ -0,0 +1,28 @@
+#pragma once
+
+#include "pch.h"
+#include "function.h"
+#include "expression_graph.h"
+
+/**
+ * @brief Contracts the multiply-adds under \p root into calls to the built-in fma.
+ *
+ * Every addition or subtraction with a product operand (used only by it) is replaced by
+ * one fma, so `a*b - c` becomes `fma(a, b, -c)` and `c*d + a*b + e` becomes
+ * `fma(c, d, a*b) + e`. The sums are not regrouped, since that changes where they
+ * overflow (see canonicalizeSumsAndProducts()); only the operands of one operation are
+ * swapped, which is exact. A subtracted product takes the negation on whichever factor is
+ * a constant or a negation already. A product used elsewhere is computed anyway and is
+ * left alone.
+ *
+ * An fma rounds once where the multiply and the add round twice, so results change in the
+ * last bits (usually towards the exact value).
+ *
+ * @param graph      The graph holding the expression; rewritten nodes are added to it.
+ * @param root       Root of the expression.
+ * @param functions  The map of function names to Function definitions; nothing is
+ *                   contracted unless "fma" is the built-in.
+ * @param contracted If not null, set to the number of multiply-adds contracted.
+ * @return The root of the contracted expression.
+ */
+NodeId contractMultiplyAdds(ExpressionGraph& graph, NodeId root, const std::unordered_map<std::string, Function>& functions, size_t* contracted = nullptr);
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "pch.h"
+#include "expression_graph.h"
+
+/// Lowest degree evaluated in Estrin form rather than Horner form.
+constexpr size_t ESTRIN_MIN_DEGREE = 8;
+
+/**
+ * @brief Rewrites the sums under \p root that are polynomials in a variable into Horner or
+ *        Estrin form.
+ *
+ * Each maximal sum is split into terms of the form `c * x^i * y^j * ... * f / g`, with
+ * integer powers up to MAX_CHAIN_EXPONENT. The variable with the highest power (then the
+ * one in most terms) is factored out, so `a*x^4 + b*x^3 + c*x^2 + d*x + e` becomes
+ * `(((a*x + b)*x + c)*x + d)*x + e`, and the coefficient of each power is rewritten the
+ * same way in the remaining variables. Missing powers multiply by a power of x instead.
+ * Sums in which no variable appears squared or in two terms are left alone.
+ *
+ * From ESTRIN_MIN_DEGREE on, the coefficients are paired as `(c0 + c1*x) + (c2 + c3*x)*x^2
+ * + ...` instead, which takes a few more multiplications but shortens the chain of
+ * dependent operations from 2n to about 2 log n, so native code can overlap them.
+ *
+ * The powers of x are left as "^" nodes for reduceStrength() to expand. The rewrite changes
+ * how results are rounded, so it is only applied with fast math.
+ *
+ * @param graph The graph holding the expression; rewritten nodes are added to it.
+ * @param root  Root of the expression.
+ * @return The root of the rewritten expression.
+ */
+NodeId rewritePolynomials(ExpressionGraph& graph, NodeId root);
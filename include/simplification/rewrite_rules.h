@@ -0,0 +1,125 @@
+#pragma once
+
+#include "pch.h"
+#include "token.h"
+#include "expression_graph.h"
+
+/**
+ * @class RewriteRules
+ * @brief Algebraic rewrite rules written as patterns and compiled into a discrimination tree.
+ *
+ * A rule reads "pattern => replacement", both in the expression syntax extended with
+ * pattern variables: `?x` matches any subexpression, and every occurrence of the same
+ * variable in a pattern must match the same subexpression (e.g. `?x - ?x`). Numbers match
+ * equal numbers, and operators and function calls match the same operator or function
+ * applied to matching operands; plain names are not allowed. The replacement may use the
+ * variables of its pattern, e.g. `?x * 1 => ?x` or `?x ^ 2 => ?x * ?x`.
+ *
+ * Patterns are flattened in preorder and merged into a trie (a discrimination tree) whose
+ * first level is indexed by the root operator or function. Finding the rule for a node
+ * walks the trie along the node's operands instead of trying every rule in turn, and a
+ * node whose root no rule mentions is rejected with a single lookup. When several rules
+ * match, the one added first wins.
+ */
+class RewriteRules {
+public:
+    /// A pattern or replacement: a pattern variable (VARIABLE), a NUMBER, an OPERATOR or a FUNCTION call.
+    struct Term {
+        TokenType type;
+        OperatorType op = OperatorType::UNKNOWN;
+        NUMBER_TYPE number = 0;
+        std::string name;               ///< Called function (FUNCTION only).
+        uint32_t variable = 0;          ///< Index of the pattern variable (VARIABLE only).
+        std::vector<Term> operands;
+    };
+
+    /// A rule parsed but not compiled.
+    struct Rule {
+        Term pattern;
+        Term replacement;
+        uint32_t variables;             ///< Number of pattern variables.
+    };
+
+    /**
+     * @brief Parses \p rule, as add() does, for matchers other than the trie (see saturate()).
+     *
+     * @throws SolverException If \p rule is malformed (see add()).
+     */
+    static Rule parse(const std::string& rule);
+
+    RewriteRules();
+
+    /// Compiles \p rules, in priority order.
+    explicit RewriteRules(const std::vector<std::string>& rules);
+
+    // The trie refers to the function names it owns, so it is moved but not copied
+    RewriteRules(const RewriteRules&) = delete;
+    RewriteRules& operator=(const RewriteRules&) = delete;
+    RewriteRules(RewriteRules&&) = default;
+    RewriteRules& operator=(RewriteRules&&) = default;
+
+    /**
+     * @brief Compiles \p rule and adds it after the existing rules.
+     *
+     * @param rule The rule, as "pattern => replacement".
+     * @throws SolverException If \p rule has no "=>", either side is malformed, or the
+     *         replacement uses a variable its pattern does not bind.
+     */
+    void add(const std::string& rule);
+
+    /**
+     * @brief Rewrites \p node with the first rule whose pattern matches it.
+     *
+     * Only \p node itself is matched, not its operands; the nodes of the replacement are
+     * added to \p graph.
+     *
+     * @return The replacement, or std::nullopt if no rule matches.
+     */
+    std::optional<NodeId> rewrite(ExpressionGraph& graph, NodeId node) const;
+
+    /// Number of rules.
+    size_t size() const { return replacements.size(); }
+
+private:
+    /// What a trie transition consumes: one node (without its operands) of the matched expression.
+    struct Key {
+        TokenType type;
+        OperatorType op;
+        NUMBER_TYPE number;
+        std::string_view name;  ///< Function name; in the trie, a view into functionNames.
+        size_t arity;
+
+        bool operator<(const Key& other) const;
+    };
+
+    /// A trie state: the pattern nodes read so far, in preorder.
+    struct State {
+        std::map<Key, uint32_t> next;                       ///< Transitions on the next node's key; its operands follow.
+        std::vector<std::pair<uint32_t, uint32_t>> binds;   ///< (variable, state): the next operand, whole, is the variable.
+        uint32_t rule;                                      ///< Rule of the patterns ending here, or NO_RULE.
+    };
+
+    /// Parses one side of a rule into a Term.
+    class Parser;
+
+    static constexpr uint32_t NO_RULE = std::numeric_limits<uint32_t>::max();
+    static constexpr NodeId UNBOUND = std::numeric_limits<NodeId>::max();
+
+    /// The key of \p node, or std::nullopt if only a pattern variable can match it (a variable or NaN).
+    static std::optional<Key> keyOf(const GraphNode& node);
+
+    /// Adds the path of \p pattern to the trie from \p state; returns the state it ends in.
+    uint32_t insert(uint32_t state, const Term& pattern);
+
+    /// Matches \p pending (operands still to match, last first) from \p state, keeping the best rule found.
+    void match(const ExpressionGraph& graph, uint32_t state, std::vector<NodeId>& pending, std::vector<NodeId>& bound,
+               uint32_t& best, std::vector<NodeId>& bestBound) const;
+
+    /// Adds \p term to \p graph with the variables replaced by \p bound.
+    static NodeId build(ExpressionGraph& graph, const Term& term, const std::vector<NodeId>& bound);
+
+    std::vector<State> states;      ///< The trie; state 0 is the root.
+    std::vector<Term> replacements; ///< Replacement of each rule.
+    uint32_t variableCount = 0;     ///< Most variables in any pattern.
+    std::unordered_set<std::string> functionNames;  ///< Names of the functions the patterns call.
+};
@@ -3,5 +3,5 @@
 
 class ConstantFoldingRule : public SimplificationRule {
 public:
-    bool apply(const std::vector<Token>& input, std::vector<Token>& output) override;
+    bool apply(const std::vector<Token>& input, std::vector<Token>& output, TokenPool& pool) override;
 };
@@ -7,7 +7,7 @@ class FunctionFoldingRule : public SimplificationRule {
 public:
     // Constructor takes the functions map.
     FunctionFoldingRule(const std::unordered_map<std::string, Function>& functions_map);
-    bool apply(const std::vector<Token>& input, std::vector<Token>& output) override;
+    bool apply(const std::vector<Token>& input, std::vector<Token>& output, TokenPool& pool) override;
 private:
     const std::unordered_map<std::string, Function>& functions;
 };
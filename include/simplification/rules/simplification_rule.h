@@ -2,6 +2,7 @@
 
 #include "pch.h"
 #include "token.h"
+#include "token_pool.h"
 #include "exception.h"
 
 class SimplificationRule {
@@ -10,6 +11,7 @@ public:
     /// @brief Attempt to simplify a given token sequence.
     /// @param input The tokens representing a subexpression.
     /// @param output The simplified tokens if the rule applies.
+    /// @param pool The pool the tokens refer to; new numbers are added to it.
     /// @return true if the rule was applied; false otherwise.
-    virtual bool apply(const std::vector<Token>& input, std::vector<Token>& output) = 0;
+    virtual bool apply(const std::vector<Token>& input, std::vector<Token>& output, TokenPool& pool) = 0;
 };
@@ -1,5 +1,7 @@
 #pragma once
 #include "function.h"
+#include "expression_graph.h"
+#include "rewrite_rules.h"
 #include "rules/simplification_rule.h"
 
 class SimplificationEngine {
@@ -7,22 +9,51 @@ public:
     /// Add a new simplification rule.
     void add_rule(std::unique_ptr<SimplificationRule> rule);
 
+    /// Use the pattern rules \p patterns as well, after the rules added with add_rule(); they must outlive the engine.
+    void add_patterns(const RewriteRules& patterns);
+
     /**
      * @brief Simplify the full postfix token sequence.
      *
-     * This function repeatedly applies all simplification rules on every
-     * sub-expression (by “rebuilding” the expression via a stack) until no rule
-     * makes any further change or a maximum number of passes is reached.
+     * The expression is simplified as an ExpressionGraph (see the overload below) and
+     * expanded back to postfix.
      *
      * @param input The original postfix token vector.
+     * @param pool The pool the tokens refer to.
      * @param functions A table of functions (needed for function rules).
      * @return The fully simplified postfix token vector.
      */
-    std::vector<Token> simplify(const std::vector<Token>& input, const std::unordered_map<std::string, Function>& functions);
+    std::vector<Token> simplify(const std::vector<Token>& input, TokenPool& pool, const std::unordered_map<std::string, Function>& functions);
+
+    /**
+     * @brief Simplify the expression under \p root in \p graph.
+     *
+     * Nodes are visited once each, operands first, so a subexpression shared by several
+     * parents is simplified only once and the whole pass takes time linear in the number of
+     * distinct subexpressions. Only the parents of rewritten nodes are rebuilt; the rest of
+     * the graph is reused as is. A node whose (simplified) operands are all leaves is
+     * presented to the rules as the postfix sequence "operands..., node", and any node is
+     * matched against the pattern rules; the first rule that applies replaces the node,
+     * and the replacement is offered to the rules again until none applies or a maximum
+     * number of rewrites is reached.
+     *
+     * @param graph The graph holding the expression; simplified nodes are added to it.
+     * @param root Root of the expression.
+     * @param pool Pool for the tokens the rules are presented with.
+     * @param functions A table of functions (needed for function rules).
+     * @return The root of the simplified expression.
+     */
+    NodeId simplify(ExpressionGraph& graph, NodeId root, TokenPool& pool, const std::unordered_map<std::string, Function>& functions);
 
 private:
-    /// A single pass that traverses the full expression and applies rules where possible.
-    std::vector<Token> simplifyPass(const std::vector<Token>& input, const std::unordered_map<std::string, Function>& functions, bool &changed);
+    /// Applies the rules to \p node until none applies; returns the resulting node.
+    NodeId rewrite(ExpressionGraph& graph, NodeId node, TokenPool& pool, const std::unordered_map<std::string, Function>& functions);
+
+    /// Applies the first rule added with add_rule() that matches \p node; returns the replacement, if any.
+    std::optional<NodeId> applyRules(ExpressionGraph& graph, NodeId node, TokenPool& pool, const std::unordered_map<std::string, Function>& functions);
 
     std::vector<std::unique_ptr<SimplificationRule>> rules;
+    std::vector<const RewriteRules*> patterns;
+    std::vector<Token> window;      ///< Tokens presented to the rules, reused across nodes.
+    std::vector<Token> candidate;   ///< Output of the rules, reused across nodes.
 };
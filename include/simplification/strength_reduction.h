@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pch.h"
+#include "function.h"
+#include "expression_graph.h"
+
+/// Largest integer exponent expanded into a chain of multiplications under fast math.
+constexpr NUMBER_TYPE MAX_CHAIN_EXPONENT = 32;
+
+/**
+ * @brief Lowers powers and divisions by constants under \p root into cheaper operations.
+ *
+ * Only rewrites that give the same value for every input in every precision are always
+ * applied:
+ *  - `x^0` becomes 1 and `x^1` becomes x;
+ *  - `x^2` becomes `x * x`, the correctly rounded square;
+ *  - `x / c` becomes `x * (1/c)` when c is a power of two whose reciprocal is exact even in
+ *    float, which also drops the division's zero check.
+ *
+ * With \p fastMath, rewrites that round differently from std::pow, or that change the
+ * outcome for some inputs, are applied as well:
+ *  - other integer powers up to MAX_CHAIN_EXPONENT become multiplications by repeated
+ *    squaring (`x^5` is `(x*x)*(x*x)*x`), and negative ones divide 1 by that product, which
+ *    raises a division by zero where std::pow would return infinity;
+ *  - `x^0.5` becomes `sqrt(x)` and `x^-0.5` becomes `1 / sqrt(x)`;
+ *  - division by any other constant becomes multiplication by its rounded reciprocal.
+ *
+ * @param graph     The graph holding the expression; rewritten nodes are added to it.
+ * @param root      Root of the expression.
+ * @param functions The map of function names to Function definitions (sqrt must be the built-in to be used).
+ * @param fastMath  Whether to apply the rewrites that are not exact.
+ * @return The root of the lowered expression.
+ */
+NodeId reduceStrength(ExpressionGraph& graph, NodeId root, const std::unordered_map<std::string, Function>& functions, bool fastMath);
@@ -2,10 +2,23 @@
 
 #include "pch.h"
 #include "token.h"
+#include "token_pool.h"
 #include "symbol_table.h"
 #include "function.h"
 #include "LRU_cache.h"
 #include "simplification.h"
+#include "simplification/equality_saturation.h"
+#include "program.h"
+#include "engine.h"
+#include "native_code.h"
+#include "batch.h"
+#include "hoisting.h"
+#include "array_view.h"
+#include "precision.h"
+#include "compiled_expression.h"
+#include "specialized_expression.h"
+#include "program_cache.h"
+#include "tiering.h"
 
 /**
  * @class Solver
@@ -16,6 +29,8 @@
  * to cache expression results, with an option to enable or disable caching on demand.
  */
 class Solver {
+    friend class SpecializedExpression;
+
 public:
     /**
      * @brief Constructs a Solver instance and registers built-in functions.
@@ -31,14 +46,11 @@ public:
     /**
      * @brief Destructor for the Solver class.
      * 
-     * Ends the profiling session (if enabled). Cleans up any associated resources.
+     * Ends the profiling session (if enabled). Cleans up any associated resources, waiting for
+     * the tier promotion being built on another thread, if any (see setTiering()).
      */
     ~Solver() {
         PROFILE_END_SESSION();
-        if (currentAST) {
-            delete currentAST;
-            currentAST = nullptr;
-        }
     }
 
     /**
@@ -78,14 +90,57 @@ public:
      * 
      * - Internally, this calls setCurrentExpression() which parses the expression (or uses a cached parse if unchanged).
      * - Then it checks the cache (if enabled) to see if the expression result is already stored.
-     * - If not in cache, it evaluates the expression in postfix form and stores the result if caching is on.
+     * - If not in cache, it runs the compiled program on \p engine (or the solver's engine) and stores the result if caching is on.
+     * - With tiering (see setTiering()), the call is counted (even when its result comes from the cache) and may
+     *   promote the expression to a higher tier.
      * 
      * @param expression A string representing the mathematical expression to evaluate (e.g. "3 + 4 * 2").
      * @param debug If true, prints debugging information such as the final postfix representation.
+     * @param engine The execution tier to use for this call; defaults to the one selected with setEngine(),
+     *               or to the engine of the expression's Tier if that is the interpreter and it is tiered.
+     * @param precision The precision to run the program in; defaults to the one selected with setPrecision().
      * @return The computed value of the expression.
      * @throws SolverException If there is a parsing error, missing function, or other runtime error.
      */
-    NUMBER_TYPE evaluate(const std::string& expression, bool debug = false);
+    NUMBER_TYPE evaluate(const std::string& expression, bool debug = false, std::optional<Engine> engine = std::nullopt,
+                         std::optional<Precision> precision = std::nullopt);
+
+    /**
+     * @brief Compiles an expression into a reusable, thread-safe CompiledExpression.
+     *
+     * The expression is parsed, simplified and compiled once, with the constants and
+     * functions declared so far; native code is generated up front for Engine::JIT and
+     * Engine::C. The returned handle does not depend on the solver: later declarations do
+     * not affect it, and it can be evaluated concurrently with caller-supplied variable
+     * values while the solver keeps evaluating other expressions.
+     *
+     * @param expression The mathematical expression to compile (e.g. "x^2 + y").
+     * @param engine The execution tier to compile for; defaults to the one selected with setEngine().
+     * @param precision The precision to run in; defaults to the one selected with setPrecision().
+     * @return The compiled expression.
+     * @throws SolverException If the expression cannot be parsed or compiled.
+     */
+    CompiledExpression compile(const std::string& expression, std::optional<Engine> engine = std::nullopt,
+                               std::optional<Precision> precision = std::nullopt);
+
+    /**
+     * @brief Compiles an expression specialized on some of its variables held fixed.
+     *
+     * The variables in \p fixed are treated as constants at their current values, so the
+     * whole simplifier runs on them and the residual program only computes what depends
+     * on the other variables. When one of them is redeclared with a different value, the
+     * returned handle rebuilds its residual on its next evaluation.
+     *
+     * @param expression The mathematical expression to specialize (e.g. "a*x^2 + b*x + c").
+     * @param fixed Names of the declared variables to hold fixed (e.g. {"a", "b", "c"}).
+     * @param engine The execution tier to compile for; defaults to the one selected with setEngine().
+     * @param precision The precision to run in; defaults to the one selected with setPrecision().
+     * @return The specialized expression, which must not outlive the solver.
+     * @throws SolverException If a fixed name is not a declared variable, or the expression cannot be parsed or compiled.
+     */
+    SpecializedExpression specialize(const std::string& expression, const std::vector<std::string>& fixed,
+                                     std::optional<Engine> engine = std::nullopt,
+                                     std::optional<Precision> precision = std::nullopt);
 
     /**
      * @brief Evaluates a mathematical expression for each value in a range of inputs for one variable.
@@ -98,13 +153,58 @@ public:
      * @param values A vector of values to assign to that variable sequentially.
      * @param expression The mathematical expression to evaluate (e.g. "x^2 + 1").
      * @param debug If true, prints debug info for the parsing phase (once) and indicates evaluations in a loop.
+     * @param threads Number of worker threads (0 uses the hardware concurrency). Results do not depend on it.
+     * @param precision The precision to run the program in; defaults to the one selected with setPrecision().
      * @return A vector of computed results, with one result per value in \p values.
      * @throws SolverException If \p variable is invalid or if an error occurs during evaluation.
      */
     std::vector<NUMBER_TYPE> evaluateForRange(const std::string& variable,
                                          const std::vector<NUMBER_TYPE>& values,
                                          const std::string& expression,
-                                         bool debug = false);
+                                         bool debug = false,
+                                         size_t threads = 0,
+                                         std::optional<Precision> precision = std::nullopt);
+
+    /**
+     * @brief Evaluates an expression for each value of \p values, writing the results into \p results.
+     *
+     * Same as the vector overload, but the inputs are read from and the results written to
+     * caller-owned memory (e.g. a NumPy array), without intermediate copies.
+     *
+     * @param variable The name of the variable to iterate (e.g. "x").
+     * @param values The values to assign to that variable.
+     * @param expression The mathematical expression to evaluate (e.g. "x^2 + 1").
+     * @param results Output, one element per value in \p values. Failed points are set to NaN.
+     * @param debug If true, prints debug info for the parsing phase.
+     * @param threads Number of worker threads (0 uses the hardware concurrency).
+     * @param precision The precision to run the program in; defaults to the one selected with setPrecision().
+     * @throws SolverException If \p variable is invalid, \p results has the wrong size, or the expression is invalid.
+     */
+    void evaluateForRange(const std::string& variable,
+                          const ArrayView& values,
+                          const std::string& expression,
+                          const ArrayView& results,
+                          bool debug = false,
+                          size_t threads = 0,
+                          std::optional<Precision> precision = std::nullopt);
+
+    /**
+     * @brief Prepares evaluateForRange() and returns the sweep, to be run later.
+     *
+     * The expression is parsed, its tier advanced and the declared variables loaded here.
+     * The returned function only reads state copied out of the Solver, so it may run while
+     * other threads use the Solver (the Python bindings release the GIL around it).
+     * \p values and \p results must outlive it.
+     *
+     * @throws SolverException As evaluateForRange(), on preparation.
+     */
+    std::function<void()> prepareRange(const std::string& variable,
+                                       const ArrayView& values,
+                                       const std::string& expression,
+                                       const ArrayView& results,
+                                       bool debug = false,
+                                       size_t threads = 0,
+                                       std::optional<Precision> precision = std::nullopt);
 
 
     /**
@@ -117,17 +217,61 @@ public:
      * The result vector is returned in row-major order with respect to the input vectors in
      * \p valuesSets, i.e., the last variable varies fastest.
      *
+     * The flat index space of the product is split into contiguous slices, one per thread, and
+     * each thread writes its slice of the result vector with its own evaluation state, so the
+     * results are bit-identical to a single-threaded evaluation.
+     *
      * @param variables A list of variable names, e.g., ["x", "y"].
      * @param valuesSets A corresponding list of ranges for each variable, e.g., [[0, 1, 2], [10, 20]].
      * @param expression The expression to evaluate once for every combination (cartesian product).
      * @param debug If true, prints debug info for parsing; does NOT print each evaluation.
+     * @param threads Number of worker threads (0 uses the hardware concurrency). Results do not depend on it.
+     * @param precision The precision to run the program in; defaults to the one selected with setPrecision().
      * @return A flat vector of results (size = product of the lengths of each range in \p valuesSets).
      * @throws SolverException If a variable name is invalid, or expression parsing fails, etc.
      */
     std::vector<NUMBER_TYPE> evaluateForRanges(const std::vector<std::string>& variables,
                                           const std::vector<std::vector<NUMBER_TYPE>>& valuesSets,
                                           const std::string& expression,
-                                          bool debug);
+                                          bool debug,
+                                          size_t threads = 0,
+                                          std::optional<Precision> precision = std::nullopt);
+
+    /**
+     * @brief Evaluates an expression over the cartesian product of \p valuesSets, writing the results into \p results.
+     *
+     * Same as the vector overload, but the inputs are read from and the results written to
+     * caller-owned memory (e.g. NumPy arrays), without intermediate copies.
+     *
+     * @param variables A list of variable names, e.g., ["x", "y"].
+     * @param valuesSets The values of each variable.
+     * @param expression The expression to evaluate once for every combination.
+     * @param results Output in row-major order (last variable fastest). Failed points are set to NaN.
+     * @param debug If true, prints debug info for parsing.
+     * @param threads Number of worker threads (0 uses the hardware concurrency).
+     * @param precision The precision to run the program in; defaults to the one selected with setPrecision().
+     * @throws SolverException If a variable name is invalid, \p results has the wrong size, or the expression is invalid.
+     */
+    void evaluateForRanges(const std::vector<std::string>& variables,
+                           const std::vector<ArrayView>& valuesSets,
+                           const std::string& expression,
+                           const ArrayView& results,
+                           bool debug = false,
+                           size_t threads = 0,
+                           std::optional<Precision> precision = std::nullopt);
+
+    /**
+     * @brief Prepares evaluateForRanges() and returns the sweep, to be run later (see prepareRange()).
+     *
+     * @throws SolverException As evaluateForRanges(), on preparation.
+     */
+    std::function<void()> prepareRanges(const std::vector<std::string>& variables,
+                                        const std::vector<ArrayView>& valuesSets,
+                                        const std::string& expression,
+                                        const ArrayView& results,
+                                        bool debug = false,
+                                        size_t threads = 0,
+                                        std::optional<Precision> precision = std::nullopt);
 
     /**
      * @brief Registers a predefined function with a C++ callback.
@@ -159,13 +303,34 @@ public:
     void declareFunction(const std::string& name, const std::vector<std::string>& args, const std::string& expression);
 
     /**
-     * @brief Clears the solver's expression cache and function cache (if any).
+     * @brief Clears the solver's expression cache and program cache.
      * 
      * This is a direct way to force the solver to discard all cached results. After calling,
      * the next evaluations will re-parse and re-compute the expression outcomes from scratch.
      */
     void clearCache();
 
+    /**
+     * @brief Bounds the program cache.
+     *
+     * The program cache keeps the parsed, simplified and compiled form of the most recently
+     * used expressions (and their native code), so switching between expressions does not
+     * re-parse them. It is independent of setUseCache(), which only controls result caching.
+     * Entries are dropped when a constant or function they refer to is declared.
+     *
+     * @param entries Maximum number of expressions kept (DEFAULT_PROGRAM_CACHE_SIZE by default; 0 disables the cache).
+     * @param bytes Maximum estimated size of the kept entries in bytes (0 for no limit).
+     */
+    void setProgramCacheSize(size_t entries, size_t bytes = 0);
+
+    /**
+     * @brief Returns the hit, miss, eviction and invalidation counters and the size of the program cache.
+     */
+    ProgramCacheStats getProgramCacheStats() const;
+
+    /// Default number of expressions kept by the program cache.
+    static constexpr size_t DEFAULT_PROGRAM_CACHE_SIZE = 512;
+
     /**
      * @brief Toggles whether the solver uses its LRU cache.
      * 
@@ -177,6 +342,170 @@ public:
      */
     void setUseCache(bool useCache);
 
+    /**
+     * @brief Selects the execution tier used by evaluate() and the range evaluations.
+     * 
+     * Engine::JIT compiles each expression to native x86-64 code the first time it is run;
+     * Engine::C emits C and builds it with the system compiler, caching objects on disk.
+     * Engine::BATCH evaluates range inputs a block at a time with the columnar evaluator
+     * (scalar evaluations use the interpreter).
+     * Where native code cannot be generated, evaluation falls back to the bytecode
+     * interpreter. All tiers produce identical results.
+     * 
+     * @param engine The engine to use (Engine::INTERPRETER by default).
+     */
+    void setEngine(Engine engine);
+
+    /**
+     * @brief Returns the execution tier selected with setEngine().
+     */
+    Engine getEngine() const { return engine; }
+
+    /**
+     * @brief Selects the precision compiled programs are executed in.
+     * 
+     * Expressions are always parsed and simplified in NUMBER_TYPE; the compiled program is
+     * then run in \p precision on every engine, so throughput-critical sweeps can run in
+     * double or float while audits keep the full precision of the build. Results are
+     * returned as NUMBER_TYPE and written to range outputs in their own element type.
+     * 
+     * @param precision The precision to use (DEFAULT_PRECISION, the precision of NUMBER_TYPE, by default).
+     */
+    void setPrecision(Precision precision);
+
+    /**
+     * @brief Returns the precision selected with setPrecision().
+     */
+    Precision getPrecision() const { return precision; }
+
+    /**
+     * @brief Enables the simplifications that trade exactness for speed.
+     * 
+     * By default expressions are only rewritten in ways that give the same result for every
+     * input. With fast math, sums and products are also regrouped with their constants
+     * folded, polynomials are evaluated in Horner or Estrin form, integer powers are
+     * expanded into multiplications, `x^0.5` is evaluated with sqrt and divisions by
+     * constants become multiplications by their reciprocal, so results may differ in the
+     * last bits, overflow differently (`x*4*0.25` no longer overflows for large x) and `0^-n`
+     * raises a division by zero. Products with 0 fold to 0, even where the other operand is
+     * infinite (NaN otherwise) or raises an error. Compiled programs and cached results are
+     * discarded when the setting changes.
+     * 
+     * @param enabled Whether to apply the inexact rewrites (false by default).
+     */
+    void setFastMath(bool enabled);
+
+    /**
+     * @brief Returns whether fast math was enabled with setFastMath().
+     */
+    bool getFastMath() const { return fastMath; }
+
+    /**
+     * @brief Enables contracting multiply-adds into fused multiply-adds.
+     * 
+     * With it, after simplification every addition of a product is rewritten with fma
+     * (see contractMultiplyAdds()), which every engine executes with one rounding: `a*b + c`
+     * takes one instruction instead of two and is usually closer to the exact value, but
+     * results change in the last bits. Compiled programs and cached results are discarded
+     * when the setting changes.
+     * 
+     * @param enabled Whether to contract multiply-adds (false by default).
+     */
+    void setFusedMultiplyAdd(bool enabled);
+
+    /**
+     * @brief Returns whether multiply-adds are contracted, see setFusedMultiplyAdd().
+     */
+    bool getFusedMultiplyAdd() const { return fusedMultiplyAdd; }
+
+    /**
+     * @brief Enables the equality-saturation optimizer, for the expressions that run hottest.
+     * 
+     * After simplification, every expression is optimized with saturate(): algebraic
+     * identities (commutativity, associativity, the identities of 0, 1 and negation, ...)
+     * are applied in every direction at once in an e-graph, and the cheapest equivalent
+     * expression is kept, pow and transcendental calls counting most. This finds rewrites
+     * the greedy rules miss, at a compile time bounded by \p limits. The identities hold in
+     * real arithmetic only, so results may differ in the last bits (and regrouped
+     * intermediates may overflow or underflow differently), but errors, domains and special
+     * values are kept. With fast math (see setFastMath()) distributivity, the power laws and
+     * the laws of exp, ln and sqrt are used as well, factoring `a*(x + y) + b*(x + y)` into
+     * `(a + b)*(x + y)` and combining `exp(a)*exp(b)` into `exp(a + b)`, although they do
+     * not keep them (`inf*0 + inf*1` is NaN, `inf*(0 + 1)` is inf). Compiled programs and
+     * cached results are discarded when the setting changes.
+     * 
+     * @param enabled Whether to run the optimizer (false by default).
+     * @param limits  Bounds on the e-graph size, the rounds of rewriting and the time spent per expression.
+     */
+    void setEqualitySaturation(bool enabled, const SaturationLimits& limits = {});
+
+    /**
+     * @brief Returns whether the equality-saturation optimizer is enabled, see setEqualitySaturation().
+     */
+    bool getEqualitySaturation() const { return equalitySaturation; }
+
+    /**
+     * @brief Sets how many inputs Engine::BATCH evaluates per block.
+     * 
+     * Larger blocks amortize per-instruction dispatch over more inputs, smaller ones keep
+     * the working set (one column per register) in cache.
+     * 
+     * @param lanes Inputs per block (BatchProgram::DEFAULT_LANES by default).
+     * @throws SolverException If \p lanes is zero.
+     */
+    void setBatchSize(size_t lanes);
+
+    /**
+     * @brief Returns the number of inputs Engine::BATCH evaluates per block.
+     */
+    size_t getBatchSize() const { return batchSize; }
+
+    /**
+     * @brief Sets when expressions are promoted to a more expensive, faster Tier.
+     * 
+     * With tiering enabled, an expression starts at Tier::BASELINE: it is compiled without
+     * the simplifier, which pays off for formulas evaluated only a few times. Every run of
+     * its program is counted (a range evaluation counts each point, and a result served from
+     * the cache counts as a run); once the count reaches
+     * \p policy.optimizeAfter the expression is rebuilt at Tier::OPTIMIZED, and once it
+     * reaches \p policy.nativeAfter at Tier::NATIVE. With \p policy.background the rebuild
+     * is queued on a thread of the solver, which builds one at a time, while the current
+     * tier keeps serving calls, and is switched to at the first call after it is ready (a
+     * rebuild whose expression is dropped from the cache meanwhile is skipped or discarded
+     * without waiting for it); otherwise it runs in the call that crosses the threshold. While setEngine() selects Engine::INTERPRETER,
+     * calls that do not name an engine run on the engine of the tier (Engine::INTERPRETER
+     * below Tier::NATIVE); any other engine selected with setEngine() is kept at every tier.
+     * 
+     * Tiering does not change compile() and specialize(), which always simplify. Compiled
+     * programs and cached results are discarded when the policy changes.
+     * 
+     * @param policy The thresholds and the native engine (tiering is disabled by default).
+     */
+    void setTiering(const TieringPolicy& policy);
+
+    /**
+     * @brief Returns the tiering policy, see setTiering().
+     */
+    const TieringPolicy& getTiering() const { return tiering; }
+
+    /**
+     * @brief Pins \p expression to \p tier, or unpins it if \p tier is empty.
+     * 
+     * A pinned expression is built at its tier and never promoted, whether tiering is
+     * enabled or not. The program of \p expression is discarded so the next call rebuilds it.
+     * 
+     * @param expression The expression string, as passed to evaluate().
+     * @param tier The tier to pin it to, or std::nullopt to let the policy decide again.
+     */
+    void pinTier(const std::string& expression, std::optional<Tier> tier);
+
+    /**
+     * @brief Returns the tier of \p expression and its execution count.
+     * 
+     * An expression without a compiled program reports the tier it would start at.
+     */
+    TierInfo getTierInfo(const std::string& expression);
+
     /**
      * @brief Lists all declared constants.
      * 
@@ -252,32 +581,122 @@ private:
     void registerBuiltInFunctions();
 
     /**
-     * @brief Parses a mathematical expression from string to postfix.
-     * 
-     * The process includes tokenizing, converting tokens to postfix notation,
-     * and flattening (inlining any user-defined functions). If \p debug is set,
-     * it may print intermediate steps.
-     * 
+     * @brief Parses a mathematical expression into a simplified expression graph.
+     *
+     * The process includes tokenizing, converting tokens to postfix notation, adding the
+     * postfix to an ExpressionGraph (inlining user-defined functions and substituting
+     * constants) and, unless \p optimized is false, simplifying it with optimize(). If
+     * \p debug is set, it prints the expression before and after simplification.
+     *
      * @param expression The input mathematical expression (in infix).
-     * @param debug If true, prints debug information about the tokenization/postfix steps.
-     * @return A vector of Tokens representing the flattened postfix form.
+     * @param graph Receives the nodes of the expression that are reachable from the returned root.
+     * @param debug If true, prints debug information about the parsing steps.
+     * @param dependencies If given, receives the names the expression and its inlined functions refer to.
+     * @param fixed If given, variables substituted by their current values before simplification.
+     * @param optimized Whether to simplify the expression (false for Tier::BASELINE).
+     * @return The root of the simplified expression in \p graph.
      * @throws SolverException If a syntax error or unknown function is encountered.
      */
-    std::vector<Token> parse(const std::string &expression, bool debug = false);
+    NodeId parse(const std::string &expression, ExpressionGraph& graph, bool debug = false,
+                 std::unordered_set<std::string>* dependencies = nullptr,
+                 const std::vector<std::string>* fixed = nullptr, bool optimized = true);
+
+    /// The settings of the optimizing passes, copied so a promotion can run them on another thread.
+    struct OptimizationSettings {
+        bool fastMath;
+        bool fusedMultiplyAdd;
+        bool equalitySaturation;
+        SaturationLimits saturationLimits;
+    };
 
     /**
-     * @brief Parses a mathematical expression from string to postfix.
-     * 
-     * The process includes tokenizing, converting tokens to postfix notation,
-     * and flattening (inlining any user-defined functions). If \p debug is set,
-     * it may print intermediate steps.
-     * 
-     * @param expression The input mathematical expression (in infix).
-     * @param debug If true, prints debug information about the tokenization/postfix steps.
-     * @return A vector of Tokens representing the flattened postfix form.
-     * @throws SolverException If a syntax error or unknown function is encountered.
+     * @brief The current settings of the optimizing passes.
+     */
+    OptimizationSettings optimizationSettings() const {
+        return { fastMath, fusedMultiplyAdd, equalitySaturation, saturationLimits };
+    }
+
+    /**
+     * @brief Runs the optimizing passes on the expression under \p root: simplification,
+     * then equality saturation and multiply-add contraction if enabled in \p settings.
+     *
+     * Reads nothing of the solver, so it can run on another thread with its own \p pool
+     * and a copy of \p functions.
+     *
+     * @param saturation If not null, receives what equality saturation did.
+     * @param contracted If not null, receives the number of multiply-adds contracted.
+     * @return The root of the optimized expression in \p graph.
+     */
+    static NodeId optimize(ExpressionGraph& graph, NodeId root, TokenPool& pool,
+                           const std::unordered_map<std::string, Function>& functions, const OptimizationSettings& settings,
+                           SaturationReport* saturation = nullptr, size_t* contracted = nullptr);
+
+    /**
+     * @brief Compiles \p expression with the variables in \p fixed substituted by their current values.
+     *
+     * The result is not cached; SpecializedExpression keeps it.
+     */
+    CompiledExpression compileSpecialized(const std::string& expression, const std::vector<std::string>& fixed,
+                                          Engine engine, Precision precision);
+
+    /**
+     * @brief Parses \p expression into \p entry's graph unless it was parsed already.
+     */
+    void parseInto(CachedProgram& entry, const std::string& expression, bool debug);
+
+    /**
+     * @brief Returns the program cache entry of \p expression with its program compiled.
+     *
+     * The entry is parsed and compiled on a miss (or always, if \p debug is set, so the
+     * pipeline steps are printed) and stored in the program cache.
+     */
+    std::shared_ptr<CachedProgram> programFor(const std::string& expression, bool debug);
+
+    /**
+     * @brief Returns the optimized program of \p expression, compiling it apart if its
+     * cached entry is at Tier::BASELINE.
+     */
+    Program optimizedProgram(const std::string& expression);
+
+    /**
+     * @brief The tier an expression runs at after \p executions runs, pinned to \p pinned if set.
      */
-    ASTNode* parseAST(const std::string &expression, bool debug = false);
+    Tier targetTier(std::optional<Tier> pinned, size_t executions) const;
+
+    /**
+     * @brief The engine that runs \p entry in calls that do not name one.
+     */
+    Engine engineFor(const CachedProgram& entry) const;
+
+    /**
+     * @brief Counts \p runs of the current program and promotes it when its tier falls behind targetTier().
+     *
+     * A promotion that finished on another thread is installed first. Must be called
+     * before the current program's registers are loaded, since installing replaces it.
+     */
+    void advanceTier(size_t runs);
+
+    /**
+     * @brief Starts building \p entry at \p tier, queued on the promotion thread if the policy says so.
+     */
+    void startPromotion(CachedProgram& entry, Tier tier);
+
+    /**
+     * @brief Switches \p entry to the program of its finished promotion.
+     *
+     * If the promotion failed, the entry stays at its tier and is not promoted again.
+     */
+    void installPromotion(CachedProgram& entry);
+
+    /**
+     * @brief Returns the program cache entry of \p expression with its AST built.
+     */
+    std::shared_ptr<CachedProgram> astFor(const std::string& expression, bool debug);
+
+    /**
+     * @brief Drops the cached programs that refer to \p name, after it was (re)declared.
+     */
+    void invalidatePrograms(const std::string& name);
 
     /**
      * @brief Generates an integer cache key based on an expression string and argument values.
@@ -291,6 +710,114 @@ private:
      */
     std::size_t generateCacheKey(const std::string& base, const std::vector<NUMBER_TYPE>& args);
 
+    /**
+     * @brief Resolves every variable register of the current program to its symbol table slot.
+     *
+     * Resolution is done once per compiled program and redone only when the symbol table's
+     * set of declared variables changes, so steady-state evaluation never looks names up.
+     */
+    void refreshBindings();
+
+    /**
+     * @brief Copies the current variable values into the variable registers of currentRegisters.
+     *
+     * @param overrides Registers the caller fills itself (e.g. range variables); they need not be declared.
+     * @throws SolverException If the program reads a variable that is neither declared nor overridden.
+     */
+    void loadVariables(const std::vector<int>& overrides = {});
+
+    /**
+     * @brief Runs the current program once in precision \p T on \p engine, with the loaded variables.
+     */
+    template <typename T>
+    T run(Engine engine);
+
+    /**
+     * @brief Returns the native code for the current program in precision \p T on \p engine, or nullptr for the interpreter.
+     *
+     * The program is compiled on first use for each engine and precision. If compilation fails
+     * (or the platform is not supported) nullptr is returned and callers fall back to the interpreter.
+     */
+    template <typename T>
+    const TypedNativeCode<T>* nativeCode(Engine engine);
+
+    /**
+     * @brief Compiles \p program in precision \p T for \p engine, or returns nullptr if the engine is unavailable or fails.
+     */
+    template <typename T>
+    static std::unique_ptr<TypedNativeCode<T>> compileNative(const Program& program, Engine engine);
+
+    /// A failed point of a range evaluation: its flat index and the error message.
+    using RangeError = std::pair<size_t, std::string>;
+
+    /**
+     * @struct Sweep
+     * @brief A range evaluation in precision \p T, with everything it reads copied out of the Solver.
+     */
+    template <typename T>
+    struct Sweep {
+        std::vector<int> slots;                         ///< Register of each range variable.
+        std::vector<ArrayView> ranges;                  ///< The values of each range variable.
+        ArrayView results;                              ///< Output, one entry per combination.
+        size_t threads = 1;                             ///< Number of worker threads.
+        Program program;                                ///< The program evaluated.
+        std::vector<T> loaded;                          ///< Its register file, loaded and rounded to T.
+        std::optional<HoistedSweep<T>> hoist;           ///< The hoisted invariants, if worth hoisting.
+        std::shared_ptr<const NativeCode> native;       ///< Native code of program, if the engine is native.
+        std::shared_ptr<const NativeCode> residualNative;  ///< Native code of the residual program of hoist.
+        size_t batchLanes = 0;                          ///< Lanes of the batch engine (0 for the other engines).
+    };
+
+    /**
+     * @brief Prepares the evaluation of the current program over the cartesian product of \p ranges.
+     *
+     * The registers in \p slots receive the values of the corresponding ranges (-1 for
+     * ranges the program does not read); every other register comes from currentRegisters.
+     * Work that does not depend on every range variable is hoisted out of the per-point
+     * program (see HoistedSweep), and the flat index space is split into one contiguous
+     * slice per worker thread. Native code is compiled here; the returned function reads
+     * nothing from the Solver.
+     *
+     * @param slots Register of each range variable.
+     * @param ranges The values of each range variable.
+     * @param results Output, one entry per combination. Failed points are set to NaN.
+     * @param threads Number of worker threads (0 uses the hardware concurrency).
+     * @param precision The precision to run the program in.
+     * @return The sweep, which returns the failed points in index order.
+     */
+    std::function<std::vector<RangeError>()> prepareSweep(const std::vector<int>& slots, const std::vector<ArrayView>& ranges,
+                                                          const ArrayView& results, size_t threads, Precision precision);
+
+    /**
+     * @brief prepareSweep() in precision \p T.
+     */
+    template <typename T>
+    std::function<std::vector<RangeError>()> prepareSweepAs(const std::vector<int>& slots, const std::vector<ArrayView>& ranges,
+                                                            const ArrayView& results, size_t threads);
+
+    /**
+     * @brief Runs a prepared sweep; returns the failed points, in index order.
+     */
+    template <typename T>
+    static std::vector<RangeError> runSweep(Sweep<T>& sweep);
+
+    /**
+     * @brief Evaluates the points [\p begin, \p end) of \p sweep on the calling thread.
+     *
+     * With \p hoist, the residual program runs per point on its tabulated inputs; \p native
+     * is then compiled from the residual program.
+     */
+    template <typename T>
+    static void sweepSlice(const Sweep<T>& sweep, size_t begin, size_t end, const HoistedSweep<T>* hoist,
+                           const TypedNativeCode<T>* native, std::vector<RangeError>& errors);
+
+    /**
+     * @brief Advances \p indices to the next combination of the cartesian product of \p ranges.
+     *
+     * The last index varies fastest; after the last combination the indices wrap to zero.
+     */
+    static void nextCombination(std::vector<size_t>& indices, const std::vector<ArrayView>& ranges);
+
     /**
      * @brief Invalidates solver caches if caching is enabled.
      * 
@@ -323,18 +850,69 @@ private:
     /// Flag indicating whether expression caching is currently active.
     bool cacheEnabled = true;
 
+    /// The execution tier used when evaluate() is not given one.
+    Engine engine = Engine::INTERPRETER;
+
+    /// The precision used when an evaluation is not given one.
+    Precision precision = DEFAULT_PRECISION;
+
+    /// Whether simplification applies the rewrites that are not exact.
+    bool fastMath = false;
+
+    /// Whether multiply-adds are contracted into fma calls after simplification.
+    bool fusedMultiplyAdd = false;
+
+    /// Whether expressions are optimized by equality saturation after simplification.
+    bool equalitySaturation = false;
+
+    /// Bounds on the equality-saturation optimizer.
+    SaturationLimits saturationLimits;
+
+    /// When expressions are promoted to a higher tier.
+    TieringPolicy tiering;
+
+    /// Tiers pinned with pinTier(), by expression string.
+    std::unordered_map<std::string, Tier> pinnedTiers;
+
+    /// Builds the background promotions (see startPromotion()).
+    PromotionQueue promotions;
+
     /// Symbol table for all declared variables and constants (manages their values).
     SymbolTable symbolTable;
 
+    /// Names and literal values referred to by the tokens of every expression parsed.
+    TokenPool tokenPool;
+
     /// The most recent expression string passed to setCurrentExpression().
     std::string currentExpressionPostfix;
 
     /// The most recent expression string passed to setCurrentExpression().
     std::string currentExpressionAST;
 
-    /// The parsed (and flattened) postfix tokens corresponding to currentExpression.
-    std::vector<Token> currentPostfix;
+    /// Parsed and compiled expressions by expression string, most recently used first.
+    LRUCache<std::string, std::shared_ptr<CachedProgram>> programCache{ DEFAULT_PROGRAM_CACHE_SIZE };
+
+    /// Counters of programCache (entries and bytes are filled in by getProgramCacheStats()).
+    ProgramCacheStats programStats;
+
+    /// The program cache entry of currentExpressionPostfix (kept alive even if evicted).
+    std::shared_ptr<CachedProgram> current;
+
+    /// Register file for the current program, reused across evaluations (constants preloaded).
+    std::vector<NUMBER_TYPE> currentRegisters;
+
+    /// currentRegisters converted to each precision run<T>() evaluates in, reused so no evaluation allocates.
+    std::tuple<std::vector<float>, std::vector<double>, std::vector<long double>> typedRegisters;
+
+    /// Inputs per block for Engine::BATCH.
+    size_t batchSize = BatchProgram<NUMBER_TYPE>::DEFAULT_LANES;
+
+    /// Symbol table slot of each variable register of the current program (SymbolTable::npos if undeclared).
+    std::vector<size_t> currentBindings;
+
+    /// SymbolTable::layoutVersion() that currentBindings were resolved against.
+    size_t currentBindingsVersion = 0;
 
-    /// The parsed (and flattened) AST tokens corresponding to currentExpression.
-    ASTNode* currentAST;
+    /// The program cache entry of currentExpressionAST, with its AST built.
+    std::shared_ptr<CachedProgram> currentAST;
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "pch.h"
+#include "compiled_expression.h"
+
+class Solver;
+
+/**
+ * @class SpecializedExpression
+ * @brief An expression compiled with some of its variables held fixed, returned by Solver::specialize().
+ *
+ * The fixed variables are substituted by their current values before simplification, so
+ * the whole optimizer (constant folding, function folding, strength reduction and the
+ * opt-in rewrites) runs on them and the residual program only computes what depends on
+ * the remaining inputs.
+ *
+ * Unlike a CompiledExpression, the handle refers to its solver: before each evaluation it
+ * compares the values of the fixed variables in the solver with those the residual was
+ * built with, and rebuilds the residual if one changed. Constants and functions are those
+ * declared when the residual was (last) built. The handle must not outlive its solver, and
+ * must not be evaluated from several threads at once.
+ */
+class SpecializedExpression {
+public:
+    /// The source expression.
+    const std::string& expression() const { return source; }
+
+    /// Names of the variables held fixed.
+    const std::vector<std::string>& fixed() const { return fixedNames; }
+
+    /// Names of the other variables the expression reads, in the order evaluate() expects their values.
+    const std::vector<std::string>& variables() const { return inputs; }
+
+    /// The execution tier the residual is compiled for.
+    Engine engine() const { return tier; }
+
+    /// The precision the residual is executed in.
+    Precision precision() const { return scalar; }
+
+    /**
+     * @brief The residual program for the current values of the fixed variables, rebuilt first if one changed.
+     *
+     * Its variables() are the inputs it still reads, a subset of variables().
+     */
+    const CompiledExpression& residual();
+
+    /// Number of times the residual was rebuilt after a fixed variable changed.
+    size_t rebuildCount() const { return rebuilds; }
+
+    /**
+     * @brief Evaluates the expression with the given input values and the current values of the fixed variables.
+     *
+     * @param values One value per entry of variables(), in the same order.
+     * @return The value of the expression.
+     * @throws SolverException If the number of values is wrong, a fixed variable is no longer
+     *         declared, or on a runtime error.
+     */
+    NUMBER_TYPE evaluate(const std::vector<NUMBER_TYPE>& values);
+
+    /**
+     * @brief Evaluates the expression with input values looked up by name.
+     *
+     * Names that are not inputs (including the fixed variables) are ignored.
+     *
+     * @param values Value of each input, by name.
+     * @return The value of the expression.
+     * @throws SolverException If an input is missing, a fixed variable is no longer declared, or on a runtime error.
+     */
+    NUMBER_TYPE evaluate(const std::unordered_map<std::string, NUMBER_TYPE>& values);
+
+private:
+    friend class Solver;
+
+    SpecializedExpression(Solver& solver, std::string expression, std::vector<std::string> fixed,
+                          std::vector<std::string> inputs, Engine engine, Precision precision);
+
+    /// Rebuilds the residual unless it was built with the current values of the fixed variables.
+    void refresh();
+
+    /// Compiles the residual with the current values of the fixed variables and maps its variables to inputs.
+    void rebuild();
+
+    Solver* solver;                         ///< The solver the fixed variables are read from.
+    std::string source;                     ///< The source expression.
+    std::vector<std::string> fixedNames;    ///< The variables held fixed.
+    std::vector<std::string> inputs;        ///< The other variables of the expression.
+    Engine tier;                            ///< Engine the residual is compiled for.
+    Precision scalar;                       ///< Precision the residual runs in.
+    std::vector<size_t> slots;              ///< Symbol table slot of each fixed variable.
+    std::optional<size_t> layout;           ///< Symbol table layout version slots were resolved in (none before the first refresh).
+    std::vector<NUMBER_TYPE> bound;         ///< Values of the fixed variables the residual was built with.
+    std::optional<CompiledExpression> compiled;  ///< The residual program.
+    std::vector<size_t> positions;          ///< Index in inputs of each variable of the residual.
+    size_t rebuilds = 0;                    ///< Rebuilds after the first build.
+};
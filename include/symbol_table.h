@@ -22,6 +22,9 @@ struct SymbolEntry {
 
 class SymbolTable {
 public:
+    // Returned by variableSlot() when a name is not a declared variable
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
     // Declare a constant (stored separately for fast lookups)
     void declareConstant(const std::string& name, NUMBER_TYPE value);
 
@@ -34,6 +37,15 @@ public:
     // Fast direct access to a variable's value (unsafe but fast)
     NUMBER_TYPE* getVariablePtr(const std::string& name);
 
+    // Stable index of a variable in the value vector, or npos if it is not declared
+    size_t variableSlot(const std::string& name) const;
+
+    // Value of the variable at a slot returned by variableSlot() (no bounds checking)
+    NUMBER_TYPE variableValue(size_t slot) const { return variables[slot].value; }
+
+    // Incremented whenever variables are added or removed, i.e. whenever resolved slots may be stale
+    size_t layoutVersion() const { return layout; }
+
     // Clears all variables but keeps constants
     void clearVariables();
 
@@ -62,6 +74,9 @@ private:
     // Maps variable names to indices in the `variables` vector
     std::unordered_map<std::string, size_t> variableIndex;
 
+    // Bumped on every change to the set of declared variables
+    size_t layout = 0;
+
     // Small cache for frequently accessed symbols
     mutable std::string cachedSymbolName;
     mutable NUMBER_TYPE cachedSymbolValue;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "pch.h"
+#include "engine.h"
+
+/**
+ * @enum Tier
+ * @brief How much work the Solver has put into an expression's program.
+ *
+ * A higher tier costs more to build and less to run. Tiers may differ in the last bits
+ * where the optimizing passes do (see Solver::setFastMath()).
+ */
+enum class Tier {
+    BASELINE,       ///< Compiled as parsed, with user functions inlined and constants substituted; run by the interpreter.
+    OPTIMIZED,      ///< Simplified by every enabled pass; run by the interpreter.
+    NATIVE          ///< Simplified, and run by the native engine of the TieringPolicy.
+};
+
+/**
+ * @brief Parses a tier name ("baseline", "optimized" or "native").
+ *
+ * @throws SolverException If \p name is not a known tier.
+ */
+inline Tier tierFromString(const std::string& name) {
+    if (name == "baseline") return Tier::BASELINE;
+    if (name == "optimized") return Tier::OPTIMIZED;
+    if (name == "native") return Tier::NATIVE;
+    throw SolverException("Unknown tier '" + name + "'. Expected 'baseline', 'optimized' or 'native'.");
+}
+
+/**
+ * @brief Returns the name of \p tier, as accepted by tierFromString().
+ */
+inline std::string tierToString(Tier tier) {
+    switch (tier) {
+        case Tier::BASELINE: return "baseline";
+        case Tier::OPTIMIZED: return "optimized";
+        case Tier::NATIVE: return "native";
+    }
+    return "unknown";
+}
+
+/**
+ * @struct TieringPolicy
+ * @brief When the Solver promotes an expression to a higher tier, see Solver::setTiering().
+ */
+struct TieringPolicy {
+    bool enabled = false;               ///< Whether expressions start at Tier::BASELINE and are promoted as they run.
+    size_t optimizeAfter = 100;         ///< Executions after which an expression is promoted to Tier::OPTIMIZED.
+    size_t nativeAfter = 1000;          ///< Executions after which an expression is promoted to Tier::NATIVE.
+    Engine nativeEngine = Engine::JIT;  ///< The engine Tier::NATIVE runs on.
+    bool background = true;             ///< Whether promotions are built on a background thread.
+
+    bool operator==(const TieringPolicy&) const = default;
+};
+
+/**
+ * @struct TierInfo
+ * @brief The tier of an expression and what led to it, see Solver::getTierInfo().
+ */
+struct TierInfo {
+    Tier tier = Tier::OPTIMIZED;        ///< The tier the expression runs at.
+    size_t executions = 0;              ///< Times its program ran (a range evaluation counts each point).
+    bool promoting = false;             ///< Whether a promotion is being built.
+    bool pinned = false;                ///< Whether the tier was pinned with Solver::pinTier().
+};
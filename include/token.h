@@ -8,7 +8,7 @@
  * 
  * The TokenType enum defines the types of tokens that can be present in a mathematical expression.
  */
-enum TokenType { 
+enum TokenType : uint8_t { 
     NUMBER,          ///< A numeric constant (e.g., 42, 3.14)
     VARIABLE,        ///< A variable (e.g., x, y)
     OPERATOR,        ///< An operator (e.g., +, -, *, /, ^)
@@ -19,7 +19,7 @@ enum TokenType {
 };
 
 
-enum class OperatorType {
+enum class OperatorType : uint8_t {
     ADD,    // +
     SUB,    // -
     MUL,    // *
@@ -28,30 +28,31 @@ enum class OperatorType {
     UNKNOWN // Fallback
 };
 
+/// Id of a name interned in a TokenPool.
+using SymbolId = uint32_t;
+
 /**
  * @struct Token
  * @brief Represents a token in a mathematical expression.
  * 
- * When the token is a number, the numeric value is precomputed and stored in
- * the numericValue field. This saves us from having to call std::stold() during evaluation.
+ * A token holds no text: \p id refers to its TokenPool, as the index of the value in the
+ * constant pool for a NUMBER and as the interned symbol for any other token. Names,
+ * operators and delimiters therefore compare as integers, and copying a token copies
+ * 8 bytes.
  */
 struct Token {
     TokenType type;         ///< The type of the token
-    std::string value;      ///< The textual representation (for non-operator tokens)
-    NUMBER_TYPE numericValue;  ///< Precomputed numeric value (only valid if type == NUMBER)
     OperatorType op;        ///< Operator type (only valid if type == OPERATOR)
+    uint32_t id;            ///< Constant pool index (NUMBER) or symbol id (other tokens) in the TokenPool
+
+    Token(TokenType t, uint32_t id, OperatorType op = OperatorType::UNKNOWN)
+        : type(t), op(op), id(id) {}
 
-    // Constructor for all tokens:
-    Token(TokenType t, const std::string &val)
-        : type(t), value(val), numericValue(0), op(OperatorType::UNKNOWN)
-    {
-        if (t == NUMBER) {
-            numericValue = std::stold(val);
-        }
-    }
+    Token() : type(NUMBER), op(OperatorType::UNKNOWN), id(0) {}
 
-    Token() : type(NUMBER), value(), numericValue(0), op(OperatorType::UNKNOWN) {}
+    bool operator==(const Token& other) const = default;
 };
 
+static_assert(sizeof(Token) <= 16, "Tokens are meant to stay small enough to copy freely");
+
 using Env = std::unordered_map<std::string, NUMBER_TYPE>;
-using EvalFunc = std::function<NUMBER_TYPE(const Env&)>;
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "pch.h"
+#include "token.h"
+#include <deque>
+#include <string_view>
+
+/// Hash of a number consistent with SameNumber.
+struct NumberHash {
+    size_t operator()(NUMBER_TYPE value) const;
+};
+
+/// Number equality that tells -0 from 0 and treats NaN as equal to itself.
+struct SameNumber {
+    bool operator()(NUMBER_TYPE a, NUMBER_TYPE b) const;
+};
+
+/**
+ * @class TokenPool
+ * @brief The names and literal values the tokens of a Solver refer to.
+ *
+ * Names (variables, functions, and the text of operators and delimiters) are interned
+ * once and get a SymbolId, and numbers are stored once each in a constant pool, so a
+ * Token only carries a 32-bit id. The operators, parentheses, comma and unary negation
+ * have fixed ids, which lets the parser recognise them without looking at any text.
+ *
+ * Ids stay valid for the lifetime of the pool.
+ */
+class TokenPool {
+public:
+    /// Symbol ids interned by the constructor.
+    enum : SymbolId {
+        LEFT_PAREN,     ///< "("
+        RIGHT_PAREN,    ///< ")"
+        COMMA,          ///< ","
+        NEG,            ///< "neg", the function unary minus is parsed into
+        OPERATORS       ///< Id of the first operator; operatorSymbol(op) is OPERATORS + op
+    };
+
+    TokenPool();
+
+    /// Returns the id of \p name, interning it if needed.
+    SymbolId intern(std::string_view name);
+
+    /// The name of symbol \p id.
+    const std::string& name(SymbolId id) const { return names[id]; }
+
+    /// Returns the constant pool index of \p value, adding it if needed.
+    uint32_t constant(NUMBER_TYPE value);
+
+    /// The value at constant pool index \p index.
+    NUMBER_TYPE number(uint32_t index) const { return numbers[index]; }
+
+    /// The symbol id of operator \p op.
+    static SymbolId operatorSymbol(OperatorType op) { return OPERATORS + static_cast<SymbolId>(op); }
+
+    /// A NUMBER token for \p value.
+    Token numberToken(NUMBER_TYPE value) { return Token(NUMBER, constant(value)); }
+
+    /// An OPERATOR token for \p op.
+    static Token operatorToken(OperatorType op) { return Token(OPERATOR, operatorSymbol(op), op); }
+
+    /// A VARIABLE or FUNCTION token named \p name.
+    Token symbolToken(TokenType type, std::string_view name) { return Token(type, intern(name)); }
+
+    /// The text of \p token: its name, or its value for a NUMBER.
+    std::string text(const Token& token) const;
+
+private:
+    std::deque<std::string> names;                                     ///< Name of each symbol (a deque keeps them in place).
+    std::unordered_map<std::string_view, SymbolId> symbols;            ///< Name -> symbol id; views into names.
+    std::vector<NUMBER_TYPE> numbers;                                  ///< The constant pool.
+    std::unordered_map<NUMBER_TYPE, uint32_t, NumberHash, SameNumber> constants;  ///< Value -> constant pool index.
+};
@@ -2,35 +2,37 @@
 
 #include "pch.h"
 #include "token.h"
+#include "token_pool.h"
 #include "exception.h"
 
 /**
  * @class Tokenizer
  * @brief A static utility class for tokenizing mathematical expressions.
  * 
- * The Tokenizer class provides functions to convert a mathematical expression string
- * into a series of tokens (numbers, variables, operators, etc.) using regular expressions.
+ * The Tokenizer class converts a mathematical expression string into a series of tokens
+ * (numbers, variables, operators, etc.) in a single hand-written scan, checking the
+ * syntax as it goes.
  */
 class Tokenizer {
 public:
     /**
      * @brief Tokenizes a mathematical expression into tokens.
+     *
+     * Numbers are digits with an optional fractional part and are converted with
+     * std::from_chars; names are a letter or underscore followed by letters, digits or
+     * underscores, and are function calls when the next non-blank character is '('. A '-'
+     * where an operand is expected is a negation.
      * 
      * @param equation The equation to tokenize.
+     * @param pool Receives the names and numbers the tokens refer to.
      * @return A vector of tokens representing the equation.
+     * @throws SolverException On an unknown character, an operator or comma where an operand
+     *         is expected, or unbalanced parentheses, with the position of the offending
+     *         character; or if the expression is empty or ends with an operator.
      */
-    static std::vector<Token> tokenize(const std::string& equation);
+    static std::vector<Token> tokenize(const std::string& equation, TokenPool& pool);
 
 private:
-    static std::sregex_iterator tokenizeUsingRegex(const std::string& equation);
-
-    static void processMatch(const std::string& match, std::vector<Token>& tokens, std::sregex_iterator& it, const std::sregex_iterator& end);
-
-    static void handleNumberToken(const std::string& match, std::vector<Token>& tokens, std::sregex_iterator& it, const std::sregex_iterator& end);
-
-    static void handleVariableOrFunctionToken(const std::string& match, std::vector<Token>& tokens, std::sregex_iterator& it, const std::sregex_iterator& end);
-
-    static void handleOperatorToken(const std::string& match, std::vector<Token>& tokens, std::sregex_iterator& it, const std::sregex_iterator& end);
-
-    static bool isUnaryContext(const Token& lastToken);
+    /// Appends the NUMBER token of \p value, merged into a preceding negation unless \p next is '^'.
+    static void handleNumberToken(NUMBER_TYPE value, std::vector<Token>& tokens, TokenPool& pool, char next);
 };
@@ -19,8 +19,11 @@ namespace Validator {
 
     /**
      * @brief Validate the syntax of the given expression.
+     *
+     * This is the check Tokenizer::tokenize() makes while scanning, without keeping the tokens.
      * 
      * @param expression The expression to validate.
+     * @throws SolverException Describing the first syntax error and its position.
      */
     void isValidSyntax(const std::string& expression);
 }
@@ -2,197 +2,238 @@
 #include "ast.h"
 #include "exception.h" // SolverException, if needed
 
-namespace AST {
+/**
+ * Lays a SyntaxTree out from an ExpressionGraph. A node's children get consecutive
+ * indices, reserved when the node is placed, and the node array is sized by a first walk
+ * over the same shape so it is allocated once.
+ */
+class SyntaxTreeBuilder {
+public:
+    explicit SyntaxTreeBuilder(const ExpressionGraph& graph) : graph(graph) {}
 
-ASTNode* buildASTFromPostfix(const std::vector<Token> &postfix, const std::unordered_map<std::string, Function> &functions)
-{
-    std::stack<ASTNode*> nodeStack;
+    SyntaxTree build(NodeId root) {
+        std::unordered_set<NodeId> counted;
+        tree.nodes.reserve(count(root, counted));
+        tree.nodes.emplace_back();
+        place(0, root);
+        return std::move(tree);
+    }
 
-    for (const auto &token : postfix)
-    {
-        switch (token.type)
-        {
-        case NUMBER:
-        case VARIABLE:
-        {
-            // Create a leaf node
-            ASTNode* node = new ASTNode(token);
-            nodeStack.push(node);
-            break;
+private:
+    // Number of AST nodes the subtree of id needs, given the nodes already counted elsewhere.
+    size_t count(NodeId id, std::unordered_set<NodeId>& counted) const {
+        if (counted.count(id)) {
+            return 1;
         }
-
-        case OPERATOR:
-        {
-            // For a binary operator, we pop 2 children (right, then left) from the stack
-            if (nodeStack.size() < 2) {
-                throw SolverException("Not enough operands for operator '" + token.value + "' when building AST.");
-            }
-
-            ASTNode* rightChild = nodeStack.top(); 
-            nodeStack.pop();
-            ASTNode* leftChild  = nodeStack.top(); 
-            nodeStack.pop();
-
-            ASTNode* opNode = new ASTNode(token);
-            opNode->children.push_back(leftChild);
-            opNode->children.push_back(rightChild);
-
-            nodeStack.push(opNode);
-            break;
+        size_t total = 1;
+        for (NodeId child : graph[id].children) {
+            total += count(child, counted);
         }
+        if (!graph.isLeaf(id)) {
+            counted.insert(id);
+        }
+        return total;
+    }
 
-        case FUNCTION:
-        {
-            // Predefined function: find how many arguments
-            auto it = functions.find(token.value);
-            if (it == functions.end()) {
-                throw SolverException("Unknown function '" + token.value + "' in AST construction.");
-            }
-            const Function &func = it->second;
-            const size_t argCount = func.argCount;
-
-            if (nodeStack.size() < argCount) {
-                throw SolverException("Not enough arguments for function '" + token.value + "' in AST construction.");
-            }
-
-            // Pop 'argCount' children (right to left in stack order)
-            std::vector<ASTNode*> argNodes(argCount);
-            for (size_t i = 0; i < argCount; ++i) {
-                argNodes[argCount - 1 - i] = nodeStack.top();
-                nodeStack.pop();
-            }
+    // Fills tree.nodes[index] with graph node id; a node already built elsewhere becomes a leaf reading its slot.
+    void place(uint32_t index, NodeId id) {
+        const GraphNode& source = graph[id];
+        ASTNode node;
+        node.type = source.type;
+        node.op = source.op;
+        node.value = source.number;
+        if (source.type == VARIABLE || source.type == FUNCTION) {
+            node.name = nameIndex(source.name);
+        }
 
-            // Create a function node, attach the children
-            ASTNode* funcNode = new ASTNode(token);
-            for (ASTNode* child : argNodes) {
-                funcNode->children.push_back(child);
+        auto it = built.find(id);
+        if (it != built.end()) {
+            ASTNode& definition = tree.nodes[it->second];
+            if (definition.slot < 0) {
+                definition.slot = static_cast<int32_t>(tree.slots++);
             }
+            node.reuse = definition.slot;
+            tree.nodes[index] = node;
+            return;
+        }
 
-            nodeStack.push(funcNode);
-            break;
+        node.first = static_cast<uint32_t>(tree.nodes.size());
+        node.count = static_cast<uint32_t>(source.children.size());
+        tree.nodes[index] = node;
+        tree.nodes.resize(tree.nodes.size() + node.count);
+        for (uint32_t k = 0; k < node.count; ++k) {
+            place(node.first + k, source.children[k]);
+        }
+        // Registered once complete: the first use is evaluated before any later one
+        if (node.count > 0) {
+            built.emplace(id, index);
         }
+    }
 
-        default:
-            // Normally, the flattened postfix should not contain parentheses or user-defined FUNCTION tokens.
-            throw SolverException("Unsupported token type in flattened postfix for AST building: " + token.value);
+    uint32_t nameIndex(const std::string& name) {
+        auto [it, inserted] = nameIndices.try_emplace(name, static_cast<uint32_t>(tree.names.size()));
+        if (inserted) {
+            tree.names.push_back(name);
         }
+        return it->second;
     }
 
-    // At the end, we should have exactly 1 node in the stack
-    if (nodeStack.size() != 1) {
-        throw SolverException("Error building AST: leftover nodes in the stack.");
+    const ExpressionGraph& graph;
+    SyntaxTree tree;
+    std::unordered_map<NodeId, uint32_t> built;             ///< Index of the node built for each shared graph node.
+    std::unordered_map<std::string, uint32_t> nameIndices;  ///< Index of each name in tree.names.
+};
+
+size_t SyntaxTree::byteSize() const {
+    size_t bytes = sizeof(SyntaxTree) + nodes.capacity() * sizeof(ASTNode);
+    for (const std::string& name : names) {
+        bytes += sizeof(std::string) + name.capacity();
     }
+    return bytes;
+}
 
-    // This is the root of our AST
-    ASTNode* root = nodeStack.top();
-    nodeStack.pop();
+namespace AST {
 
-    return root;
+SyntaxTree buildASTFromPostfix(const std::vector<Token> &postfix, const TokenPool &pool, const std::unordered_map<std::string, Function> &functions)
+{
+    ExpressionGraph graph;
+    NodeId root = graph.addPostfix(postfix, pool, functions);
+    return buildASTFromGraph(graph, root);
 }
 
-NUMBER_TYPE evaluateAST(const ASTNode* node, const SymbolTable& symbolTable, const std::unordered_map<std::string, Function>& functions)
+SyntaxTree buildASTFromGraph(const ExpressionGraph& graph, NodeId root)
 {
-    if (!node) {
-        // You could throw or return 0.0 if you expect never to have null in a valid AST.
-        throw SolverException("Invalid AST: encountered a null node during evaluation.");
-    }
+    return SyntaxTreeBuilder(graph).build(root);
+}
 
-    switch (node->token.type)
-    {
-    case NUMBER:
-    {
-        // Leaf node with a numeric value
-        return stringToNumber(node->token.value);
-    }
-    case VARIABLE:
-    {
-        // Leaf node referencing a variable; look it up in the symbol table
-        return symbolTable.lookupSymbol(node->token.value);
-    }
-    case OPERATOR:
+namespace {
+
+// Walks a SyntaxTree, keeping the values of shared subtrees in slots.
+class Evaluator {
+public:
+    Evaluator(const SyntaxTree& tree, const SymbolTable& symbolTable, const std::unordered_map<std::string, Function>& functions)
+        : tree(tree), symbolTable(symbolTable), functions(functions), slots(tree.slotCount()) {}
+
+    NUMBER_TYPE value(uint32_t index)
     {
-        // We expect exactly 2 children for a binary operator
-        if (node->children.size() != 2) {
-            throw SolverException("Invalid AST: operator node with != 2 children.");
-        }
-        NUMBER_TYPE leftVal  = evaluateAST(node->children[0], symbolTable, functions);
-        NUMBER_TYPE rightVal = evaluateAST(node->children[1], symbolTable, functions);
-
-        const std::string& op = node->token.value;
-        if      (op == "+") return leftVal + rightVal;
-        else if (op == "-") return leftVal - rightVal;
-        else if (op == "*") return leftVal * rightVal;
-        else if (op == "/") {
-            if (std::fabs(rightVal) < 1e-14) {
-                throw SolverException("Division by zero error in AST evaluation.");
-            }
-            return leftVal / rightVal;
-        }
-        else if (op == "^") {
-            return std::pow(leftVal, rightVal);
+        const ASTNode& node = tree[index];
+        if (node.reuse >= 0) {
+            return slots[node.reuse];
         }
-        else {
-            throw SolverException("Unknown operator '" + op + "' in AST evaluation.");
+        NUMBER_TYPE result = compute(node);
+        if (node.slot >= 0) {
+            slots[node.slot] = result;
         }
+        return result;
     }
-    case FUNCTION:
+
+private:
+    NUMBER_TYPE compute(const ASTNode& node)
     {
-        // For a predefined function node, evaluate all children
-        auto it = functions.find(node->token.value);
-        if (it == functions.end()) {
-            throw SolverException("Unknown function '" + node->token.value + "' in AST evaluation.");
+        switch (node.type)
+        {
+        case NUMBER:
+        {
+            // Leaf node with a numeric value
+            return node.value;
         }
-        const Function& func = it->second;
-
-        // Evaluate each argument
-        std::vector<NUMBER_TYPE> argVals;
-        argVals.reserve(node->children.size());
-        for (auto* child : node->children) {
-            NUMBER_TYPE val = evaluateAST(child, symbolTable, functions);
-            argVals.push_back(val);
+        case VARIABLE:
+        {
+            // Leaf node referencing a variable; look it up in the symbol table
+            return symbolTable.lookupSymbol(tree.name(node));
         }
+        case OPERATOR:
+        {
+            // We expect exactly 2 children for a binary operator
+            if (node.count != 2) {
+                throw SolverException("Invalid AST: operator node with != 2 children.");
+            }
+            NUMBER_TYPE leftVal  = value(node.first);
+            NUMBER_TYPE rightVal = value(node.first + 1);
 
-        // Call the predefined function callback
-        NUMBER_TYPE result = 0.0;
-        try {
-            result = func.callback(argVals);
-        }
-        catch (const std::exception &e) {
-            throw SolverException("Error calling function '" + node->token.value + "': " + e.what());
+            switch (node.op) {
+                case OperatorType::ADD: return leftVal + rightVal;
+                case OperatorType::SUB: return leftVal - rightVal;
+                case OperatorType::MUL: return leftVal * rightVal;
+                case OperatorType::DIV:
+                    if (std::fabs(rightVal) < 1e-14) {
+                        throw SolverException("Division by zero error in AST evaluation.");
+                    }
+                    return leftVal / rightVal;
+                case OperatorType::POW: return std::pow(leftVal, rightVal);
+                default:
+                    throw SolverException(std::string("Unknown operator '") + operatorSymbol(node.op) + "' in AST evaluation.");
+            }
         }
+        case FUNCTION:
+        {
+            // For a predefined function node, evaluate all children
+            auto it = functions.find(tree.name(node));
+            if (it == functions.end()) {
+                throw SolverException("Unknown function '" + tree.name(node) + "' in AST evaluation.");
+            }
+            const Function& func = it->second;
 
-        return result;
-    }
-    default:
-        throw SolverException("Unsupported token type in AST evaluation: " + node->token.value);
+            // Evaluate each argument
+            std::vector<NUMBER_TYPE> argVals;
+            argVals.reserve(node.count);
+            for (uint32_t k = 0; k < node.count; ++k) {
+                argVals.push_back(value(node.first + k));
+            }
+
+            // Call the predefined function callback
+            NUMBER_TYPE result = 0.0;
+            try {
+                result = func.callback(argVals);
+            }
+            catch (const std::exception &e) {
+                throw SolverException("Error calling function '" + tree.name(node) + "': " + e.what());
+            }
+
+            return result;
+        }
+        default:
+            throw SolverException("Unsupported token type in AST evaluation.");
+        }
     }
-}
 
-static void printASTRecursive(const ASTNode* node, const std::string& prefix, bool isLast)
+    const SyntaxTree& tree;
+    const SymbolTable& symbolTable;
+    const std::unordered_map<std::string, Function>& functions;
+    std::vector<NUMBER_TYPE> slots;
+};
+
+void printASTRecursive(const SyntaxTree& tree, uint32_t index, const std::string& prefix, bool isLast)
 {
-    if (!node) return;
+    const ASTNode& node = tree[index];
 
     // Print the prefix and the branch symbol
     std::cout << prefix << (isLast ? "\\-- " : "|-- ");
 
-    // Describe the node based on its token type
-    switch (node->token.type) {
+    // Describe the node based on its type
+    switch (node.type) {
         case NUMBER:
-            std::cout << "NUMBER(" << node->token.value << ")";
+            std::cout << "NUMBER(" << numberToString(node.value) << ")";
             break;
         case VARIABLE:
-            std::cout << "VARIABLE(" << node->token.value << ")";
+            std::cout << "VARIABLE(" << tree.name(node) << ")";
             break;
         case OPERATOR:
-            std::cout << "OPERATOR(" << node->token.value << ")";
+            std::cout << "OPERATOR(" << operatorSymbol(node.op) << ")";
             break;
         case FUNCTION:
-            std::cout << "FUNCTION(" << node->token.value << ")";
+            std::cout << "FUNCTION(" << tree.name(node) << ")";
             break;
         default:
-            std::cout << "UNKNOWN_TOKEN(" << node->token.value << ")";
+            std::cout << "UNKNOWN_TOKEN";
             break;
     }
+    if (node.reuse >= 0) {
+        std::cout << " = $" << node.reuse;
+    }
+    if (node.slot >= 0) {
+        std::cout << " -> $" << node.slot;
+    }
     std::cout << std::endl;
 
     // Prepare the prefix for child nodes.
@@ -201,15 +242,26 @@ static void printASTRecursive(const ASTNode* node, const std::string& prefix, bo
     std::string childPrefix = prefix + (isLast ? "    " : "|   ");
 
     // Recurse for each child
-    for (size_t i = 0; i < node->children.size(); ++i) {
-        bool childIsLast = (i == node->children.size() - 1);
-        printASTRecursive(node->children[i], childPrefix, childIsLast);
+    for (uint32_t k = 0; k < node.count; ++k) {
+        printASTRecursive(tree, node.first + k, childPrefix, k + 1 == node.count);
+    }
+}
+
+} // namespace
+
+NUMBER_TYPE evaluateAST(const SyntaxTree& tree, const SymbolTable& symbolTable, const std::unordered_map<std::string, Function>& functions)
+{
+    if (tree.size() == 0) {
+        throw SolverException("Invalid AST: the tree is empty.");
     }
+    return Evaluator(tree, symbolTable, functions).value(0);
 }
 
-void printAST(const ASTNode* root)
+void printAST(const SyntaxTree& tree)
 {
-    printASTRecursive(root, "", true);
+    if (tree.size() > 0) {
+        printASTRecursive(tree, 0, "", true);
+    }
 }
 
 }
@@ -0,0 +1,178 @@
+#include "batch.h"
+
+namespace {
+
+// Element-wise kernels. They are kept free of branches and calls (except pow, fma and the
+// built-ins) so the compiler can vectorize them. The destination may alias an operand
+// (temporaries are reused once their value is dead), which is fine for element-wise loops.
+
+template <typename T>
+void add(T* d, const T* a, const T* b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = a[i] + b[i];
+}
+
+template <typename T>
+void sub(T* d, const T* a, const T* b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = a[i] - b[i];
+}
+
+template <typename T>
+void mul(T* d, const T* a, const T* b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = a[i] * b[i];
+}
+
+template <typename T>
+void div(T* d, const T* a, const T* b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = a[i] / b[i];
+}
+
+template <typename T>
+void pow(T* d, const T* a, const T* b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = std::pow(a[i], b[i]);
+}
+
+template <typename T>
+void fma(T* d, const T* a, const T* b, const T* c, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = std::fma(a[i], b[i], c[i]);
+}
+
+template <typename T>
+void neg(T* d, const T* a, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = -a[i];
+}
+
+template <typename T>
+bool anyZero(const T* b, size_t n) {
+    bool zero = false;
+    for (size_t i = 0; i < n; ++i) zero |= (b[i] == 0);
+    return zero;
+}
+
+// Applies a unary function computed in long double, as the built-in callbacks do.
+template <typename T, typename F>
+void apply(T* d, const T* a, size_t n, F f) {
+    for (size_t i = 0; i < n; ++i) d[i] = f(a[i]);
+}
+
+} // namespace
+
+template <typename T>
+BatchProgram<T>::BatchProgram(const Program& program, size_t lanes)
+    : program(program), laneCount(lanes) {
+    if (lanes == 0) {
+        throw SolverException("Batch size must be at least 1.");
+    }
+    columns.assign(static_cast<size_t>(program.registerCount()) * laneCount, 0);
+    failed.assign(laneCount, 0);
+}
+
+template <typename T>
+void BatchProgram<T>::load(const T* registers) {
+    for (uint32_t reg = 0; reg < program.tempBase(); ++reg) {
+        std::fill_n(column(reg), laneCount, registers[reg]);
+    }
+}
+
+template <typename T>
+void BatchProgram<T>::fail(size_t lane, const std::string& message) {
+    // Only the first error of a lane is reported, as the scalar evaluation stops there.
+    if (!failed[lane]) {
+        failed[lane] = 1;
+        failures.emplace_back(lane, message);
+    }
+}
+
+template <typename T>
+const T* BatchProgram<T>::run(size_t count) {
+    PROFILE_FUNCTION()
+    count = std::min(count, laneCount);
+    std::fill_n(failed.begin(), count, 0);
+    failures.clear();
+
+    for (const Instruction& ins : program.instructions()) {
+        T* d = column(ins.dst);
+        switch (ins.op) {
+            case OpCode::ADD: add(d, column(ins.a), column(ins.b), count); break;
+            case OpCode::SUB: sub(d, column(ins.a), column(ins.b), count); break;
+            case OpCode::MUL: mul(d, column(ins.a), column(ins.b), count); break;
+            case OpCode::DIV: {
+                const T* b = column(ins.b);
+                if (anyZero(b, count)) {
+                    for (size_t i = 0; i < count; ++i) {
+                        if (b[i] == 0) fail(i, "Division by zero");
+                    }
+                }
+                div(d, column(ins.a), b, count);
+                break;
+            }
+            case OpCode::POW: pow(d, column(ins.a), column(ins.b), count); break;
+            case OpCode::NEG: neg(d, column(ins.a), count); break;
+            case OpCode::FMA: fma(d, column(ins.a), column(ins.b), column(ins.c), count); break;
+            case OpCode::CALL: call(ins, count); break;
+        }
+    }
+
+    if (failures.size() > 1) {
+        std::stable_sort(failures.begin(), failures.end(),
+                         [](const auto& x, const auto& y) { return x.first < y.first; });
+    }
+    return column(program.resultRegister());
+}
+
+template <typename T>
+void BatchProgram<T>::call(const Instruction& ins, size_t count) {
+    const auto& argPool = program.argumentPool();
+    T* d = column(ins.dst);
+    const T* a = column(argPool[ins.a]);
+
+    // Built-ins run as one loop per block; they must compute exactly what their callbacks
+    // in registerBuiltInFunctions compute.
+    switch (program.callbackBuiltins()[ins.fn]) {
+        case Builtin::NEG: neg(d, a, count); return;
+        case Builtin::SIN: apply(d, a, count, [](T x) { return static_cast<T>(std::sinl(x)); }); return;
+        case Builtin::COS: apply(d, a, count, [](T x) { return static_cast<T>(std::cosl(x)); }); return;
+        case Builtin::TAN: apply(d, a, count, [](T x) { return static_cast<T>(std::tanl(x)); }); return;
+        case Builtin::EXP: apply(d, a, count, [](T x) { return static_cast<T>(std::expl(x)); }); return;
+        case Builtin::LN: apply(d, a, count, [](T x) { return static_cast<T>(std::logl(x)); }); return;
+        case Builtin::SQRT: apply(d, a, count, [](T x) { return static_cast<T>(std::sqrtl(x)); }); return;
+        case Builtin::ABS: apply(d, a, count, [](T x) { return std::abs(x); }); return;
+        case Builtin::LOG: {
+            const T* b = column(argPool[ins.a + 1]);
+            for (size_t i = 0; i < count; ++i) d[i] = static_cast<T>(std::logl(a[i]) / std::logl(b[i]));
+            return;
+        }
+        case Builtin::MAX: {
+            const T* b = column(argPool[ins.a + 1]);
+            for (size_t i = 0; i < count; ++i) d[i] = std::max(a[i], b[i]);
+            return;
+        }
+        case Builtin::MIN: {
+            const T* b = column(argPool[ins.a + 1]);
+            for (size_t i = 0; i < count; ++i) d[i] = std::min(a[i], b[i]);
+            return;
+        }
+        default:
+            break;
+    }
+
+    // Other callbacks take one argument vector per call, so they still run lane by lane.
+    const FunctionCallback& callback = program.callbackTable()[ins.fn];
+    std::vector<NUMBER_TYPE> args(ins.b);
+    for (size_t i = 0; i < count; ++i) {
+        if (failed[i]) {
+            continue;
+        }
+        for (uint32_t k = 0; k < ins.b; ++k) {
+            args[k] = column(argPool[ins.a + k])[i];
+        }
+        try {
+            d[i] = static_cast<T>(callback(args));
+        } catch (const SolverException& e) {
+            fail(i, e.what());
+        }
+    }
+}
+
+template class BatchProgram<float>;
+template class BatchProgram<double>;
+template class BatchProgram<long double>;
@@ -0,0 +1,328 @@
+#include "c_backend.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <dlfcn.h>
+    #include <unistd.h>
+    #define SOLVER_C_BACKEND_SUPPORTED 1
+#else
+    #define SOLVER_C_BACKEND_SUPPORTED 0
+#endif
+
+namespace {
+
+// Flags every object is built with. Contraction must stay off: an FMA rounds differently
+// from the multiply and add the interpreter performs (FMA instructions call fma explicitly). -fno-math-errno only drops errno
+// updates and never changes a result.
+const char* const COMPILER_FLAGS = "-O3 -march=native -ffp-contract=off -fno-math-errno -fPIC -shared";
+
+// Name of the generated function.
+const char* const ENTRY_POINT = "solver_program";
+
+struct CType {
+    const char* name;       // The C spelling of T
+    const char* pow;        // The pow overload std::pow resolves to for T
+    const char* fma;        // The fma overload std::fma resolves to for T
+    const char* suffix;     // Literal suffix
+};
+
+template <typename T>
+constexpr CType cType() {
+    if constexpr (std::is_same_v<T, float>) return { "float", "powf", "fmaf", "f" };
+    else if constexpr (std::is_same_v<T, double>) return { "double", "pow", "fma", "" };
+    else return { "long double", "powl", "fmal", "L" };
+}
+
+// Exact C spelling of a constant of type T (hexadecimal floating literal).
+template <typename T>
+std::string literal(T value) {
+    if (std::isnan(value)) return "((num)NAN)";
+    if (std::isinf(value)) return value < 0 ? "(-(num)INFINITY)" : "((num)INFINITY)";
+
+    char buffer[64];
+    if constexpr (std::is_same_v<T, long double>) {
+        std::snprintf(buffer, sizeof(buffer), "%La", value);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%a", static_cast<double>(value));
+    }
+    return std::string("(") + buffer + cType<T>().suffix + ")";
+}
+
+// 64-bit FNV-1a; stable across processes and builds, unlike std::hash.
+uint64_t fnv1a(const std::string& data, uint64_t hash = 14695981039346656037ull) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string compilerCommand() {
+    const char* cc = std::getenv("CC");
+    return (cc && *cc) ? cc : "cc";
+}
+
+std::string readFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void writeFileAtomically(const std::filesystem::path& path, const std::string& contents, const std::string& unique) {
+    const std::filesystem::path temporary = path.string() + "." + unique + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out << contents;
+        if (!out) {
+            throw SolverException("Failed to write '" + temporary.string() + "'.");
+        }
+    }
+    std::filesystem::rename(temporary, path);
+}
+
+std::string quote(const std::string& argument) {
+    if (argument.find('\'') != std::string::npos) {
+        throw SolverException("Unsupported character in path '" + argument + "'.");
+    }
+    return "'" + argument + "'";
+}
+
+} // namespace
+
+template <typename T>
+std::string CProgram<T>::emitSource(const Program& program) {
+    const uint32_t variables = program.variableBase();
+    const uint32_t temps = program.tempBase();
+    const auto& constants = program.constantValues();
+    const auto& argPool = program.argumentPool();
+
+    auto operand = [&](uint32_t reg) -> std::string {
+        if (reg < variables) return literal(static_cast<T>(constants[reg]));
+        std::ostringstream name;
+        if (reg < temps) name << "r[" << reg << "]";
+        else name << "t" << (reg - temps);
+        return name.str();
+    };
+
+    std::ostringstream c;
+    c << "#include <math.h>\n"
+      << "typedef " << cType<T>().name << " num;\n"
+      << "typedef int (*invoke_fn)(const void*, const num*, unsigned, num*);\n\n"
+      << "int " << ENTRY_POINT << "(num* r, const void* const* cb, invoke_fn invoke) {\n";
+
+    if (program.registerCount() > temps) {
+        c << "    num ";
+        for (uint32_t t = 0; t < program.registerCount() - temps; ++t) {
+            c << (t ? ", " : "") << "t" << t;
+        }
+        c << ";\n";
+    }
+
+    for (const Instruction& ins : program.instructions()) {
+        const std::string dst = operand(ins.dst);
+        const std::string a = operand(ins.a);
+        const std::string b = ins.op == OpCode::CALL || ins.op == OpCode::NEG ? "" : operand(ins.b);
+
+        switch (ins.op) {
+            case OpCode::ADD: c << "    " << dst << " = " << a << " + " << b << ";\n"; break;
+            case OpCode::SUB: c << "    " << dst << " = " << a << " - " << b << ";\n"; break;
+            case OpCode::MUL: c << "    " << dst << " = " << a << " * " << b << ";\n"; break;
+            case OpCode::DIV:
+                c << "    if (" << b << " == 0) return 1;\n";
+                c << "    " << dst << " = " << a << " / " << b << ";\n";
+                break;
+            case OpCode::POW: c << "    " << dst << " = " << cType<T>().pow << "(" << a << ", " << b << ");\n"; break;
+            case OpCode::NEG: c << "    " << dst << " = -" << a << ";\n"; break;
+            case OpCode::FMA: c << "    " << dst << " = " << cType<T>().fma << "(" << a << ", " << b << ", " << operand(ins.c) << ");\n"; break;
+            case OpCode::CALL: {
+                std::vector<std::string> args;
+                for (uint32_t i = 0; i < ins.b; ++i) {
+                    args.push_back(operand(argPool[ins.a + i]));
+                }
+
+                // The built-ins compute in long double (see registerBuiltInFunctions), then round.
+                c << "    ";
+                switch (program.callbackBuiltins()[ins.fn]) {
+                    case Builtin::NEG:  c << dst << " = -" << args[0] << ";\n"; break;
+                    case Builtin::SIN:  c << dst << " = (num)sinl(" << args[0] << ");\n"; break;
+                    case Builtin::COS:  c << dst << " = (num)cosl(" << args[0] << ");\n"; break;
+                    case Builtin::TAN:  c << dst << " = (num)tanl(" << args[0] << ");\n"; break;
+                    case Builtin::EXP:  c << dst << " = (num)expl(" << args[0] << ");\n"; break;
+                    case Builtin::LN:   c << dst << " = (num)logl(" << args[0] << ");\n"; break;
+                    case Builtin::LOG:  c << dst << " = (num)(logl(" << args[0] << ") / logl(" << args[1] << "));\n"; break;
+                    case Builtin::SQRT: c << dst << " = (num)sqrtl(" << args[0] << ");\n"; break;
+                    case Builtin::ABS:  c << dst << " = (num)fabsl(" << args[0] << ");\n"; break;
+                    // Same operand order as std::max/std::min, which matters for NaN and signed zeros.
+                    case Builtin::MAX:  c << dst << " = (" << args[0] << " < " << args[1] << ") ? " << args[1] << " : " << args[0] << ";\n"; break;
+                    case Builtin::MIN:  c << dst << " = (" << args[1] << " < " << args[0] << ") ? " << args[1] << " : " << args[0] << ";\n"; break;
+                    default: {
+                        c << "{\n        num a[" << std::max<size_t>(1, args.size()) << "] = { ";
+                        for (size_t i = 0; i < args.size(); ++i) {
+                            c << (i ? ", " : "") << args[i];
+                        }
+                        c << " };\n"
+                          << "        int s = invoke(cb[" << ins.fn << "], a, " << args.size() << ", &" << dst << ");\n"
+                          << "        if (s) return s;\n"
+                          << "    }\n";
+                        break;
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    if (program.resultRegister() >= temps) {
+        c << "    r[" << program.resultRegister() << "] = " << operand(program.resultRegister()) << ";\n";
+    }
+    c << "    return 0;\n}\n";
+    return c.str();
+}
+
+template <typename T>
+std::string CProgram<T>::cacheDirectory() {
+    if (const char* dir = std::getenv("SOLVER_CACHE_DIR"); dir && *dir) {
+        return dir;
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return (std::filesystem::path(xdg) / "solver").string();
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return (std::filesystem::path(home) / ".cache" / "solver").string();
+    }
+    return (std::filesystem::temp_directory_path() / "solver-cache").string();
+}
+
+template <typename T>
+bool CProgram<T>::isSupported() {
+    return SOLVER_C_BACKEND_SUPPORTED;
+}
+
+#if SOLVER_C_BACKEND_SUPPORTED
+
+namespace {
+
+// Runs a shell command; returns its combined output and sets \p status to its exit status.
+std::string runCommand(const std::string& command, int& status) {
+    std::string output;
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        throw SolverException("Failed to run the C compiler: " + command);
+    }
+    char chunk[512];
+    while (size_t n = std::fread(chunk, 1, sizeof(chunk), pipe)) {
+        output.append(chunk, n);
+    }
+    status = pclose(pipe);
+    return output;
+}
+
+// The target -march=native resolves to on this host, as the macros \p compiler predefines
+// for it (CPU features such as __AVX2__ included). Objects built for another CPU must not
+// be loaded from a shared cache directory, so this is part of the cache key.
+const std::string& nativeTarget(const std::string& compiler) {
+    static std::mutex mutex;
+    static std::map<std::string, std::string> targets;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [it, inserted] = targets.try_emplace(compiler);
+    if (inserted) {
+        int status = 0;
+        it->second = runCommand(compiler + " -march=native -E -dM -x c /dev/null 2>&1", status);
+    }
+    return it->second;
+}
+
+} // namespace
+
+template <typename T>
+CProgram<T>::CProgram(const Program& program)
+    : callbacks(program.callbackTable()), result(program.resultRegister()) {
+    PROFILE_FUNCTION()
+    for (const FunctionCallback& callback : callbacks) {
+        callbackTable.push_back(&callback);
+    }
+
+    const std::string source = emitSource(program);
+    const std::string compiler = compilerCommand();
+
+    // The key covers everything that determines the object: source (which embeds the
+    // number type and every constant), compiler, flags and the CPU -march=native targets.
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx",
+                  static_cast<unsigned long long>(fnv1a(source, fnv1a(compiler + '\n' + COMPILER_FLAGS + '\n' + nativeTarget(compiler)))));
+
+    namespace fs = std::filesystem;
+    std::error_code error;
+    const fs::path directory = cacheDirectory();
+    fs::create_directories(directory, error);
+    if (error) {
+        throw SolverException("Failed to create cache directory '" + directory.string() + "': " + error.message());
+    }
+
+    const fs::path sourcePath = directory / (std::string(key) + ".c");
+    const fs::path objectPath = directory / (std::string(key) + ".so");
+
+    // The source is kept next to the object so a hash collision is detected rather than loaded.
+    cached = fs::exists(objectPath) && fs::exists(sourcePath) && readFile(sourcePath) == source;
+    if (!cached) {
+        const std::string unique = std::to_string(getpid()) + "-" + std::to_string(reinterpret_cast<uintptr_t>(this));
+        writeFileAtomically(sourcePath, source, unique);
+
+        const fs::path temporary = objectPath.string() + "." + unique + ".tmp";
+        const std::string command = compiler + " " + COMPILER_FLAGS + " -o " + quote(temporary.string())
+                                  + " -x c " + quote(sourcePath.string()) + " -lm 2>&1";
+        int status = 0;
+        const std::string diagnostics = runCommand(command, status);
+        if (status != 0) {
+            fs::remove(temporary, error);
+            throw SolverException("C compilation failed (" + command + "):\n" + diagnostics);
+        }
+        fs::rename(temporary, objectPath);
+    }
+
+    path = objectPath.string();
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        throw SolverException("Failed to load '" + path + "': " + dlerror());
+    }
+    entry = reinterpret_cast<EntryPoint>(dlsym(handle, ENTRY_POINT));
+    if (!entry) {
+        dlclose(handle);
+        handle = nullptr;
+        throw SolverException("Symbol '" + std::string(ENTRY_POINT) + "' not found in '" + path + "'.");
+    }
+}
+
+template <typename T>
+CProgram<T>::~CProgram() {
+    if (handle) {
+        dlclose(handle);
+    }
+}
+
+#else
+
+template <typename T>
+CProgram<T>::CProgram(const Program&) {
+    throw SolverException("Loading compiled code is not supported on this platform.");
+}
+
+template <typename T>
+CProgram<T>::~CProgram() = default;
+
+#endif
+
+template <typename T>
+T CProgram<T>::run(T* registers) const {
+    if (int status = entry(registers, callbackTable.data(), &NativeCodeDetail::invokeCallback<T>); status != NativeCodeDetail::OK) {
+        NativeCodeDetail::raise(status);
+    }
+    return registers[result];
+}
+
+template class CProgram<float>;
+template class CProgram<double>;
+template class CProgram<long double>;
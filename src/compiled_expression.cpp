@@ -0,0 +1,43 @@
+#include "compiled_expression.h"
+
+CompiledExpression::CompiledExpression(std::string expression, Program program, Engine engine, Precision precision,
+                                       std::shared_ptr<const NativeCode> native)
+    : source(std::move(expression)), compiled(std::move(program)), tier(engine), scalar(precision), native(std::move(native)) {}
+
+NUMBER_TYPE CompiledExpression::evaluate(const std::vector<NUMBER_TYPE>& values) const {
+    PROFILE_FUNCTION()
+    if (values.size() != variables().size()) {
+        throw SolverException("Expression '" + source + "' reads " + std::to_string(variables().size())
+                              + " variables, got " + std::to_string(values.size()) + " values.");
+    }
+    return withPrecision(scalar, [&](auto zero) -> NUMBER_TYPE {
+        return static_cast<NUMBER_TYPE>(run<decltype(zero)>(values.data()));
+    });
+}
+
+NUMBER_TYPE CompiledExpression::evaluate(const std::unordered_map<std::string, NUMBER_TYPE>& values) const {
+    std::vector<NUMBER_TYPE> ordered;
+    ordered.reserve(variables().size());
+    for (const std::string& name : variables()) {
+        auto it = values.find(name);
+        if (it == values.end()) {
+            throw SolverException("Variable '" + name + "' not found in environment.");
+        }
+        ordered.push_back(it->second);
+    }
+    return evaluate(ordered);
+}
+
+template <typename T>
+T CompiledExpression::run(const NUMBER_TYPE* values) const {
+    // A private register file per call keeps concurrent evaluations independent.
+    std::vector<T> registers;
+    compiled.initRegisters(registers);
+    std::transform(values, values + variables().size(), registers.begin() + compiled.variableBase(),
+                   [](NUMBER_TYPE value) { return static_cast<T>(value); });
+
+    if (native) {
+        return static_cast<const TypedNativeCode<T>*>(native.get())->run(registers.data());
+    }
+    return compiled.run(registers.data());
+}
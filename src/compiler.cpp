@@ -5,98 +5,172 @@
 #include <stdexcept> // For std::runtime_error if needed
 
 
-EvalFunc compilePostfix(const std::vector<Token>& tokens, const std::unordered_map<std::string, Function>& functions) {
-    std::stack<EvalFunc> funcStack;
-    
-    for (const auto &token : tokens) {
-        if (token.type == NUMBER) {
-            // Create a lambda that returns the constant.
-            NUMBER_TYPE val = token.numericValue;
-            funcStack.push([val](const Env&) -> NUMBER_TYPE {
-                return val;
-            });
+/**
+ * Builds a Program from an ExpressionGraph in two passes. The first pass collects the
+ * constant and variable registers so the register layout is known. The second pass emits
+ * one instruction per operator or call node reachable from the root, in evaluation order.
+ * Since the graph is hash-consed, a subexpression used in several places (e.g. an argument
+ * that inlining bound to every use of a parameter) is one node and is computed once.
+ * Temporaries are assigned by liveness: a temporary is freed after its last read and the
+ * lowest free one is reused, so an expression without shared nodes gets exactly the
+ * registers of a stack-depth allocation.
+ */
+class ProgramBuilder {
+public:
+    ProgramBuilder(const ExpressionGraph& graph, const std::unordered_map<std::string, Function>& functions)
+        : graph(graph), functions(functions) {}
+
+    Program build(NodeId root) {
+        const std::vector<NodeId> order = graph.reachable(root);
+        collectOperands(order);
+        emit(order, root);
+        program.verify();
+        return std::move(program);
+    }
+
+private:
+    // Assigns every NUMBER node a constant register and every VARIABLE node a variable
+    // ordinal, in order of first use. Nodes are unique, so equal values and names share one.
+    void collectOperands(const std::vector<NodeId>& order) {
+        operands.assign(graph.size(), 0);
+        for (NodeId id : order) {
+            const GraphNode& node = graph[id];
+            if (node.type == NUMBER) {
+                operands[id] = static_cast<uint32_t>(program.constants.size());
+                program.constants.push_back(node.number);
+            }
+            else if (node.type == VARIABLE) {
+                operands[id] = static_cast<uint32_t>(program.variables.size());
+                program.variables.push_back(node.name);
+            }
         }
-        else if (token.type == VARIABLE) {
-            // Create a lambda that looks up the variable in the environment.
-            std::string varName = token.value;
-            funcStack.push([varName](const Env &env) -> NUMBER_TYPE {
-                auto it = env.find(varName);
-                if (it == env.end()) {
-                    throw SolverException("Variable '" + varName + "' not found in environment.");
-                }
-                return it->second;
-            });
+    }
+
+    // Emits the operator and call nodes in order, keeping every value in a temporary until its last read.
+    void emit(const std::vector<NodeId>& order, NodeId root) {
+        const uint32_t temps = program.tempBase();
+        const uint32_t end = static_cast<uint32_t>(order.size());
+
+        // Position in order of the last node reading each node's value (end for the result).
+        std::vector<uint32_t> lastUse(graph.size(), 0);
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            for (NodeId child : graph[order[i]].children) {
+                lastUse[child] = i;
+            }
         }
-        else if (token.type == OPERATOR) {
-            // Binary operator: pop two functions.
-            if (funcStack.size() < 2) {
-                throw SolverException("Not enough operands during compilation for operator " + token.value);
+        lastUse[root] = end;
+
+        std::vector<uint32_t> reg(graph.size(), 0);
+        std::vector<bool> busy;
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            const NodeId id = order[i];
+            const GraphNode& node = graph[id];
+            if (node.type == NUMBER) {
+                reg[id] = operands[id];
+                continue;
             }
-            auto rightFunc = funcStack.top();
-            funcStack.pop();
-            auto leftFunc  = funcStack.top();
-            funcStack.pop();
-            switch (token.op) {
-                case OperatorType::ADD:
-                    funcStack.push([leftFunc, rightFunc](const Env &env) -> NUMBER_TYPE {
-                        return leftFunc(env) + rightFunc(env);
-                    });
-                    break;
-                case OperatorType::SUB:
-                    funcStack.push([leftFunc, rightFunc](const Env &env) -> NUMBER_TYPE {
-                        return leftFunc(env) - rightFunc(env);
-                    });
-                    break;
-                case OperatorType::MUL:
-                    funcStack.push([leftFunc, rightFunc](const Env &env) -> NUMBER_TYPE {
-                        return leftFunc(env) * rightFunc(env);
-                    });
-                    break;
-                case OperatorType::DIV:
-                    funcStack.push([leftFunc, rightFunc](const Env &env) -> NUMBER_TYPE {
-                        NUMBER_TYPE r = rightFunc(env);
-                        if (r == 0) throw SolverException("Division by zero");
-                        return leftFunc(env) / r;
-                    });
-                    break;
-                case OperatorType::POW:
-                    funcStack.push([leftFunc, rightFunc](const Env &env) -> NUMBER_TYPE {
-                        return std::pow(leftFunc(env), rightFunc(env));
-                    });
-                    break;
-                default:
-                    throw SolverException("Unknown operator during compilation: " + token.value);
+            if (node.type == VARIABLE) {
+                reg[id] = program.variableBase() + operands[id];
+                continue;
             }
-        }
-        else if (token.type == FUNCTION) {
-            // For a function, we need to pop as many operands as the function requires.
-            auto funcIt = functions.find(token.value);
-            if (funcIt == functions.end()) {
-                throw SolverException("Unknown function during compilation: " + token.value);
+
+            Instruction ins{};
+            if (node.type == OPERATOR) {
+                switch (node.op) {
+                    case OperatorType::ADD: ins.op = OpCode::ADD; break;
+                    case OperatorType::SUB: ins.op = OpCode::SUB; break;
+                    case OperatorType::MUL: ins.op = OpCode::MUL; break;
+                    case OperatorType::DIV: ins.op = OpCode::DIV; break;
+                    case OperatorType::POW: ins.op = OpCode::POW; break;
+                    default:
+                        throw SolverException("Unknown operator during compilation: " + node.name);
+                }
+                ins.a = reg[node.children[0]];
+                ins.b = reg[node.children[1]];
             }
-            size_t argCount = funcIt->second.argCount;
-            if (funcStack.size() < argCount) {
-                throw SolverException("Not enough operands for function " + token.value);
+            else if (node.type == FUNCTION) {
+                auto funcIt = functions.find(node.name);
+                if (funcIt == functions.end()) {
+                    throw SolverException("Unknown function during compilation: " + node.name);
+                }
+                const Function& func = funcIt->second;
+                if (node.children.size() != func.argCount) {
+                    throw SolverException("Not enough operands for function " + node.name);
+                }
+                if (func.isPredefined && func.builtin == Builtin::NEG) {
+                    // Unary minus is common enough to deserve its own opcode.
+                    ins.op = OpCode::NEG;
+                    ins.a = reg[node.children[0]];
+                }
+                else if (func.isPredefined && func.builtin == Builtin::FMA) {
+                    // So is fma, which must round once in the execution precision.
+                    ins.op = OpCode::FMA;
+                    ins.a = reg[node.children[0]];
+                    ins.b = reg[node.children[1]];
+                    ins.c = reg[node.children[2]];
+                }
+                else {
+                    ins.op = OpCode::CALL;
+                    ins.a = static_cast<uint32_t>(program.argPool.size());
+                    ins.b = static_cast<uint32_t>(node.children.size());
+                    ins.fn = callbackIndex(node.name, func);
+                    for (NodeId child : node.children) {
+                        program.argPool.push_back(reg[child]);
+                    }
+                }
             }
-            std::vector<EvalFunc> args(argCount);
-            for (size_t i = 0; i < argCount; ++i) {
-                args[argCount - i - 1] = funcStack.top();
-                funcStack.pop();
+            else {
+                throw SolverException("Unsupported node type during compilation: " + node.name);
             }
-            // Capture the function callback directly.
-            auto callback = funcIt->second.callback;
-            funcStack.push([token, args, callback](const Env &env) -> NUMBER_TYPE {
-                std::vector<NUMBER_TYPE> evaluatedArgs;
-                evaluatedArgs.reserve(args.size());
-                for (auto &f : args) {
-                    evaluatedArgs.push_back(f(env));
+
+            // Operands read for the last time free their temporaries, which the result may reuse.
+            for (NodeId child : node.children) {
+                if (!graph.isLeaf(child) && lastUse[child] == i) {
+                    busy[reg[child] - temps] = false;
                 }
-                return callback(evaluatedArgs);
-            });
+            }
+            const uint32_t slot = static_cast<uint32_t>(std::find(busy.begin(), busy.end(), false) - busy.begin());
+            if (slot == busy.size()) {
+                busy.push_back(true);
+            }
+            busy[slot] = true;
+            reg[id] = temps + slot;
+            ins.dst = reg[id];
+            program.code.push_back(ins);
         }
+
+        program.maxDepth = static_cast<uint32_t>(busy.size());
+        program.result = reg[root];
     }
-    if (funcStack.size() != 1) {
-        throw SolverException("Compilation error: stack size is not 1 after processing.");
+
+    uint32_t callbackIndex(const std::string& name, const Function& func) {
+        auto it = std::find(program.callbackNames.begin(), program.callbackNames.end(), name);
+        if (it != program.callbackNames.end()) {
+            return static_cast<uint32_t>(std::distance(program.callbackNames.begin(), it));
+        }
+        if (!func.callback) {
+            throw SolverException("Function '" + name + "' has no callback and cannot be compiled.");
+        }
+        program.callbacks.push_back(func.callback);
+        program.callbackNames.push_back(name);
+        program.builtins.push_back(func.isPredefined ? func.builtin : Builtin::NONE);
+        return static_cast<uint32_t>(program.callbacks.size() - 1);
     }
-    return funcStack.top();
+
+    const ExpressionGraph& graph;
+    const std::unordered_map<std::string, Function>& functions;
+    Program program;
+    std::vector<uint32_t> operands;     ///< Per-node constant register or variable ordinal.
+};
+
+
+Program compileGraph(const ExpressionGraph& graph, NodeId root, const std::unordered_map<std::string, Function>& functions) {
+    PROFILE_FUNCTION()
+    return ProgramBuilder(graph, functions).build(root);
+}
+
+Program compilePostfix(const std::vector<Token>& tokens, const TokenPool& pool, const std::unordered_map<std::string, Function>& functions) {
+    ExpressionGraph graph;
+    NodeId root = graph.addPostfix(tokens, pool, functions);
+    return compileGraph(graph, root, functions);
 }
@@ -0,0 +1,294 @@
+#include "expression_graph.h"
+#include "function.h"
+#include "symbol_table.h"
+
+const char* operatorSymbol(OperatorType op) {
+    switch (op) {
+        case OperatorType::ADD: return "+";
+        case OperatorType::SUB: return "-";
+        case OperatorType::MUL: return "*";
+        case OperatorType::DIV: return "/";
+        case OperatorType::POW: return "^";
+        default:                return "?";
+    }
+}
+
+namespace {
+
+void hashCombine(size_t& hash, size_t value) {
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+bool sameNode(const GraphNode& a, const GraphNode& b) {
+    return a.type == b.type && a.op == b.op && a.name == b.name && a.children == b.children
+        && (a.type != NUMBER || SameNumber{}(a.number, b.number));
+}
+
+} // namespace
+
+NodeId ExpressionGraph::intern(GraphNode node) {
+    size_t hash = std::hash<int>{}(node.type);
+    hashCombine(hash, static_cast<size_t>(node.op));
+    hashCombine(hash, std::hash<std::string>{}(node.name));
+    if (node.type == NUMBER) {
+        hashCombine(hash, NumberHash{}(node.number));
+    }
+    for (NodeId child : node.children) {
+        hashCombine(hash, child);
+    }
+    node.hash = hash;
+
+    // Keep the table at most half full so probe sequences stay short
+    if (2 * (nodes.size() + 1) > index.size()) {
+        growIndex();
+    }
+    const size_t mask = index.size() - 1;
+    size_t slot = hash & mask;
+    for (; index[slot].second != EMPTY_SLOT; slot = (slot + 1) & mask) {
+        if (index[slot].first == hash && sameNode(nodes[index[slot].second], node)) {
+            return index[slot].second;
+        }
+    }
+    const NodeId id = static_cast<NodeId>(nodes.size());
+    nodes.push_back(std::move(node));
+    index[slot] = { hash, id };
+    return id;
+}
+
+void ExpressionGraph::growIndex() {
+    std::vector<std::pair<size_t, NodeId>> grown(std::max<size_t>(64, 2 * index.size()), { 0, EMPTY_SLOT });
+    const size_t mask = grown.size() - 1;
+    for (const auto& entry : index) {
+        if (entry.second == EMPTY_SLOT) {
+            continue;
+        }
+        size_t slot = entry.first & mask;
+        while (grown[slot].second != EMPTY_SLOT) {
+            slot = (slot + 1) & mask;
+        }
+        grown[slot] = entry;
+    }
+    index = std::move(grown);
+}
+
+NodeId ExpressionGraph::number(NUMBER_TYPE value) {
+    return intern({ NUMBER, OperatorType::UNKNOWN, value, {}, {}, 0 });
+}
+
+NodeId ExpressionGraph::variable(const std::string& name) {
+    return intern({ VARIABLE, OperatorType::UNKNOWN, 0, name, {}, 0 });
+}
+
+NodeId ExpressionGraph::binary(OperatorType op, NodeId left, NodeId right) {
+    return intern({ OPERATOR, op, 0, operatorSymbol(op), { left, right }, 0 });
+}
+
+NodeId ExpressionGraph::call(const std::string& name, std::vector<NodeId> arguments) {
+    return intern({ FUNCTION, OperatorType::UNKNOWN, 0, name, std::move(arguments), 0 });
+}
+
+NodeId ExpressionGraph::withChildren(NodeId id, std::vector<NodeId> operands) {
+    const GraphNode& node = nodes[id];
+    return intern({ node.type, node.op, 0, node.name, std::move(operands), 0 });
+}
+
+NodeId ExpressionGraph::add(const Token& token, const TokenPool& pool, std::vector<NodeId> operands) {
+    switch (token.type) {
+        case NUMBER:
+            return number(pool.number(token.id));
+        case VARIABLE:
+            return variable(pool.name(token.id));
+        case OPERATOR:
+            if (token.op == OperatorType::UNKNOWN || operands.size() != 2) {
+                throw SolverException("Invalid operator '" + pool.name(token.id) + "' in expression graph.");
+            }
+            return binary(token.op, operands[0], operands[1]);
+        case FUNCTION:
+            return call(pool.name(token.id), std::move(operands));
+        default:
+            throw SolverException("Unsupported token type in expression graph: " + pool.text(token));
+    }
+}
+
+NodeId ExpressionGraph::addPostfix(const std::vector<Token>& postfix, const TokenPool& pool, const std::unordered_map<std::string, Function>& functions,
+                                   const SymbolTable* constants, std::unordered_set<std::string>* names) {
+    PROFILE_FUNCTION()
+    std::vector<NodeId> stack;
+    stack.reserve(postfix.size());
+    // Names are resolved once per symbol: the node of each variable, the definition of each function
+    std::unordered_map<SymbolId, NodeId> leaves;
+    std::unordered_map<SymbolId, const Function*> callees;
+    // Inlined calls, by function symbol and argument nodes
+    std::map<std::pair<SymbolId, std::vector<NodeId>>, NodeId> inlined;
+
+    for (const Token& token : postfix) {
+        switch (token.type) {
+            case NUMBER:
+                stack.push_back(number(pool.number(token.id)));
+                break;
+
+            case VARIABLE: {
+                auto [leaf, inserted] = leaves.try_emplace(token.id, 0);
+                if (inserted) {
+                    const std::string& name = pool.name(token.id);
+                    if (names) {
+                        names->insert(name);
+                    }
+                    leaf->second = constants && constants->isConstant(name) ? number(constants->lookupSymbol(name)) : variable(name);
+                }
+                stack.push_back(leaf->second);
+                break;
+            }
+
+            case OPERATOR: {
+                if (stack.size() < 2) {
+                    throw SolverException("Not enough operands for operator '" + pool.name(token.id) + "'");
+                }
+                const NodeId right = stack.back();
+                stack.pop_back();
+                const NodeId left = stack.back();
+                stack.pop_back();
+                stack.push_back(add(token, pool, { left, right }));
+                break;
+            }
+
+            case FUNCTION: {
+                auto [callee, resolving] = callees.try_emplace(token.id, nullptr);
+                if (resolving) {
+                    auto it = functions.find(pool.name(token.id));
+                    if (it == functions.end()) {
+                        throw SolverException("Unknown function: '" + pool.name(token.id) + "'");
+                    }
+                    callee->second = &it->second;
+                    if (names) {
+                        names->insert(it->first);
+                    }
+                }
+                const Function& function = *callee->second;
+                if (stack.size() < function.argCount) {
+                    throw SolverException("Insufficient arguments for function: '" + pool.name(token.id) + "'");
+                }
+
+                std::vector<NodeId> arguments(stack.end() - function.argCount, stack.end());
+                stack.resize(stack.size() - function.argCount);
+                if (function.isPredefined) {
+                    stack.push_back(call(pool.name(token.id), std::move(arguments)));
+                    break;
+                }
+
+                // User-defined functions are inlined from their body, with the parameters bound to the arguments
+                auto [inlinedCall, inserted] = inlined.try_emplace({ token.id, arguments }, 0);
+                if (inserted) {
+                    inlinedCall->second = copy(*function.body, function.bodyRoot, function.argumentNames, arguments, constants, names);
+                }
+                stack.push_back(inlinedCall->second);
+                break;
+            }
+
+            default:
+                throw SolverException("Unsupported token type during flattening: " + pool.text(token));
+        }
+    }
+
+    if (stack.size() != 1) {
+        throw SolverException("Flattening error: leftover expressions in the stack. Stack size = " + std::to_string(stack.size()));
+    }
+    return stack.back();
+}
+
+NodeId ExpressionGraph::copy(const ExpressionGraph& source, NodeId root,
+                             const std::vector<std::string>& parameters, const std::vector<NodeId>& arguments,
+                             const SymbolTable* constants, std::unordered_set<std::string>* names) {
+    std::unordered_map<NodeId, NodeId> copied;
+    for (NodeId id : source.reachable(root)) {
+        const GraphNode& node = source[id];
+        NodeId result;
+        if (node.type == NUMBER) {
+            result = number(node.number);
+        }
+        else if (node.type == VARIABLE) {
+            auto parameter = std::find(parameters.begin(), parameters.end(), node.name);
+            if (parameter != parameters.end()) {
+                result = arguments[std::distance(parameters.begin(), parameter)];
+            }
+            else {
+                if (names) {
+                    names->insert(node.name);
+                }
+                result = constants && constants->isConstant(node.name) ? number(constants->lookupSymbol(node.name)) : variable(node.name);
+            }
+        }
+        else {
+            if (names && node.type == FUNCTION) {
+                names->insert(node.name);
+            }
+            std::vector<NodeId> children;
+            children.reserve(node.children.size());
+            for (NodeId child : node.children) {
+                children.push_back(copied.at(child));
+            }
+            result = intern({ node.type, node.op, 0, node.name, std::move(children), 0 });
+        }
+        copied.emplace(id, result);
+    }
+    return copied.at(root);
+}
+
+Token ExpressionGraph::token(NodeId id, TokenPool& pool) const {
+    const GraphNode& node = nodes[id];
+    switch (node.type) {
+        case NUMBER:   return pool.numberToken(node.number);
+        case OPERATOR: return TokenPool::operatorToken(node.op);
+        default:       return pool.symbolToken(node.type, node.name);
+    }
+}
+
+std::vector<NodeId> ExpressionGraph::reachable(NodeId root) const {
+    std::vector<NodeId> order;
+    std::vector<bool> visited(nodes.size(), false);
+    // Iterative post-order walk: (node, index of the next child to visit)
+    std::vector<std::pair<NodeId, size_t>> stack{ { root, 0 } };
+    visited[root] = true;
+    while (!stack.empty()) {
+        auto& [id, next] = stack.back();
+        const std::vector<NodeId>& children = nodes[id].children;
+        if (next < children.size()) {
+            const NodeId child = children[next++];
+            if (!visited[child]) {
+                visited[child] = true;
+                stack.emplace_back(child, 0);
+            }
+        }
+        else {
+            order.push_back(id);
+            stack.pop_back();
+        }
+    }
+    return order;
+}
+
+std::vector<Token> ExpressionGraph::toPostfix(NodeId root, TokenPool& pool) const {
+    std::vector<Token> postfix;
+    std::vector<std::pair<NodeId, size_t>> stack{ { root, 0 } };
+    while (!stack.empty()) {
+        auto& [id, next] = stack.back();
+        const std::vector<NodeId>& children = nodes[id].children;
+        if (next < children.size()) {
+            stack.emplace_back(children[next++], 0);
+        }
+        else {
+            postfix.push_back(token(id, pool));
+            stack.pop_back();
+        }
+    }
+    return postfix;
+}
+
+size_t ExpressionGraph::byteSize() const {
+    size_t bytes = sizeof(ExpressionGraph) + nodes.capacity() * sizeof(GraphNode);
+    for (const GraphNode& node : nodes) {
+        bytes += node.name.capacity() + node.children.capacity() * sizeof(NodeId);
+    }
+    bytes += index.capacity() * sizeof(std::pair<size_t, NodeId>);
+    return bytes;
+}
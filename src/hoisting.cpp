@@ -0,0 +1,318 @@
+#include "hoisting.h"
+
+namespace {
+
+constexpr uint32_t NONE = UINT32_MAX;
+
+// Registers an instruction reads, in operand order.
+std::vector<uint32_t> operandsOf(const Program& program, const Instruction& ins) {
+    switch (ins.op) {
+        case OpCode::NEG:
+            return { ins.a };
+        case OpCode::FMA:
+            return { ins.a, ins.b, ins.c };
+        case OpCode::CALL: {
+            const auto& pool = program.argumentPool();
+            return { pool.begin() + ins.a, pool.begin() + ins.a + ins.b };
+        }
+        default:
+            return { ins.a, ins.b };
+    }
+}
+
+// Rough cost of an instruction relative to copying a hoisted value into a register:
+// calls and pow dominate the evaluation of most expressions, arithmetic is cheap.
+size_t costOf(const Instruction& ins) {
+    return (ins.op == OpCode::CALL || ins.op == OpCode::POW) ? 8 : 1;
+}
+
+} // namespace
+
+template <typename T>
+HoistedSweep<T>::HoistedSweep(const Program& program, const std::vector<int>& slots,
+                           const std::vector<ArrayView>& ranges)
+    : slots(slots), ranges(ranges), base(program.tempBase()) {
+    PROFILE_FUNCTION()
+    size_t total = 1;
+    for (const ArrayView& values : ranges) {
+        total *= values.size();
+    }
+    // Masks are 32-bit; sweeps over more dimensions (or with nothing to share) run unhoisted.
+    if (ranges.size() > 32 || total < 2) {
+        return;
+    }
+
+    // The dimension that writes each variable register (the last one, if a name repeats).
+    std::vector<uint32_t> dimensionOf(program.registerCount(), NONE);
+    for (size_t d = 0; d < ranges.size(); ++d) {
+        if (slots[d] >= 0) {
+            dimensionOf[slots[d]] = static_cast<uint32_t>(d);
+        }
+    }
+
+    // Classify every instruction by the dimensions it depends on, following each temporary
+    // back to the instruction that last wrote it (temporaries are reused once dead).
+    const auto& code = program.instructions();
+    std::vector<uint32_t> writer(program.registerCount(), NONE);
+    lifted.assign(code.size(), 0);
+    producers.resize(code.size());
+    masks.assign(code.size(), 0);
+    for (size_t i = 0; i < code.size(); ++i) {
+        bool liftable = true;
+        for (uint32_t reg : operandsOf(program, code[i])) {
+            uint32_t producer = NONE;
+            if (reg >= base) {
+                producer = writer[reg];
+                if (producer == NONE) {
+                    throw SolverException("Invalid program: temporary register read before it is written.");
+                }
+                masks[i] |= masks[producer];
+                liftable = liftable && lifted[producer];
+            }
+            else if (dimensionOf[reg] != NONE) {
+                masks[i] |= 1u << dimensionOf[reg];
+            }
+            producers[i].push_back(producer);
+        }
+        lifted[i] = liftable && tableSize(masks[i]) * 2 <= total;
+        writer[code[i].dst] = static_cast<uint32_t>(i);
+    }
+    const uint32_t resultProducer = program.resultRegister() >= base ? writer[program.resultRegister()] : NONE;
+
+    // A hoisted value needs a table if it is read outside its own group (or is the result).
+    std::vector<int> exported(code.size(), -1);
+    auto exportValue = [&](uint32_t producer) {
+        if (exported[producer] < 0) {
+            exported[producer] = static_cast<int>(tableMasks.size());
+            tableMasks.push_back(masks[producer]);
+        }
+    };
+    std::vector<uint32_t> remaining;
+    std::vector<bool> residualReads(code.size(), false);
+    size_t saved = 0;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (lifted[i]) {
+            saved += costOf(code[i]);
+        }
+        else {
+            remaining.push_back(static_cast<uint32_t>(i));
+        }
+        for (uint32_t producer : producers[i]) {
+            if (producer != NONE && lifted[producer] && (!lifted[i] || masks[producer] != masks[i])) {
+                exportValue(producer);
+                residualReads[producer] = residualReads[producer] || !lifted[i];
+            }
+        }
+    }
+    if (resultProducer != NONE && lifted[resultProducer]) {
+        exportValue(resultProducer);
+        residualReads[resultProducer] = true;
+    }
+
+    // Not worth it unless the hoisted work outweighs copying its values in for every point.
+    const size_t residualInputs = std::count(residualReads.begin(), residualReads.end(), true);
+    if (saved <= residualInputs) {
+        tableMasks.clear();
+        lifted.assign(code.size(), 0);
+        return;
+    }
+    hoisted = code.size() - remaining.size();
+
+    strides.resize(tableMasks.size());
+    for (size_t t = 0; t < tableMasks.size(); ++t) {
+        strides[t].assign(ranges.size(), 0);
+        size_t stride = 1;
+        for (size_t d = ranges.size(); d-- > 0;) {
+            if (tableMasks[t] & (1u << d)) {
+                strides[t][d] = stride;
+                stride *= ranges[d].size();
+            }
+        }
+    }
+
+    // One group per set of dimensions. A group only reads groups over strict subsets of its
+    // dimensions, so evaluating them by increasing number of dimensions respects dependencies.
+    std::vector<uint32_t> groupMasks;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (lifted[i] && std::find(groupMasks.begin(), groupMasks.end(), masks[i]) == groupMasks.end()) {
+            groupMasks.push_back(masks[i]);
+        }
+    }
+    std::stable_sort(groupMasks.begin(), groupMasks.end(), [](uint32_t x, uint32_t y) {
+        return __builtin_popcount(x) < __builtin_popcount(y);
+    });
+    for (uint32_t mask : groupMasks) {
+        std::vector<uint32_t> members;
+        for (size_t i = 0; i < code.size(); ++i) {
+            if (lifted[i] && masks[i] == mask) {
+                members.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        Group group{ mask, {}, {}, {} };
+        group.program = extract(program, members, NONE, exported, group.inputs);
+        for (size_t k = 0; k < members.size(); ++k) {
+            if (exported[members[k]] >= 0) {
+                group.outputs.emplace_back(group.program.tempBase() + static_cast<uint32_t>(k), exported[members[k]]);
+            }
+        }
+        groups.push_back(std::move(group));
+    }
+
+    rest = extract(program, remaining, resultProducer, exported, inputs);
+    if (resultProducer == NONE) {
+        rest.result = program.resultRegister();
+    }
+}
+
+template <typename T>
+Program HoistedSweep<T>::extract(const Program& program, const std::vector<uint32_t>& members, uint32_t resultProducer,
+                              const std::vector<int>& exported, std::vector<Import>& imports) {
+    const auto& code = program.instructions();
+    std::vector<uint32_t> position(code.size(), NONE);
+    for (size_t k = 0; k < members.size(); ++k) {
+        position[members[k]] = static_cast<uint32_t>(k);
+    }
+
+    // The tables read by the members become extra variables, in order of first use.
+    std::vector<uint32_t> tablesRead;
+    auto importOf = [&](uint32_t producer) {
+        const uint32_t table = static_cast<uint32_t>(exported[producer]);
+        auto it = std::find(tablesRead.begin(), tablesRead.end(), table);
+        if (it == tablesRead.end()) {
+            tablesRead.push_back(table);
+            return static_cast<uint32_t>(tablesRead.size() - 1);
+        }
+        return static_cast<uint32_t>(std::distance(tablesRead.begin(), it));
+    };
+    for (uint32_t i : members) {
+        for (uint32_t producer : producers[i]) {
+            if (producer != NONE && position[producer] == NONE) {
+                importOf(producer);
+            }
+        }
+    }
+    if (resultProducer != NONE && position[resultProducer] == NONE) {
+        importOf(resultProducer);
+    }
+
+    Program piece;
+    piece.constants = program.constants;
+    piece.variables = program.variables;
+    for (uint32_t table : tablesRead) {
+        std::ostringstream name;
+        name << "%" << table;
+        piece.variables.push_back(name.str());
+    }
+    piece.callbacks = program.callbacks;
+    piece.callbackNames = program.callbackNames;
+    piece.builtins = program.builtins;
+    piece.maxDepth = static_cast<uint32_t>(members.size());
+
+    const uint32_t inputBase = base;
+    const uint32_t temps = piece.tempBase();
+    auto map = [&](uint32_t reg, uint32_t producer) {
+        if (producer == NONE) {
+            return reg;
+        }
+        return position[producer] != NONE ? temps + position[producer] : inputBase + importOf(producer);
+    };
+
+    for (uint32_t k = 0; k < members.size(); ++k) {
+        const uint32_t i = members[k];
+        Instruction ins = code[i];
+        const auto& from = producers[i];
+        const std::vector<uint32_t> operands = operandsOf(program, code[i]);
+        if (ins.op == OpCode::CALL) {
+            ins.a = static_cast<uint32_t>(piece.argPool.size());
+            for (size_t j = 0; j < operands.size(); ++j) {
+                piece.argPool.push_back(map(operands[j], from[j]));
+            }
+        }
+        else {
+            ins.a = map(operands[0], from[0]);
+            if (operands.size() > 1) {
+                ins.b = map(operands[1], from[1]);
+            }
+            if (operands.size() > 2) {
+                ins.c = map(operands[2], from[2]);
+            }
+        }
+        ins.dst = temps + k;
+        piece.code.push_back(ins);
+    }
+
+    piece.result = resultProducer != NONE ? map(NONE, resultProducer) : (members.empty() ? 0 : temps);
+    for (uint32_t k = 0; k < tablesRead.size(); ++k) {
+        imports.push_back({ tablesRead[k], inputBase + k });
+    }
+    piece.verify();
+    return piece;
+}
+
+template <typename T>
+void HoistedSweep<T>::tabulate(const T* registers) {
+    PROFILE_FUNCTION()
+    tables.resize(tableMasks.size());
+    for (size_t t = 0; t < tableMasks.size(); ++t) {
+        tables[t].assign(tableSize(tableMasks[t]), 0);
+    }
+
+    std::vector<size_t> indices(ranges.size(), 0);
+    std::vector<T> local;
+    for (const Group& group : groups) {
+        group.program.initRegisters(local);
+        std::copy(registers, registers + base, local.begin());
+
+        const size_t count = tableSize(group.mask);
+        for (size_t entry = 0; entry < count; ++entry) {
+            for (size_t remainder = entry, d = ranges.size(); d-- > 0;) {
+                if (group.mask & (1u << d)) {
+                    indices[d] = remainder % ranges[d].size();
+                    remainder /= ranges[d].size();
+                    if (slots[d] >= 0) {
+                        local[slots[d]] = ranges[d].template get<T>(indices[d]);
+                    }
+                }
+            }
+            for (const Import& input : group.inputs) {
+                local[input.reg] = tables[input.table][offset(input.table, indices)];
+            }
+            group.program.run(local.data());
+            for (const auto& [reg, table] : group.outputs) {
+                tables[table][entry] = local[reg];
+            }
+        }
+    }
+}
+
+template <typename T>
+std::vector<T> HoistedSweep<T>::residualRegisters(const T* registers) const {
+    std::vector<T> local;
+    rest.initRegisters(local);
+    std::copy(registers, registers + base, local.begin());
+    return local;
+}
+
+template <typename T>
+size_t HoistedSweep<T>::offset(uint32_t table, const std::vector<size_t>& indices) const {
+    size_t result = 0;
+    for (size_t d = 0; d < indices.size(); ++d) {
+        result += indices[d] * strides[table][d];
+    }
+    return result;
+}
+
+template <typename T>
+size_t HoistedSweep<T>::tableSize(uint32_t mask) const {
+    size_t size = 1;
+    for (size_t d = 0; d < ranges.size(); ++d) {
+        if (mask & (1u << d)) {
+            size *= ranges[d].size();
+        }
+    }
+    return size;
+}
+
+template class HoistedSweep<float>;
+template class HoistedSweep<double>;
+template class HoistedSweep<long double>;
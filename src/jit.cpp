@@ -0,0 +1,478 @@
+#include "jit.h"
+#include <cstring>
+
+#if defined(__x86_64__) && !defined(_WIN32)
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define SOLVER_JIT_SUPPORTED 1
+#else
+    #define SOLVER_JIT_SUPPORTED 0
+#endif
+
+namespace {
+
+using namespace NativeCodeDetail;
+
+using LongDoubleUnary = long double (*)(long double);
+using LongDoubleBinary = long double (*)(long double, long double);
+using LongDoubleTernary = long double (*)(long double, long double, long double);
+
+// The long double libm entry points the built-ins are defined with (see registerBuiltInFunctions).
+LongDoubleUnary libmFunction(Builtin builtin) {
+    switch (builtin) {
+        case Builtin::SIN: return static_cast<LongDoubleUnary>(::sinl);
+        case Builtin::COS: return static_cast<LongDoubleUnary>(::cosl);
+        case Builtin::TAN: return static_cast<LongDoubleUnary>(::tanl);
+        case Builtin::EXP: return static_cast<LongDoubleUnary>(::expl);
+        case Builtin::LN:
+        case Builtin::LOG: return static_cast<LongDoubleUnary>(::logl);
+        default: return nullptr;
+    }
+}
+
+/**
+ * Minimal x86-64 machine code buffer with forward jump patching.
+ */
+class Assembler {
+public:
+    void byte(uint8_t value) { code.push_back(value); }
+
+    void bytes(std::initializer_list<uint8_t> values) { code.insert(code.end(), values); }
+
+    void u32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) byte(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void u64(uint64_t value) {
+        for (int i = 0; i < 8; ++i) byte(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    // Emits a jump opcode with a rel32 placeholder and returns the placeholder's offset.
+    size_t jump(std::initializer_list<uint8_t> opcode) {
+        bytes(opcode);
+        size_t at = code.size();
+        u32(0);
+        return at;
+    }
+
+    // Points the rel32 placeholder at \p at to \p target.
+    void patch(size_t at, size_t target) {
+        const int32_t rel = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(at + 4));
+        for (int i = 0; i < 4; ++i) code[at + i] = static_cast<uint8_t>(static_cast<uint32_t>(rel) >> (8 * i));
+    }
+
+    size_t here() const { return code.size(); }
+
+    std::vector<uint8_t> code;
+};
+
+/**
+ * Lowers a Program to a function `int fn(T* registers)`.
+ *
+ * rbx holds the register file for the whole function. Temporaries live in the register
+ * file exactly as in the interpreter, so every instruction is a load/compute/store
+ * sequence. The stack frame holds the outgoing arguments of long double libm calls
+ * (which are passed in memory), one spill slot and the argument buffer for callbacks:
+ *
+ *   [rsp +  0, rsp + 32)  outgoing long double arguments (fmal's third one takes the spill slot)
+ *   [rsp + 32, rsp + 48)  spill slot
+ *   [rsp + 48, ...)       callback arguments
+ *
+ * The four basic operators, pow and fma use the same precision as the interpreter: the x87
+ * unit (and fmal) for long double, SSE for double and float, with the FMA3 instruction
+ * where the processor has one and fma/fmaf otherwise. Everything the interpreter computes in
+ * long double (the libm built-ins, sqrt) goes through the x87 unit for every precision,
+ * so results round exactly as they do in Program::run().
+ */
+template <typename T>
+class Emitter {
+public:
+    Emitter(const Program& program, const std::vector<FunctionCallback>& callbacks)
+        : program(program), callbacks(callbacks) {}
+
+    std::vector<uint8_t> emit() {
+        size_t maxArgs = 0;
+        for (const Instruction& ins : program.instructions()) {
+            if (ins.op == OpCode::CALL) maxArgs = std::max<size_t>(maxArgs, ins.b);
+        }
+        if (static_cast<uint64_t>(program.registerCount()) * sizeof(T) > INT32_MAX
+            || maxArgs * sizeof(T) > INT32_MAX / 2) {
+            throw SolverException("Program is too large to be compiled to native code.");
+        }
+        frame = static_cast<uint32_t>((ARGS + maxArgs * sizeof(T) + 15) & ~size_t(15));
+
+        // push rbx; mov rbx, rdi; sub rsp, frame
+        as.byte(0x53);
+        as.bytes({ 0x48, 0x89, 0xFB });
+        as.bytes({ 0x48, 0x81, 0xEC });
+        as.u32(frame);
+
+        for (const Instruction& ins : program.instructions()) {
+            lower(ins);
+        }
+
+        // xor eax, eax
+        as.bytes({ 0x31, 0xC0 });
+
+        // Epilogue: add rsp, frame; pop rbx; ret
+        const size_t epilogue = as.here();
+        as.bytes({ 0x48, 0x81, 0xC4 });
+        as.u32(frame);
+        as.byte(0x5B);
+        as.byte(0xC3);
+
+        // Division by zero: discard the divisor left on the x87 stack and report.
+        const size_t divisionError = as.here();
+        if constexpr (X87) {
+            as.bytes({ 0xDD, 0xD8 });   // fstp st(0)
+        }
+        as.byte(0xB8);                  // mov eax, DIVISION_BY_ZERO
+        as.u32(DIVISION_BY_ZERO);
+        const size_t back = as.jump({ 0xE9 });
+        as.patch(back, epilogue);
+
+        for (size_t at : divisionErrors) as.patch(at, divisionError);
+        for (size_t at : callbackErrors) as.patch(at, epilogue);
+
+        return std::move(as.code);
+    }
+
+private:
+    static constexpr bool X87 = std::is_same_v<T, long double>;
+    static constexpr bool SINGLE = std::is_same_v<T, float>;
+    static constexpr uint32_t OUTGOING = 0;
+    static constexpr uint32_t SPILL = 32;
+    static constexpr uint32_t ARGS = 48;
+
+    void lower(const Instruction& ins) {
+        switch (ins.op) {
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MUL:
+            case OpCode::DIV:
+                if constexpr (X87) arithmeticX87(ins); else arithmeticSSE(ins);
+                break;
+            case OpCode::POW:
+                power(ins);
+                break;
+            case OpCode::NEG:
+                fld(ins.a);
+                as.bytes({ 0xD9, 0xE0 });       // fchs
+                fstp(ins.dst);
+                break;
+            case OpCode::FMA:
+                fusedMultiplyAdd(ins);
+                break;
+            case OpCode::CALL:
+                call(ins);
+                break;
+        }
+    }
+
+    void arithmeticX87(const Instruction& ins) {
+        if (ins.op == OpCode::DIV) {
+            fld(ins.b);
+            as.bytes({ 0xD9, 0xE4 });           // ftst
+            as.bytes({ 0xDF, 0xE0 });           // fnstsw ax
+            as.bytes({ 0x80, 0xE4, 0x45 });     // and ah, C3|C2|C0
+            as.bytes({ 0x80, 0xFC, 0x40 });     // cmp ah, C3 (equal to zero, ordered)
+            divisionErrors.push_back(as.jump({ 0x0F, 0x84 }));
+            fld(ins.a);
+            as.bytes({ 0xDE, 0xF1 });           // fdivrp st(1), st: a / b
+            fstp(ins.dst);
+            return;
+        }
+
+        fld(ins.a);
+        fld(ins.b);
+        switch (ins.op) {
+            case OpCode::ADD: as.bytes({ 0xDE, 0xC1 }); break;     // faddp
+            case OpCode::SUB: as.bytes({ 0xDE, 0xE9 }); break;     // fsubp st(1), st: a - b
+            case OpCode::MUL: as.bytes({ 0xDE, 0xC9 }); break;     // fmulp
+            default: break;
+        }
+        fstp(ins.dst);
+    }
+
+    void arithmeticSSE(const Instruction& ins) {
+        sseLoad(0, ins.a);
+        sseLoad(1, ins.b);
+        uint8_t opcode = 0x58;
+        switch (ins.op) {
+            case OpCode::ADD: opcode = 0x58; break;
+            case OpCode::SUB: opcode = 0x5C; break;
+            case OpCode::MUL: opcode = 0x59; break;
+            case OpCode::DIV: {
+                opcode = 0x5E;
+                as.bytes({ 0x0F, 0x57, 0xD2 }); // xorps xmm2, xmm2
+                if constexpr (!SINGLE) as.byte(0x66);
+                as.bytes({ 0x0F, 0x2E, 0xCA }); // ucomis[sd] xmm1, xmm2
+                as.bytes({ 0x7A, 0x06 });       // jp over the je (NaN is not zero)
+                divisionErrors.push_back(as.jump({ 0x0F, 0x84 }));
+                break;
+            }
+            default: break;
+        }
+        as.bytes({ ssePrefix(), 0x0F, opcode, 0xC1 });
+        sseStore(ins.dst, 0);
+    }
+
+    void power(const Instruction& ins) {
+        if constexpr (X87) {
+            fld(ins.a);
+            fstpStack(OUTGOING);
+            fld(ins.b);
+            fstpStack(OUTGOING + 16);
+            callAbsolute(reinterpret_cast<const void*>(static_cast<LongDoubleBinary>(::powl)));
+            fstp(ins.dst);
+        } else {
+            sseLoad(0, ins.a);
+            sseLoad(1, ins.b);
+            if constexpr (SINGLE) {
+                callAbsolute(reinterpret_cast<const void*>(static_cast<float (*)(float, float)>(::powf)));
+            } else {
+                callAbsolute(reinterpret_cast<const void*>(static_cast<double (*)(double, double)>(::pow)));
+            }
+            sseStore(ins.dst, 0);
+        }
+    }
+
+    void fusedMultiplyAdd(const Instruction& ins) {
+        if constexpr (X87) {
+            fld(ins.a);
+            fstpStack(OUTGOING);
+            fld(ins.b);
+            fstpStack(OUTGOING + 16);
+            fld(ins.c);
+            fstpStack(OUTGOING + 32);
+            callAbsolute(reinterpret_cast<const void*>(static_cast<LongDoubleTernary>(::fmal)));
+            fstp(ins.dst);
+        } else {
+            if (hasFma()) {
+                sseLoad(1, ins.a);
+                sseLoad(2, ins.b);
+                sseLoad(0, ins.c);
+                as.bytes({ 0xC4, 0xE2, SINGLE ? uint8_t(0x71) : uint8_t(0xF1), 0xB9, 0xC2 });  // vfmadd231s[sd] xmm0, xmm1, xmm2
+            } else {
+                sseLoad(0, ins.a);
+                sseLoad(1, ins.b);
+                sseLoad(2, ins.c);
+                if constexpr (SINGLE) {
+                    callAbsolute(reinterpret_cast<const void*>(static_cast<float (*)(float, float, float)>(::fmaf)));
+                } else {
+                    callAbsolute(reinterpret_cast<const void*>(static_cast<double (*)(double, double, double)>(::fma)));
+                }
+            }
+            sseStore(ins.dst, 0);
+        }
+    }
+
+    static bool hasFma() {
+        static const bool supported = __builtin_cpu_supports("fma");
+        return supported;
+    }
+
+    void call(const Instruction& ins) {
+        const auto& args = program.argumentPool();
+        const Builtin builtin = program.callbackBuiltins()[ins.fn];
+
+        switch (builtin) {
+            case Builtin::SIN:
+            case Builtin::COS:
+            case Builtin::TAN:
+            case Builtin::EXP:
+            case Builtin::LN:
+                fld(args[ins.a]);
+                fstpStack(OUTGOING);
+                callAbsolute(reinterpret_cast<const void*>(libmFunction(builtin)));
+                fstp(ins.dst);
+                return;
+            case Builtin::LOG:
+                // logl(a) / logl(b), with logl(a) kept in the spill slot across the second call.
+                fld(args[ins.a]);
+                fstpStack(OUTGOING);
+                callAbsolute(reinterpret_cast<const void*>(libmFunction(builtin)));
+                fstpStack(SPILL);
+                fld(args[ins.a + 1]);
+                fstpStack(OUTGOING);
+                callAbsolute(reinterpret_cast<const void*>(libmFunction(builtin)));
+                fldStack(SPILL);
+                as.bytes({ 0xDE, 0xF1 });       // fdivrp st(1), st
+                fstp(ins.dst);
+                return;
+            case Builtin::SQRT:
+                fld(args[ins.a]);
+                as.bytes({ 0xD9, 0xFA });       // fsqrt
+                fstp(ins.dst);
+                return;
+            case Builtin::ABS:
+                fld(args[ins.a]);
+                as.bytes({ 0xD9, 0xE1 });       // fabs
+                fstp(ins.dst);
+                return;
+            case Builtin::NEG:
+                fld(args[ins.a]);
+                as.bytes({ 0xD9, 0xE0 });       // fchs
+                fstp(ins.dst);
+                return;
+            default:
+                break;
+        }
+
+        // Generic callback: copy the arguments into the frame and go through the trampoline.
+        for (uint32_t i = 0; i < ins.b; ++i) {
+            copyToStack(args[ins.a + i], ARGS + i * static_cast<uint32_t>(sizeof(T)));
+        }
+        as.bytes({ 0x48, 0xBF });               // mov rdi, &callback
+        as.u64(reinterpret_cast<uint64_t>(&callbacks[ins.fn]));
+        as.bytes({ 0x48, 0x8D, 0xB4, 0x24 });   // lea rsi, [rsp + ARGS]
+        as.u32(ARGS);
+        as.byte(0xBA);                          // mov edx, argc
+        as.u32(ins.b);
+        as.bytes({ 0x48, 0x8D, 0x8B });         // lea rcx, [rbx + dst]
+        as.u32(disp(ins.dst));
+        callAbsolute(reinterpret_cast<const void*>(&invokeCallback<T>));
+        as.bytes({ 0x85, 0xC0 });               // test eax, eax
+        callbackErrors.push_back(as.jump({ 0x0F, 0x85 }));
+    }
+
+    // --- Operand helpers ---------------------------------------------------
+
+    static uint32_t disp(uint32_t reg) { return reg * static_cast<uint32_t>(sizeof(T)); }
+
+    static constexpr uint8_t ssePrefix() { return SINGLE ? 0xF3 : 0xF2; }
+
+    // fld T [rbx + reg]
+    void fld(uint32_t reg) {
+        if constexpr (X87) as.bytes({ 0xDB, 0xAB });
+        else if constexpr (SINGLE) as.bytes({ 0xD9, 0x83 });
+        else as.bytes({ 0xDD, 0x83 });
+        as.u32(disp(reg));
+    }
+
+    // fstp T [rbx + reg]
+    void fstp(uint32_t reg) {
+        if constexpr (X87) as.bytes({ 0xDB, 0xBB });
+        else if constexpr (SINGLE) as.bytes({ 0xD9, 0x9B });
+        else as.bytes({ 0xDD, 0x9B });
+        as.u32(disp(reg));
+    }
+
+    // fld tbyte [rsp + offset]
+    void fldStack(uint32_t offset) {
+        as.bytes({ 0xDB, 0xAC, 0x24 });
+        as.u32(offset);
+    }
+
+    // fstp tbyte [rsp + offset]
+    void fstpStack(uint32_t offset) {
+        as.bytes({ 0xDB, 0xBC, 0x24 });
+        as.u32(offset);
+    }
+
+    // movs[sd] xmmN, [rbx + reg]
+    void sseLoad(uint8_t xmm, uint32_t reg) {
+        as.bytes({ ssePrefix(), 0x0F, 0x10, static_cast<uint8_t>(0x83 | (xmm << 3)) });
+        as.u32(disp(reg));
+    }
+
+    // movs[sd] [rbx + reg], xmmN
+    void sseStore(uint32_t reg, uint8_t xmm) {
+        as.bytes({ ssePrefix(), 0x0F, 0x11, static_cast<uint8_t>(0x83 | (xmm << 3)) });
+        as.u32(disp(reg));
+    }
+
+    // Bitwise copy of register \p reg to [rsp + offset], through rax/eax.
+    void copyToStack(uint32_t reg, uint32_t offset) {
+        for (uint32_t done = 0; done < sizeof(T); done += 8) {
+            if constexpr (SINGLE) {
+                as.bytes({ 0x8B, 0x83 });                   // mov eax, [rbx + d]
+                as.u32(disp(reg));
+                as.bytes({ 0x89, 0x84, 0x24 });             // mov [rsp + o], eax
+                as.u32(offset);
+            } else {
+                as.bytes({ 0x48, 0x8B, 0x83 });             // mov rax, [rbx + d]
+                as.u32(disp(reg) + done);
+                as.bytes({ 0x48, 0x89, 0x84, 0x24 });       // mov [rsp + o], rax
+                as.u32(offset + done);
+            }
+        }
+    }
+
+    // mov rax, target; call rax
+    void callAbsolute(const void* target) {
+        as.bytes({ 0x48, 0xB8 });
+        as.u64(reinterpret_cast<uint64_t>(target));
+        as.bytes({ 0xFF, 0xD0 });
+    }
+
+    const Program& program;
+    const std::vector<FunctionCallback>& callbacks;
+    Assembler as;
+    uint32_t frame = 0;
+    std::vector<size_t> divisionErrors;
+    std::vector<size_t> callbackErrors;
+};
+
+} // namespace
+
+template <typename T>
+bool JitProgram<T>::isSupported() {
+    return SOLVER_JIT_SUPPORTED;
+}
+
+#if SOLVER_JIT_SUPPORTED
+
+template <typename T>
+JitProgram<T>::JitProgram(const Program& program)
+    : callbacks(program.callbackTable()), result(program.resultRegister()) {
+    PROFILE_FUNCTION()
+    std::vector<uint8_t> code = Emitter<T>(program, callbacks).emit();
+
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    mapped = (code.size() + page - 1) / page * page;
+    void* pages = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) {
+        throw SolverException("Failed to map memory for native code.");
+    }
+    std::memcpy(pages, code.data(), code.size());
+    if (mprotect(pages, mapped, PROT_READ | PROT_EXEC) != 0) {
+        munmap(pages, mapped);
+        throw SolverException("Failed to make native code executable.");
+    }
+
+    memory = pages;
+    size = code.size();
+    entry = reinterpret_cast<EntryPoint>(pages);
+}
+
+template <typename T>
+JitProgram<T>::~JitProgram() {
+    if (memory) {
+        munmap(memory, mapped);
+    }
+}
+
+#else
+
+template <typename T>
+JitProgram<T>::JitProgram(const Program&) {
+    throw SolverException("Native code generation is not supported on this platform.");
+}
+
+template <typename T>
+JitProgram<T>::~JitProgram() = default;
+
+#endif
+
+template <typename T>
+T JitProgram<T>::run(T* registers) const {
+    if (int status = entry(registers); status != OK) {
+        raise(status);
+    }
+    return registers[result];
+}
+
+template class JitProgram<float>;
+template class JitProgram<double>;
+template class JitProgram<long double>;
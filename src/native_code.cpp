@@ -0,0 +1,38 @@
+#include "native_code.h"
+#include "function.h"
+
+namespace NativeCodeDetail {
+
+// Exception raised by a callback, parked until control is back in C++.
+static thread_local std::exception_ptr pendingException;
+
+template <typename T>
+int invokeCallback(const void* callback, const T* args, uint32_t argc, T* out) {
+    thread_local std::vector<NUMBER_TYPE> buffer;
+    try {
+        buffer.assign(args, args + argc);
+        *out = static_cast<T>((*static_cast<const FunctionCallback*>(callback))(buffer));
+        return OK;
+    } catch (...) {
+        pendingException = std::current_exception();
+        return CALLBACK_FAILED;
+    }
+}
+
+template int invokeCallback(const void*, const float*, uint32_t, float*);
+template int invokeCallback(const void*, const double*, uint32_t, double*);
+template int invokeCallback(const void*, const long double*, uint32_t, long double*);
+
+void raise(int status) {
+    if (status == DIVISION_BY_ZERO) {
+        throw SolverException("Division by zero");
+    }
+    if (status == CALLBACK_FAILED && pendingException) {
+        std::exception_ptr error = pendingException;
+        pendingException = nullptr;
+        std::rethrow_exception(error);
+    }
+    throw SolverException("Native code failed with status " + std::to_string(status) + ".");
+}
+
+} // namespace NativeCodeDetail
@@ -18,21 +18,30 @@ size_t getFunctionArgCount(const std::string& functionName, const std::unordered
 
 #pragma region Parsing and Shunting Yard
 
-int getPrecedence(const std::string& op) {
-    if (op == "+" || op == "-") return 1;
-    if (op == "*" || op == "/") return 2;
-    if (op == "^") return 3;
-    return 0;
+int getPrecedence(OperatorType op) {
+    switch (op) {
+        case OperatorType::ADD:
+        case OperatorType::SUB: return 1;
+        case OperatorType::MUL:
+        case OperatorType::DIV: return 2;
+        case OperatorType::POW: return 3;
+        default:                return 0;
+    }
+}
+
+bool isLeftAssociative(OperatorType op) {
+    return op != OperatorType::POW;  // "^" is right-associative, all others are left-associative
 }
 
-bool isLeftAssociative(const std::string& op) {
-    return op != "^";  // "^" is right-associative, all others are left-associative
+// Whether token is the opening parenthesis.
+static bool isLeftParen(const Token& token) {
+    return token.type == PAREN && token.id == TokenPool::LEFT_PAREN;
 }
 
 void processOperatorStack(const Token& token, std::stack<Token>& operatorStack, std::vector<Token>& outputVector) {
     while (!operatorStack.empty() &&
-           ((isLeftAssociative(token.value) && getPrecedence(token.value) <= getPrecedence(operatorStack.top().value)) ||
-            (!isLeftAssociative(token.value) && getPrecedence(token.value) < getPrecedence(operatorStack.top().value)))) {
+           ((isLeftAssociative(token.op) && getPrecedence(token.op) <= getPrecedence(operatorStack.top().op)) ||
+            (!isLeftAssociative(token.op) && getPrecedence(token.op) < getPrecedence(operatorStack.top().op)))) {
         outputVector.push_back(operatorStack.top());
         operatorStack.pop();
     }
@@ -40,7 +49,7 @@ void processOperatorStack(const Token& token, std::stack<Token>& operatorStack,
 }
 
 void handleParentheses(std::stack<Token>& operatorStack, std::vector<Token>& outputVector) {
-    while (!operatorStack.empty() && operatorStack.top().value != "(") {
+    while (!operatorStack.empty() && !isLeftParen(operatorStack.top())) {
         outputVector.push_back(operatorStack.top());
         operatorStack.pop();
     }
@@ -51,7 +60,7 @@ void handleParentheses(std::stack<Token>& operatorStack, std::vector<Token>& out
 }
 
 void handleFunctionArgumentSeparator(std::stack<Token>& operatorStack, std::vector<Token>& outputVector, std::stack<int>& argumentCounts) {
-    while (!operatorStack.empty() && operatorStack.top().value != "(") {
+    while (!operatorStack.empty() && !isLeftParen(operatorStack.top())) {
         outputVector.push_back(operatorStack.top());
         operatorStack.pop();
     }
@@ -78,22 +87,22 @@ std::vector<Token> shuntingYard(const std::vector<Token>& tokens) {
             argumentCounts.push(1);
         } else if (token.type == OPERATOR) {
             processOperatorStack(token, operatorStack, outputVector);
-        } else if (token.value == "(") {
+        } else if (isLeftParen(token)) {
             operatorStack.push(token);
-        } else if (token.value == ")") {
+        } else if (token.type == PAREN) {
             handleParentheses(operatorStack, outputVector);
             if (!operatorStack.empty() && operatorStack.top().type == FUNCTION) {
                 outputVector.push_back(operatorStack.top());
                 operatorStack.pop();
             }
-        } else if (token.value == ",") {
+        } else if (token.type == SEPARATOR) {
             handleFunctionArgumentSeparator(operatorStack, outputVector, argumentCounts);
         }
     }
 
     // Pop all remaining operators into the output vector
     while (!operatorStack.empty()) {
-        if (operatorStack.top().value == "(" || operatorStack.top().value == ")") {
+        if (operatorStack.top().type == PAREN) {
             throw SolverException("Mismatched parentheses.");
         }
         outputVector.push_back(operatorStack.top());
@@ -107,7 +116,7 @@ std::vector<Token> shuntingYard(const std::vector<Token>& tokens) {
 
 #pragma region Postfix Evaluation
 
-NUMBER_TYPE evaluatePostfix(const std::vector<Token>& postfixQueue, const SymbolTable& symbolTable, const std::unordered_map<std::string, Function>& functions) {
+NUMBER_TYPE evaluatePostfix(const std::vector<Token>& postfixQueue, const TokenPool& pool, const SymbolTable& symbolTable, const std::unordered_map<std::string, Function>& functions) {
     PROFILE_FUNCTION()
     // Preallocate a vector to serve as our evaluation stack.
     // Its maximum size is the number of tokens (this is an overestimate but safe).
@@ -117,21 +126,20 @@ NUMBER_TYPE evaluatePostfix(const std::vector<Token>& postfixQueue, const Symbol
     for (const auto& token : postfixQueue) {
         switch (token.type) {
             case NUMBER: {
-                // Assume token holds a precomputed numeric value (or convert once)
-                // If not, you still call std::stold(token.value)
-                stack.push_back(token.numericValue);
+                // The value was converted once, when it entered the constant pool
+                stack.push_back(pool.number(token.id));
                 break;
             }
             case VARIABLE: {
                 // Look up the variable’s current value
-                NUMBER_TYPE varValue = symbolTable.lookupSymbol(token.value);
+                NUMBER_TYPE varValue = symbolTable.lookupSymbol(pool.name(token.id));
                 stack.push_back(varValue);
                 break;
             }
             case OPERATOR: {
                 // Ensure there are at least two operands
                 if (stack.size() < 2) {
-                    throw SolverException("Not enough operands for operator '" + token.value + "'");
+                    throw SolverException("Not enough operands for operator '" + pool.name(token.id) + "'");
                 }
                 NUMBER_TYPE right = stack.back(); stack.pop_back();
                 NUMBER_TYPE left  = stack.back(); stack.pop_back();
@@ -157,20 +165,21 @@ NUMBER_TYPE evaluatePostfix(const std::vector<Token>& postfixQueue, const Symbol
                         result = std::pow(left, right);
                         break;
                     default:
-                        throw SolverException("Unknown operator: '" + token.value + "'");
+                        throw SolverException("Unknown operator: '" + pool.name(token.id) + "'");
                 }
                 stack.push_back(result);
                 break;
             }
             case FUNCTION: {
-                auto it = functions.find(token.value);
+                const std::string& name = pool.name(token.id);
+                auto it = functions.find(name);
                 if (it == functions.end()) {
-                    throw SolverException("Unknown function: '" + token.value + "'");
+                    throw SolverException("Unknown function: '" + name + "'");
                 }
                 const Function& function = it->second;
                 size_t argCount = function.argCount;
                 if (stack.size() < argCount) {
-                    throw SolverException("Not enough arguments for function '" + token.value + "'");
+                    throw SolverException("Not enough arguments for function '" + name + "'");
                 }
 
                 // Use a fixed-size array if argCount is small
@@ -207,170 +216,14 @@ NUMBER_TYPE evaluatePostfix(const std::vector<Token>& postfixQueue, const Symbol
 }
 
 
-std::vector<Token> flattenPostfix(const std::vector<Token>& postfixQueue, const std::unordered_map<std::string, Function>& functions) {
+std::vector<Token> flattenPostfix(const std::vector<Token>& postfixQueue, TokenPool& pool, const std::unordered_map<std::string, Function>& functions) {
     PROFILE_FUNCTION()
 
-    // We use a stack of "partial" postfix expressions. Each element on the stack
-    // is a fully formed (sub)postfix sequence. For instance, if we see a NUMBER token,
-    // we push a vector containing just that one token. If we see an OPERATOR that needs
-    // two operands, we pop the top two vectors from the stack, concatenate them, then
-    // append the operator, creating a single new vector we push back.
-
-    std::stack<std::vector<Token>> argumentStack;
-
-    for (const auto& token : postfixQueue)
-    {
-        switch (token.type)
-        {
-        case NUMBER:
-        case VARIABLE:
-        {
-            // For a simple number or variable, just push it as a single-element vector.
-            argumentStack.push({ token });
-            break;
-        }
-
-        case OPERATOR:
-        {
-            // An operator needs two operands in postfix:
-            // leftExpr + rightExpr + operator
-            if (argumentStack.size() < 2)
-            {
-                throw SolverException(
-                    "Not enough operands for operator '" + token.value + "'");
-            }
-            // Pop the right-hand side
-            auto right = argumentStack.top();
-            argumentStack.pop();
-            // Pop the left-hand side
-            auto left = argumentStack.top();
-            argumentStack.pop();
-
-            // Merge them into one postfix expression
-            std::vector<Token> combined = left;
-            combined.insert(combined.end(), right.begin(), right.end());
-            combined.push_back(token);
-
-            argumentStack.push(std::move(combined));
-            break;
-        }
-
-        case FUNCTION:
-        {
-            // A function can be either a predefined function (like sin, cos) or
-            // a user-defined function. We retrieve it from the function map:
-            auto it = functions.find(token.value);
-            if (it == functions.end())
-            {
-                throw SolverException(
-                    "Unknown function: '" + token.value + "'");
-            }
-
-            const Function& function = it->second;
-            const size_t argCount = function.argCount;
-
-            // Check if we have enough arguments on the stack
-            if (argumentStack.size() < argCount)
-            {
-                throw SolverException(
-                    "Insufficient arguments for function: '" + token.value + "'");
-            }
-
-            // Collect the top `argCount` vectors from the stack
-            // in reverse order, because the top is the last argument.
-            std::vector<std::vector<Token>> args(argCount);
-            for (size_t j = 0; j < argCount; ++j)
-            {
-                args[argCount - j - 1] = argumentStack.top();
-                argumentStack.pop();
-            }
-
-            if (function.isPredefined)
-            {
-                // For predefined functions, we do NOT inline anything.
-                // Instead, we simply combine the arguments into one
-                // postfix sequence and then append the function token.
-                std::vector<Token> combined;
-                for (const auto& argPostfix : args)
-                {
-                    combined.insert(combined.end(),
-                                    argPostfix.begin(),
-                                    argPostfix.end());
-                }
-                combined.push_back(token);
-
-                // Push the resulting single postfix expression for
-                // this function call back onto the stack.
-                argumentStack.push(std::move(combined));
-            }
-            else
-            {
-                // For user-defined functions, we inline the function definition.
-                // The function.inlinedPostfix is the user-defined function's
-                // body in postfix form (where variables are placeholders).
-                // We substitute each occurrence of the variable with its
-                // corresponding argument postfix vector.
-
-                std::vector<Token> inlined;
-                inlined.reserve(function.inlinedPostfix.size() * 2); 
-                // Rough reservation to reduce reallocs
-
-                for (const auto& fToken : function.inlinedPostfix)
-                {
-                    // If it's a variable, see if it matches one of the argument names.
-                    // If so, replace it with that argument's flattened postfix tokens.
-                    if (fToken.type == VARIABLE)
-                    {
-                        auto argIt = std::find(function.argumentNames.begin(),
-                                               function.argumentNames.end(),
-                                               fToken.value);
-                        if (argIt != function.argumentNames.end())
-                        {
-                            // This variable is one of the function's formal parameters
-                            size_t index = std::distance(function.argumentNames.begin(),
-                                                         argIt);
-                            // Insert the entire argument postfix
-                            const auto& argPostfix = args[index];
-                            inlined.insert(inlined.end(),
-                                           argPostfix.begin(),
-                                           argPostfix.end());
-                        }
-                        else
-                        {
-                            // It's some other variable that isn't a function param
-                            inlined.push_back(fToken);
-                        }
-                    }
-                    else
-                    {
-                        // Keep numbers, operators, etc. as is
-                        inlined.push_back(fToken);
-                    }
-                }
-
-                // Push the fully inlined postfix expression for this function call
-                argumentStack.push(std::move(inlined));
-            }
-            break;
-        }
-
-        default:
-            throw SolverException(
-                "Unsupported token type during flattening: " + token.value);
-        }
-    }
-
-    // At the end, there should be exactly ONE expression in the stack
-    // if the postfix expression was well-formed.
-    if (argumentStack.size() != 1)
-    {
-        throw SolverException(
-            "Flattening error: leftover expressions in the stack. Stack size = "
-            + std::to_string(argumentStack.size()));
-    }
-
-    // This single element is our fully flattened postfix expression.
-    return argumentStack.top();
+    // Inlining happens on an ExpressionGraph, where each argument is shared by the uses of
+    // its parameter; expanding the graph gives the flattened postfix, in which every use
+    // of a parameter gets its own copy of the argument.
+    ExpressionGraph graph;
+    return graph.toPostfix(graph.addPostfix(postfixQueue, pool, functions), pool);
 }
 
 
@@ -0,0 +1,166 @@
+#include "program.h"
+
+template <typename T>
+void Program::initRegisters(std::vector<T>& registers) const {
+    registers.assign(registerCount(), 0);
+    std::transform(constants.begin(), constants.end(), registers.begin(), [](NUMBER_TYPE value) { return static_cast<T>(value); });
+}
+
+int Program::variableRegister(const std::string& name) const {
+    for (size_t i = 0; i < variables.size(); ++i) {
+        if (variables[i] == name) {
+            return static_cast<int>(variableBase() + i);
+        }
+    }
+    return -1;
+}
+
+template <typename T>
+T Program::run(T* r) const {
+    // Scratch buffer for callback arguments; reused across calls so steady-state evaluation does not allocate.
+    thread_local std::vector<NUMBER_TYPE> args;
+
+    for (const Instruction& ins : code) {
+        switch (ins.op) {
+            case OpCode::ADD: r[ins.dst] = r[ins.a] + r[ins.b]; break;
+            case OpCode::SUB: r[ins.dst] = r[ins.a] - r[ins.b]; break;
+            case OpCode::MUL: r[ins.dst] = r[ins.a] * r[ins.b]; break;
+            case OpCode::DIV:
+                if (r[ins.b] == 0) throw SolverException("Division by zero");
+                r[ins.dst] = r[ins.a] / r[ins.b];
+                break;
+            case OpCode::POW: r[ins.dst] = std::pow(r[ins.a], r[ins.b]); break;
+            case OpCode::NEG: r[ins.dst] = -r[ins.a]; break;
+            case OpCode::FMA: r[ins.dst] = std::fma(r[ins.a], r[ins.b], r[ins.c]); break;
+            case OpCode::CALL: {
+                if (builtins[ins.fn] != Builtin::NONE) {
+                    const T operands[2] = { r[argPool[ins.a]], ins.b > 1 ? r[argPool[ins.a + 1]] : T(0) };
+                    r[ins.dst] = builtinValue<T>(builtins[ins.fn], operands);
+                    break;
+                }
+                args.resize(ins.b);
+                for (uint32_t i = 0; i < ins.b; ++i) {
+                    args[i] = static_cast<NUMBER_TYPE>(r[argPool[ins.a + i]]);
+                }
+                r[ins.dst] = static_cast<T>(callbacks[ins.fn](args));
+                break;
+            }
+        }
+    }
+    return r[result];
+}
+
+template void Program::initRegisters(std::vector<float>&) const;
+template void Program::initRegisters(std::vector<double>&) const;
+template void Program::initRegisters(std::vector<long double>&) const;
+template float Program::run(float*) const;
+template double Program::run(double*) const;
+template long double Program::run(long double*) const;
+
+void Program::verify() const {
+    const uint32_t count = registerCount();
+    const uint32_t temps = tempBase();
+
+    if (result >= count) {
+        throw SolverException("Invalid program: result register out of range.");
+    }
+    if (callbacks.size() != callbackNames.size() || callbacks.size() != builtins.size()) {
+        throw SolverException("Invalid program: callback table is inconsistent.");
+    }
+
+    for (const Instruction& ins : code) {
+        if (ins.dst < temps || ins.dst >= count) {
+            throw SolverException("Invalid program: instruction writes outside the temporary registers.");
+        }
+        switch (ins.op) {
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MUL:
+            case OpCode::DIV:
+            case OpCode::POW:
+                if (ins.a >= count || ins.b >= count) {
+                    throw SolverException("Invalid program: operand register out of range.");
+                }
+                break;
+            case OpCode::NEG:
+                if (ins.a >= count) {
+                    throw SolverException("Invalid program: operand register out of range.");
+                }
+                break;
+            case OpCode::FMA:
+                if (ins.a >= count || ins.b >= count || ins.c >= count) {
+                    throw SolverException("Invalid program: operand register out of range.");
+                }
+                break;
+            case OpCode::CALL:
+                if (ins.fn >= callbacks.size() || !callbacks[ins.fn]) {
+                    throw SolverException("Invalid program: call to an unknown callback.");
+                }
+                if (static_cast<size_t>(ins.a) + ins.b > argPool.size()) {
+                    throw SolverException("Invalid program: argument range out of bounds.");
+                }
+                for (uint32_t i = 0; i < ins.b; ++i) {
+                    if (argPool[ins.a + i] >= count) {
+                        throw SolverException("Invalid program: argument register out of range.");
+                    }
+                }
+                break;
+            default:
+                throw SolverException("Invalid program: unknown opcode.");
+        }
+    }
+}
+
+static std::string registerName(const Program& program, uint32_t reg) {
+    std::ostringstream oss;
+    if (reg < program.variableBase()) {
+        oss << "c" << reg;
+    } else if (reg < program.tempBase()) {
+        oss << program.variableNames()[reg - program.variableBase()];
+    } else {
+        oss << "t" << (reg - program.tempBase());
+    }
+    return oss.str();
+}
+
+size_t Program::byteSize() const {
+    size_t bytes = sizeof(Program)
+                 + constants.capacity() * sizeof(NUMBER_TYPE)
+                 + code.capacity() * sizeof(Instruction)
+                 + argPool.capacity() * sizeof(uint32_t)
+                 + callbacks.capacity() * sizeof(FunctionCallback)
+                 + builtins.capacity() * sizeof(Builtin);
+    for (const std::string& name : variables) {
+        bytes += sizeof(std::string) + name.capacity();
+    }
+    for (const std::string& name : callbackNames) {
+        bytes += sizeof(std::string) + name.capacity();
+    }
+    return bytes;
+}
+
+void Program::disassemble() const {
+    static const char* names[] = { "ADD", "SUB", "MUL", "DIV", "POW", "NEG", "CALL", "FMA" };
+
+    for (size_t i = 0; i < constants.size(); ++i) {
+        std::cout << "  c" << i << " = " << numberToString(constants[i]) << std::endl;
+    }
+    for (const Instruction& ins : code) {
+        std::cout << "  " << names[static_cast<int>(ins.op)] << " " << registerName(*this, ins.dst) << ", ";
+        if (ins.op == OpCode::CALL) {
+            std::cout << callbackNames[ins.fn] << "(";
+            for (uint32_t i = 0; i < ins.b; ++i) {
+                std::cout << registerName(*this, argPool[ins.a + i]) << (i + 1 < ins.b ? ", " : "");
+            }
+            std::cout << ")";
+        } else if (ins.op == OpCode::NEG) {
+            std::cout << registerName(*this, ins.a);
+        } else if (ins.op == OpCode::FMA) {
+            std::cout << registerName(*this, ins.a) << ", " << registerName(*this, ins.b) << ", " << registerName(*this, ins.c);
+        } else {
+            std::cout << registerName(*this, ins.a) << ", " << registerName(*this, ins.b);
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "  RET " << registerName(*this, result) << std::endl;
+}
@@ -0,0 +1,60 @@
+#include "program_cache.h"
+
+size_t CachedProgram::byteSize() const {
+    size_t bytes = sizeof(CachedProgram) + graph.byteSize() + program.byteSize() + (ast ? ast->byteSize() : 0);
+    for (const std::string& name : dependencies) {
+        bytes += sizeof(std::string) + name.capacity();
+    }
+    return bytes;
+}
+
+void PendingPromotion::complete(const std::function<TierPromotion()>& build) {
+    try {
+        promoted.emplace(build());
+    } catch (...) {
+        error = std::current_exception();
+    }
+    ready.store(true, std::memory_order_release);
+}
+
+PromotionQueue::~PromotionQueue() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void PromotionQueue::push(const std::shared_ptr<PendingPromotion>& pending, std::function<TierPromotion()> build) {
+    {
+        std::lock_guard lock(mutex);
+        jobs.emplace_back(pending, std::move(build));
+        if (!worker.joinable()) {
+            worker = std::thread(&PromotionQueue::work, this);
+        }
+    }
+    wake.notify_one();
+}
+
+void PromotionQueue::work() {
+    std::unique_lock lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) {
+            return;
+        }
+        auto [target, build] = std::move(jobs.front());
+        jobs.pop_front();
+        // A promotion whose entry was dropped meanwhile is not built
+        if (std::shared_ptr<PendingPromotion> pending = target.lock()) {
+            lock.unlock();
+            pending->complete(build);
+            pending.reset();
+            lock.lock();
+        }
+    }
+}
@@ -0,0 +1,233 @@
+#include "simplification/canonical_form.h"
+
+namespace {
+
+/// Which associative family a node belongs to.
+enum class Family { NONE, SUM, PRODUCT };
+
+Family familyOf(const GraphNode& node) {
+    if (node.type == OPERATOR) {
+        switch (node.op) {
+            case OperatorType::ADD:
+            case OperatorType::SUB: return Family::SUM;
+            case OperatorType::MUL:
+            case OperatorType::DIV: return Family::PRODUCT;
+            default:                return Family::NONE;
+        }
+    }
+    // Negation is a sum of one negated term
+    if (node.type == FUNCTION && node.name == "neg" && node.children.size() == 1) {
+        return Family::SUM;
+    }
+    return Family::NONE;
+}
+
+void hashCombine(uint64_t& hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+}
+
+class Canonicalizer {
+public:
+    Canonicalizer(ExpressionGraph& graph, bool fastMath) : graph(graph), fastMath(fastMath) {}
+
+    NodeId run(NodeId root) {
+        const std::vector<NodeId> order = graph.reachable(root);
+        const size_t size = graph.size();
+
+        // A node of a sum or product used once, by a node of the same family, is flattened into
+        // it; only under fast math, since regrouping terms changes how they round
+        std::vector<uint32_t> uses(size, 0);
+        ++uses[root];
+        for (NodeId id : order) {
+            for (NodeId child : graph[id].children) {
+                ++uses[child];
+            }
+        }
+        absorbed.assign(size, false);
+        for (NodeId id : order) {
+            const Family family = familyOf(graph[id]);
+            if (family == Family::NONE || !fastMath) {
+                continue;
+            }
+            for (NodeId child : graph[id].children) {
+                if (uses[child] == 1 && familyOf(graph[child]) == family) {
+                    absorbed[child] = true;
+                }
+            }
+        }
+
+        result.assign(size, 0);
+        std::vector<NodeId> operands;
+        for (NodeId id : order) {
+            if (absorbed[id]) {
+                continue;
+            }
+            const Family family = familyOf(graph[id]);
+            if (family != Family::NONE && fastMath) {
+                result[id] = collect(id, family);
+                continue;
+            }
+            const std::vector<NodeId>& children = graph[id].children;
+            operands.resize(children.size());
+            bool changed = false;
+            for (size_t i = 0; i < children.size(); ++i) {
+                operands[i] = result[children[i]];
+                changed |= operands[i] != children[i];
+            }
+            // Swapping the operands of an addition or a multiplication is exact
+            const GraphNode& node = graph[id];
+            if (node.type == OPERATOR && (node.op == OperatorType::ADD || node.op == OperatorType::MUL) && before(operands[1], operands[0])) {
+                std::swap(operands[0], operands[1]);
+                changed = true;
+            }
+            result[id] = fingerprinted(changed ? graph.withChildren(id, operands) : id);
+        }
+        return result[root];
+    }
+
+private:
+    /// Flattens the sum or product rooted at \p id, folds its constants and rebuilds it.
+    NodeId collect(NodeId id, Family family) {
+        const bool sum = family == Family::SUM;
+        NUMBER_TYPE constant = sum ? 0 : 1;
+        NUMBER_TYPE divisor = 1;        // Divisors are folded apart, so x / 3 is not rounded as x * (1/3)
+        std::vector<NodeId> direct;     // Added or multiplied terms
+        std::vector<NodeId> inverse;    // Subtracted or divided terms
+
+        // (node, whether it is subtracted or divided)
+        std::vector<std::pair<NodeId, bool>> stack{ { id, false } };
+        while (!stack.empty()) {
+            const auto [node, inverted] = stack.back();
+            stack.pop_back();
+            if (node == id || absorbed[node]) {
+                const GraphNode& inner = graph[node];
+                const bool flipsRight = inner.type == OPERATOR && (inner.op == OperatorType::SUB || inner.op == OperatorType::DIV);
+                if (inner.type == FUNCTION) {
+                    stack.emplace_back(inner.children[0], !inverted);
+                } else {
+                    stack.emplace_back(inner.children[1], flipsRight ? !inverted : inverted);
+                    stack.emplace_back(inner.children[0], inverted);
+                }
+                continue;
+            }
+            const NodeId term = result[node];
+            const GraphNode& operand = graph[term];
+            // A constant divisor of 0 stays, so the division still fails at evaluation
+            if (operand.type == NUMBER && !(!sum && inverted && operand.number == 0)) {
+                if (sum) {
+                    constant = inverted ? constant - operand.number : constant + operand.number;
+                } else if (inverted) {
+                    divisor *= operand.number;
+                } else {
+                    constant *= operand.number;
+                }
+                continue;
+            }
+            (inverted ? inverse : direct).push_back(term);
+        }
+
+        auto byStructure = [this](NodeId a, NodeId b) { return before(a, b); };
+        std::sort(direct.begin(), direct.end(), byStructure);
+        std::sort(inverse.begin(), inverse.end(), byStructure);
+
+        if (sum) {
+            // The constant goes last, subtracted when negative
+            if (constant != 0 || (direct.empty() && inverse.empty())) {
+                if (constant < 0) {
+                    inverse.push_back(fingerprinted(graph.number(-constant)));
+                } else {
+                    direct.push_back(fingerprinted(graph.number(constant)));
+                }
+            }
+            if (direct.empty()) {
+                return fingerprinted(graph.call("neg", { balanced(OperatorType::ADD, inverse, 0, inverse.size()) }));
+            }
+            const NodeId added = balanced(OperatorType::ADD, direct, 0, direct.size());
+            return inverse.empty() ? added : fingerprinted(graph.binary(OperatorType::SUB, added, balanced(OperatorType::ADD, inverse, 0, inverse.size())));
+        }
+
+        // A product with 0 is 0 only if its other terms are finite and do not fail
+        if (fastMath && constant == 0 && inverse.empty()) {
+            return fingerprinted(graph.number(constant));
+        }
+        if (constant != 1 || direct.empty()) {
+            direct.push_back(fingerprinted(graph.number(constant)));
+        }
+        if (divisor != 1) {
+            inverse.push_back(fingerprinted(graph.number(divisor)));
+        }
+        const NodeId multiplied = balanced(OperatorType::MUL, direct, 0, direct.size());
+        return inverse.empty() ? multiplied : fingerprinted(graph.binary(OperatorType::DIV, multiplied, balanced(OperatorType::MUL, inverse, 0, inverse.size())));
+    }
+
+    /// Combines terms[first, last) with \p op as a balanced tree.
+    NodeId balanced(OperatorType op, const std::vector<NodeId>& terms, size_t first, size_t last) {
+        if (last - first == 1) {
+            return terms[first];
+        }
+        const size_t middle = first + (last - first) / 2;
+        const NodeId left = balanced(op, terms, first, middle);
+        const NodeId right = balanced(op, terms, middle, last);
+        return fingerprinted(graph.binary(op, left, right));
+    }
+
+    /// The canonical order of terms: variables by name, then calls by name, then the rest, by structure.
+    bool before(NodeId a, NodeId b) const {
+        const GraphNode& x = graph[a];
+        const GraphNode& y = graph[b];
+        auto rank = [](const GraphNode& node) {
+            switch (node.type) {
+                case VARIABLE: return 0;
+                case FUNCTION: return 1;
+                case OPERATOR: return 2;
+                default:       return 3;
+            }
+        };
+        if (rank(x) != rank(y)) {
+            return rank(x) < rank(y);
+        }
+        if (x.name != y.name && x.type != OPERATOR) {
+            return x.name < y.name;
+        }
+        if (prints[a] != prints[b]) {
+            return prints[a] < prints[b];
+        }
+        return a < b;
+    }
+
+    /// Records the structural fingerprint of \p id, from those of its children; returns \p id.
+    NodeId fingerprinted(NodeId id) {
+        if (prints.size() <= id) {
+            prints.resize(graph.size(), 0);
+        }
+        if (prints[id] != 0) {
+            return id;
+        }
+        // Unlike GraphNode::hash this does not depend on node ids, so it is the same in any graph
+        const GraphNode& node = graph[id];
+        uint64_t print = node.type;
+        hashCombine(print, static_cast<uint64_t>(node.op));
+        hashCombine(print, std::hash<std::string>{}(node.name));
+        if (node.type == NUMBER) {
+            hashCombine(print, NumberHash{}(node.number));
+        }
+        for (NodeId child : node.children) {
+            hashCombine(print, prints[child]);
+        }
+        prints[id] = print | 1;  // 0 marks a node without a fingerprint
+        return id;
+    }
+
+    ExpressionGraph& graph;
+    bool fastMath;
+    std::vector<NodeId> result;     ///< Normalized node of each visited node.
+    std::vector<bool> absorbed;     ///< Whether a node is flattened into the sum or product using it.
+    std::vector<uint64_t> prints;   ///< Structural fingerprint of each normalized node, or 0.
+};
+
+} // namespace
+
+NodeId canonicalizeSumsAndProducts(ExpressionGraph& graph, NodeId root, bool fastMath) {
+    PROFILE_FUNCTION()
+    return Canonicalizer(graph, fastMath).run(root);
+}
@@ -0,0 +1,629 @@
+#include "simplification/equality_saturation.h"
+#include "simplification/rewrite_rules.h"
+#include "simplification/strength_reduction.h"
+#include <bit>
+#include <chrono>
+
+namespace {
+
+using ClassId = uint32_t;
+using Term = RewriteRules::Term;
+
+// The identities, as pattern rules; "<=>" stands for a rule and its converse. A rule that
+// only holds one way is written in the direction whose replacement is defined wherever
+// its pattern is. These hold in real arithmetic, and in floating point keep errors,
+// domains and special values: they only change rounding, and where an intermediate
+// result overflows or underflows.
+const std::vector<std::string> IDENTITIES = {
+    // Commutativity and associativity
+    "?a + ?b <=> ?b + ?a",
+    "?a * ?b <=> ?b * ?a",
+    "(?a + ?b) + ?c <=> ?a + (?b + ?c)",
+    "(?a * ?b) * ?c <=> ?a * (?b * ?c)",
+    "(?a + ?b) - ?c <=> ?a + (?b - ?c)",
+    "?a / ?b * ?c <=> ?a * ?c / ?b",
+    // 0, 1 and negation
+    "?a + 0 => ?a",
+    "?a - 0 => ?a",
+    "0 - ?a => -?a",
+    "?a * 1 => ?a",
+    "?a * -1 => -?a",
+    "?a / 1 => ?a",
+    "?a ^ 1 => ?a",
+    "?a ^ 0 => 1",
+    "-(-?a) => ?a",
+    "?a - ?b <=> ?a + -?b",
+    "-?a * ?b <=> -(?a * ?b)",
+    "?a * ?a <=> ?a ^ 2",
+};
+
+// The identities that also change special values, errors or domains, used under fast
+// math only: inf - inf is NaN, not 0; inf * (0 + 1) is inf but inf * 0 + inf * 1 is NaN;
+// a / b / c does not fail where b * c underflows to 0; sqrt(-0) is -0 but (-0)^0.5 is 0;
+// ln(a) + ln(b) is NaN for negative a and b, and ln(a * b) overflows for large ones.
+const std::vector<std::string> FAST_MATH_IDENTITIES = {
+    // Distributivity
+    "?a * (?b + ?c) <=> ?a * ?b + ?a * ?c",
+    "?a * (?b - ?c) <=> ?a * ?b - ?a * ?c",
+    "(?a + ?b) / ?c <=> ?a / ?c + ?b / ?c",
+    "?a / ?b / ?c <=> ?a / (?b * ?c)",
+    "?a - ?a => 0",
+    "?a * 0 => 0",
+    // Powers
+    "?a ^ ?b * ?a => ?a ^ (?b + 1)",
+    "?a ^ ?b * ?a ^ ?c => ?a ^ (?b + ?c)",
+    "?a ^ ?b / ?a => ?a ^ (?b - 1)",
+    "?a ^ ?b / ?a ^ ?c => ?a ^ (?b - ?c)",
+    "?a ^ ?c * ?b ^ ?c => (?a * ?b) ^ ?c",
+    "1 / ?a ^ ?b => ?a ^ -?b",
+    "sqrt(?a) <=> ?a ^ 0.5",
+    "sqrt(?a) * sqrt(?b) => sqrt(?a * ?b)",
+    // exp and ln
+    "exp(?a) * exp(?b) <=> exp(?a + ?b)",
+    "exp(?a) / exp(?b) <=> exp(?a - ?b)",
+    "exp(?a) ^ ?b <=> exp(?a * ?b)",
+    "ln(exp(?a)) => ?a",
+    "exp(ln(?a)) => ?a",
+    "ln(?a) + ln(?b) => ln(?a * ?b)",
+    "ln(?a) - ln(?b) => ln(?a / ?b)",
+    "?b * ln(?a) => ln(?a ^ ?b)",
+    "ln(?a) / ln(?b) <=> log(?a, ?b)",
+};
+
+/// Parses \p identities into \p rules, a rule per direction of a "<=>".
+void parseIdentities(const std::vector<std::string>& identities, std::vector<RewriteRules::Rule>& rules) {
+    for (const std::string& rule : identities) {
+        const size_t both = rule.find("<=>");
+        if (both == std::string::npos) {
+            rules.push_back(RewriteRules::parse(rule));
+            continue;
+        }
+        const std::string left = rule.substr(0, both);
+        const std::string right = rule.substr(both + 3);
+        rules.push_back(RewriteRules::parse(left + "=>" + right));
+        rules.push_back(RewriteRules::parse(right + "=>" + left));
+    }
+}
+
+// The identities used with or without fast math, parsed once and shared by every solver
+const std::vector<RewriteRules::Rule>& identities(bool fastMath) {
+    static const std::vector<RewriteRules::Rule> exact = [] {
+        std::vector<RewriteRules::Rule> parsed;
+        parseIdentities(IDENTITIES, parsed);
+        return parsed;
+    }();
+    static const std::vector<RewriteRules::Rule> fast = [] {
+        std::vector<RewriteRules::Rule> parsed;
+        parseIdentities(IDENTITIES, parsed);
+        parseIdentities(FAST_MATH_IDENTITIES, parsed);
+        return parsed;
+    }();
+    return fastMath ? fast : exact;
+}
+
+/// Whether every function \p term calls is a built-in of \p functions.
+bool callsBuiltins(const Term& term, const std::unordered_map<std::string, Function>& functions) {
+    if (term.type == FUNCTION) {
+        auto function = functions.find(term.name);
+        if (function == functions.end() || function->second.builtin == Builtin::NONE) {
+            return false;
+        }
+    }
+    return std::all_of(term.operands.begin(), term.operands.end(),
+                       [&](const Term& operand) { return callsBuiltins(operand, functions); });
+}
+
+void hashCombine(size_t& hash, size_t value) {
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+/// A node of the e-graph: an operation on classes rather than on nodes.
+struct ENode {
+    TokenType type;
+    OperatorType op = OperatorType::UNKNOWN;
+    NUMBER_TYPE number = 0;
+    uint32_t symbol = 0;                ///< Interned variable or function name.
+    std::vector<ClassId> children;
+
+    bool operator==(const ENode& other) const {
+        return type == other.type && op == other.op && symbol == other.symbol && children == other.children
+            && (type != NUMBER || SameNumber{}(number, other.number));
+    }
+};
+
+size_t hashOf(const ENode& node) {
+    size_t hash = std::hash<int>{}(node.type);
+    hashCombine(hash, static_cast<size_t>(node.op));
+    hashCombine(hash, node.symbol);
+    if (node.type == NUMBER) {
+        hashCombine(hash, NumberHash{}(node.number));
+    }
+    for (ClassId child : node.children) {
+        hashCombine(hash, child);
+    }
+    return hash;
+}
+
+/// A class of equivalent nodes.
+struct EClass {
+    std::vector<uint32_t> nodes;            ///< Indices of its nodes.
+    std::optional<NUMBER_TYPE> constant;    ///< The value of the class, if its nodes fold to a constant.
+};
+
+class EGraph {
+public:
+    static constexpr ClassId UNBOUND = std::numeric_limits<ClassId>::max();
+
+    EGraph(const std::unordered_map<std::string, Function>& functions, bool fastMath)
+        : functions(functions), fastMath(fastMath), memo(0, NodeHash{ enodes }, NodeEqual{ enodes }) {
+        symbol("");     // Symbol 0, the name of operators and numbers
+        auto sqrt = functions.find("sqrt");
+        hasSqrt = sqrt != functions.end() && sqrt->second.builtin == Builtin::SQRT;
+    }
+
+    ClassId find(ClassId id) {
+        while (parent[id] != id) {
+            parent[id] = parent[parent[id]];
+            id = parent[id];
+        }
+        return id;
+    }
+
+    /// The id of \p name, interned on first use.
+    uint32_t symbol(const std::string& name) {
+        auto [it, inserted] = symbolIds.try_emplace(name, static_cast<uint32_t>(names.size()));
+        if (inserted) {
+            names.push_back(name);
+        }
+        return it->second;
+    }
+
+    const std::string& name(uint32_t symbol) const { return names[symbol]; }
+
+    /// The class of \p node, added if no class has it yet.
+    ClassId add(ENode node) {
+        for (ClassId& child : node.children) {
+            child = find(child);
+        }
+        // The node is looked up from the end of the arena, where it stays if it is new
+        const uint32_t index = static_cast<uint32_t>(enodes.size());
+        enodes.push_back(std::move(node));
+        if (auto existing = memo.find(index); existing != memo.end()) {
+            enodes.pop_back();
+            return find(nodeClass[*existing]);
+        }
+        const ClassId id = static_cast<ClassId>(classes.size());
+        const ENode& added = enodes.back();
+        parent.push_back(id);
+        classes.push_back(EClass{ { index }, added.type == NUMBER ? std::optional<NUMBER_TYPE>(added.number) : std::nullopt });
+        nodeClass.push_back(id);
+        memo.insert(index);
+        ++nodeCount;
+        // A class that folds holds its number as well, which extraction prefers
+        if (const std::optional<NUMBER_TYPE> constant = fold(enodes[index])) {
+            return merge(id, add(ENode{ NUMBER, OperatorType::UNKNOWN, *constant }));
+        }
+        return id;
+    }
+
+    /// Merges the classes of \p a and \p b; congruence is restored by rebuild().
+    ClassId merge(ClassId a, ClassId b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) {
+            return a;
+        }
+        if (classes[a].nodes.size() < classes[b].nodes.size()) {
+            std::swap(a, b);
+        }
+        parent[b] = a;
+        EClass& into = classes[a];
+        EClass& from = classes[b];
+        into.nodes.insert(into.nodes.end(), from.nodes.begin(), from.nodes.end());
+        from.nodes = {};
+        if (!into.constant) {
+            into.constant = from.constant;
+        }
+        ++merges;
+        return a;
+    }
+
+    /**
+     * Restores the invariants after merges: nodes refer to canonical classes, and equal
+     * nodes are in the same class (merging the classes of nodes that became equal).
+     */
+    void rebuild() {
+        for (bool congruent = false; !congruent;) {
+            congruent = true;
+            memo.clear();
+            nodeCount = 0;
+            std::vector<std::pair<ClassId, ClassId>> pending;
+            for (ClassId id = 0; id < classes.size(); ++id) {
+                if (find(id) != id) {
+                    continue;
+                }
+                std::vector<uint32_t>& nodes = classes[id].nodes;
+                size_t kept = 0;
+                for (uint32_t index : nodes) {
+                    for (ClassId& child : enodes[index].children) {
+                        child = find(child);
+                    }
+                    auto [existing, inserted] = memo.insert(index);
+                    if (inserted) {
+                        nodeClass[index] = id;
+                        nodes[kept++] = index;
+                    } else if (find(nodeClass[*existing]) != id) {
+                        pending.emplace_back(nodeClass[*existing], id);
+                    }
+                }
+                nodes.resize(kept);
+                nodeCount += kept;
+            }
+            for (const auto& [a, b] : pending) {
+                if (find(a) != find(b)) {
+                    merge(a, b);
+                    congruent = false;
+                }
+            }
+        }
+    }
+
+    /// Every substitution of the pattern variables under which \p pattern matches class \p id.
+    void search(const Term& pattern, ClassId id, std::vector<ClassId>& bound, std::vector<std::vector<ClassId>>& found) {
+        match(pattern, id, bound, [&] { found.push_back(bound); });
+    }
+
+    /// Adds \p term with its variables replaced by \p bound; returns its class.
+    ClassId instantiate(const Term& term, const std::vector<ClassId>& bound) {
+        switch (term.type) {
+            case VARIABLE:
+                return find(bound[term.variable]);
+            case NUMBER:
+                return add(ENode{ NUMBER, OperatorType::UNKNOWN, term.number });
+            default: {
+                ENode node{ term.type, term.op, 0, term.type == FUNCTION ? symbol(term.name) : 0 };
+                for (const Term& operand : term.operands) {
+                    node.children.push_back(instantiate(operand, bound));
+                }
+                return add(std::move(node));
+            }
+        }
+    }
+
+    /// Cost of the operation of \p node alone, under the cost model of saturate().
+    double cost(const ENode& node) {
+        std::optional<NUMBER_TYPE> exponent;
+        if (node.type == OPERATOR && node.op == OperatorType::POW) {
+            exponent = classes[find(node.children[1])].constant;
+        }
+        return operationCost(node.type, node.op, names[node.symbol], exponent);
+    }
+
+    double operationCost(TokenType type, OperatorType op, const std::string& name, std::optional<NUMBER_TYPE> exponent) const {
+        if (type == OPERATOR) {
+            switch (op) {
+                case OperatorType::DIV: return DIVISION_COST;
+                case OperatorType::POW: return powerCost(exponent);
+                default:                return ARITHMETIC_COST;
+            }
+        }
+        if (type == FUNCTION) {
+            auto function = functions.find(name);
+            switch (function == functions.end() ? Builtin::NONE : function->second.builtin) {
+                case Builtin::NEG:
+                case Builtin::ABS:
+                case Builtin::MAX:
+                case Builtin::MIN:
+                case Builtin::FMA:  return ARITHMETIC_COST;
+                case Builtin::SQRT: return SQRT_COST;
+                default:            return CALL_COST;
+            }
+        }
+        return 0;
+    }
+
+    const EClass& operator[](ClassId id) const { return classes[id]; }
+    const ENode& node(uint32_t index) const { return enodes[index]; }
+    size_t classCount() const { return classes.size(); }
+    size_t nodes() const { return nodeCount; }
+    size_t mergeCount() const { return merges; }
+
+private:
+    /// Hashes and compares nodes by their index in the arena, so rebuilding the memo copies nothing.
+    struct NodeHash {
+        const std::vector<ENode>& enodes;
+        size_t operator()(uint32_t index) const { return hashOf(enodes[index]); }
+    };
+
+    struct NodeEqual {
+        const std::vector<ENode>& enodes;
+        bool operator()(uint32_t a, uint32_t b) const { return enodes[a] == enodes[b]; }
+    };
+
+    /// Calls \p found for every extension of \p bound under which \p term matches class \p id.
+    void match(const Term& term, ClassId id, std::vector<ClassId>& bound, const std::function<void()>& found) {
+        id = find(id);
+        if (term.type == VARIABLE) {
+            ClassId& variable = bound[term.variable];
+            if (variable == UNBOUND) {
+                variable = id;
+                found();
+                variable = UNBOUND;
+            } else if (find(variable) == id) {
+                found();
+            }
+            return;
+        }
+        if (term.type == NUMBER) {
+            if (classes[id].constant && *classes[id].constant == term.number) {
+                found();
+            }
+            return;
+        }
+        const uint32_t name = term.type == FUNCTION ? symbol(term.name) : 0;
+        // Searching adds no node, so the class stays put while its operands are matched
+        for (uint32_t index : classes[id].nodes) {
+            const ENode& node = enodes[index];
+            if (node.type == term.type && node.op == term.op && node.symbol == name && node.children.size() == term.operands.size()) {
+                matchOperands(term, node, 0, bound, found);
+            }
+        }
+    }
+
+    void matchOperands(const Term& term, const ENode& node, size_t index, std::vector<ClassId>& bound, const std::function<void()>& found) {
+        if (index == term.operands.size()) {
+            found();
+            return;
+        }
+        match(term.operands[index], node.children[index], bound,
+              [&] { matchOperands(term, node, index + 1, bound, found); });
+    }
+
+    /// The value of \p node if its operands are constant and it evaluates to a finite number.
+    std::optional<NUMBER_TYPE> fold(const ENode& node) {
+        if (node.type != OPERATOR && node.type != FUNCTION) {
+            return std::nullopt;
+        }
+        std::vector<NUMBER_TYPE> args;
+        for (ClassId child : node.children) {
+            const std::optional<NUMBER_TYPE>& constant = classes[find(child)].constant;
+            if (!constant) {
+                return std::nullopt;
+            }
+            args.push_back(*constant);
+        }
+        NUMBER_TYPE value;
+        if (node.type == OPERATOR) {
+            switch (node.op) {
+                case OperatorType::ADD: value = args[0] + args[1]; break;
+                case OperatorType::SUB: value = args[0] - args[1]; break;
+                case OperatorType::MUL: value = args[0] * args[1]; break;
+                case OperatorType::DIV: value = args[0] / args[1]; break;
+                case OperatorType::POW: value = std::pow(args[0], args[1]); break;
+                default: return std::nullopt;
+            }
+        } else {
+            auto function = functions.find(names[node.symbol]);
+            if (function == functions.end() || !function->second.callback) {
+                return std::nullopt;
+            }
+            try {
+                value = function->second.callback(args);
+            } catch (const SolverException&) {
+                return std::nullopt;
+            }
+        }
+        return std::isfinite(value) ? std::optional<NUMBER_TYPE>(value) : std::nullopt;
+    }
+
+    /// Cost of a power, as strength reduction will lower it.
+    double powerCost(std::optional<NUMBER_TYPE> exponent) const {
+        if (!exponent) {
+            return POW_COST;
+        }
+        const NUMBER_TYPE n = *exponent;
+        if (n == 0 || n == 1 || n == 2) {
+            return ARITHMETIC_COST;
+        }
+        const NUMBER_TYPE magnitude = std::abs(n);
+        const double reciprocal = n < 0 ? DIVISION_COST : 0;
+        if (fastMath && magnitude == std::trunc(magnitude) && magnitude <= MAX_CHAIN_EXPONENT) {
+            // Repeated squaring: a squaring per bit after the first, a multiplication per other set bit
+            const auto bits = static_cast<uint32_t>(magnitude);
+            return reciprocal + ARITHMETIC_COST * (std::bit_width(bits) + std::popcount(bits) - 2);
+        }
+        if (fastMath && magnitude == 0.5 && hasSqrt) {
+            return reciprocal + SQRT_COST;
+        }
+        return POW_COST;
+    }
+
+    const std::unordered_map<std::string, Function>& functions;
+    bool fastMath;
+    bool hasSqrt;
+    std::vector<ENode> enodes;                          ///< Every node added, by index.
+    std::vector<ClassId> nodeClass;                     ///< Class of each node (canonical after rebuild()).
+    std::vector<EClass> classes;
+    std::vector<ClassId> parent;                        ///< Union-find forest over the classes.
+    std::unordered_set<uint32_t, NodeHash, NodeEqual> memo;  ///< One index per distinct node.
+    std::vector<std::string> names;                     ///< Interned names, by symbol.
+    std::unordered_map<std::string, uint32_t> symbolIds;
+    size_t nodeCount = 0;
+    size_t merges = 0;
+};
+
+/// The cheapest expression of a class: its cost, its size in nodes, and the node it starts with.
+struct Choice {
+    double cost = std::numeric_limits<double>::infinity();
+    size_t size = 0;
+    uint32_t node = 0;              ///< Index of the node in the e-graph.
+
+    bool operator<(const Choice& other) const {
+        return cost < other.cost || (cost == other.cost && size < other.size);
+    }
+};
+
+/// Picks the cheapest node of every class, relaxing until no choice improves.
+std::vector<Choice> extract(EGraph& egraph) {
+    std::vector<Choice> best(egraph.classCount());
+    for (bool improved = true; improved;) {
+        improved = false;
+        for (ClassId id = 0; id < egraph.classCount(); ++id) {
+            if (egraph.find(id) != id) {
+                continue;
+            }
+            for (uint32_t index : egraph[id].nodes) {
+                const ENode& node = egraph.node(index);
+                Choice choice{ egraph.cost(node), 1, index };
+                for (ClassId child : node.children) {
+                    const Choice& operand = best[egraph.find(child)];
+                    choice.cost += operand.cost;
+                    choice.size += operand.size;
+                }
+                if (choice < best[id]) {
+                    best[id] = choice;
+                    improved = true;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+/// Adds the chosen expression of class \p root to \p graph.
+NodeId build(ExpressionGraph& graph, EGraph& egraph, const std::vector<Choice>& best, ClassId root) {
+    std::unordered_map<ClassId, NodeId> built;
+    std::vector<std::pair<ClassId, bool>> stack{ { egraph.find(root), false } };
+    while (!stack.empty()) {
+        const auto [id, expanded] = stack.back();
+        stack.pop_back();
+        if (built.count(id)) {
+            continue;
+        }
+        const ENode& node = egraph.node(best[id].node);
+        if (!expanded) {
+            // Operands first; every chosen operand is strictly cheaper or smaller, so this ends
+            stack.emplace_back(id, true);
+            for (ClassId child : node.children) {
+                stack.emplace_back(egraph.find(child), false);
+            }
+            continue;
+        }
+        NodeId result;
+        switch (node.type) {
+            case NUMBER:   result = graph.number(node.number); break;
+            case VARIABLE: result = graph.variable(egraph.name(node.symbol)); break;
+            case OPERATOR: result = graph.binary(node.op, built.at(egraph.find(node.children[0])), built.at(egraph.find(node.children[1]))); break;
+            default: {
+                std::vector<NodeId> arguments;
+                for (ClassId child : node.children) {
+                    arguments.push_back(built.at(egraph.find(child)));
+                }
+                result = graph.call(egraph.name(node.symbol), std::move(arguments));
+            }
+        }
+        built.emplace(id, result);
+    }
+    return built.at(egraph.find(root));
+}
+
+} // namespace
+
+NodeId saturate(ExpressionGraph& graph, NodeId root, const std::unordered_map<std::string, Function>& functions, bool fastMath,
+                const SaturationLimits& limits, SaturationReport* report) {
+    PROFILE_FUNCTION()
+    const auto start = std::chrono::steady_clock::now();
+    const auto outOfTime = [&] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > limits.timeLimit;
+    };
+
+    std::vector<const RewriteRules::Rule*> rules;
+    for (const RewriteRules::Rule& rule : identities(fastMath)) {
+        if (callsBuiltins(rule.pattern, functions) && callsBuiltins(rule.replacement, functions)) {
+            rules.push_back(&rule);
+        }
+    }
+
+    // Load the expression, costing it on the way
+    EGraph egraph(functions, fastMath);
+    const std::vector<NodeId> order = graph.reachable(root);
+    std::unordered_map<NodeId, ClassId> loaded;
+    std::unordered_map<NodeId, double> treeCost;
+    for (NodeId id : order) {
+        const GraphNode& node = graph[id];
+        ENode enode{ node.type, node.op, node.type == NUMBER ? node.number : 0, node.type == OPERATOR ? 0 : egraph.symbol(node.name) };
+        double cost = 0;
+        for (NodeId child : node.children) {
+            enode.children.push_back(loaded.at(child));
+            cost += treeCost.at(child);
+        }
+        std::optional<NUMBER_TYPE> exponent;
+        if (node.type == OPERATOR && node.op == OperatorType::POW && graph[node.children[1]].type == NUMBER) {
+            exponent = graph[node.children[1]].number;
+        }
+        treeCost.emplace(id, cost + egraph.operationCost(node.type, node.op, node.name, exponent));
+        loaded.emplace(id, egraph.add(std::move(enode)));
+    }
+    egraph.rebuild();
+
+    SaturationReport done;
+    done.costBefore = treeCost.at(root);
+    std::vector<ClassId> bound;
+    std::vector<std::vector<ClassId>> found;
+    while (done.iterations < limits.iterationLimit && egraph.nodes() < limits.nodeLimit && !outOfTime()) {
+        ++done.iterations;
+        const size_t nodesBefore = egraph.nodes();
+        const size_t mergesBefore = egraph.mergeCount();
+
+        // Match every rule against the e-graph as it was at the start of the round, then apply
+        std::vector<std::pair<const RewriteRules::Rule*, std::vector<ClassId>>> matches;
+        const size_t classCount = egraph.classCount();
+        for (const RewriteRules::Rule* rule : rules) {
+            for (ClassId id = 0; id < classCount && matches.size() < limits.nodeLimit && !(id % 64 == 0 && outOfTime()); ++id) {
+                if (egraph.find(id) != id) {
+                    continue;
+                }
+                bound.assign(rule->variables, EGraph::UNBOUND);
+                found.clear();
+                egraph.search(rule->pattern, id, bound, found);
+                for (std::vector<ClassId>& substitution : found) {
+                    substitution.push_back(id);
+                    matches.emplace_back(rule, std::move(substitution));
+                }
+            }
+            if (outOfTime()) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < matches.size(); ++i) {
+            const auto& [rule, substitution] = matches[i];
+            if (egraph.nodes() >= limits.nodeLimit || (i % 64 == 0 && outOfTime())) {
+                break;
+            }
+            egraph.merge(substitution.back(), egraph.instantiate(rule->replacement, substitution));
+        }
+        egraph.rebuild();
+
+        if (egraph.nodes() == nodesBefore && egraph.mergeCount() == mergesBefore) {
+            done.saturated = true;
+            break;
+        }
+    }
+
+    const std::vector<Choice> best = extract(egraph);
+    const ClassId rootClass = egraph.find(loaded.at(root));
+    done.nodes = egraph.nodes();
+    for (ClassId id = 0; id < egraph.classCount(); ++id) {
+        done.classes += egraph.find(id) == id;
+    }
+    NodeId result = root;
+    done.costAfter = done.costBefore;
+    if (best[rootClass].cost < done.costBefore) {
+        result = build(graph, egraph, best, rootClass);
+        done.costAfter = best[rootClass].cost;
+    }
+    if (report) {
+        *report = done;
+    }
+    return result;
+}
@@ -0,0 +1,125 @@
+#include "simplification/multiply_add.h"
+
+namespace {
+
+bool isNegation(const GraphNode& node) {
+    return node.type == FUNCTION && node.name == "neg" && node.children.size() == 1;
+}
+
+class MultiplyAddContractor {
+public:
+    explicit MultiplyAddContractor(ExpressionGraph& graph) : graph(graph) {}
+
+    NodeId run(NodeId root) {
+        const std::vector<NodeId> order = graph.reachable(root);
+
+        // A product used elsewhere is computed anyway, so only products used once are fused
+        uses.assign(graph.size(), 0);
+        ++uses[root];
+        for (NodeId id : order) {
+            for (NodeId child : graph[id].children) {
+                ++uses[child];
+            }
+        }
+
+        result.assign(graph.size(), 0);
+        std::vector<NodeId> operands;
+        for (NodeId id : order) {
+            const std::vector<NodeId>& children = graph[id].children;
+            operands.resize(children.size());
+            bool changed = false;
+            for (size_t i = 0; i < children.size(); ++i) {
+                operands[i] = result[children[i]];
+                changed |= operands[i] != children[i];
+            }
+            result[id] = changed ? graph.withChildren(id, operands) : id;
+            result[id] = contract(id).value_or(result[id]);
+        }
+        return result[root];
+    }
+
+    size_t contracted = 0;  ///< Number of fma nodes built.
+
+private:
+    /// The addition or subtraction \p id with a product operand folded into an fma call, or std::nullopt if it has none.
+    std::optional<NodeId> contract(NodeId id) {
+        // Only the operation itself is replaced, so the sum around it is not regrouped
+        const GraphNode& node = graph[id];
+        if (node.type != OPERATOR || (node.op != OperatorType::ADD && node.op != OperatorType::SUB)) {
+            return std::nullopt;
+        }
+        const bool subtract = node.op == OperatorType::SUB;
+        const NodeId left = node.children[0];
+        const NodeId right = node.children[1];
+        if (isFusable(left)) {
+            // a*b + c is fma(a, b, c), a*b - c is fma(a, b, -c)
+            const NodeId a = graph[result[left]].children[0];
+            const NodeId b = graph[result[left]].children[1];
+            return fused(a, b, subtract ? negate(result[right]) : result[right]);
+        }
+        if (isFusable(right)) {
+            // c + a*b is fma(a, b, c), c - a*b is fma(-a, b, c); negate the factor that is cheaper to negate
+            NodeId a = graph[result[right]].children[0];
+            NodeId b = graph[result[right]].children[1];
+            if (subtract) {
+                if (!isFree(a) && isFree(b)) {
+                    b = negate(b);
+                } else {
+                    a = negate(a);
+                }
+            }
+            return fused(a, b, result[left]);
+        }
+        return std::nullopt;
+    }
+
+    /// Whether \p child is a product used only by the sum being contracted.
+    bool isFusable(NodeId child) const {
+        const GraphNode& operand = graph[result[child]];
+        return uses[child] == 1 && operand.type == OPERATOR && operand.op == OperatorType::MUL;
+    }
+
+    NodeId fused(NodeId a, NodeId b, NodeId addend) {
+        ++contracted;
+        return graph.call("fma", { a, b, addend });
+    }
+
+    /// Whether negating \p id takes no instruction (a number, or a negation to drop).
+    bool isFree(NodeId id) const {
+        return graph[id].type == NUMBER || isNegation(graph[id]);
+    }
+
+    NodeId negate(NodeId id) {
+        const GraphNode& node = graph[id];
+        if (node.type == NUMBER) {
+            return graph.number(-node.number);
+        }
+        if (isNegation(node)) {
+            return node.children[0];
+        }
+        return graph.call("neg", { id });
+    }
+
+    ExpressionGraph& graph;
+    std::vector<uint32_t> uses;     ///< Number of users of each visited node.
+    std::vector<NodeId> result;     ///< Rewritten node of each visited node.
+};
+
+} // namespace
+
+NodeId contractMultiplyAdds(ExpressionGraph& graph, NodeId root, const std::unordered_map<std::string, Function>& functions, size_t* contracted) {
+    PROFILE_FUNCTION()
+    auto fma = functions.find("fma");
+    if (fma == functions.end() || fma->second.builtin != Builtin::FMA) {
+        if (contracted) {
+            *contracted = 0;
+        }
+        return root;
+    }
+    MultiplyAddContractor contractor(graph);
+    const NodeId contractedRoot = contractor.run(root);
+    if (contracted) {
+        *contracted = contractor.contracted;
+    }
+    return contractedRoot;
+}
@@ -0,0 +1,315 @@
+#include "simplification/polynomial_form.h"
+#include "simplification/strength_reduction.h"
+
+namespace {
+
+bool isSum(const GraphNode& node) {
+    if (node.type == OPERATOR) {
+        return node.op == OperatorType::ADD || node.op == OperatorType::SUB;
+    }
+    return node.type == FUNCTION && node.name == "neg" && node.children.size() == 1;
+}
+
+/// A term of a sum: constant * variable powers * factors / divisors.
+struct Monomial {
+    NUMBER_TYPE constant = 1;
+    std::vector<std::pair<NodeId, uint32_t>> powers;    ///< (variable, exponent), one per variable.
+    std::vector<NodeId> factors;                        ///< Other factors.
+    std::vector<NodeId> divisors;
+};
+
+class PolynomialRewriter {
+public:
+    explicit PolynomialRewriter(ExpressionGraph& graph) : graph(graph) {}
+
+    NodeId run(NodeId root) {
+        const std::vector<NodeId> order = graph.reachable(root);
+        const size_t size = graph.size();
+
+        // As in canonical form, only subexpressions used once are taken apart
+        uses.assign(size, 0);
+        ++uses[root];
+        for (NodeId id : order) {
+            for (NodeId child : graph[id].children) {
+                ++uses[child];
+            }
+        }
+        absorbed.assign(size, false);
+        for (NodeId id : order) {
+            if (!isSum(graph[id])) {
+                continue;
+            }
+            for (NodeId child : graph[id].children) {
+                if (uses[child] == 1 && isSum(graph[child])) {
+                    absorbed[child] = true;
+                }
+            }
+        }
+
+        result.assign(size, 0);
+        std::vector<NodeId> operands;
+        for (NodeId id : order) {
+            const std::vector<NodeId>& children = graph[id].children;
+            operands.resize(children.size());
+            bool changed = false;
+            for (size_t i = 0; i < children.size(); ++i) {
+                operands[i] = result[children[i]];
+                changed |= operands[i] != children[i];
+            }
+            result[id] = changed ? graph.withChildren(id, operands) : id;
+            if (isSum(graph[id]) && !absorbed[id]) {
+                std::vector<Monomial> terms = collect(id);
+                if (mainVariable(terms)) {
+                    result[id] = polynomial(terms);
+                }
+            }
+        }
+        return result[root];
+    }
+
+private:
+    /// The terms of the sum rooted at \p id, with their sign in the constant.
+    std::vector<Monomial> collect(NodeId id) {
+        std::vector<Monomial> terms;
+        std::vector<std::pair<NodeId, bool>> stack{ { id, false } };
+        while (!stack.empty()) {
+            const auto [node, negative] = stack.back();
+            stack.pop_back();
+            if (node == id || absorbed[node]) {
+                const GraphNode& inner = graph[node];
+                if (inner.type == FUNCTION) {
+                    stack.emplace_back(inner.children[0], !negative);
+                } else {
+                    stack.emplace_back(inner.children[1], inner.op == OperatorType::SUB ? !negative : negative);
+                    stack.emplace_back(inner.children[0], negative);
+                }
+                continue;
+            }
+            Monomial term;
+            term.constant = negative ? -1 : 1;
+            factor(result[node], term);
+            terms.push_back(std::move(term));
+        }
+        return terms;
+    }
+
+    /// Multiplies \p term by \p id, taking apart the products used only there.
+    void factor(NodeId id, Monomial& term) {
+        const GraphNode& node = graph[id];
+        if (node.type == NUMBER) {
+            term.constant *= node.number;
+            return;
+        }
+        if (node.type == VARIABLE) {
+            addPower(term, id, 1);
+            return;
+        }
+        if (node.type == OPERATOR && node.op == OperatorType::POW) {
+            const GraphNode& base = graph[node.children[0]];
+            const GraphNode& exponent = graph[node.children[1]];
+            if (base.type == VARIABLE && exponent.type == NUMBER && exponent.number >= 1
+                && exponent.number <= MAX_CHAIN_EXPONENT && exponent.number == std::trunc(exponent.number)) {
+                addPower(term, node.children[0], static_cast<uint32_t>(exponent.number));
+                return;
+            }
+        }
+        const bool single = id >= uses.size() || uses[id] <= 1;
+        if (single && node.type == OPERATOR && node.op == OperatorType::MUL) {
+            const NodeId left = node.children[0];
+            const NodeId right = node.children[1];
+            factor(left, term);
+            factor(right, term);
+            return;
+        }
+        if (single && node.type == OPERATOR && node.op == OperatorType::DIV) {
+            const NodeId divisor = node.children[1];
+            factor(node.children[0], term);
+            term.divisors.push_back(divisor);
+            return;
+        }
+        if (single && isSum(node) && node.type == FUNCTION) {
+            term.constant = -term.constant;
+            factor(node.children[0], term);
+            return;
+        }
+        term.factors.push_back(id);
+    }
+
+    static void addPower(Monomial& term, NodeId variable, uint32_t exponent) {
+        for (auto& [existing, power] : term.powers) {
+            if (existing == variable) {
+                power += exponent;
+                return;
+            }
+        }
+        term.powers.emplace_back(variable, exponent);
+    }
+
+    /// The variable to factor out: the one with the highest power, then in most terms, then by name.
+    std::optional<NodeId> mainVariable(const std::vector<Monomial>& terms) const {
+        // (variable, highest power, number of terms)
+        std::vector<std::tuple<NodeId, uint32_t, uint32_t>> seen;
+        for (const Monomial& term : terms) {
+            for (const auto& [variable, power] : term.powers) {
+                auto it = std::find_if(seen.begin(), seen.end(), [&](const auto& entry) { return std::get<0>(entry) == variable; });
+                if (it == seen.end()) {
+                    seen.emplace_back(variable, power, 1);
+                } else {
+                    std::get<1>(*it) = std::max(std::get<1>(*it), power);
+                    ++std::get<2>(*it);
+                }
+            }
+        }
+        std::optional<NodeId> best;
+        uint32_t bestDegree = 0;
+        uint32_t bestCount = 0;
+        for (const auto& [variable, degree, count] : seen) {
+            if (degree < 2 && count < 2) {
+                continue;
+            }
+            const bool better = !best || degree > bestDegree || (degree == bestDegree && count > bestCount)
+                || (degree == bestDegree && count == bestCount && graph[variable].name < graph[*best].name);
+            if (better) {
+                best = variable;
+                bestDegree = degree;
+                bestCount = count;
+            }
+        }
+        return best;
+    }
+
+    /// Builds the sum of \p terms, factoring out variables while one qualifies.
+    NodeId polynomial(std::vector<Monomial>& terms) {
+        const std::optional<NodeId> variable = mainVariable(terms);
+        if (!variable) {
+            return plainSum(terms);
+        }
+
+        // Group the terms by their power of the variable, which they lose
+        std::vector<std::vector<Monomial>> groups;
+        for (Monomial& term : terms) {
+            uint32_t power = 0;
+            auto it = std::find_if(term.powers.begin(), term.powers.end(), [&](const auto& entry) { return entry.first == *variable; });
+            if (it != term.powers.end()) {
+                power = it->second;
+                term.powers.erase(it);
+            }
+            if (groups.size() <= power) {
+                groups.resize(power + 1);
+            }
+            groups[power].push_back(std::move(term));
+        }
+        std::vector<std::optional<NodeId>> coefficients(groups.size());
+        for (size_t power = 0; power < groups.size(); ++power) {
+            if (!groups[power].empty()) {
+                coefficients[power] = polynomial(groups[power]);
+            }
+        }
+
+        const size_t degree = coefficients.size() - 1;
+        if (degree >= ESTRIN_MIN_DEGREE) {
+            return *estrin(coefficients, 0, coefficients.size(), *variable);
+        }
+        NodeId value = *coefficients[degree];
+        size_t power = degree;
+        for (size_t next = degree; next-- > 0;) {
+            if (coefficients[next]) {
+                value = graph.binary(OperatorType::ADD, multiply(value, powerOf(*variable, power - next)), *coefficients[next]);
+                power = next;
+            }
+        }
+        return power > 0 ? multiply(value, powerOf(*variable, power)) : value;
+    }
+
+    /// The polynomial with coefficients[first, first + count) in Estrin form, or std::nullopt if they are all missing.
+    std::optional<NodeId> estrin(const std::vector<std::optional<NodeId>>& coefficients, size_t first, size_t count, NodeId variable) {
+        if (count == 1) {
+            return coefficients[first];
+        }
+        size_t half = 1;
+        while (half * 2 < count) {
+            half *= 2;
+        }
+        const std::optional<NodeId> low = estrin(coefficients, first, half, variable);
+        const std::optional<NodeId> high = estrin(coefficients, first + half, count - half, variable);
+        if (!high) {
+            return low;
+        }
+        const NodeId scaled = multiply(*high, powerOf(variable, half));
+        return low ? graph.binary(OperatorType::ADD, *low, scaled) : scaled;
+    }
+
+    /// Builds the sum of \p terms as is: positive terms added, then the negative ones subtracted.
+    NodeId plainSum(const std::vector<Monomial>& terms) {
+        NUMBER_TYPE constant = 0;
+        std::vector<NodeId> direct;
+        std::vector<NodeId> inverse;
+        for (const Monomial& term : terms) {
+            if (term.powers.empty() && term.factors.empty() && term.divisors.empty()) {
+                constant += term.constant;
+                continue;
+            }
+            std::vector<NodeId> factors;
+            for (const auto& [variable, power] : term.powers) {
+                factors.push_back(powerOf(variable, power));
+            }
+            factors.insert(factors.end(), term.factors.begin(), term.factors.end());
+            if (std::abs(term.constant) != 1 || factors.empty()) {
+                factors.push_back(graph.number(std::abs(term.constant)));
+            }
+            NodeId product = balanced(OperatorType::MUL, factors, 0, factors.size());
+            if (!term.divisors.empty()) {
+                product = graph.binary(OperatorType::DIV, product, balanced(OperatorType::MUL, term.divisors, 0, term.divisors.size()));
+            }
+            (term.constant < 0 ? inverse : direct).push_back(product);
+        }
+
+        if (direct.empty() && inverse.empty()) {
+            return graph.number(constant);
+        }
+        if (constant != 0) {
+            (constant < 0 ? inverse : direct).push_back(graph.number(std::abs(constant)));
+        }
+        if (direct.empty()) {
+            return graph.call("neg", { balanced(OperatorType::ADD, inverse, 0, inverse.size()) });
+        }
+        const NodeId added = balanced(OperatorType::ADD, direct, 0, direct.size());
+        return inverse.empty() ? added : graph.binary(OperatorType::SUB, added, balanced(OperatorType::ADD, inverse, 0, inverse.size()));
+    }
+
+    /// Combines terms[first, last) with \p op as a balanced tree.
+    NodeId balanced(OperatorType op, const std::vector<NodeId>& terms, size_t first, size_t last) {
+        if (last - first == 1) {
+            return terms[first];
+        }
+        const size_t middle = first + (last - first) / 2;
+        const NodeId left = balanced(op, terms, first, middle);
+        const NodeId right = balanced(op, terms, middle, last);
+        return graph.binary(op, left, right);
+    }
+
+    /// \p value * \p factor, or \p factor alone if \p value is 1.
+    NodeId multiply(NodeId value, NodeId factor) {
+        const GraphNode& node = graph[value];
+        if (node.type == NUMBER && node.number == 1) {
+            return factor;
+        }
+        return graph.binary(OperatorType::MUL, value, factor);
+    }
+
+    NodeId powerOf(NodeId variable, size_t power) {
+        return power == 1 ? variable : graph.binary(OperatorType::POW, variable, graph.number(static_cast<NUMBER_TYPE>(power)));
+    }
+
+    ExpressionGraph& graph;
+    std::vector<uint32_t> uses;     ///< Number of users of each visited node.
+    std::vector<bool> absorbed;     ///< Whether a sum node is flattened into the sum using it.
+    std::vector<NodeId> result;     ///< Rewritten node of each visited node.
+};
+
+} // namespace
+
+NodeId rewritePolynomials(ExpressionGraph& graph, NodeId root) {
+    PROFILE_FUNCTION()
+    return PolynomialRewriter(graph).run(root);
+}
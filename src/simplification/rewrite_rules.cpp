@@ -0,0 +1,344 @@
+#include "simplification/rewrite_rules.h"
+#include <charconv>
+
+#pragma region Parsing
+
+// Recursive descent over one side of a rule, with the parser's precedences: unary minus, then
+// "^" (right-associative), "*" and "/", and "+" and "-". As in the tokenizer, a minus directly
+// before a literal makes a negative number unless the literal is raised to a power.
+class RewriteRules::Parser {
+public:
+    Parser(const std::string& rule, std::string_view text, std::vector<std::string>& variables, bool bindNew)
+        : rule(rule), text(text), variables(variables), bindNew(bindNew) {}
+
+    Term parse() {
+        Term term = sum();
+        if (peek() != '\0') {
+            fail(std::string("unexpected '") + peek() + "'");
+        }
+        return term;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& what) const {
+        throw SolverException("Invalid rewrite rule '" + rule + "': " + what + ".");
+    }
+
+    // The next non-blank character, or '\0' at the end
+    char peek() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+        return pos < text.size() ? text[pos] : '\0';
+    }
+
+    bool accept(char c) {
+        if (peek() != c) {
+            return false;
+        }
+        ++pos;
+        return true;
+    }
+
+    static Term binary(OperatorType op, Term left, Term right) {
+        Term term{ OPERATOR, op };
+        term.operands.push_back(std::move(left));
+        term.operands.push_back(std::move(right));
+        return term;
+    }
+
+    static Term negation(Term operand) {
+        Term term{ FUNCTION };
+        term.name = "neg";
+        term.operands.push_back(std::move(operand));
+        return term;
+    }
+
+    Term sum() {
+        Term term = product();
+        for (;;) {
+            if (accept('+')) {
+                term = binary(OperatorType::ADD, std::move(term), product());
+            } else if (accept('-')) {
+                term = binary(OperatorType::SUB, std::move(term), product());
+            } else {
+                return term;
+            }
+        }
+    }
+
+    Term product() {
+        Term term = factor();
+        for (;;) {
+            if (accept('*')) {
+                term = binary(OperatorType::MUL, std::move(term), factor());
+            } else if (accept('/')) {
+                term = binary(OperatorType::DIV, std::move(term), factor());
+            } else {
+                return term;
+            }
+        }
+    }
+
+    Term factor() {
+        if (!accept('-')) {
+            return power(primary());
+        }
+        if (std::isdigit(static_cast<unsigned char>(peek()))) {
+            Term literal = number();
+            if (peek() != '^') {
+                literal.number = -literal.number;
+                return literal;
+            }
+            return negation(power(std::move(literal)));
+        }
+        return negation(factor());
+    }
+
+    Term power(Term base) {
+        return accept('^') ? binary(OperatorType::POW, std::move(base), factor()) : base;
+    }
+
+    Term number() {
+        const char* first = text.data() + pos;
+        Term term{ NUMBER };
+        auto [last, error] = std::from_chars(first, text.data() + text.size(), term.number);
+        if (error != std::errc()) {
+            fail("invalid number");
+        }
+        pos += static_cast<size_t>(last - first);
+        return term;
+    }
+
+    std::string_view name() {
+        const size_t first = pos;
+        while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_')) {
+            ++pos;
+        }
+        if (pos == first || std::isdigit(static_cast<unsigned char>(text[first]))) {
+            fail("expected a name");
+        }
+        return text.substr(first, pos - first);
+    }
+
+    Term primary() {
+        const char c = peek();
+        if (accept('(')) {
+            Term term = sum();
+            if (!accept(')')) {
+                fail("missing ')'");
+            }
+            return term;
+        }
+        if (accept('?')) {
+            const std::string_view variable = name();
+            auto it = std::find(variables.begin(), variables.end(), variable);
+            if (it == variables.end()) {
+                if (!bindNew) {
+                    fail("'?" + std::string(variable) + "' is not bound by the pattern");
+                }
+                it = variables.emplace(variables.end(), variable);
+            }
+            Term term{ VARIABLE };
+            term.variable = static_cast<uint32_t>(it - variables.begin());
+            return term;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            return number();
+        }
+        if (c == '\0') {
+            fail("unexpected end");
+        }
+        Term term{ FUNCTION };
+        term.name = name();
+        if (!accept('(')) {
+            fail("'" + term.name + "' is not a call; pattern variables are written '?" + term.name + "'");
+        }
+        if (!accept(')')) {
+            do {
+                term.operands.push_back(sum());
+            } while (accept(','));
+            if (!accept(')')) {
+                fail("missing ')'");
+            }
+        }
+        return term;
+    }
+
+    const std::string& rule;
+    std::string_view text;
+    std::vector<std::string>& variables;  ///< Pattern variables by index, in order of first use.
+    bool bindNew;                         ///< Whether new variables may appear (in the pattern, not the replacement).
+    size_t pos = 0;
+};
+
+#pragma endregion
+
+#pragma region Compilation
+
+bool RewriteRules::Key::operator<(const Key& other) const {
+    return std::tie(type, op, number, name, arity) < std::tie(other.type, other.op, other.number, other.name, other.arity);
+}
+
+RewriteRules::RewriteRules() : states(1, State{ {}, {}, NO_RULE }) {}
+
+RewriteRules::RewriteRules(const std::vector<std::string>& rules) : RewriteRules() {
+    for (const std::string& rule : rules) {
+        add(rule);
+    }
+}
+
+RewriteRules::Rule RewriteRules::parse(const std::string& rule) {
+    const size_t arrow = rule.find("=>");
+    if (arrow == std::string::npos) {
+        throw SolverException("Invalid rewrite rule '" + rule + "': expected 'pattern => replacement'.");
+    }
+    std::vector<std::string> variables;
+    const std::string_view text(rule);
+    Term pattern = Parser(rule, text.substr(0, arrow), variables, true).parse();
+    Term replacement = Parser(rule, text.substr(arrow + 2), variables, false).parse();
+    if (pattern.type == VARIABLE) {
+        throw SolverException("Invalid rewrite rule '" + rule + "': the pattern matches everything.");
+    }
+    return Rule{ std::move(pattern), std::move(replacement), static_cast<uint32_t>(variables.size()) };
+}
+
+void RewriteRules::add(const std::string& rule) {
+    Rule parsed = parse(rule);
+    State& accepting = states[insert(0, parsed.pattern)];
+    const uint32_t index = static_cast<uint32_t>(replacements.size());
+    accepting.rule = std::min(accepting.rule, index);
+    replacements.push_back(std::move(parsed.replacement));
+    variableCount = std::max(variableCount, parsed.variables);
+}
+
+uint32_t RewriteRules::insert(uint32_t state, const Term& pattern) {
+    if (pattern.type == VARIABLE) {
+        for (const auto& [variable, target] : states[state].binds) {
+            if (variable == pattern.variable) {
+                return target;
+            }
+        }
+        const uint32_t target = static_cast<uint32_t>(states.size());
+        states.push_back(State{ {}, {}, NO_RULE });
+        states[state].binds.emplace_back(pattern.variable, target);
+        return target;
+    }
+
+    const std::string_view name = pattern.type == FUNCTION ? *functionNames.insert(pattern.name).first : std::string_view();
+    const Key key{ pattern.type, pattern.op, pattern.number, name, pattern.operands.size() };
+    auto [transition, inserted] = states[state].next.try_emplace(key, static_cast<uint32_t>(states.size()));
+    const uint32_t target = transition->second;
+    if (inserted) {
+        states.push_back(State{ {}, {}, NO_RULE });
+    }
+    // The operands follow their node, left to right
+    uint32_t next = target;
+    for (const Term& operand : pattern.operands) {
+        next = insert(next, operand);
+    }
+    return next;
+}
+
+#pragma endregion
+
+#pragma region Matching
+
+std::optional<RewriteRules::Key> RewriteRules::keyOf(const GraphNode& node) {
+    switch (node.type) {
+        case NUMBER:
+            if (std::isnan(node.number)) {
+                return std::nullopt;
+            }
+            return Key{ NUMBER, OperatorType::UNKNOWN, node.number, {}, 0 };
+        case OPERATOR:
+            return Key{ OPERATOR, node.op, 0, {}, node.children.size() };
+        case FUNCTION:
+            return Key{ FUNCTION, OperatorType::UNKNOWN, 0, node.name, node.children.size() };
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<NodeId> RewriteRules::rewrite(ExpressionGraph& graph, NodeId node) const {
+    // A node whose root no pattern starts with is rejected by the first lookup
+    std::optional<Key> key = keyOf(graph[node]);
+    if (!key) {
+        return std::nullopt;
+    }
+    auto root = states[0].next.find(*key);
+    if (root == states[0].next.end()) {
+        return std::nullopt;
+    }
+
+    std::vector<NodeId> pending(graph[node].children.rbegin(), graph[node].children.rend());
+    std::vector<NodeId> bound(variableCount, UNBOUND);
+    std::vector<NodeId> bestBound;
+    uint32_t best = NO_RULE;
+    match(graph, root->second, pending, bound, best, bestBound);
+    if (best == NO_RULE) {
+        return std::nullopt;
+    }
+    return build(graph, replacements[best], bestBound);
+}
+
+void RewriteRules::match(const ExpressionGraph& graph, uint32_t state, std::vector<NodeId>& pending, std::vector<NodeId>& bound,
+                         uint32_t& best, std::vector<NodeId>& bestBound) const {
+    const State& current = states[state];
+    if (pending.empty()) {
+        if (current.rule < best) {
+            best = current.rule;
+            bestBound = bound;
+        }
+        return;
+    }
+
+    const NodeId id = pending.back();
+    pending.pop_back();
+
+    // The node itself matches a pattern node with the same key; its operands are matched next
+    if (std::optional<Key> key = keyOf(graph[id])) {
+        auto transition = current.next.find(*key);
+        if (transition != current.next.end()) {
+            const std::vector<NodeId>& children = graph[id].children;
+            pending.insert(pending.end(), children.rbegin(), children.rend());
+            match(graph, transition->second, pending, bound, best, bestBound);
+            pending.resize(pending.size() - children.size());
+        }
+    }
+
+    // Or a pattern variable takes the whole node, if it is unbound or bound to the same node
+    for (const auto& [variable, target] : current.binds) {
+        if (bound[variable] == UNBOUND) {
+            bound[variable] = id;
+            match(graph, target, pending, bound, best, bestBound);
+            bound[variable] = UNBOUND;
+        }
+        else if (bound[variable] == id) {
+            match(graph, target, pending, bound, best, bestBound);
+        }
+    }
+
+    pending.push_back(id);
+}
+
+NodeId RewriteRules::build(ExpressionGraph& graph, const Term& term, const std::vector<NodeId>& bound) {
+    switch (term.type) {
+        case VARIABLE:
+            return bound[term.variable];
+        case NUMBER:
+            return graph.number(term.number);
+        case OPERATOR:
+            return graph.binary(term.op, build(graph, term.operands[0], bound), build(graph, term.operands[1], bound));
+        default: {
+            std::vector<NodeId> arguments;
+            arguments.reserve(term.operands.size());
+            for (const Term& operand : term.operands) {
+                arguments.push_back(build(graph, operand, bound));
+            }
+            return graph.call(term.name, std::move(arguments));
+        }
+    }
+}
+
+#pragma endregion
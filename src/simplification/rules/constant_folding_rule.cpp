@@ -1,7 +1,7 @@
 #include "simplification/rules/constant_folding_rule.h"
 
 
-bool ConstantFoldingRule::apply(const std::vector<Token>& input, std::vector<Token>& output) {
+bool ConstantFoldingRule::apply(const std::vector<Token>& input, std::vector<Token>& output, TokenPool& pool) {
     // Check that the sub-expression is exactly of the form:
     // NUMBER, NUMBER, OPERATOR
     if (input.size() == 3 &&
@@ -9,32 +9,28 @@ bool ConstantFoldingRule::apply(const std::vector<Token>& input, std::vector<Tok
         input[1].type == NUMBER &&
         input[2].type == OPERATOR) {
 
-        NUMBER_TYPE lhs = input[0].numericValue;
-        NUMBER_TYPE rhs = input[1].numericValue;
+        NUMBER_TYPE lhs = pool.number(input[0].id);
+        NUMBER_TYPE rhs = pool.number(input[1].id);
         NUMBER_TYPE result = 0;
-        std::string op = input[2].value;
+        OperatorType op = input[2].op;
 
-        if (op == "+") {
+        if (op == OperatorType::ADD) {
             result = lhs + rhs;
-        } else if (op == "-") {
+        } else if (op == OperatorType::SUB) {
             result = lhs - rhs;
-        } else if (op == "*") {
+        } else if (op == OperatorType::MUL) {
             result = lhs * rhs;
-        } else if (op == "/") {
+        } else if (op == OperatorType::DIV) {
             if (std::fabs(rhs) < 1e-14)
                 throw SolverException("Division by zero in constant folding.");
             result = lhs / rhs;
-        } else if (op == "^") {
+        } else if (op == OperatorType::POW) {
             result = std::pow(lhs, rhs);
         } else {
             return false;
         }
 
-        Token newToken;
-        newToken.type  = NUMBER;
-        newToken.value = numberToString(result);
-        newToken.numericValue = result;
-        output = { newToken };
+        output = { pool.numberToken(result) };
         return true;
     }
     return false;
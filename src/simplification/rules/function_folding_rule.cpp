@@ -1,12 +1,10 @@
 #include "simplification/rules/function_folding_rule.h"
-#include <sstream>
-#include <iomanip>
 #include <cmath>
 
 FunctionFoldingRule::FunctionFoldingRule(const std::unordered_map<std::string, Function>& functions_map)
     : functions(functions_map) {}
 
-bool FunctionFoldingRule::apply(const std::vector<Token>& input, std::vector<Token>& output) {
+bool FunctionFoldingRule::apply(const std::vector<Token>& input, std::vector<Token>& output, TokenPool& pool) {
     // Expect input: arg1, arg2, ..., argN, FUNCTION
     if (input.size() < 2) {
         return false;
@@ -20,9 +18,10 @@ bool FunctionFoldingRule::apply(const std::vector<Token>& input, std::vector<Tok
             return false;
         }
     }
-    auto it = functions.find(input.back().value);
+    const std::string& name = pool.name(input.back().id);
+    auto it = functions.find(name);
     if (it == functions.end()) {
-        throw SolverException("Unknown function in folding: " + input.back().value);
+        throw SolverException("Unknown function in folding: " + name);
     }
     const Function& func = it->second;
     size_t argCount = func.argCount;
@@ -32,13 +31,9 @@ bool FunctionFoldingRule::apply(const std::vector<Token>& input, std::vector<Tok
     std::vector<NUMBER_TYPE> numericArgs;
     numericArgs.reserve(argCount);
     for (size_t i = 0; i < argCount; ++i) {
-        numericArgs.push_back(input[i].numericValue);
+        numericArgs.push_back(pool.number(input[i].id));
     }
     NUMBER_TYPE result = func.callback(numericArgs);
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(15) << result;
-    Token newToken(NUMBER, oss.str());
-    newToken.numericValue = result;
-    output = { newToken };
+    output = { pool.numberToken(result) };
     return true;
 }
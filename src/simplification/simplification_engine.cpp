@@ -4,99 +4,78 @@ void SimplificationEngine::add_rule(std::unique_ptr<SimplificationRule> rule) {
     rules.push_back(std::move(rule));
 }
 
-std::vector<Token> SimplificationEngine::simplify(const std::vector<Token>& input, const std::unordered_map<std::string, Function>& functions) {
-    std::vector<Token> current = input;
-    bool changed = false;
-    const int MAX_ITERATIONS = 50; // safeguard against infinite loops
-
-    for (int i = 0; i < MAX_ITERATIONS; ++i) {
-        std::vector<Token> next = simplifyPass(current, functions, changed);
-        if (!changed)
-            break;
-        current = std::move(next);
-    }
-    return current;
+void SimplificationEngine::add_patterns(const RewriteRules& rules) {
+    patterns.push_back(&rules);
 }
 
-std::vector<Token> SimplificationEngine::simplifyPass(const std::vector<Token>& input, const std::unordered_map<std::string, Function>& functions, bool &changed) {
-    changed = false;
-    std::stack<std::vector<Token>> stack;
+std::vector<Token> SimplificationEngine::simplify(const std::vector<Token>& input, TokenPool& pool, const std::unordered_map<std::string, Function>& functions) {
+    ExpressionGraph graph;
+    NodeId root = graph.addPostfix(input, pool, functions);
+    return graph.toPostfix(simplify(graph, root, pool, functions), pool);
+}
 
-    for (const Token &token : input) {
-        if (token.type == NUMBER || token.type == VARIABLE) {
-            // These are leaves; push as single-token expressions.
-            stack.push({ token });
+NodeId SimplificationEngine::simplify(ExpressionGraph& graph, NodeId root, TokenPool& pool, const std::unordered_map<std::string, Function>& functions) {
+    PROFILE_FUNCTION()
+    // Simplified node of every node visited so far, by id; operands are always visited first.
+    const std::vector<NodeId> order = graph.reachable(root);
+    std::vector<NodeId> simplified(graph.size());
+    std::vector<NodeId> operands;
+    for (NodeId id : order) {
+        if (graph.isLeaf(id)) {
+            simplified[id] = id;
+            continue;
         }
-        else if (token.type == OPERATOR) {
-            // For a binary operator, pop the last two sub-expressions.
-            if (stack.size() < 2) {
-                throw SolverException("Not enough operands for operator '" + token.value + "' during simplification.");
-            }
-            auto rightExpr = stack.top(); stack.pop();
-            auto leftExpr  = stack.top(); stack.pop();
-
-            // Reassemble the current sub-expression.
-            std::vector<Token> subExpr = leftExpr;
-            subExpr.insert(subExpr.end(), rightExpr.begin(), rightExpr.end());
-            subExpr.push_back(token);
-
-            // Try all rules (in order) on this sub-expression.
-            for (const auto &rule : rules) {
-                std::vector<Token> candidate;
-                if (rule->apply(subExpr, candidate)) {
-                    subExpr = std::move(candidate);
-                    changed = true;
-                    break; // if one rule applies, do not try further rules for this sub-expression.
-                }
-            }
-            stack.push(std::move(subExpr));
+        // Only a node with a rewritten operand is rebuilt; the others are kept as they are
+        const std::vector<NodeId>& children = graph[id].children;
+        operands.resize(children.size());
+        bool changed = false;
+        for (size_t i = 0; i < children.size(); ++i) {
+            operands[i] = simplified[children[i]];
+            changed |= operands[i] != children[i];
         }
-        else if (token.type == FUNCTION) {
-            // Look up the function to know how many arguments to pop.
-            auto it = functions.find(token.value);
-            if (it == functions.end()) {
-                throw SolverException("Unknown function '" + token.value + "' during simplification.");
-            }
-            const Function &func = it->second;
-            size_t argCount = func.argCount;
-
-            if (stack.size() < argCount) {
-                throw SolverException("Not enough arguments for function '" + token.value + "' during simplification.");
-            }
+        const NodeId node = changed ? graph.withChildren(id, operands) : id;
+        simplified[id] = rewrite(graph, node, pool, functions);
+    }
+    return simplified[root];
+}
 
-            // Pop the function's arguments (in reverse order).
-            std::vector<std::vector<Token>> argExprs(argCount);
-            for (size_t i = 0; i < argCount; i++) {
-                argExprs[argCount - i - 1] = stack.top();
-                stack.pop();
-            }
-            
-            // Reassemble the full sub-expression representing the function call.
-            std::vector<Token> subExpr;
-            for (const auto &arg : argExprs) {
-                subExpr.insert(subExpr.end(), arg.begin(), arg.end());
-            }
-            subExpr.push_back(token);
+NodeId SimplificationEngine::rewrite(ExpressionGraph& graph, NodeId node, TokenPool& pool, const std::unordered_map<std::string, Function>& functions) {
+    const int MAX_ITERATIONS = 50; // safeguard against rules undoing each other
 
-            // Try all rules on this function sub-expression.
-            for (const auto &rule : rules) {
-                std::vector<Token> candidate;
-                if (rule->apply(subExpr, candidate)) {
-                    subExpr = std::move(candidate);
-                    changed = true;
-                    break;
-                }
-            }
-            stack.push(std::move(subExpr));
+    for (int i = 0; i < MAX_ITERATIONS; ++i) {
+        if (graph.isLeaf(node)) {
+            return node;
         }
-        else {
-            throw SolverException("Unexpected token type in postfix: " + token.value);
+        std::optional<NodeId> rewritten = applyRules(graph, node, pool, functions);
+        for (size_t p = 0; !rewritten && p < patterns.size(); ++p) {
+            rewritten = patterns[p]->rewrite(graph, node);
+        }
+        if (!rewritten) {
+            break;
         }
+        node = *rewritten;
     }
+    return node;
+}
 
-    if (stack.size() != 1) {
-        throw SolverException("Postfix simplification error: leftover expressions in stack.");
+std::optional<NodeId> SimplificationEngine::applyRules(ExpressionGraph& graph, NodeId node, TokenPool& pool, const std::unordered_map<std::string, Function>& functions) {
+    // The rules match small postfix windows: operands that are single tokens, then the operator or function.
+    window.clear();
+    for (NodeId operand : graph[node].children) {
+        if (!graph.isLeaf(operand)) {
+            return std::nullopt;
+        }
+        window.push_back(graph.token(operand, pool));
     }
+    window.push_back(graph.token(node, pool));
 
-    return stack.top();
+    for (const auto &rule : rules) {
+        candidate.clear();
+        if (rule->apply(window, candidate, pool)) {
+            // Rules mostly reduce the window to a single number or operand
+            const bool leaf = candidate.size() == 1 && (candidate[0].type == NUMBER || candidate[0].type == VARIABLE);
+            return leaf ? graph.add(candidate[0], pool) : graph.addPostfix(candidate, pool, functions);
+        }
+    }
+    return std::nullopt;
 }
@@ -0,0 +1,105 @@
+#include "simplification/strength_reduction.h"
+
+namespace {
+
+// Whether c and 1/c are both normal floats, so x / c and x * (1/c) round alike in every precision
+bool hasExactReciprocal(NUMBER_TYPE c) {
+    if (!std::isfinite(c) || c == 0) {
+        return false;
+    }
+    int exponent = 0;
+    const NUMBER_TYPE mantissa = std::frexp(c, &exponent);
+    const int power = exponent - 1;
+    return std::abs(mantissa) == 0.5 && power >= std::numeric_limits<float>::min_exponent - 1 && power <= -(std::numeric_limits<float>::min_exponent - 1);
+}
+
+class StrengthReducer {
+public:
+    StrengthReducer(ExpressionGraph& graph, const std::unordered_map<std::string, Function>& functions, bool fastMath)
+        : graph(graph), fastMath(fastMath) {
+        auto sqrt = functions.find("sqrt");
+        hasSqrt = sqrt != functions.end() && sqrt->second.builtin == Builtin::SQRT;
+    }
+
+    NodeId run(NodeId root) {
+        const std::vector<NodeId> order = graph.reachable(root);
+        std::vector<NodeId> result(graph.size(), 0);
+        std::vector<NodeId> operands;
+        for (NodeId id : order) {
+            const std::vector<NodeId>& children = graph[id].children;
+            operands.resize(children.size());
+            bool changed = false;
+            for (size_t i = 0; i < children.size(); ++i) {
+                operands[i] = result[children[i]];
+                changed |= operands[i] != children[i];
+            }
+            const NodeId node = changed ? graph.withChildren(id, operands) : id;
+            result[id] = lower(node).value_or(node);
+        }
+        return result[root];
+    }
+
+private:
+    std::optional<NodeId> lower(NodeId id) {
+        const GraphNode& node = graph[id];
+        if (node.type != OPERATOR || graph[node.children[1]].type != NUMBER) {
+            return std::nullopt;
+        }
+        const NodeId left = node.children[0];
+        const NUMBER_TYPE constant = graph[node.children[1]].number;
+
+        if (node.op == OperatorType::POW) {
+            // pow(x, +-0) is 1 even for NaN, and x * x is the correctly rounded square
+            if (constant == 0) {
+                return graph.number(1);
+            }
+            if (constant == 1) {
+                return left;
+            }
+            if (constant == 2) {
+                return graph.binary(OperatorType::MUL, left, left);
+            }
+            if (!fastMath) {
+                return std::nullopt;
+            }
+            if (constant == std::trunc(constant) && std::abs(constant) <= MAX_CHAIN_EXPONENT) {
+                const NodeId power = chain(left, static_cast<uint32_t>(std::abs(constant)));
+                return constant > 0 ? power : graph.binary(OperatorType::DIV, graph.number(1), power);
+            }
+            if (std::abs(constant) == 0.5 && hasSqrt) {
+                const NodeId root = graph.call("sqrt", { left });
+                return constant > 0 ? root : graph.binary(OperatorType::DIV, graph.number(1), root);
+            }
+            return std::nullopt;
+        }
+
+        if (node.op == OperatorType::DIV) {
+            const NUMBER_TYPE reciprocal = 1 / constant;
+            if (hasExactReciprocal(constant) || (fastMath && constant != 0 && std::isfinite(reciprocal) && reciprocal != 0)) {
+                return graph.binary(OperatorType::MUL, left, graph.number(reciprocal));
+            }
+        }
+        return std::nullopt;
+    }
+
+    // x^n by repeated squaring; hash-consing makes the squares shared nodes
+    NodeId chain(NodeId x, uint32_t n) {
+        if (n == 1) {
+            return x;
+        }
+        const NodeId half = chain(x, n / 2);
+        const NodeId square = graph.binary(OperatorType::MUL, half, half);
+        return n % 2 == 0 ? square : graph.binary(OperatorType::MUL, square, x);
+    }
+
+    ExpressionGraph& graph;
+    bool fastMath;
+    bool hasSqrt = false;   ///< Whether "sqrt" is the built-in square root.
+};
+
+} // namespace
+
+NodeId reduceStrength(ExpressionGraph& graph, NodeId root, const std::unordered_map<std::string, Function>& functions, bool fastMath) {
+    PROFILE_FUNCTION()
+    return StrengthReducer(graph, functions, fastMath).run(root);
+}
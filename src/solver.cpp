@@ -6,6 +6,11 @@
 #include "tokenizer.h"
 #include "ast.h"
 #include "compiler.h"
+#include "jit.h"
+#include "c_backend.h"
+#include "batch.h"
+#include "simplification/multiply_add.h"
+#include "simplification/strength_reduction.h"
 
 Solver::Solver(size_t exprCacheSize)
     : expressionCache(exprCacheSize) {
@@ -18,6 +23,90 @@ void Solver::setUseCache(bool useCache) {
     cacheEnabled = useCache;
 }
 
+void Solver::setEngine(Engine engine) {
+    PROFILE_FUNCTION()
+    this->engine = engine;
+}
+
+void Solver::setPrecision(Precision precision) {
+    PROFILE_FUNCTION()
+    this->precision = precision;
+}
+
+void Solver::setFastMath(bool enabled) {
+    PROFILE_FUNCTION()
+    if (enabled == fastMath) {
+        return;
+    }
+    // Every program was simplified under the old setting
+    fastMath = enabled;
+    clearCache();
+}
+
+void Solver::setFusedMultiplyAdd(bool enabled) {
+    PROFILE_FUNCTION()
+    if (enabled == fusedMultiplyAdd) {
+        return;
+    }
+    fusedMultiplyAdd = enabled;
+    clearCache();
+}
+
+void Solver::setEqualitySaturation(bool enabled, const SaturationLimits& limits) {
+    PROFILE_FUNCTION()
+    if (enabled == equalitySaturation && limits == saturationLimits) {
+        return;
+    }
+    equalitySaturation = enabled;
+    saturationLimits = limits;
+    clearCache();
+}
+
+void Solver::setTiering(const TieringPolicy& policy) {
+    PROFILE_FUNCTION()
+    if (policy == tiering) {
+        return;
+    }
+    tiering = policy;
+    clearCache();
+}
+
+void Solver::pinTier(const std::string& expression, std::optional<Tier> tier) {
+    PROFILE_FUNCTION()
+    if (tier) {
+        pinnedTiers[expression] = *tier;
+    } else {
+        pinnedTiers.erase(expression);
+    }
+    // Drop the program so it is rebuilt at the new tier, which may be lower
+    programCache.eraseIf([&](const std::string& key, const std::shared_ptr<CachedProgram>&) { return key == expression; });
+    if (current && currentExpressionPostfix == expression) {
+        current.reset();
+    }
+}
+
+TierInfo Solver::getTierInfo(const std::string& expression) {
+    const CachedProgram* entry = current && currentExpressionPostfix == expression ? current.get() : nullptr;
+    if (!entry) {
+        std::shared_ptr<CachedProgram>* cached = programCache.get(expression);
+        entry = cached && (*cached)->compiled ? cached->get() : nullptr;
+    }
+    if (!entry) {
+        auto pin = pinnedTiers.find(expression);
+        const std::optional<Tier> pinned = pin != pinnedTiers.end() ? std::optional<Tier>(pin->second) : std::nullopt;
+        return TierInfo{ targetTier(pinned, 0), 0, false, pinned.has_value() };
+    }
+    return TierInfo{ entry->tier, entry->executions, entry->promotion != nullptr, entry->pinned.has_value() };
+}
+
+void Solver::setBatchSize(size_t lanes) {
+    PROFILE_FUNCTION()
+    if (lanes == 0) {
+        throw SolverException("Batch size must be at least 1.");
+    }
+    batchSize = lanes;
+}
+
 void Solver::invalidateCaches() {
     PROFILE_FUNCTION()
     if (cacheEnabled) {
@@ -28,11 +117,42 @@ void Solver::invalidateCaches() {
 void Solver::clearCache() {
     PROFILE_FUNCTION()
     expressionCache.clear();
+    programCache.clear();
+    current.reset();
+    currentAST.reset();
+}
+
+void Solver::setProgramCacheSize(size_t entries, size_t bytes) {
+    PROFILE_FUNCTION()
+    programStats.evictions += programCache.resize(entries, bytes);
+}
+
+ProgramCacheStats Solver::getProgramCacheStats() const {
+    ProgramCacheStats stats = programStats;
+    stats.entries = programCache.size();
+    stats.bytes = programCache.weight();
+    return stats;
+}
+
+void Solver::invalidatePrograms(const std::string& name) {
+    auto dependsOnName = [&](const std::shared_ptr<CachedProgram>& entry) {
+        return entry && entry->dependencies.count(name) > 0;
+    };
+    programStats.invalidations += programCache.eraseIf([&](const std::string&, const std::shared_ptr<CachedProgram>& entry) {
+        return dependsOnName(entry);
+    });
+    if (dependsOnName(current)) {
+        current.reset();
+    }
+    if (dependsOnName(currentAST)) {
+        currentAST.reset();
+    }
 }
 
 void Solver::declareConstant(const std::string& name, NUMBER_TYPE value) {
     PROFILE_FUNCTION()
     symbolTable.declareConstant(name, value);
+    invalidatePrograms(name);
     invalidateCaches();
 }
 
@@ -44,45 +164,251 @@ void Solver::declareVariable(const std::string& name, NUMBER_TYPE value) {
 
 #pragma region Parsing
 
-std::vector<Token> Solver::parse(const std::string& expression, bool debug) {
-    auto tokens   = Tokenizer::tokenize(expression);
+NodeId Solver::parse(const std::string& expression, ExpressionGraph& graph, bool debug, std::unordered_set<std::string>* dependencies,
+                     const std::vector<std::string>* fixed, bool optimized) {
+    auto tokens   = Tokenizer::tokenize(expression, tokenPool);
     auto postfix  = Postfix::shuntingYard(tokens);
-    auto flattened = Postfix::flattenPostfix(postfix, functions);
-    auto inlined = Simplification::replaceConstantSymbols(flattened, symbolTable);
+
+    // Inline user functions and substitute constants; an expression depends on the names
+    // it uses, including those of inlined function bodies
+    ExpressionGraph built;
+    NodeId flattened = built.addPostfix(postfix, tokenPool, functions, &symbolTable, dependencies);
+
+    // Fixed variables become numbers, so simplification folds them like constants
+    if (fixed) {
+        ExpressionGraph bound;
+        std::vector<NodeId> values;
+        for (const std::string& name : *fixed) {
+            values.push_back(bound.number(symbolTable.lookupSymbol(name)));
+        }
+        flattened = bound.copy(built, flattened, *fixed, values);
+        built = std::move(bound);
+    }
 
     // Now do a simplification pass
-    auto simplified = Simplification::simplifyPostfix(inlined, functions);
+    SaturationReport saturation;
+    size_t contracted = 0;
+    NodeId simplified = flattened;
+    if (optimized) {
+        simplified = optimize(built, flattened, tokenPool, functions, optimizationSettings(), &saturation, &contracted);
+    }
 
     if (debug) {
         std::cout << "Flattened postfix: ";
-        printPostfix(inlined);
+        printPostfix(built.toPostfix(flattened, tokenPool), tokenPool);
         std::cout << "Simplified postfix: ";
-        printPostfix(simplified);
+        printPostfix(built.toPostfix(simplified, tokenPool), tokenPool);
+        if (optimized && equalitySaturation) {
+            std::cout << "Equality saturation: " << saturation.iterations << " rounds, " << saturation.nodes << " nodes in "
+                      << saturation.classes << " classes (" << (saturation.saturated ? "saturated" : "stopped by the limits")
+                      << "), cost " << saturation.costBefore << " -> " << saturation.costAfter << std::endl;
+        }
+        if (optimized && fusedMultiplyAdd) {
+            std::cout << "Contracted multiply-adds: " << contracted << std::endl;
+        }
+    }
+
+    // Keep only the nodes of the simplified expression
+    return graph.copy(built, simplified);
+}
+
+NodeId Solver::optimize(ExpressionGraph& graph, NodeId root, TokenPool& pool, const std::unordered_map<std::string, Function>& functions,
+                        const OptimizationSettings& settings, SaturationReport* saturation, size_t* contracted) {
+    NodeId simplified = Simplification::simplifyGraph(graph, root, pool, functions, settings.fastMath);
+
+    if (settings.equalitySaturation) {
+        simplified = saturate(graph, simplified, functions, settings.fastMath, settings.saturationLimits, saturation);
+        // The extracted expression may bring powers back, which are lowered again
+        simplified = reduceStrength(graph, simplified, functions, settings.fastMath);
+    }
+
+    if (settings.fusedMultiplyAdd) {
+        simplified = contractMultiplyAdds(graph, simplified, functions, contracted);
+    }
+    return simplified;
+}
+
+void Solver::parseInto(CachedProgram& entry, const std::string& expression, bool debug) {
+    if (!entry.parsed) {
+        entry.root = parse(expression, entry.graph, debug, &entry.dependencies, nullptr, entry.tier != Tier::BASELINE);
+        entry.parsed = true;
+        entry.resultKey = generateCacheKey(expression, {});
+    }
+}
+
+std::shared_ptr<CachedProgram> Solver::programFor(const std::string& expression, bool debug) {
+    std::shared_ptr<CachedProgram>* cached = debug ? nullptr : programCache.get(expression);
+    if (cached && (*cached)->compiled) {
+        ++programStats.hits;
+        return *cached;
+    }
+    ++programStats.misses;
+
+    // An entry built by the AST pipeline gets its program added; debug always starts afresh.
+    std::shared_ptr<CachedProgram> entry = cached ? *cached : std::make_shared<CachedProgram>();
+    auto pin = pinnedTiers.find(expression);
+    entry->pinned = pin != pinnedTiers.end() ? std::optional<Tier>(pin->second) : std::nullopt;
+    if (!entry->parsed) {
+        entry->tier = targetTier(entry->pinned, 0);
+    }
+    parseInto(*entry, expression, debug);
+    entry->program = compileGraph(entry->graph, entry->root, functions);
+    entry->compiled = true;
+    programStats.evictions += programCache.put(expression, entry, entry->byteSize());
+    return entry;
+}
+
+Program Solver::optimizedProgram(const std::string& expression) {
+    std::shared_ptr<CachedProgram> entry = programFor(expression, false);
+    if (entry->tier != Tier::BASELINE) {
+        return entry->program;
+    }
+    ExpressionGraph graph;
+    const NodeId root = parse(expression, graph);
+    return compileGraph(graph, root, functions);
+}
+
+#pragma endregion
+
+#pragma region Tiering
+
+Tier Solver::targetTier(std::optional<Tier> pinned, size_t executions) const {
+    if (pinned) {
+        return *pinned;
+    }
+    if (!tiering.enabled) {
+        return Tier::OPTIMIZED;
+    }
+    if (executions >= tiering.nativeAfter) {
+        return Tier::NATIVE;
+    }
+    return executions >= tiering.optimizeAfter ? Tier::OPTIMIZED : Tier::BASELINE;
+}
+
+Engine Solver::engineFor(const CachedProgram& entry) const {
+    // Tiering picks the engine only in place of the default interpreter, not of one selected with setEngine()
+    if (engine != Engine::INTERPRETER || (!tiering.enabled && !entry.pinned)) {
+        return engine;
+    }
+    return entry.tier == Tier::NATIVE ? tiering.nativeEngine : Engine::INTERPRETER;
+}
+
+void Solver::advanceTier(size_t runs) {
+    CachedProgram& entry = *current;
+    entry.executions += runs;
+    if (entry.promotion && entry.promotion->ready.load(std::memory_order_acquire)) {
+        installPromotion(entry);
+    }
+
+    const Tier target = targetTier(entry.pinned, entry.executions);
+    if (target > entry.tier && !entry.promotion && !entry.promotionFailed) {
+        startPromotion(entry, target);
+        if (!tiering.background) {
+            installPromotion(entry);
+        }
     }
+}
 
-    return simplified; 
+void Solver::startPromotion(CachedProgram& entry, Tier tier) {
+    PROFILE_FUNCTION()
+    // The job gets copies of everything it reads, so the solver can keep changing meanwhile
+    const bool simplify = entry.tier == Tier::BASELINE;
+    auto job = [tier, simplify, graph = simplify ? entry.graph : ExpressionGraph(), root = entry.root,
+                program = simplify ? Program() : entry.program, functions = functions, settings = optimizationSettings(),
+                engine = tiering.nativeEngine, precision = precision]() mutable {
+        TierPromotion promoted{ tier };
+        if (simplify) {
+            TokenPool pool;
+            const NodeId optimized = optimize(graph, root, pool, functions, settings);
+            promoted.graph.emplace();
+            promoted.root = promoted.graph->copy(graph, optimized);
+            program = compileGraph(*promoted.graph, promoted.root, functions);
+        }
+        if (tier == Tier::NATIVE) {
+            promoted.native = withPrecision(precision, [&](auto zero) -> std::unique_ptr<NativeCode> {
+                return compileNative<decltype(zero)>(program, engine);
+            });
+        }
+        promoted.program = std::move(program);
+        promoted.engine = engine;
+        promoted.precision = precision;
+        return promoted;
+    };
+    auto pending = std::make_shared<PendingPromotion>();
+    if (tiering.background) {
+        promotions.push(pending, std::move(job));
+    } else {
+        pending->complete(std::move(job));
+    }
+    entry.promotion = std::move(pending);
+}
+
+void Solver::installPromotion(CachedProgram& entry) {
+    PROFILE_FUNCTION()
+    const std::shared_ptr<PendingPromotion> pending = std::move(entry.promotion);  // Leaves it empty
+    try {
+        if (pending->error) {
+            std::rethrow_exception(pending->error);
+        }
+    } catch (const SolverException& e) {
+        std::cerr << "Staying at the " << tierToString(entry.tier) << " tier (promotion failed): " << e.what() << std::endl;
+        entry.promotionFailed = true;
+        return;
+    }
+    TierPromotion promoted = std::move(*pending->promoted);
+
+    if (promoted.graph) {
+        entry.graph = std::move(*promoted.graph);
+        entry.root = promoted.root;
+        if (entry.ast) {
+            entry.ast = AST::buildASTFromGraph(entry.graph, entry.root);
+        }
+    }
+    // Native code refers to the callbacks of the program it was compiled from, so it goes with it
+    entry.native.clear();
+    entry.residualNative.clear();
+    entry.program = std::move(promoted.program);
+    if (promoted.tier == Tier::NATIVE && (promoted.engine == Engine::JIT || promoted.engine == Engine::C)) {
+        entry.native.emplace(std::make_pair(promoted.engine, promoted.precision), std::move(promoted.native));
+    }
+    entry.tier = promoted.tier;
+
+    if (&entry == current.get()) {
+        current->program.initRegisters(currentRegisters);
+        currentBindings.clear();
+        refreshBindings();
+        if (std::shared_ptr<CachedProgram>* cached = programCache.get(currentExpressionPostfix); cached && *cached == current) {
+            programStats.evictions += programCache.put(currentExpressionPostfix, current, current->byteSize());
+        }
+    }
 }
 
 #pragma endregion
 
 #pragma region Evaluation
 
-NUMBER_TYPE Solver::evaluate(const std::string& expression, bool debug) {
+NUMBER_TYPE Solver::evaluate(const std::string& expression, bool debug, std::optional<Engine> engine, std::optional<Precision> precision) {
     PROFILE_FUNCTION()
     setCurrentExpression(expression, debug);
 
-    std::size_t cacheKey = generateCacheKey(expression, {});
+    // The same expression gives different results in different precisions.
+    const Precision selected = precision.value_or(this->precision);
+    const std::size_t baseKey = current->resultKey;
+    const std::size_t cacheKey = baseKey ^ (static_cast<std::size_t>(selected) + 0x9e3779b9 + (baseKey << 6) + (baseKey >> 2));
+
+    // Counted before the cache lookup, so an expression served from the cache is still promoted
+    advanceTier(1);
     if (cacheEnabled) {
         if (NUMBER_TYPE* cachedResult = expressionCache.get(cacheKey)) {
             return *cachedResult;
         }
     }
 
-    EvalFunc compiledExpr = compilePostfix(currentPostfix, functions);
-
-    Env env = symbolTable.getVariables();
-
-    NUMBER_TYPE result = compiledExpr(env);
+    loadVariables();
+    const Engine selectedEngine = engine.value_or(engineFor(*current));
+    NUMBER_TYPE result = withPrecision(selected, [&](auto zero) -> NUMBER_TYPE {
+        return static_cast<NUMBER_TYPE>(run<decltype(zero)>(selectedEngine));
+    });
 
     if (cacheEnabled) {
         expressionCache.put(cacheKey, result);
@@ -91,38 +417,121 @@ NUMBER_TYPE Solver::evaluate(const std::string& expression, bool debug) {
     return result;
 }
 
-std::vector<NUMBER_TYPE> Solver::evaluateForRange(const std::string& variable, const std::vector<NUMBER_TYPE>& values, const std::string& expression, bool debug) {
+template <typename T>
+T Solver::run(Engine engine) {
+    const TypedNativeCode<T>* native = nativeCode<T>(engine);
+    if constexpr (std::is_same_v<T, NUMBER_TYPE>) {
+        return native ? native->run(currentRegisters.data()) : current->program.run(currentRegisters.data());
+    } else {
+        std::vector<T>& registers = std::get<std::vector<T>>(typedRegisters);
+        registers.assign(currentRegisters.begin(), currentRegisters.end());
+        return native ? native->run(registers.data()) : current->program.run(registers.data());
+    }
+}
+
+CompiledExpression Solver::compile(const std::string& expression, std::optional<Engine> engine, std::optional<Precision> precision) {
     PROFILE_FUNCTION()
-    setCurrentExpression(expression, debug);
+    Program program = optimizedProgram(expression);
+
+    const Engine selectedEngine = engine.value_or(this->engine);
+    const Precision selectedPrecision = precision.value_or(this->precision);
+    std::shared_ptr<const NativeCode> native = withPrecision(selectedPrecision, [&](auto zero) -> std::shared_ptr<const NativeCode> {
+        return compileNative<decltype(zero)>(program, selectedEngine);
+    });
+    return CompiledExpression(expression, std::move(program), selectedEngine, selectedPrecision, std::move(native));
+}
+
+SpecializedExpression Solver::specialize(const std::string& expression, const std::vector<std::string>& fixed,
+                                         std::optional<Engine> engine, std::optional<Precision> precision) {
+    PROFILE_FUNCTION()
+    for (const std::string& name : fixed) {
+        if (!symbolTable.isVariable(name)) {
+            throw SolverException("Fixed variable '" + name + "' is not declared.");
+        }
+    }
+
+    // The inputs are the variables of the unspecialized expression that are not fixed
+    const Program program = optimizedProgram(expression);
+    std::vector<std::string> inputs;
+    for (const std::string& name : program.variableNames()) {
+        if (std::find(fixed.begin(), fixed.end(), name) == fixed.end()) {
+            inputs.push_back(name);
+        }
+    }
 
-    std::vector<NUMBER_TYPE> results;
-    results.reserve(values.size());
+    SpecializedExpression specialized(*this, expression, fixed, std::move(inputs),
+                                      engine.value_or(this->engine), precision.value_or(this->precision));
+    specialized.refresh();
+    return specialized;
+}
+
+CompiledExpression Solver::compileSpecialized(const std::string& expression, const std::vector<std::string>& fixed,
+                                              Engine engine, Precision precision) {
+    PROFILE_FUNCTION()
+    ExpressionGraph graph;
+    const NodeId root = parse(expression, graph, false, nullptr, &fixed);
+    Program program = compileGraph(graph, root, functions);
+
+    std::shared_ptr<const NativeCode> native = withPrecision(precision, [&](auto zero) -> std::shared_ptr<const NativeCode> {
+        return compileNative<decltype(zero)>(program, engine);
+    });
+    return CompiledExpression(expression, std::move(program), engine, precision, std::move(native));
+}
+
+std::vector<NUMBER_TYPE> Solver::evaluateForRange(const std::string& variable, const std::vector<NUMBER_TYPE>& values, const std::string& expression, bool debug, size_t threads, std::optional<Precision> precision) {
+    std::vector<NUMBER_TYPE> results(values.size());
+    evaluateForRange(variable, ArrayView(values), expression, ArrayView(results), debug, threads, precision);
+    return results;
+}
+
+void Solver::evaluateForRange(const std::string& variable, const ArrayView& values, const std::string& expression, const ArrayView& results, bool debug, size_t threads, std::optional<Precision> precision) {
+    prepareRange(variable, values, expression, results, debug, threads, precision)();
+}
+
+std::function<void()> Solver::prepareRange(const std::string& variable, const ArrayView& values, const std::string& expression, const ArrayView& results, bool debug, size_t threads, std::optional<Precision> precision) {
+    PROFILE_FUNCTION()
+    setCurrentExpression(expression, debug);
 
     if (!Validator::isValidName(variable)) {
         throw SolverException("Invalid variable name '" + variable + "'.");
     }
+    if (results.size() != values.size()) {
+        throw SolverException("Output has " + std::to_string(results.size()) + " elements, expected " + std::to_string(values.size()) + ".");
+    }
 
-    EvalFunc compiledExpr = compilePostfix(currentPostfix, functions);
-
-    Env env = symbolTable.getVariables();
+    advanceTier(values.size());
 
-    for (NUMBER_TYPE value : values) {
-        PROFILE_SCOPE("EvaluateRangeLoop");
-        env[variable] = value;
+    // The range variable does not need to be declared; it is written straight into its register.
+    const int slot = current->program.variableRegister(variable);
+    loadVariables({ slot });
 
-        try {
-            NUMBER_TYPE result = compiledExpr(env);
-            results.push_back(result);
-        } catch (const SolverException& e) {
-            std::cerr << "Error evaluating expression for " << variable << " = " << value << ": " << e.what() << std::endl;
-            results.push_back(std::nan(""));
+    auto sweep = prepareSweep({ slot }, { values }, results, threads, precision.value_or(this->precision));
+    return [sweep = std::move(sweep), variable, values] {
+        for (const auto& [index, message] : sweep()) {
+            std::cerr << "Error evaluating expression for " << variable << " = " << values[index] << ": " << message << std::endl;
         }
+    };
+}
+
+std::vector<NUMBER_TYPE> Solver::evaluateForRanges(const std::vector<std::string>& variables, const std::vector<std::vector<NUMBER_TYPE>>& valuesSets, const std::string& expression, bool debug, size_t threads, std::optional<Precision> precision) {
+    // Compute the total number of combinations in the cartesian product
+    size_t totalCombinations = 1;
+    std::vector<ArrayView> ranges;
+    for (const auto& vals : valuesSets) {
+        totalCombinations *= vals.size();
+        ranges.emplace_back(vals);
     }
 
+    std::vector<NUMBER_TYPE> results(totalCombinations);
+    evaluateForRanges(variables, ranges, expression, ArrayView(results), debug, threads, precision);
     return results;
 }
 
-std::vector<NUMBER_TYPE> Solver::evaluateForRanges(const std::vector<std::string>& variables, const std::vector<std::vector<NUMBER_TYPE>>& valuesSets, const std::string& expression, bool debug) {
+void Solver::evaluateForRanges(const std::vector<std::string>& variables, const std::vector<ArrayView>& valuesSets, const std::string& expression, const ArrayView& results, bool debug, size_t threads, std::optional<Precision> precision) {
+    prepareRanges(variables, valuesSets, expression, results, debug, threads, precision)();
+}
+
+std::function<void()> Solver::prepareRanges(const std::vector<std::string>& variables, const std::vector<ArrayView>& valuesSets, const std::string& expression, const ArrayView& results, bool debug, size_t threads, std::optional<Precision> precision) {
     PROFILE_FUNCTION()
 
     // Basic validation:
@@ -137,55 +546,284 @@ std::vector<NUMBER_TYPE> Solver::evaluateForRanges(const std::vector<std::string
 
     // Parse and compile the expression
     setCurrentExpression(expression, debug);
-    EvalFunc compiledExpr = compilePostfix(currentPostfix, functions);
 
     // Compute the total number of combinations in the cartesian product
     size_t totalCombinations = 1;
     for (const auto& vals : valuesSets) {
         totalCombinations *= vals.size();
     }
+    if (results.size() != totalCombinations) {
+        throw SolverException("Output has " + std::to_string(results.size()) + " elements, expected " + std::to_string(totalCombinations) + ".");
+    }
+
+    advanceTier(totalCombinations);
+
+    // Load the declared variables once; the range variables are written straight into
+    // their registers for every combination.
+    std::vector<int> slots(variables.size());
+    for (size_t i = 0; i < variables.size(); ++i) {
+        slots[i] = current->program.variableRegister(variables[i]);
+    }
+    loadVariables(slots);
+
+    auto sweep = prepareSweep(slots, valuesSets, results, threads, precision.value_or(this->precision));
+    return [sweep = std::move(sweep), totalCombinations] {
+        for (const auto& [index, message] : sweep()) {
+            std::cerr << "Error evaluating expression for combination " << (index + 1)
+                      << " of " << totalCombinations << ": " << message << std::endl;
+        }
+    };
+}
+
+std::function<std::vector<Solver::RangeError>()> Solver::prepareSweep(const std::vector<int>& slots, const std::vector<ArrayView>& ranges, const ArrayView& results, size_t threads, Precision precision) {
+    return withPrecision(precision, [&](auto zero) {
+        return prepareSweepAs<decltype(zero)>(slots, ranges, results, threads);
+    });
+}
+
+template <typename T>
+std::function<std::vector<Solver::RangeError>()> Solver::prepareSweepAs(const std::vector<int>& slots, const std::vector<ArrayView>& ranges, const ArrayView& results, size_t threads) {
+    PROFILE_FUNCTION()
+    // Held by the returned function, which may outlive the current program (or run during a promotion)
+    auto sweep = std::make_shared<Sweep<T>>();
+    sweep->slots = slots;
+    sweep->ranges = ranges;
+    sweep->results = results;
+    sweep->threads = threads;
+    sweep->program = current->program;
+    sweep->loaded.assign(currentRegisters.begin(), currentRegisters.end());
+
+    const Engine selectedEngine = engineFor(*current);
+    if (selectedEngine == Engine::BATCH) {
+        sweep->batchLanes = batchSize;
+    }
+    if (nativeCode<T>(selectedEngine)) {
+        sweep->native = current->native.at({ selectedEngine, precisionOf<T>() });
+    }
+
+    // Move the work that does not depend on every range variable out of the per-point
+    // program; it is tabulated when the sweep runs.
+    if (results.size() > 1) {
+        sweep->hoist.emplace(current->program, slots, ranges);
+        if (sweep->hoist->hoistedCount() == 0) {
+            sweep->hoist.reset();
+        }
+    }
+    if (sweep->hoist && sweep->native) {
+        // Repeated sweeps over the same ranges hoist the same instructions; compile their residual once
+        auto [it, inserted] = current->residualNative.try_emplace({ selectedEngine, precisionOf<T>(), slots, sweep->hoist->hoistedInstructions() });
+        if (inserted) {
+            it->second = compileNative<T>(sweep->hoist->residual(), selectedEngine);
+        }
+        sweep->residualNative = it->second;
+    }
+    return [sweep] { return runSweep(*sweep); };
+}
+
+template <typename T>
+std::vector<Solver::RangeError> Solver::runSweep(Sweep<T>& sweep) {
+    PROFILE_FUNCTION()
+    const size_t total = sweep.results.size();
+    const TypedNativeCode<T>* native = static_cast<const TypedNativeCode<T>*>(sweep.native.get());
+
+    // If any hoisted value fails, every point is evaluated in full instead, so errors are
+    // reported per point exactly as before.
+    HoistedSweep<T>* hoist = sweep.hoist ? &*sweep.hoist : nullptr;
+    if (hoist) {
+        try {
+            hoist->tabulate(sweep.loaded.data());
+            if (native) {
+                native = static_cast<const TypedNativeCode<T>*>(sweep.residualNative.get());
+            }
+        } catch (const SolverException&) {
+            hoist = nullptr;
+        }
+    }
+
+    // Below this many points per thread, starting a thread costs more than it saves.
+    constexpr size_t MIN_POINTS_PER_THREAD = 1024;
+    size_t threads = sweep.threads;
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min(threads, (total + MIN_POINTS_PER_THREAD - 1) / MIN_POINTS_PER_THREAD));
+
+    // Contiguous slices of the flat index space; each worker writes only its own slice of
+    // results and keeps its own errors, so no synchronization is needed until the join.
+    std::vector<std::vector<RangeError>> errors(threads);
+    std::vector<std::exception_ptr> failures(threads);
+    auto work = [&](size_t worker) {
+        const size_t begin = total * worker / threads;
+        const size_t end = total * (worker + 1) / threads;
+        try {
+            sweepSlice<T>(sweep, begin, end, hoist, native, errors[worker]);
+        } catch (...) {
+            failures[worker] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t worker = 1; worker < threads; ++worker) {
+        pool.emplace_back(work, worker);
+    }
+    work(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
 
-    // Prepare output vector
-    std::vector<NUMBER_TYPE> results;
-    results.reserve(totalCombinations);
+    for (const std::exception_ptr& failure : failures) {
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
 
-    // Initialize an environment map with current variable values
-    Env env = symbolTable.getVariables();
+    std::vector<RangeError> merged;
+    for (auto& slice : errors) {
+        std::move(slice.begin(), slice.end(), std::back_inserter(merged));
+    }
+    return merged;
+}
 
-    // Indices for tracking cartesian product iteration
-    std::vector<size_t> indices(variables.size(), 0);
+template <typename T>
+void Solver::sweepSlice(const Sweep<T>& sweep, size_t begin, size_t end, const HoistedSweep<T>* hoist, const TypedNativeCode<T>* native, std::vector<RangeError>& errors) {
+    PROFILE_FUNCTION()
+    if (begin >= end) {
+        return;
+    }
+    const std::vector<int>& slots = sweep.slots;
+    const std::vector<ArrayView>& ranges = sweep.ranges;
+    const ArrayView& results = sweep.results;
+
+    // Per-thread evaluation state: a private copy of the loaded register file.
+    const Program& program = hoist ? hoist->residual() : sweep.program;
+    std::vector<T> registers = hoist ? hoist->residualRegisters(sweep.loaded.data()) : sweep.loaded;
+
+    // Indices of the first combination of the slice (last variable changes fastest)
+    std::vector<size_t> indices(ranges.size(), 0);
+    for (size_t rest = begin, i = ranges.size(); i-- > 0;) {
+        indices[i] = rest % ranges[i].size();
+        rest /= ranges[i].size();
+    }
 
-    // Iterate through all combinations
-    for (size_t count = 0; count < totalCombinations; ++count) {
+    // Writes the inputs of the current combination through store(register, value).
+    auto bind = [&](auto&& store) {
+        if (hoist) {
+            hoist->bind(indices, store);
+            return;
+        }
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (slots[i] >= 0) {
+                store(static_cast<uint32_t>(slots[i]), ranges[i].template get<T>(indices[i]));
+            }
+        }
+    };
+
+    if (sweep.batchLanes > 0) {
+        BatchProgram<T> batch(program, sweep.batchLanes);
+        batch.load(registers.data());
+        for (size_t start = begin; start < end; start += batch.lanes()) {
+            const size_t count = std::min(batch.lanes(), end - start);
+            for (size_t lane = 0; lane < count; ++lane) {
+                bind([&](uint32_t reg, T value) { batch.column(reg)[lane] = value; });
+                nextCombination(indices, ranges);
+            }
+            const T* column = batch.run(count);
+            for (size_t lane = 0; lane < count; ++lane) {
+                results.set(start + lane, column[lane]);
+            }
+            for (const auto& [lane, message] : batch.errors()) {
+                errors.emplace_back(start + lane, message);
+                results.set(start + lane, std::nan(""));
+            }
+        }
+        return;
+    }
+
+    for (size_t index = begin; index < end; ++index) {
         PROFILE_SCOPE("EvaluateRangesLoop");
 
         // Assign each variable to its current index's value
-        for (size_t i = 0; i < variables.size(); ++i) {
-            env[variables[i]] = valuesSets[i][indices[i]];
-        }
+        bind([&](uint32_t reg, T value) { registers[reg] = value; });
 
         // Evaluate and capture the result
         try {
-            NUMBER_TYPE val = compiledExpr(env);
-            results.push_back(val);
+            results.set(index, native ? native->run(registers.data()) : program.run(registers.data()));
         } catch (const SolverException& e) {
-            std::cerr << "Error evaluating expression for combination " << (count + 1)
-                      << " of " << totalCombinations << ": " << e.what() << std::endl;
-            results.push_back(std::nan(""));
-        }
-
-        // Increment the indices in a multi-digit manner (last variable changes fastest)
-        for (int varIndex = static_cast<int>(variables.size()) - 1; varIndex >= 0; --varIndex) {
-            indices[varIndex]++;
-            if (indices[varIndex] < valuesSets[varIndex].size()) {
-                break; // Successfully incremented without overflow
-            } else {
-                indices[varIndex] = 0; // Reset this index and carry over to the next variable
-            }
+            errors.emplace_back(index, e.what());
+            results.set(index, std::nan(""));
         }
+
+        nextCombination(indices, ranges);
     }
+}
 
-    return results;
+void Solver::nextCombination(std::vector<size_t>& indices, const std::vector<ArrayView>& ranges) {
+    // Increment the indices in a multi-digit manner (last variable changes fastest)
+    for (int varIndex = static_cast<int>(indices.size()) - 1; varIndex >= 0; --varIndex) {
+        indices[varIndex]++;
+        if (indices[varIndex] < ranges[varIndex].size()) {
+            break; // Successfully incremented without overflow
+        } else {
+            indices[varIndex] = 0; // Reset this index and carry over to the next variable
+        }
+    }
+}
+
+void Solver::refreshBindings() {
+    const auto& names = current->program.variableNames();
+    if (currentBindings.size() == names.size() && currentBindingsVersion == symbolTable.layoutVersion()) {
+        return;
+    }
+
+    currentBindings.resize(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        currentBindings[i] = symbolTable.variableSlot(names[i]);
+    }
+    currentBindingsVersion = symbolTable.layoutVersion();
+}
+
+void Solver::loadVariables(const std::vector<int>& overrides) {
+    refreshBindings();
+
+    const uint32_t base = current->program.variableBase();
+    for (size_t i = 0; i < currentBindings.size(); ++i) {
+        const size_t slot = currentBindings[i];
+        if (slot != SymbolTable::npos) {
+            currentRegisters[base + i] = symbolTable.variableValue(slot);
+        }
+        else if (std::find(overrides.begin(), overrides.end(), static_cast<int>(base + i)) == overrides.end()) {
+            throw SolverException("Variable '" + current->program.variableNames()[i] + "' not found in environment.");
+        }
+    }
+}
+
+template <typename T>
+const TypedNativeCode<T>* Solver::nativeCode(Engine engine) {
+    if (engine != Engine::JIT && engine != Engine::C) {
+        return nullptr;
+    }
+
+    auto [it, inserted] = current->native.try_emplace({ engine, precisionOf<T>() });
+    if (inserted) {
+        it->second = compileNative<T>(current->program, engine);
+    }
+    return static_cast<const TypedNativeCode<T>*>(it->second.get());
+}
+
+template <typename T>
+std::unique_ptr<TypedNativeCode<T>> Solver::compileNative(const Program& program, Engine engine) {
+    try {
+        if (engine == Engine::JIT && JitProgram<T>::isSupported()) {
+            return std::make_unique<JitProgram<T>>(program);
+        }
+        if (engine == Engine::C && CProgram<T>::isSupported()) {
+            return std::make_unique<CProgram<T>>(program);
+        }
+    } catch (const SolverException& e) {
+        std::cerr << "Falling back to the interpreter (" << engineToString(engine) << " engine failed): " << e.what() << std::endl;
+    }
+    return nullptr;
 }
 
 #pragma endregion
@@ -198,6 +836,7 @@ void Solver::registerPredefinedFunction(const std::string& name, const FunctionC
     if (!result.second) {
         throw SolverException("Function '" + name + "' already exists.");
     }
+    invalidatePrograms(name);
 }
 
 void Solver::declareFunction(const std::string& name, const std::vector<std::string>& args, const std::string& expression) {
@@ -206,19 +845,22 @@ void Solver::declareFunction(const std::string& name, const std::vector<std::str
         throw SolverException("Invalid function name: '" + name + "'.");
     }
 
-    Validator::isValidSyntax(expression);
-
     try {
-        // Tokenize and convert the function body to postfix
-        auto tokens = Tokenizer::tokenize(expression);
+        // Tokenize (checking the syntax) and convert the function body to postfix
+        auto tokens = Tokenizer::tokenize(expression, tokenPool);
         auto postfix = Postfix::shuntingYard(tokens);
-        auto flattened = Postfix::flattenPostfix(postfix, functions);
 
-        // Store the function with its inlined postfix and argument names
-        functions[name] = Function(flattened, args);
+        // Store the body as a graph with the functions it calls inlined, so using it
+        // inlines a copy of the graph rather than of the expanded expression
+        auto body = std::make_shared<ExpressionGraph>();
+        NodeId root = body->addPostfix(postfix, tokenPool, functions);
+
+        functions[name] = Function(std::move(body), root, args);
     } catch (const std::exception& e) {
         throw SolverException("Error defining function '" + name + "': " + e.what());
     }
+    invalidatePrograms(name);
+    invalidateCaches();
 }
 
 #pragma endregion
@@ -234,16 +876,27 @@ std::unordered_map<std::string, NUMBER_TYPE> Solver::listVariables() const {
 }
 
 void Solver::setCurrentExpression(const std::string& expression, bool debug) {
-    // Check if the expression is the same and the currentPostfix is not empty
-    if (expression == currentExpressionPostfix && !currentPostfix.empty()) {
+    // The current expression is the most recently used one; skip the cache lookup
+    if (!debug && current && expression == currentExpressionPostfix) {
+        ++programStats.hits;
         return;
     }
 
-    // Otherwise, parse the new expression into postfix
+    // Otherwise, fetch (or parse and compile) the expression's program
+    std::shared_ptr<CachedProgram> entry = programFor(expression, debug);
+
     currentExpressionPostfix = expression;
-    currentPostfix = parse(expression, debug); 
+    current = std::move(entry);
+    current->program.initRegisters(currentRegisters);
+
+    // Resolve the program's variables against the symbol table once, up front
+    currentBindings.clear();
+    refreshBindings();
 
     if (debug) {
+        std::cout << "Compiled program:" << std::endl;
+        current->program.disassemble();
+
         std::cout << "Current expression set to: " << expression << std::endl;
     }
 }
@@ -0,0 +1,83 @@
+#include "specialized_expression.h"
+#include "solver.h"
+
+SpecializedExpression::SpecializedExpression(Solver& solver, std::string expression, std::vector<std::string> fixed,
+                                             std::vector<std::string> inputs, Engine engine, Precision precision)
+    : solver(&solver), source(std::move(expression)), fixedNames(std::move(fixed)), inputs(std::move(inputs)),
+      tier(engine), scalar(precision) {}
+
+const CompiledExpression& SpecializedExpression::residual() {
+    refresh();
+    return *compiled;
+}
+
+NUMBER_TYPE SpecializedExpression::evaluate(const std::vector<NUMBER_TYPE>& values) {
+    PROFILE_FUNCTION()
+    if (values.size() != inputs.size()) {
+        throw SolverException("Expression '" + source + "' reads " + std::to_string(inputs.size())
+                              + " variables, got " + std::to_string(values.size()) + " values.");
+    }
+    refresh();
+    std::vector<NUMBER_TYPE> ordered(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        ordered[i] = values[positions[i]];
+    }
+    return compiled->evaluate(ordered);
+}
+
+NUMBER_TYPE SpecializedExpression::evaluate(const std::unordered_map<std::string, NUMBER_TYPE>& values) {
+    refresh();
+    return compiled->evaluate(values);
+}
+
+void SpecializedExpression::refresh() {
+    const SymbolTable& symbols = solver->symbolTable;
+    if (layout != symbols.layoutVersion()) {
+        slots.clear();
+        for (const std::string& name : fixedNames) {
+            const size_t slot = symbols.variableSlot(name);
+            if (slot == SymbolTable::npos) {
+                throw SolverException("Fixed variable '" + name + "' is not declared.");
+            }
+            slots.push_back(slot);
+        }
+        layout = symbols.layoutVersion();
+    }
+
+    bool stale = !compiled;
+    for (size_t i = 0; i < slots.size() && !stale; ++i) {
+        // -0 and 0 are told apart, since results may differ (1/x)
+        stale = !SameNumber{}(symbols.variableValue(slots[i]), bound[i]);
+    }
+    if (!stale) {
+        return;
+    }
+    const bool first = !compiled;
+    rebuild();
+    if (!first) {
+        ++rebuilds;
+    }
+}
+
+void SpecializedExpression::rebuild() {
+    PROFILE_FUNCTION()
+    // Nothing is kept until the compile succeeds, so a failed one is retried rather than the old residual run
+    std::vector<NUMBER_TYPE> values;
+    for (size_t slot : slots) {
+        values.push_back(solver->symbolTable.variableValue(slot));
+    }
+    CompiledExpression residual = solver->compileSpecialized(source, fixedNames, tier, scalar);
+
+    // Folding may drop inputs, so the residual reads a subset of them
+    std::vector<size_t> order;
+    for (const std::string& name : residual.variables()) {
+        auto it = std::find(inputs.begin(), inputs.end(), name);
+        if (it == inputs.end()) {
+            throw SolverException("Specialized expression '" + source + "' reads variable '" + name + "' its unspecialized form does not.");
+        }
+        order.push_back(static_cast<size_t>(std::distance(inputs.begin(), it)));
+    }
+    bound = std::move(values);
+    compiled.emplace(std::move(residual));
+    positions = std::move(order);
+}
@@ -31,6 +31,7 @@ void SymbolTable::declareVariable(const std::string& name, NUMBER_TYPE value, bo
         // New variable → Add to vector and map
         variableIndex[name] = variables.size();
         variables.emplace_back(value, SymbolType::VARIABLE);
+        ++layout;
     } else {
         // Existing variable → Update value
         variables[it->second].value = value;
@@ -47,11 +48,18 @@ NUMBER_TYPE* SymbolTable::getVariablePtr(const std::string& name) {
         // Variable does not exist, create it with default value (0.0)
         variableIndex[name] = variables.size();
         variables.emplace_back(0.0, SymbolType::VARIABLE);
+        ++layout;
         return &variables.back().value;
     }
     return &variables[it->second].value;
 }
 
+// Stable index of a variable in the value vector (npos if not declared)
+size_t SymbolTable::variableSlot(const std::string& name) const {
+    auto it = variableIndex.find(name);
+    return it == variableIndex.end() ? npos : it->second;
+}
+
 // Lookup a symbol (checks both variables and constants)
 NUMBER_TYPE SymbolTable::lookupSymbol(const std::string& name) const {
     if (cachedSymbolName == name) {
@@ -80,6 +88,7 @@ void SymbolTable::clearVariables() {
     variables.clear();
     variableIndex.clear();
     cachedSymbolName.clear();
+    ++layout;
 }
 
 // Restore variables from a saved copy
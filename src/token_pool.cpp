@@ -0,0 +1,47 @@
+#include "token_pool.h"
+#include "expression_graph.h"
+
+size_t NumberHash::operator()(NUMBER_TYPE value) const {
+    // -0 hashes like 0 in std::hash, but the two are different numbers here
+    return std::isnan(value) ? 0 : std::hash<NUMBER_TYPE>{}(value) + std::signbit(value);
+}
+
+bool SameNumber::operator()(NUMBER_TYPE a, NUMBER_TYPE b) const {
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b);
+    }
+    return a == b && std::signbit(a) == std::signbit(b);
+}
+
+TokenPool::TokenPool() {
+    intern("(");
+    intern(")");
+    intern(",");
+    intern("neg");
+    for (OperatorType op : { OperatorType::ADD, OperatorType::SUB, OperatorType::MUL, OperatorType::DIV, OperatorType::POW }) {
+        intern(::operatorSymbol(op));
+    }
+}
+
+SymbolId TokenPool::intern(std::string_view name) {
+    auto it = symbols.find(name);
+    if (it != symbols.end()) {
+        return it->second;
+    }
+    const SymbolId id = static_cast<SymbolId>(names.size());
+    names.emplace_back(name);
+    symbols.emplace(names.back(), id);
+    return id;
+}
+
+uint32_t TokenPool::constant(NUMBER_TYPE value) {
+    auto [it, inserted] = constants.try_emplace(value, static_cast<uint32_t>(numbers.size()));
+    if (inserted) {
+        numbers.push_back(value);
+    }
+    return it->second;
+}
+
+std::string TokenPool::text(const Token& token) const {
+    return token.type == NUMBER ? numberToString(number(token.id)) : name(token.id);
+}
@@ -2,131 +2,198 @@
 #include "exception.h"
 #include "validator.h"
 #include "tokenizer.h"
+#include <charconv>
+#include <cstdio>
 
-std::vector<Token> Tokenizer::tokenize(const std::string& equation) {
-    PROFILE_FUNCTION() // Profile the entire tokenize function
-
-    std::vector<Token> tokens;
-    tokens.reserve(equation.size());
-
-    auto begin = tokenizeUsingRegex(equation);
-    auto end = std::sregex_iterator();
+namespace {
 
-    for (auto it = begin; it != end; ++it) {
-        PROFILE_SCOPE("Tokenizer::tokenize_ProcessMatchLoop");
-        std::string match = (*it)[1].str();
-        processMatch(match, tokens, it, end);
-    }
+bool isNameStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
 
-    return tokens;
+bool isNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
 }
 
-std::sregex_iterator Tokenizer::tokenizeUsingRegex(const std::string& equation) {
-    PROFILE_FUNCTION() // Profile the regex tokenization function
-    // Regex definitions
-    static const std::regex tokenRegex(R"(\s*([+\-*/^]|\d+(\.\d+)?|[a-zA-Z_][a-zA-Z_0-9]*|[(),])\s*)");
-    
-    return std::sregex_iterator(equation.begin(), equation.end(), tokenRegex);
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
 }
 
-void Tokenizer::processMatch(const std::string& match, std::vector<Token>& tokens, std::sregex_iterator& it, const std::sregex_iterator& end) {
-    PROFILE_FUNCTION() // Profile the processMatch function
-    static const std::regex numberRegex(R"(\d+(\.\d+)?)");
-    static const std::regex variableRegex(R"([a-zA-Z_][a-zA-Z_0-9]*)");
-    static const std::regex operatorRegex(R"([+\-*/^])");
-    static const std::regex parenRegex(R"([\(\)])");
-    static const std::regex separatorRegex(R"(,)");
+bool isSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c));
+}
 
-    if (std::regex_match(match, numberRegex)) {
-        handleNumberToken(match, tokens, it, end);
-    }
-    else if (std::regex_match(match, variableRegex)) {
-        handleVariableOrFunctionToken(match, tokens, it, end);
-    }
-    else if (std::regex_match(match, operatorRegex)) {
-        handleOperatorToken(match, tokens, it, end);
-    }
-    else if (std::regex_match(match, parenRegex)) {
-        tokens.emplace_back(PAREN, match);
-    }
-    else if (std::regex_match(match, separatorRegex)) {
-        tokens.emplace_back(SEPARATOR, match);
-    }
-    else {
-        throw SolverException("Error: Unknown token '" + match + "'");
+OperatorType binaryOperator(char c) {
+    switch (c) {
+        case '+': return OperatorType::ADD;
+        case '-': return OperatorType::SUB;
+        case '*': return OperatorType::MUL;
+        case '/': return OperatorType::DIV;
+        case '^': return OperatorType::POW;
+        default:  return OperatorType::UNKNOWN;
     }
 }
 
-void Tokenizer::handleNumberToken(const std::string& match, std::vector<Token>& tokens, std::sregex_iterator& it, const std::sregex_iterator& end) {
-    PROFILE_FUNCTION() // Profile the handleNumberToken function
-    // Handle negation case for numbers
-    if (!tokens.empty() && tokens.back().type == FUNCTION && tokens.back().value == "neg") {
-        auto next_it = std::next(it);
-        if (next_it != end && (*next_it)[1].str() == "^") {
-            tokens.emplace_back(NUMBER, match); 
-        } else {
-            tokens.back() = Token{NUMBER, "-" + match};  // Merge negation into the number token
+/// The character starting at \p p: its whole UTF-8 sequence if a valid one starts there, else the byte.
+std::string_view characterAt(const char* p, const char* end) {
+    const auto lead = static_cast<unsigned char>(*p);
+    // Length of the sequence, and the range of its second byte (which rules out overlong forms and surrogates)
+    size_t length = 1;
+    unsigned char low = 0x80, high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    }
+    if (length > static_cast<size_t>(end - p)) {
+        return { p, 1 };
+    }
+    for (size_t i = 1; i < length; ++i) {
+        const auto byte = static_cast<unsigned char>(p[i]);
+        if (i == 1 ? byte < low || byte > high : (byte & 0xC0) != 0x80) {
+            return { p, 1 };
         }
-    } else {
-        tokens.emplace_back(NUMBER, match);
     }
+    return { p, length };
 }
 
-void Tokenizer::handleVariableOrFunctionToken(const std::string& match, std::vector<Token>& tokens, std::sregex_iterator& it, const std::sregex_iterator& end) {
-    PROFILE_FUNCTION() // Profile the handleVariableOrFunctionToken function
-    auto next_it = std::next(it);
-    if (next_it != end && (*next_it)[1].str() == "(") {
-        tokens.emplace_back(FUNCTION, match);
-    } else {
-        tokens.emplace_back(VARIABLE, match);
+std::string syntaxError(const std::string& what, std::string_view character, size_t position) {
+    // A byte that is not a printable character is escaped, so the message stays valid UTF-8
+    std::string shown(character);
+    const auto byte = static_cast<unsigned char>(character[0]);
+    if (character.size() == 1 && (byte >= 0x80 || !std::isprint(byte))) {
+        char escaped[5];
+        std::snprintf(escaped, sizeof(escaped), "\\x%02x", byte);
+        shown = escaped;
     }
+    return "Syntax Error: " + what + " '" + shown + "' at position " + std::to_string(position);
 }
 
-void Tokenizer::handleOperatorToken(const std::string& match, std::vector<Token>& tokens, std::sregex_iterator& it, const std::sregex_iterator& end) {
-    PROFILE_FUNCTION() // Profile the handleOperatorToken function
-    if (match == "-" && (tokens.empty() || isUnaryContext(tokens.back()))) {
-        // PROFILE_SCOPE("Tokenizer::handleOperatorToken_UnaryMinus");
-        // Handle unary minus (negation)
-        tokens.emplace_back(FUNCTION, "neg");
-        auto next_it = std::next(it);
-        if (next_it != end && (*next_it)[1].str() == "^") {
-            tokens.emplace_back(PAREN, "(");
-        }
-    } else {
-        // Create an operator token and assign the enumeration value.
-        Token token(OPERATOR, match);
-        if (match == "+") {
-            token.op = OperatorType::ADD;
-        } else if (match == "-") {
-            token.op = OperatorType::SUB;
-        } else if (match == "*") {
-            token.op = OperatorType::MUL;
-        } else if (match == "/") {
-            token.op = OperatorType::DIV;
-        } else if (match == "^") {
-            token.op = OperatorType::POW;
-        } else {
-            token.op = OperatorType::UNKNOWN;
-        }
-        tokens.push_back(token);
-    }
-}
+} // namespace
 
-bool Tokenizer::isUnaryContext(const Token& lastToken) {
-    // If last token is an operator, separator, or '(' => next '-' is unary
-    if (lastToken.type == OPERATOR || lastToken.type == SEPARATOR)
-        return true;
+std::vector<Token> Tokenizer::tokenize(const std::string& equation, TokenPool& pool) {
+    PROFILE_FUNCTION() // Profile the entire tokenize function
+
+    std::vector<Token> tokens;
+    tokens.reserve(equation.size());
+
+    const char* const begin = equation.data();
+    const char* const end = begin + equation.size();
+    const char* p = begin;
+    int depth = 0;              // Open parentheses
+    bool expectOperand = true;  // At the start, or after an operator, a comma or '('
+
+    // The first character after p that is not whitespace, or '\0'
+    auto peek = [&](const char* from) {
+        while (from != end && isSpace(*from)) {
+            ++from;
+        }
+        return from != end ? *from : '\0';
+    };
 
-    // If last token is '(' => next '-' is unary
-    if (lastToken.type == PAREN && lastToken.value == "(")
-        return true;
+    while (p != end) {
+        const char c = *p;
+        const size_t position = static_cast<size_t>(p - begin);
 
-    // ALLOW chaining multiple unary minus:
-    // If the last token is FUNCTION and value=="neg", we are still in a
-    // context needing an operand, so another '-' is also unary.
-    if (lastToken.type == FUNCTION && lastToken.value == "neg")
-        return true;
+        if (isSpace(c)) {
+            ++p;
+        }
+        else if (isDigit(c)) {
+            // Numbers are digits with an optional fraction: \d+(\.\d+)?
+            const char* last = p;
+            while (last != end && isDigit(*last)) {
+                ++last;
+            }
+            if (last + 1 < end && *last == '.' && isDigit(last[1])) {
+                last += 2;
+                while (last != end && isDigit(*last)) {
+                    ++last;
+                }
+            }
+            NUMBER_TYPE value = 0;
+            auto [parsed, error] = std::from_chars(p, last, value);
+            if (error != std::errc()) {
+                throw SolverException("Syntax Error: Invalid number '" + std::string(p, last) + "' at position " + std::to_string(position));
+            }
+            p = last;
+            handleNumberToken(value, tokens, pool, peek(p));
+            expectOperand = false;
+        }
+        else if (isNameStart(c)) {
+            const char* last = p + 1;
+            while (last != end && isNameChar(*last)) {
+                ++last;
+            }
+            // A name followed by '(' is a function call
+            const TokenType type = peek(last) == '(' ? FUNCTION : VARIABLE;
+            tokens.push_back(pool.symbolToken(type, std::string_view(p, last - p)));
+            p = last;
+            expectOperand = false;
+        }
+        else if (c == '(') {
+            tokens.emplace_back(PAREN, TokenPool::LEFT_PAREN);
+            ++depth;
+            ++p;
+            expectOperand = true;
+        }
+        else if (c == ')') {
+            if (--depth < 0) {
+                throw SolverException(syntaxError("Unmatched closing parenthesis", std::string_view(p, 1), position));
+            }
+            tokens.emplace_back(PAREN, TokenPool::RIGHT_PAREN);
+            ++p;
+            expectOperand = false;
+        }
+        else if (c == ',') {
+            if (expectOperand) {
+                throw SolverException(syntaxError("Unexpected comma", std::string_view(p, 1), position));
+            }
+            tokens.emplace_back(SEPARATOR, TokenPool::COMMA);
+            ++p;
+            expectOperand = true;
+        }
+        else if (binaryOperator(c) != OperatorType::UNKNOWN) {
+            if (expectOperand && c == '-') {
+                // Unary minus (negation); chains of them are allowed
+                tokens.emplace_back(FUNCTION, TokenPool::NEG);
+            }
+            else if (expectOperand) {
+                throw SolverException(syntaxError("Unexpected operator", std::string_view(p, 1), position));
+            }
+            else {
+                tokens.push_back(TokenPool::operatorToken(binaryOperator(c)));
+            }
+            ++p;
+            expectOperand = true;
+        }
+        else {
+            throw SolverException(syntaxError("Unknown character", characterAt(p, end), position));
+        }
+    }
 
-    return false;
+    if (depth > 0) {
+        throw SolverException("Syntax Error: Mismatched parentheses. Missing closing parenthesis ')'.");
+    }
+    if (tokens.empty()) {
+        throw SolverException("Syntax Error: Empty expression.");
+    }
+    if (expectOperand) {
+        throw SolverException("Syntax Error: Expression cannot end with an operator.");
+    }
+    return tokens;
 }
 
+void Tokenizer::handleNumberToken(NUMBER_TYPE value, std::vector<Token>& tokens, TokenPool& pool, char next) {
+    // Handle negation case for numbers
+    if (!tokens.empty() && tokens.back().type == FUNCTION && tokens.back().id == TokenPool::NEG && next != '^') {
+        tokens.back() = pool.numberToken(-value);  // Merge negation into the number token (but -2^2 is -(2^2))
+    } else {
+        tokens.push_back(pool.numberToken(value));
+    }
+}
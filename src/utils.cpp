@@ -53,24 +53,41 @@ void Solver::registerBuiltInFunctions() {
         return std::min(args[0], args[1]);
     }, 2);
 
+    // Fused multiply-add: a * b + c with a single rounding
+    registerPredefinedFunction("fma", [](const std::vector<NUMBER_TYPE>& args) -> NUMBER_TYPE {
+        return std::fma(args[0], args[1], args[2]);
+    }, 3);
+
     // Add more predefined functions as needed
+
+    // Tag the built-ins so the compiler back ends can recognise them
+    static const std::pair<const char*, Builtin> builtins[] = {
+        {"neg", Builtin::NEG}, {"sin", Builtin::SIN}, {"cos", Builtin::COS}, {"tan", Builtin::TAN},
+        {"exp", Builtin::EXP}, {"ln", Builtin::LN}, {"log", Builtin::LOG}, {"sqrt", Builtin::SQRT},
+        {"abs", Builtin::ABS}, {"max", Builtin::MAX}, {"min", Builtin::MIN}, {"fma", Builtin::FMA}
+    };
+    for (const auto& [name, builtin] : builtins) {
+        functions.at(name).builtin = builtin;
+    }
 }
 
 
 // Semantic validation: Ensure all dependencies are defined
 void Solver::validateFunctionDependencies(const std::string& expression, const std::vector<std::string>& args) {
-    auto tokens = Tokenizer::tokenize(expression);
+    auto tokens = Tokenizer::tokenize(expression, tokenPool);
     for (const auto& token : tokens) {
         if (token.type == VARIABLE) {
             // Check if the variable is a function argument or a declared constant
-            if (std::find(args.begin(), args.end(), token.value) == args.end() && !symbolTable.isConstant(token.value)) {
-                throw SolverException("Variable '" + token.value + "' is not declared in the function scope or as a constant.");
+            const std::string& name = tokenPool.name(token.id);
+            if (std::find(args.begin(), args.end(), name) == args.end() && !symbolTable.isConstant(name)) {
+                throw SolverException("Variable '" + name + "' is not declared in the function scope or as a constant.");
             }
         }
         else if (token.type == FUNCTION) {
             // Ensure that the function being called is defined
-            if (functions.find(token.value) == functions.end()) {
-                throw SolverException("Function '" + token.value + "' is not defined.");
+            const std::string& name = tokenPool.name(token.id);
+            if (functions.find(name) == functions.end()) {
+                throw SolverException("Function '" + name + "' is not defined.");
             }
         }
     }
@@ -110,7 +127,7 @@ void Solver::printFunctionExpressions() {
 
         if (!function.isPredefined) {
             std::cout << "  Postfix Expression: ";
-            printPostfix(function.inlinedPostfix);
+            printPostfix(function.body->toPostfix(function.bodyRoot, tokenPool), tokenPool);
         } else {
             std::cout << "  Predefined Callback: Yes" << std::endl;
         }
@@ -136,14 +153,14 @@ NUMBER_TYPE Solver::evaluateAST(const std::string &expression, bool debug)
         }
     }
 
-    if (!currentAST) {
+    if (!currentAST || !currentAST->ast) {
         throw SolverException("Cannot evaluate AST pipeline: currentAST is null.");
     }
 
     // Evaluate the final AST
     NUMBER_TYPE result = 0.0;
     try {
-        result = AST::evaluateAST(currentAST, symbolTable, functions);
+        result = AST::evaluateAST(*currentAST->ast, symbolTable, functions);
     }
     catch (const SolverException &e) {
         throw; // or handle differently
@@ -153,55 +170,35 @@ NUMBER_TYPE Solver::evaluateAST(const std::string &expression, bool debug)
 }
 
 
-ASTNode* Solver::parseAST(const std::string& expression, bool debug) {
-    auto tokens   = Tokenizer::tokenize(expression);
-    auto postfix  = Postfix::shuntingYard(tokens);
-    auto flattened = Postfix::flattenPostfix(postfix, functions);
-    auto inlined = Simplification::replaceConstantSymbols(flattened, symbolTable);
-
-    ASTNode * root = AST::buildASTFromPostfix(inlined, functions);
-
-    ASTNode * simplified = Simplification::simplifyAST(root, functions);
-
-    if (debug) {
-        std::cout << "Flattened AST: ";
-        AST::printAST(root);
-        std::cout << "Simplified AST: ";
-        AST::printAST(simplified);
-    }
-
-
-    return simplified; 
-}
-
-
 void Solver::setCurrentExpressionAST(const std::string &expression, bool debug) {
-    if (expression == currentExpressionAST && currentAST != nullptr) {
+    if (!debug && expression == currentExpressionAST && currentAST) {
+        ++programStats.hits;
         return; // no need to rebuild
     }
 
-    // Store the expression
+    // On a parse error the previous AST stays current
+    currentAST = astFor(expression, debug);
     currentExpressionAST = expression;
+}
 
-    // If we had an old AST, free it
-    if (currentAST) {
-        delete currentAST;
-        currentAST = nullptr;
+std::shared_ptr<CachedProgram> Solver::astFor(const std::string& expression, bool debug) {
+    std::shared_ptr<CachedProgram>* cached = debug ? nullptr : programCache.get(expression);
+    if (cached && (*cached)->ast) {
+        ++programStats.hits;
+        return *cached;
     }
+    ++programStats.misses;
 
-    try {
-        // store it
-        currentAST = parseAST(expression, debug); // 'root' is no longer valid after the simplification returns the new root
+    // An entry built by the postfix pipeline gets its AST added; debug always starts afresh.
+    std::shared_ptr<CachedProgram> entry = cached ? *cached : std::make_shared<CachedProgram>();
+    parseInto(*entry, expression, debug);
+    entry->ast = AST::buildASTFromGraph(entry->graph, entry->root);
 
+    if (debug) {
+        std::cout << "AST: ";
+        AST::printAST(*entry->ast);
     }
-    catch (const SolverException &e) {
-        // If there's an error, ensure we don't leave a partial AST
-        if (currentAST) {
-            delete currentAST;
-            currentAST = nullptr;
-        }
-        // rethrow 
-        throw;
-    }
+    programStats.evictions += programCache.put(expression, entry, entry->byteSize());
+    return entry;
 }
 
@@ -4,6 +4,12 @@ import pytest
 import numpy as np
 from solver import Solver, SolverException
 
+@pytest.fixture(autouse=True)
+def cache_dir(tmp_path, monkeypatch):
+    # Keep compiled objects of the C engine out of the user's cache
+    monkeypatch.setenv("SOLVER_CACHE_DIR", str(tmp_path))
+    return tmp_path
+
 @pytest.fixture
 def solver_with_defaults():
     """
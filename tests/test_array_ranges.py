@@ -0,0 +1,64 @@
+# tests/test_array_ranges.py
+import pytest
+import math
+import numpy as np
+from solver import SolverException
+
+def test_array_range_returns_ndarray(solver_with_defaults):
+    values = np.linspace(0, 3, 101)
+    results = solver_with_defaults.evaluate_range("x", values, "h(x) - sin(x)")
+    assert isinstance(results, np.ndarray) and results.dtype == np.float64
+    assert results.tolist() == solver_with_defaults.evaluate_range("x", values.tolist(), "h(x) - sin(x)")
+
+def test_array_range_reads_float32_and_strided_inputs(solver_with_defaults):
+    values = np.linspace(-2, 2, 40)
+    expected = solver_with_defaults.evaluate_range("x", values[::3].tolist(), "x^3 + x")
+    assert solver_with_defaults.evaluate_range("x", values[::3], "x^3 + x").tolist() == expected
+    single = values.astype(np.float32)
+    expected = solver_with_defaults.evaluate_range("x", [float(v) for v in single], "x^3 + x")
+    assert solver_with_defaults.evaluate_range("x", single, "x^3 + x").tolist() == expected
+
+def test_integer_arrays_are_converted(solver_with_defaults):
+    results = solver_with_defaults.evaluate_range("x", np.arange(4), "x * 2")
+    assert results.tolist() == [0.0, 2.0, 4.0, 6.0]
+
+def test_range_writes_into_out(solver_with_defaults):
+    values = np.array([1.0, 2.0, 0.0, 4.0])
+    out = np.full(4, 7.0)
+    assert solver_with_defaults.evaluate_range("x", values, "1 / x", out=out) is out
+    assert out[[0, 1, 3]].tolist() == [1.0, 0.5, 0.25]
+    assert math.isnan(out[2])
+
+def test_range_writes_into_float32_and_strided_out(solver_with_defaults):
+    values = np.array([1.0, 2.0, 3.0])
+    out = np.zeros(6, dtype=np.float32)
+    solver_with_defaults.evaluate_range("x", values, "x / 3", out=out[::2])
+    assert out.tolist() == [np.float32(1 / 3), 0, np.float32(2 / 3), 0, 1, 0]
+
+def test_ranges_write_into_grid_out(solver_with_defaults):
+    xs = np.linspace(0, 1, 5)
+    ys = np.linspace(1, 2, 3)
+    out = np.empty((5, 3))
+    solver_with_defaults.evaluate_ranges(["x", "y"], [xs, ys], "g(x, y) * cos(y)", out=out)
+    expected = solver_with_defaults.evaluate_ranges(["x", "y"], [xs.tolist(), ys.tolist()], "g(x, y) * cos(y)")
+    assert out.ravel().tolist() == expected
+
+def test_ranges_accept_mixed_lists_and_arrays(solver_with_defaults):
+    results = solver_with_defaults.evaluate_ranges(["x", "y"], [[1.0, 2.0], np.array([10.0, 20.0])], "x * 100 + y")
+    assert isinstance(results, np.ndarray)
+    assert results.tolist() == [110.0, 120.0, 210.0, 220.0]
+
+def test_out_of_wrong_size_raises(solver_with_defaults):
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate_range("x", np.zeros(3), "x + 1", out=np.zeros(4))
+
+def test_non_contiguous_grid_out_raises(solver_with_defaults):
+    out = np.zeros((3, 2)).T
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate_ranges(["x", "y"], [np.zeros(2), np.zeros(3)], "x + y", out=out)
+
+def test_read_only_out_raises(solver_with_defaults):
+    out = np.zeros(2)
+    out.flags.writeable = False
+    with pytest.raises((BufferError, ValueError)):
+        solver_with_defaults.evaluate_range("x", np.zeros(2), "x + 1", out=out)
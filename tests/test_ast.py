@@ -0,0 +1,34 @@
+# tests/test_ast.py
+import pytest
+from solver import SolverException
+
+EXPRESSIONS = [
+    "3.25 * x - y / 4",
+    "x ^ 2 + 2 * x * y + y ^ 2",
+    "sin(x) * cos(y) + sqrt(x * x + 1)",
+    "max(x, y) - min(x, y) + abs(y)",
+    "f(x) + g(x, y) * h(y)",
+    "p(x, y) / (1 + k(x) * k(x))",
+    "circle_area(x) - pi * x ^ 2",
+    "0.001 * x + 250.0 / y",
+]
+
+@pytest.mark.parametrize("expression", EXPRESSIONS)
+def test_ast_matches_program(solver_with_defaults, expression):
+    for x, y in [(1.5, -2.0), (0.25, 3.0), (-4.0, 0.5)]:
+        solver_with_defaults.declare_variable("x", x)
+        solver_with_defaults.declare_variable("y", y)
+        expected = solver_with_defaults.evaluate(expression)
+        assert solver_with_defaults.evaluate_ast(expression) == pytest.approx(expected, rel=1e-12)
+
+def test_ast_numbers_are_binary(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 0.1)
+    assert solver_with_defaults.evaluate_ast("x * 0.3 + 0.7") == pytest.approx(0.1 * 0.3 + 0.7, rel=1e-15)
+    assert solver_with_defaults.evaluate_ast("123456789.125 + x") == 123456789.225
+
+def test_ast_errors(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 0)
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate_ast("f(x) / x")
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate_ast("undefined_variable + 1")
@@ -0,0 +1,72 @@
+# tests/test_compiled_expression.py
+import pytest
+import math
+import numpy as np
+from concurrent.futures import ThreadPoolExecutor
+from solver import Solver, SolverException
+
+def test_compiled_matches_evaluate(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 1.5)
+    solver_with_defaults.declare_variable("y", -0.25)
+    compiled = solver_with_defaults.compile("f(x) * y + sin(pi * x)")
+    assert compiled.expression == "f(x) * y + sin(pi * x)"
+    assert sorted(compiled.variables) == ["x", "y"]
+    values = {"x": 1.5, "y": -0.25}
+    expected = solver_with_defaults.evaluate("f(x) * y + sin(pi * x)")
+    assert compiled.evaluate(values) == expected
+    assert compiled.evaluate([values[name] for name in compiled.variables]) == expected
+
+def test_compiled_takes_caller_values(solver_with_defaults):
+    compiled = solver_with_defaults.compile("x^2 + 2*x + 1")
+    assert compiled.variables == ["x"]
+    assert [compiled.evaluate([x]) for x in (0, 1, 2)] == [1, 4, 9]
+    assert compiled.evaluate({"x": 3, "unused": 7}) == 16
+
+def test_compiled_without_variables(solver_with_defaults):
+    compiled = solver_with_defaults.compile("2 * pi")
+    assert compiled.variables == []
+    assert compiled.evaluate() == pytest.approx(2 * math.pi)
+
+def test_compiled_reports_missing_values(solver_with_defaults):
+    compiled = solver_with_defaults.compile("x + y")
+    with pytest.raises(SolverException):
+        compiled.evaluate([1.0])
+    with pytest.raises(SolverException):
+        compiled.evaluate({"x": 1.0})
+    with pytest.raises(SolverException):
+        solver_with_defaults.compile("1 / x").evaluate([0.0])
+
+def test_compiled_outlives_declarations_and_solver():
+    solver = Solver()
+    solver.declare_constant("c", 2)
+    solver.declare_function("f", ["x"], "c * x")
+    compiled = solver.compile("f(x) + 1")
+    solver.declare_variable("x", 100)
+    del solver
+    assert compiled.evaluate([3]) == 7
+
+def test_alternating_compiled_expressions(solver_with_defaults):
+    first = solver_with_defaults.compile("x * 2")
+    second = solver_with_defaults.compile("x + 10")
+    for x in range(5):
+        assert first.evaluate([x]) == 2 * x
+        assert second.evaluate([x]) == x + 10
+        assert solver_with_defaults.evaluate_range("x", [x], "x - 1") == [x - 1]
+
+@pytest.mark.parametrize("engine", ["interpreter", "jit", "c", "batch"])
+def test_compiled_engines_and_precisions(solver_with_defaults, engine):
+    expression = "exp(-x) * cos(y) + x / (y + 3)"
+    solver_with_defaults.declare_variable("x", 0.3)
+    solver_with_defaults.declare_variable("y", 1.7)
+    for precision in ("float", "double", "long double"):
+        compiled = solver_with_defaults.compile(expression, engine=engine, precision=precision)
+        assert compiled.engine == engine and compiled.precision == precision
+        assert compiled.evaluate({"x": 0.3, "y": 1.7}) == solver_with_defaults.evaluate(expression, precision=precision)
+
+def test_compiled_is_thread_safe(solver_with_defaults):
+    compiled = solver_with_defaults.compile("sin(x) * x + g(x, 2)", engine="jit")
+    inputs = np.linspace(-5, 5, 2000).tolist()
+    expected = [compiled.evaluate([x]) for x in inputs]
+    with ThreadPoolExecutor(max_workers=8) as pool:
+        results = list(pool.map(lambda x: compiled.evaluate([x]), inputs))
+    assert results == expected
@@ -0,0 +1,42 @@
+# tests/test_cse.py
+import pytest
+import math
+from solver import SolverException
+
+def f(x): return x**2 + 2*x + 1
+def g(x, y): return x * y + x + y
+def h(x): return f(g(x, x))
+def k(x): return f(x) + g(x, x)
+def m(x, y): return h(x) + f(g(x, y))
+def p(x, y): return m(x, y) + k(x)
+
+def test_inlined_argument_is_computed_once(solver_with_defaults):
+    nested = solver_with_defaults.compile("h(x)").instruction_count
+    outer = solver_with_defaults.compile("f(t)").instruction_count
+    inner = solver_with_defaults.compile("g(x, x)").instruction_count
+    assert nested == outer + inner
+    assert solver_with_defaults.compile("(x + 1) * (x + 1)").instruction_count == 2
+
+@pytest.mark.parametrize("engine", ["interpreter", "jit", "c", "batch"])
+def test_shared_subexpressions_across_engines(solver_with_defaults, engine):
+    solver_with_defaults.set_engine(engine)
+    solver_with_defaults.declare_variable("x", 1.25)
+    solver_with_defaults.declare_variable("y", -0.5)
+    for expression, expected in [("h(x)", h(1.25)), ("m(x, y)", m(1.25, -0.5)), ("p(x, y) / k(y)", p(1.25, -0.5) / k(-0.5))]:
+        assert solver_with_defaults.evaluate(expression) == pytest.approx(expected, rel=1e-12)
+        assert solver_with_defaults.evaluate_ast(expression) == pytest.approx(expected, rel=1e-12)
+
+def test_shared_subexpressions_in_ranges(solver_with_defaults):
+    xs = [0.5 * i for i in range(-4, 5)]
+    ys = [1.0, 2.0, 3.0]
+    results = solver_with_defaults.evaluate_ranges(["x", "y"], [xs, ys], "p(x, y) + sin(g(x, y)) * sin(g(x, y))")
+    # The last dimension varies fastest
+    expected = [p(x, y) + math.sin(g(x, y)) ** 2 for x in xs for y in ys]
+    assert results == pytest.approx(expected, rel=1e-12)
+
+def test_shared_subexpression_errors(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 0)
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate("1 / x + 1 / x")
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate_ast("1 / x + 1 / x")
@@ -0,0 +1,115 @@
+# tests/test_engines.py
+import pytest
+import math
+from solver import SolverException
+
+EXPRESSIONS = [
+    "2 + 2",
+    "f(10)",
+    "g(5, 5)",
+    "h(2)",
+    "x - y / 3",
+    "-x^2 + y",
+    "2^x - 3^-y",
+    "sin(x) * cos(y) + tan(0.5)",
+    "exp(x / 10) - ln(y)",
+    "log(y, 2) + sqrt(x) + abs(-y)",
+    "max(x, y) - min(x, y)",
+    "p(x, y) / k(y)",
+]
+
+@pytest.fixture
+def solver(solver_with_defaults):
+    solver_with_defaults.use_cache(False)
+    solver_with_defaults.declare_variable("x", 1.75)
+    solver_with_defaults.declare_variable("y", 3.5)
+    return solver_with_defaults
+
+@pytest.mark.parametrize("engine", ["jit", "c"])
+@pytest.mark.parametrize("expression", EXPRESSIONS)
+def test_native_matches_interpreter(solver, expression, engine):
+    expected = solver.evaluate(expression, engine="interpreter")
+    assert solver.evaluate(expression, engine=engine) == expected
+
+def test_default_engine_is_interpreter(solver):
+    assert solver.get_engine() == "interpreter"
+    solver.set_engine("jit")
+    assert solver.get_engine() == "jit"
+    assert solver.evaluate("x * y") == pytest.approx(1.75 * 3.5)
+
+def test_jit_sees_updated_variables(solver):
+    assert solver.evaluate("x + 1", engine="jit") == pytest.approx(2.75)
+    solver.declare_variable("x", 10)
+    assert solver.evaluate("x + 1", engine="jit") == pytest.approx(11)
+
+@pytest.mark.parametrize("engine", ["jit", "c"])
+def test_native_division_by_zero(solver, engine):
+    with pytest.raises(SolverException, match="Division by zero"):
+        solver.evaluate("x / (y - y)", engine=engine)
+
+@pytest.mark.parametrize("engine", ["jit", "c"])
+def test_native_ranges(solver, engine):
+    solver.set_engine(engine)
+    values = [0.0, 0.5, 1.0, 2.0]
+    results = solver.evaluate_range("x", values, "1 / x + f(x)")
+    assert math.isnan(results[0])
+    for x, r in zip(values[1:], results[1:]):
+        assert r == pytest.approx(1 / x + x**2 + 2*x + 1)
+
+def test_unknown_engine(solver):
+    with pytest.raises(SolverException):
+        solver.evaluate("1 + 1", engine="gpu")
+    with pytest.raises(SolverException):
+        solver.set_engine("gpu")
+
+def test_c_engine_reuses_cached_objects(solver, cache_dir):
+    solver.evaluate("x * y + 7", engine="c")
+    objects = sorted(p.name for p in cache_dir.glob("*.so"))
+    assert len(objects) == 1
+
+    # A fresh solver (e.g. a restarted process) finds the object instead of compiling again
+    other = type(solver)()
+    other.declare_variable("x", 2)
+    other.declare_variable("y", 3)
+    before = objects[0]
+    mtime = (cache_dir / before).stat().st_mtime_ns
+    assert other.evaluate("x * y + 7", engine="c") == 13
+    assert sorted(p.name for p in cache_dir.glob("*.so")) == objects
+    assert (cache_dir / before).stat().st_mtime_ns == mtime
+
+@pytest.mark.parametrize("lanes", [1, 7, 256, 1024])
+@pytest.mark.parametrize("expression", EXPRESSIONS)
+def test_batch_range_matches_interpreter(solver, expression, lanes):
+    values = [i * 0.37 - 20 for i in range(300)]
+    expected = solver.evaluate_range("x", values, expression)
+    solver.set_engine("batch")
+    solver.set_batch_size(lanes)
+    results = solver.evaluate_range("x", values, expression)
+    assert len(results) == len(expected)
+    for r, e in zip(results, expected):
+        assert r == e or (math.isnan(r) and math.isnan(e))
+
+def test_batch_ranges_match_interpreter(solver):
+    xs = [0.0, 1.0, 2.5, -3.0]
+    ys = [i * 0.5 for i in range(100)]
+    expression = "x / y + sin(x * y) - log(y + 2, 3)"
+    expected = solver.evaluate_ranges(["x", "y"], [xs, ys], expression)
+    solver.set_engine("batch")
+    solver.set_batch_size(64)
+    results = solver.evaluate_ranges(["x", "y"], [xs, ys], expression)
+    for r, e in zip(results, expected):
+        assert r == e or (math.isnan(r) and math.isnan(e))
+
+def test_batch_reports_failed_lanes(solver, capfd):
+    solver.set_engine("batch")
+    solver.set_batch_size(4)
+    results = solver.evaluate_range("x", [1.0, 0.0, 2.0, 4.0, 0.0, 8.0], "1 / x")
+    assert [math.isnan(r) for r in results] == [False, True, False, False, True, False]
+    assert results[5] == pytest.approx(0.125)
+    errors = capfd.readouterr().err.splitlines()
+    assert len(errors) == 2 and all("Division by zero" in line for line in errors)
+
+def test_batch_size_must_be_positive(solver):
+    assert solver.get_batch_size() == 256
+    with pytest.raises(SolverException):
+        solver.set_batch_size(0)
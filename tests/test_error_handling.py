@@ -1,5 +1,6 @@
 # tests/test_error_handling.py
 import pytest
+import re
 from solver import SolverException
 
 def test_division_by_zero(solver_with_defaults):
@@ -23,3 +24,28 @@ def test_undefined_variable_in_function(solver_with_defaults):
     solver_with_defaults.declare_function("n", ["x"], "x + z")
     with pytest.raises(SolverException):
         solver_with_defaults.evaluate("n(5)")
+
+@pytest.mark.parametrize("expression, message", [
+    ("2 + $", "Unknown character '$' at position 4"),
+    ("1 + 2)", "Unmatched closing parenthesis ')' at position 5"),
+    ("2 * * 3", "Unexpected operator '*' at position 4"),
+    ("max(1, , 2)", "Unexpected comma ',' at position 7"),
+    (".5 + 1", "Unknown character '.' at position 0"),
+    ("é + 1", "Unknown character 'é' at position 0"),
+    ("x²", "Unknown character '²' at position 1"),
+    ("2 + \x01", "Unknown character '\\x01' at position 4"),
+    ("(1 + 2", "Missing closing parenthesis"),
+    ("2 +", "cannot end with an operator"),
+])
+def test_syntax_errors_report_positions(solver_with_defaults, expression, message):
+    with pytest.raises(SolverException, match=re.escape(message)):
+        solver_with_defaults.evaluate(expression)
+    with pytest.raises(SolverException, match=re.escape(message)):
+        solver_with_defaults.declare_function("bad", ["x"], expression)
+
+def test_lexer_accepts_what_the_parser_handles(solver_with_defaults):
+    solver_with_defaults.declare_variable("x_1", 3)
+    assert solver_with_defaults.evaluate("x_1*2.50-  -1") == 8.5
+    assert solver_with_defaults.evaluate("-2^2") == -4
+    solver_with_defaults.declare_function("negate", ["x"], "-x")
+    assert solver_with_defaults.evaluate("negate(x_1)") == -3
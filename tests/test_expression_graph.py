@@ -0,0 +1,43 @@
+# tests/test_expression_graph.py
+import pytest
+import time
+from solver import Solver
+
+DEPTH = 40
+
+@pytest.fixture
+def nested():
+    # d{n}(x) expands to 2^n copies of x, but is one new node per level as a graph
+    solver = Solver()
+    solver.declare_function("d0", ["x"], "x * 3 - 1")
+    for n in range(1, DEPTH + 1):
+        solver.declare_function(f"d{n}", ["x"], f"(d{n - 1}(x) + d{n - 1}(x)) / 2")
+    solver.declare_variable("x", 2)
+    return solver
+
+def test_nested_functions_stay_linear(nested):
+    start = time.perf_counter()
+    assert nested.evaluate(f"d{DEPTH}(x)") == 5
+    assert nested.evaluate_ast(f"d{DEPTH}(x)") == 5
+    assert time.perf_counter() - start < 5
+    assert nested.compile(f"d{DEPTH}(x)").instruction_count == 2 + 2 * DEPTH
+    # Memory grows with the depth, not with the expanded expression
+    assert nested.get_program_cache_stats()["bytes"] < 1_000_000
+
+def test_nested_functions_in_ranges(nested):
+    xs = [0.5 * i for i in range(8)]
+    expected = [x * 3 - 1 for x in xs]
+    assert nested.evaluate_range("x", xs, f"d{DEPTH}(x)") == pytest.approx(expected)
+
+def test_repeated_subexpressions_share_instructions(solver_with_defaults):
+    assert solver_with_defaults.compile("sin(x) + sin(x)").instruction_count == 2
+    assert solver_with_defaults.compile("sin(x) + sin(y)").instruction_count == 3
+    assert solver_with_defaults.compile("x * 2 + x * 2").instruction_count == 2
+
+def test_function_bodies_bind_at_declaration(solver_with_defaults):
+    solver_with_defaults.declare_function("inner", ["t"], "t + 1")
+    solver_with_defaults.declare_function("outer", ["t"], "inner(t) * inner(t)")
+    solver_with_defaults.declare_function("inner", ["t"], "t + 100")
+    assert solver_with_defaults.evaluate("outer(2)") == 9
+    assert solver_with_defaults.evaluate_ast("outer(2)") == 9
+    assert solver_with_defaults.evaluate("inner(2)") == 102
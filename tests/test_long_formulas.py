@@ -0,0 +1,42 @@
+# tests/test_long_formulas.py
+import pytest
+import time
+
+N = 400
+
+@pytest.fixture
+def many(solver_with_defaults):
+    for i in range(N):
+        solver_with_defaults.declare_variable(f"v{i}", i * 0.25)
+    return solver_with_defaults
+
+def test_long_sum_of_names_and_literals(many):
+    expression = " + ".join(f"v{i} * {i % 7}.5 - -{i % 3}" for i in range(N))
+    expected = sum(i * 0.25 * (i % 7 + 0.5) + i % 3 for i in range(N))
+    start = time.perf_counter()
+    assert many.evaluate(expression) == pytest.approx(expected, rel=1e-12)
+    assert many.evaluate_ast(expression) == pytest.approx(expected, rel=1e-12)
+    assert time.perf_counter() - start < 5
+
+def test_deeply_nested_calls(many):
+    expression = "v1"
+    for i in range(60):
+        expression = f"max(-({expression}), f(v{i % 5}) - {i})"
+    value = 0.25
+    for i in range(60):
+        value = max(-value, ((i % 5) * 0.25 + 1) ** 2 - i)
+    assert many.evaluate(expression) == pytest.approx(value, rel=1e-12)
+
+def test_names_sharing_text_with_functions(many):
+    # A variable may be named like a function; the following "(" decides which one is meant
+    many.declare_variable("sin", 2)
+    assert many.evaluate("sin(sin) * sin") == pytest.approx(2 * 0.9092974268256817, rel=1e-12)
+
+def test_simplifying_a_long_formula_is_linear(many):
+    # Every term has identities to remove and constants to fold, so most of the sum is rebuilt
+    terms = 20_000
+    expression = " + ".join(f"(v{i % N} - 0) * (3 - 2) + 0 * v{i % N} + max(2 * 3, {i % 5})" for i in range(terms))
+    expected = sum(i % N * 0.25 + 6 for i in range(terms))
+    start = time.perf_counter()
+    assert many.evaluate(expression) == pytest.approx(expected, rel=1e-12)
+    assert time.perf_counter() - start < 5
@@ -0,0 +1,83 @@
+# tests/test_precision.py
+import pytest
+import numpy as np
+from solver import SolverException
+
+ENGINES = ["interpreter", "jit", "c", "batch"]
+
+def test_precision_defaults_to_build_precision(solver_with_defaults):
+    assert solver_with_defaults.get_precision() in ("double", "long double")
+    solver_with_defaults.set_precision("float")
+    assert solver_with_defaults.get_precision() == "float"
+
+def test_unknown_precision_raises(solver_with_defaults):
+    with pytest.raises(SolverException):
+        solver_with_defaults.set_precision("half")
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate("1 + 1", precision="quad")
+
+@pytest.mark.parametrize("engine", ENGINES)
+def test_double_precision_matches_float64_arithmetic(solver_with_defaults, engine):
+    solver_with_defaults.set_engine(engine)
+    solver_with_defaults.declare_variable("x", 0.1)
+    solver_with_defaults.declare_variable("y", 0.7)
+    x, y = np.float64(0.1), np.float64(0.7)
+    assert solver_with_defaults.evaluate("x * 3 + y / 7", precision="double") == x * 3 + y / 7
+    assert solver_with_defaults.evaluate("(x - y) * (x + y)", precision="double") == (x - y) * (x + y)
+
+@pytest.mark.parametrize("engine", ENGINES)
+def test_float_precision_matches_float32_arithmetic(solver_with_defaults, engine):
+    solver_with_defaults.set_engine(engine)
+    solver_with_defaults.set_precision("float")
+    solver_with_defaults.declare_variable("x", 0.1)
+    solver_with_defaults.declare_variable("y", 0.7)
+    x, y = np.float32(0.1), np.float32(0.7)
+    assert solver_with_defaults.evaluate("x * 3 + y / 7") == x * np.float32(3) + y / np.float32(7)
+    assert solver_with_defaults.evaluate("(x - y) * (x + y)") == (x - y) * (x + y)
+
+def test_results_are_cached_per_precision(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 0.1)
+    wide = solver_with_defaults.evaluate("x / 3")
+    single = solver_with_defaults.evaluate("x / 3", precision="float")
+    assert single == np.float32(0.1) / np.float32(3)
+    assert single != wide
+    assert solver_with_defaults.evaluate("x / 3") == wide
+
+@pytest.mark.parametrize("engine", ENGINES)
+def test_repeated_evaluations_across_precisions(solver_with_defaults, engine):
+    # The register file of each precision is reused, whatever program ran in it last
+    solver_with_defaults.use_cache(False)
+    solver_with_defaults.set_engine(engine)
+    solver_with_defaults.declare_variable("y", 0.7)
+    small, large = "x * 3", "(x - y) * (x + y) + x / 7 - y * 5"
+    for value in [0.1, 0.3, 0.9]:
+        solver_with_defaults.declare_variable("x", value)
+        x, y = np.float64(value), np.float64(0.7)
+        for expression in [large, small, large]:
+            expected = eval(expression)
+            assert solver_with_defaults.evaluate(expression, precision="double") == expected
+            assert solver_with_defaults.evaluate(expression, precision="float") == np.float32(
+                eval(expression, {"x": np.float32(x), "y": np.float32(y)}))
+
+@pytest.mark.parametrize("precision", ["float", "double", "long double"])
+def test_engines_agree_in_each_precision(solver_with_defaults, precision):
+    xs = np.linspace(-2, 2, 37)
+    ys = np.linspace(0.5, 3, 29)
+    expression = "sin(x) * exp(-y) + f(x) / y - max(x, y)^2"
+    reference = solver_with_defaults.evaluate_ranges(["x", "y"], [xs, ys], expression, precision=precision)
+    for engine in ENGINES[1:]:
+        solver_with_defaults.set_engine(engine)
+        results = solver_with_defaults.evaluate_ranges(["x", "y"], [xs, ys], expression, precision=precision)
+        assert results.tolist() == reference.tolist()
+
+def test_float_range_matches_float32_arithmetic(solver_with_defaults):
+    values = np.linspace(-1, 1, 101, dtype=np.float32)
+    out = np.zeros(101, dtype=np.float32)
+    solver_with_defaults.evaluate_range("x", values, "x * x - x / 3", out=out, precision="float")
+    assert out.tolist() == (values * values - values / np.float32(3)).tolist()
+
+def test_precision_rounds_builtins_once(solver_with_defaults):
+    values = np.linspace(0.1, 3, 50, dtype=np.float32)
+    wide = solver_with_defaults.evaluate_range("x", values, "sin(x)")
+    single = solver_with_defaults.evaluate_range("x", values, "sin(x)", precision="float")
+    assert single.tolist() == wide.astype(np.float32).tolist()
@@ -0,0 +1,91 @@
+# tests/test_program_cache.py
+import pytest
+from solver import Solver, SolverException
+
+def test_alternating_expressions_hit_the_cache(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 2)
+    start = solver_with_defaults.get_program_cache_stats()
+    for _ in range(10):
+        assert solver_with_defaults.evaluate("x^2 + 1") == 5
+        assert solver_with_defaults.evaluate("f(x) * 3") == 27
+    stats = solver_with_defaults.get_program_cache_stats()
+    assert stats["misses"] - start["misses"] == 2
+    assert stats["hits"] - start["hits"] == 18
+    assert stats["entries"] >= 2 and stats["bytes"] > 0
+
+def test_cache_is_bounded_in_entries(solver_with_defaults):
+    solver_with_defaults.set_program_cache_size(3)
+    solver_with_defaults.declare_variable("x", 1)
+    for k in range(10):
+        assert solver_with_defaults.evaluate(f"x + {k}") == 1 + k
+    stats = solver_with_defaults.get_program_cache_stats()
+    assert stats["entries"] == 3
+    assert stats["evictions"] >= 7
+    misses = stats["misses"]
+    solver_with_defaults.evaluate("x + 0")
+    assert solver_with_defaults.get_program_cache_stats()["misses"] == misses + 1
+
+def test_cache_is_bounded_in_bytes(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 1)
+    solver_with_defaults.evaluate("x + 1")
+    one = solver_with_defaults.get_program_cache_stats()["bytes"]
+    solver_with_defaults.clear_cache()
+    solver_with_defaults.set_program_cache_size(100, 3 * one)
+    for k in range(10):
+        solver_with_defaults.evaluate(f"x + {k}")
+    stats = solver_with_defaults.get_program_cache_stats()
+    assert 1 <= stats["entries"] <= 3
+    assert stats["bytes"] <= 3 * one
+
+def test_disabled_cache_still_evaluates(solver_with_defaults):
+    solver_with_defaults.set_program_cache_size(0)
+    solver_with_defaults.declare_variable("x", 3)
+    assert solver_with_defaults.evaluate("x * 2") == 6
+    assert solver_with_defaults.evaluate("x * 3") == 9
+    assert solver_with_defaults.evaluate("x * 2") == 6
+    assert solver_with_defaults.get_program_cache_stats()["entries"] == 0
+
+def test_declaring_a_constant_invalidates_dependent_programs():
+    solver = Solver()
+    solver.declare_variable("x", 2)
+    with pytest.raises(SolverException):
+        solver.evaluate("x * c")
+    assert solver.evaluate("x + 1") == 3
+    before = solver.get_program_cache_stats()
+    solver.declare_constant("c", 5)
+    assert solver.get_program_cache_stats()["invalidations"] == before["invalidations"] + 1
+    assert solver.evaluate("x * c") == 10
+    assert solver.evaluate("x + 1") == 3
+    assert solver.get_program_cache_stats()["hits"] == before["hits"] + 1
+
+def test_redeclaring_a_function_invalidates_dependent_programs(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 2)
+    solver_with_defaults.declare_function("p", ["t"], "t + 1")
+    assert solver_with_defaults.evaluate("p(x) * 2") == 6
+    assert solver_with_defaults.evaluate("x - 1") == 1
+    before = solver_with_defaults.get_program_cache_stats()
+    solver_with_defaults.declare_function("p", ["t"], "t * 10")
+    stats = solver_with_defaults.get_program_cache_stats()
+    assert stats["invalidations"] == before["invalidations"] + 1
+    assert solver_with_defaults.evaluate("p(x) * 2") == 40
+    assert solver_with_defaults.evaluate("x - 1") == 1
+    assert solver_with_defaults.evaluate_ast("p(x) * 2") == 40
+
+def test_ast_pipeline_uses_the_cache(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 3)
+    start = solver_with_defaults.get_program_cache_stats()
+    for _ in range(5):
+        assert solver_with_defaults.evaluate_ast("x * x") == 9
+        assert solver_with_defaults.evaluate_ast("x + x") == 6
+    stats = solver_with_defaults.get_program_cache_stats()
+    assert stats["misses"] - start["misses"] == 2
+    assert stats["hits"] - start["hits"] == 8
+
+def test_clear_cache_reparses(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 1)
+    solver_with_defaults.evaluate("x + 2")
+    solver_with_defaults.clear_cache()
+    assert solver_with_defaults.get_program_cache_stats()["entries"] == 0
+    misses = solver_with_defaults.get_program_cache_stats()["misses"]
+    assert solver_with_defaults.evaluate("x + 2") == 3
+    assert solver_with_defaults.get_program_cache_stats()["misses"] == misses + 1
@@ -0,0 +1,155 @@
+# tests/test_ranges.py
+import concurrent.futures
+import pytest
+import math
+import numpy as np
+
+def test_range_matches_scalar_evaluation(solver_with_defaults):
+    values = [0.0, 0.5, 1.0, 2.0, 3.5]
+    results = solver_with_defaults.evaluate_range("x", values, "x^2 + 2*x + 1")
+    assert len(results) == len(values)
+    for x, r in zip(values, results):
+        assert math.isclose(r, x**2 + 2*x + 1, rel_tol=1e-12)
+
+def test_range_with_user_function(solver_with_defaults):
+    values = [1.0, 2.0, 3.0]
+    results = solver_with_defaults.evaluate_range("x", values, "h(x) + sin(0)")
+    for x, r in zip(values, results):
+        g = x * x + x + x
+        assert math.isclose(r, g**2 + 2*g + 1, rel_tol=1e-12)
+
+def test_range_uses_declared_variables(solver_with_defaults):
+    solver_with_defaults.declare_variable("y", 10)
+    results = solver_with_defaults.evaluate_range("x", [1.0, 2.0], "x * y")
+    assert results == pytest.approx([10.0, 20.0])
+
+def test_range_variable_not_in_expression(solver_with_defaults):
+    results = solver_with_defaults.evaluate_range("x", [1.0, 2.0, 3.0], "2 + 3")
+    assert results == pytest.approx([5.0, 5.0, 5.0])
+
+def test_range_division_by_zero_gives_nan(solver_with_defaults):
+    results = solver_with_defaults.evaluate_range("x", [0.0, 2.0], "1 / x")
+    assert math.isnan(results[0])
+    assert math.isclose(results[1], 0.5)
+
+def test_ranges_cartesian_product_order(solver_with_defaults):
+    xs = [1.0, 2.0]
+    ys = [10.0, 20.0, 30.0]
+    results = solver_with_defaults.evaluate_ranges(["x", "y"], [xs, ys], "x * 100 + y")
+    # Last variable varies fastest
+    expected = [x * 100 + y for x in xs for y in ys]
+    assert results == pytest.approx(expected)
+
+def test_ranges_mismatched_lengths(solver_with_defaults):
+    from solver import SolverException
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate_ranges(["x", "y"], [[1.0]], "x + y")
+
+@pytest.mark.parametrize("engine", ["interpreter", "jit", "batch"])
+@pytest.mark.parametrize("threads", [2, 3, 8])
+def test_threaded_ranges_are_bit_identical(solver_with_defaults, engine, threads):
+    solver_with_defaults.set_engine(engine)
+    xs = [i * 0.01 for i in range(100)]
+    ys = [i * 0.37 - 5 for i in range(50)]
+    expression = "h(x) / y + sin(x * y)"
+    serial = solver_with_defaults.evaluate_ranges(["x", "y"], [xs, ys], expression, threads=1)
+    parallel = solver_with_defaults.evaluate_ranges(["x", "y"], [xs, ys], expression, threads=threads)
+    assert len(parallel) == len(serial)
+    for p, s in zip(parallel, serial):
+        assert p == s or (math.isnan(p) and math.isnan(s))
+
+def test_threaded_range_reports_errors_in_order(solver_with_defaults, capfd):
+    values = [float(i % 1000) for i in range(5000)]
+    results = solver_with_defaults.evaluate_range("x", values, "1 / x", threads=4)
+    assert [i for i, r in enumerate(results) if math.isnan(r)] == [0, 1000, 2000, 3000, 4000]
+    errors = capfd.readouterr().err.splitlines()
+    assert len(errors) == 5 and all("x = 0" in line for line in errors)
+
+def test_threaded_range_matches_serial(solver_with_defaults):
+    values = [i * 0.001 for i in range(20000)]
+    serial = solver_with_defaults.evaluate_range("x", values, "f(x) - exp(x)", threads=1)
+    assert solver_with_defaults.evaluate_range("x", values, "f(x) - exp(x)", threads=0) == serial
+    assert solver_with_defaults.evaluate_range("x", values, "f(x) - exp(x)", threads=7) == serial
+
+@pytest.mark.parametrize("engine", ["interpreter", "jit", "batch"])
+def test_hoisted_ranges_match_scalar_evaluation(solver_with_defaults, engine):
+    solver_with_defaults.use_cache(False)
+    solver_with_defaults.set_engine(engine)
+    xs = [i * 0.3 - 1 for i in range(7)]
+    ys = [i * 0.25 + 0.5 for i in range(5)]
+    zs = [i * 1.5 for i in range(4)]
+    # Terms over {x}, {y}, {x, y} and {z} are hoisted; only the final combination runs per point.
+    expression = "sin(x) * exp(y) + h(x) / (z + 2) - log(y, 2) * z^2 + max(x, y) * cos(x * y)"
+    results = solver_with_defaults.evaluate_ranges(["x", "y", "z"], [xs, ys, zs], expression)
+    expected = []
+    for x in xs:
+        for y in ys:
+            for z in zs:
+                solver_with_defaults.declare_variable("x", x)
+                solver_with_defaults.declare_variable("y", y)
+                solver_with_defaults.declare_variable("z", z)
+                expected.append(solver_with_defaults.evaluate(expression))
+    assert results == expected
+
+def test_hoisted_failure_reports_every_point(solver_with_defaults, capfd):
+    # 1 / y only depends on y, and fails for y = 0: every point with y = 0 is reported.
+    results = solver_with_defaults.evaluate_ranges(["x", "y"], [[1.0, 2.0, 3.0], [0.0, 1.0, 2.0]], "sin(x) + 1 / y")
+    assert [i for i, r in enumerate(results) if math.isnan(r)] == [0, 3, 6]
+    assert results[1] == math.sin(1.0) + 1.0
+    errors = capfd.readouterr().err.splitlines()
+    assert len(errors) == 3 and all("Division by zero" in line for line in errors)
+
+def test_hoisted_invariants_follow_declared_variables(solver_with_defaults):
+    solver_with_defaults.use_cache(False)
+    values = [0.5, 1.0, 1.5, 2.0]
+    solver_with_defaults.declare_variable("y", 1)
+    first = solver_with_defaults.evaluate_range("x", values, "x * exp(y) + sin(y)")
+    solver_with_defaults.declare_variable("y", 2)
+    second = solver_with_defaults.evaluate_range("x", values, "x * exp(y) + sin(y)")
+    assert first == pytest.approx([x * math.exp(1) + math.sin(1) for x in values])
+    assert second == pytest.approx([x * math.exp(2) + math.sin(2) for x in values])
+
+def test_hoisted_native_code_follows_the_sweep(solver_with_defaults):
+    # The residual native code is reused across sweeps; sweeps hoisting differently get their own.
+    expression = "sin(x) * exp(y) + x * y"
+    sweeps = [(["x", "y"], [[0.5, 1.0, 1.5], [2.0, 3.0]]),
+              (["y", "x"], [[2.0, 3.0], [0.5, 1.0, 1.5]]),
+              (["x", "y"], [[0.5, 1.0, 1.5], [2.0, 3.0]]),
+              (["x", "y"], [[0.5], [2.0, 3.0, 4.0, 5.0]])]
+    solver_with_defaults.declare_variable("y", 0)
+    expected = [solver_with_defaults.evaluate_ranges(names, values, expression) for names, values in sweeps]
+    solver_with_defaults.set_engine("jit")
+    assert [solver_with_defaults.evaluate_ranges(names, values, expression) for names, values in sweeps] == expected
+
+@pytest.mark.parametrize("engine", ["interpreter", "jit", "batch"])
+def test_one_solver_from_many_threads(solver_with_defaults, engine):
+    # Range evaluations run without the GIL; other threads keep switching, evicting and
+    # promoting the Solver's programs meanwhile.
+    solver = solver_with_defaults
+    solver.declare_variable("y", 0.5)
+    expressions = [f"sin(x) * {i} + x * y - cos(x + {i})" for i in range(6)]
+    xs = np.linspace(-2, 2, 5000)
+    expected = [solver.evaluate_range("x", xs, expression) for expression in expressions]
+    solver.set_engine(engine)
+    solver.set_program_cache_size(2)
+    solver.set_tiering(True, optimize_after=1, native_after=20000, background=False)
+
+    def work(worker):
+        for round in range(20):
+            i = (worker + round) % len(expressions)
+            if round % 2:
+                result = solver.evaluate_ranges(["x", "y"], [xs, [0.5]], expressions[i], threads=2)
+            else:
+                result = solver.evaluate_range("x", xs, expressions[i], threads=2)
+            assert np.array_equal(result, expected[i])
+
+    def churn():
+        for round in range(200):
+            solver.evaluate(expressions[round % len(expressions)].replace("x", "y"))
+            if round % 10 == 0:
+                solver.clear_cache()
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=7) as pool:
+        futures = [pool.submit(work, worker) for worker in range(6)] + [pool.submit(churn)]
+        for future in futures:
+            future.result()
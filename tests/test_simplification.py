@@ -0,0 +1,267 @@
+# tests/test_simplification.py
+import pytest
+import numpy as np
+from solver import SolverException
+
+@pytest.mark.parametrize("expression, simplified", [
+    ("(x + y) * 1", "x + y"),
+    ("1 * sin(x) + 0", "sin(x)"),
+    ("(x * y - 0) / (3 - 2)", "x * y"),
+    ("0 + max(x, y) * (2 - 1)", "max(x, y)"),
+])
+def test_identities_apply_to_any_operand(solver_with_defaults, expression, simplified):
+    compiled = solver_with_defaults.compile(expression)
+    assert compiled.instruction_count == solver_with_defaults.compile(simplified).instruction_count
+    solver_with_defaults.declare_variable("x", 1.5)
+    solver_with_defaults.declare_variable("y", -2.25)
+    assert solver_with_defaults.evaluate(expression) == pytest.approx(solver_with_defaults.evaluate(simplified), rel=1e-15)
+
+def test_products_with_zero_keep_errors_and_special_values(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 1.5)
+    solver_with_defaults.declare_variable("y", float("inf"))
+    for expression in ["x / 0 * 0", "0 * (x / 0)"]:
+        with pytest.raises(SolverException, match="Division by zero"):
+            solver_with_defaults.evaluate(expression)
+    assert np.isnan(solver_with_defaults.evaluate("y * 0"))
+    assert np.isnan(solver_with_defaults.evaluate("0 * (x * y)"))
+
+def test_fast_math_folds_products_with_zero(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 1.5)
+    solver_with_defaults.declare_variable("y", float("inf"))
+    solver_with_defaults.set_fast_math(True)
+    assert solver_with_defaults.compile("x + (x * y) * 0").instruction_count == 0
+    assert solver_with_defaults.evaluate("x / 0 * 0") == 0
+    assert solver_with_defaults.evaluate("y * 0") == 0
+
+def test_identities_match_exact_numbers(solver_with_defaults):
+    # Constants close to 0 or 1 are kept
+    solver_with_defaults.declare_variable("x", 1e20)
+    assert solver_with_defaults.evaluate("x * 0.000000000000001") == pytest.approx(1e5, rel=1e-12)
+    assert solver_with_defaults.compile("x * 1.000000000000001").instruction_count == 1
+    assert solver_with_defaults.compile("x * 1").instruction_count == 0
+
+@pytest.mark.parametrize("expression, instructions", [
+    ("2 + x + 3 + y", 2),
+    ("2 * x * 3", 1),
+    ("x - 1 + 4 - y", 2),
+    ("x / 2 / 4", 1),
+])
+def test_fast_math_collects_constants_of_sums_and_products(solver_with_defaults, expression, instructions):
+    solver_with_defaults.set_fast_math(True)
+    assert solver_with_defaults.compile(expression).instruction_count == instructions
+    solver_with_defaults.declare_variable("x", 1.5)
+    solver_with_defaults.declare_variable("y", -2.25)
+    expected = eval(expression, {"x": 1.5, "y": -2.25})
+    assert solver_with_defaults.evaluate(expression) == pytest.approx(expected, rel=1e-15)
+
+@pytest.mark.parametrize("expression, x, exact, fast", [
+    ("(x + 10000000000000000) - 10000000000000000", 1.0, 0.0, 1.0),
+    ("x * 4 * 0.25", 1e308, float("inf"), 1e308),
+    ("x * 2 / 2", 1e308, float("inf"), None),
+])
+def test_sums_and_products_are_only_regrouped_under_fast_math(solver_with_defaults, expression, x, exact, fast):
+    # In double, where these round or overflow
+    solver_with_defaults.declare_variable("x", x)
+    assert solver_with_defaults.evaluate(expression, precision="double") == exact
+    if fast is not None:
+        solver_with_defaults.set_fast_math(True)
+        assert solver_with_defaults.evaluate(expression, precision="double") == fast
+
+@pytest.mark.parametrize("first, second", [
+    ("x + y", "y + x"),
+    ("x * y * z", "z * (x * y)"),
+    ("x - y + z", "z - y + x"),
+])
+def test_reordered_sums_and_products_compile_alike(solver_with_defaults, first, second):
+    solver_with_defaults.declare_variable("z", 4)
+    assert solver_with_defaults.compile(first).instruction_count == solver_with_defaults.compile(second).instruction_count
+    solver_with_defaults.declare_variable("x", 1.5)
+    solver_with_defaults.declare_variable("y", -2.25)
+    assert solver_with_defaults.evaluate(first) == pytest.approx(solver_with_defaults.evaluate(second), rel=1e-15)
+
+def test_constant_zero_divisor_is_kept(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 2)
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate("x * 3 / 0")
+
+@pytest.mark.parametrize("expression, reference", [
+    ("x ^ 2", lambda x: x * x),
+    ("x ^ 1", lambda x: x),
+    ("x ^ 0", lambda x: np.ones_like(x)),
+    ("x / 8", lambda x: x / np.float32(8)),
+    ("x / 0.5", lambda x: x / np.float32(0.5)),
+])
+def test_exact_lowerings_match_float32_arithmetic(solver_with_defaults, expression, reference):
+    values = np.array([0.0, -0.0, 1e-45, -3.5, 1.1, 7e15, 3e38, np.inf, -np.inf], dtype=np.float32)
+    out = np.zeros(len(values), dtype=np.float32)
+    solver_with_defaults.evaluate_range("x", values, expression, out=out, precision="float")
+    with np.errstate(over="ignore"):
+        assert out.tobytes() == reference(values).tobytes()
+
+@pytest.mark.parametrize("expression", ["x ^ 3", "x ^ -1", "x ^ 0.5", "x / 3"])
+def test_inexact_lowerings_need_fast_math(solver_with_defaults, expression):
+    assert solver_with_defaults.compile(expression).instruction_count == 1
+
+@pytest.mark.parametrize("expression, instructions", [
+    ("x ^ 3", 2),
+    ("x ^ 8", 3),
+    ("x ^ -2", 2),
+    ("x ^ 0.5", 1),
+    ("x ^ -0.5", 2),
+    ("x / 3", 1),
+])
+def test_fast_math_expands_powers_and_reciprocals(solver_with_defaults, expression, instructions):
+    solver_with_defaults.declare_variable("x", 1.7)
+    exact = solver_with_defaults.evaluate(expression)
+    solver_with_defaults.set_fast_math(True)
+    assert solver_with_defaults.get_fast_math()
+    assert solver_with_defaults.compile(expression).instruction_count == instructions
+    assert solver_with_defaults.evaluate(expression) == pytest.approx(exact, rel=1e-15)
+
+def test_fast_math_reciprocal_of_zero_raises(solver_with_defaults):
+    solver_with_defaults.declare_variable("x", 0)
+    assert solver_with_defaults.evaluate("x ^ -1") == float("inf")
+    solver_with_defaults.set_fast_math(True)
+    with pytest.raises(SolverException):
+        solver_with_defaults.evaluate("x ^ -1")
+
+def test_fast_math_evaluates_polynomials_in_horner_form(solver_with_defaults):
+    expression = "a*x^4 + b*x^3 + c*x^2 + d*x + f"
+    for name, value in zip("abcdf", [1.3, -0.7, 2.1, 0.4, -1.9]):
+        solver_with_defaults.declare_variable(name, value)
+    solver_with_defaults.set_fast_math(True)
+    # Four multiplications and four additions
+    assert solver_with_defaults.compile(expression).instruction_count == 8
+    values = np.linspace(-2, 2, 41)
+    out = solver_with_defaults.evaluate_range("x", values, expression)
+    assert out == pytest.approx(np.polyval([1.3, -0.7, 2.1, 0.4, -1.9], values), rel=1e-12, abs=1e-12)
+
+@pytest.mark.parametrize("expression, coefficients", [
+    ("3*x^4 - 2*x^3 + x^2 - 5*x + 7", [3, -2, 1, -5, 7]),
+    ("x^6 - x^2", [1, 0, 0, 0, -1, 0, 0]),
+    ("x^9 + 2*x^8 - x^7 + 3*x^6 + x^5 - x^4 + 2*x^3 + x^2 - x + 1", [1, 2, -1, 3, 1, -1, 2, 1, -1, 1]),
+    ("x^11 - 4*x^8 + x", [1, 0, 0, -4, 0, 0, 0, 0, 0, 0, 1, 0]),
+])
+def test_fast_math_polynomials_keep_their_value(solver_with_defaults, expression, coefficients):
+    solver_with_defaults.set_fast_math(True)
+    values = np.linspace(-1.5, 1.5, 31)
+    out = solver_with_defaults.evaluate_range("x", values, expression)
+    assert out == pytest.approx(np.polyval(coefficients, values), rel=1e-12, abs=1e-12)
+
+def test_fast_math_factors_multivariate_polynomials(solver_with_defaults):
+    expression = "x^2*y + x*y^2 + x*y + 1"
+    solver_with_defaults.declare_variable("x", 0.83)
+    solver_with_defaults.declare_variable("y", 1.7)
+    exact = solver_with_defaults.evaluate(expression)
+    instructions = solver_with_defaults.compile(expression).instruction_count
+    solver_with_defaults.set_fast_math(True)
+    # (y*x + (y + 1)*y)*x + 1
+    assert solver_with_defaults.compile(expression).instruction_count < instructions
+    assert solver_with_defaults.evaluate(expression) == pytest.approx(exact, rel=1e-15)
+
+def test_multiply_adds_are_contracted_on_request(solver_with_defaults):
+    expression = "a*b + c*d - g"
+    for name, value in zip("abcdg", [1.1, 2.3, 3.7, 4.1, 0.3]):
+        solver_with_defaults.declare_variable(name, value)
+    compiled = solver_with_defaults.compile(expression)
+    assert (compiled.instruction_count, compiled.fma_count) == (4, 0)
+    solver_with_defaults.set_fused_multiply_add(True)
+    assert solver_with_defaults.get_fused_multiply_add()
+    # fma(a, b, c*d) - g
+    compiled = solver_with_defaults.compile(expression)
+    assert (compiled.instruction_count, compiled.fma_count) == (3, 1)
+    assert solver_with_defaults.evaluate(expression) == pytest.approx(1.1 * 2.3 + 3.7 * 4.1 - 0.3, rel=1e-15)
+
+def test_contraction_does_not_regroup_sums(solver_with_defaults):
+    for name, value in {"x": 1e308, "y": 1e308, "z": -1e308, "w": -1e308, "a": 0.0, "b": 0.0}.items():
+        solver_with_defaults.declare_variable(name, value)
+    expression = "x + y + z + w + a*b"
+    # x + y overflows to inf, which the other terms do not cancel
+    assert solver_with_defaults.evaluate(expression, precision="double") == np.inf
+    solver_with_defaults.set_fused_multiply_add(True)
+    assert solver_with_defaults.compile(expression).fma_count == 1
+    assert solver_with_defaults.evaluate(expression, precision="double") == np.inf
+
+def test_shared_products_are_not_contracted(solver_with_defaults):
+    solver_with_defaults.set_fused_multiply_add(True)
+    compiled = solver_with_defaults.compile("x*y + sin(x*y)")
+    assert (compiled.instruction_count, compiled.fma_count) == (3, 0)
+
+@pytest.mark.parametrize("engine", ["interpreter", "jit", "c", "batch"])
+def test_contracted_multiply_adds_round_once(solver_with_defaults, engine):
+    solver_with_defaults.set_fused_multiply_add(True)
+    solver_with_defaults.set_engine(engine)
+    values = np.linspace(0.5, 2, 1001, dtype=np.float32)
+    out = np.zeros(len(values), dtype=np.float32)
+    solver_with_defaults.evaluate_range("x", values, "x*x - 1", out=out, precision="float")
+    # x*x - 1 is exact in double for these values, so rounding it once gives the fma result
+    wide = values.astype(np.float64)
+    assert out.tobytes() == (wide * wide - 1).astype(np.float32).tobytes()
+
+@pytest.mark.parametrize("engine", ["interpreter", "jit", "c", "batch", "ast"])
+def test_fma_function(solver_with_defaults, engine):
+    for name, value in zip("xyz", [0.1, 10, -1]):
+        solver_with_defaults.declare_variable(name, value)
+    if engine == "ast":
+        result = solver_with_defaults.evaluate_ast("fma(x, y, z)")
+    else:
+        solver_with_defaults.set_engine(engine)
+        assert solver_with_defaults.compile("fma(x, y, z)").fma_count == 1
+        result = solver_with_defaults.evaluate("fma(x, y, z)")
+    # 0.1 * 10 - 1 is 0 when the product is rounded to double first
+    assert result == 5.551115123125783e-17
+
+@pytest.mark.parametrize("expression, before, after, fast_math", [
+    ("a*x*a*x + a*x", 4, 3, False), # (a*x)*(a*x) + a*x
+    ("a*(x + y) + b*(x + y)", 4, 3, True),  # (a + b)*(x + y)
+    ("a*x*x + b*x*x + c*x*x", 6, 4, True),
+    ("exp(a)*exp(b)", 3, 2, True),  # exp(a + b)
+    ("x^0.5 * x^1.5", 3, 1, True),  # x^2
+])
+def test_equality_saturation_finds_cheaper_forms(solver_with_defaults, expression, before, after, fast_math):
+    for name, value in zip("abcxy", [0.3, 0.5, 0.7, 1.1, 1.3]):
+        solver_with_defaults.declare_variable(name, value)
+    exact = solver_with_defaults.evaluate(expression)
+    solver_with_defaults.set_fast_math(fast_math)
+    assert not solver_with_defaults.get_equality_saturation()
+    assert solver_with_defaults.compile(expression).instruction_count == before
+    solver_with_defaults.set_equality_saturation(True)
+    assert solver_with_defaults.get_equality_saturation()
+    assert solver_with_defaults.compile(expression).instruction_count == after
+    assert solver_with_defaults.evaluate(expression) == pytest.approx(exact, rel=1e-14)
+
+@pytest.mark.parametrize("expression, values", [
+    ("x - x", {"x": np.inf}),
+    ("x * 0", {"x": np.inf}),
+    ("a*x + a*y", {"a": np.inf, "x": 0.0, "y": 1.0}),
+    ("x ^ 0.5", {"x": -0.0}),
+    ("x ^ 0.5", {"x": -np.inf}),
+    ("sqrt(x)", {"x": -0.0}),
+    ("x / y / z", {"x": 1.0, "y": 1e-200, "z": 1e-200}),
+    ("ln(x) + ln(y)", {"x": 1e200, "y": 1e200}),
+    ("ln(x) + ln(y)", {"x": -2.0, "y": -2.0}),
+    ("ln(x) - ln(y)", {"x": 1e200, "y": 1e-200}),
+    ("y * ln(x)", {"x": -2.0, "y": 2.0}),
+    ("exp(x) * exp(y)", {"x": 800.0, "y": -800.0}),
+])
+def test_equality_saturation_keeps_edge_values(solver_with_defaults, expression, values):
+    # Without fast math, the identities only change rounding; these inputs are exact in double
+    def outcome():
+        try:
+            return np.float64(solver_with_defaults.evaluate(expression, precision="double")).tobytes()
+        except SolverException as e:
+            return str(e)
+    for name, value in values.items():
+        solver_with_defaults.declare_variable(name, value)
+    expected = outcome()
+    solver_with_defaults.set_equality_saturation(True)
+    assert outcome() == expected
+
+def test_equality_saturation_limits(solver_with_defaults):
+    expression = "(x + 1)*(x + 1) - (x + 1)"
+    solver_with_defaults.declare_variable("x", 1.1)
+    for limits in [dict(node_limit=10), dict(iteration_limit=1), dict(time_limit=0)]:
+        solver_with_defaults.set_equality_saturation(True, **limits)
+        assert solver_with_defaults.evaluate(expression) == pytest.approx(2.1 * 2.1 - 2.1, rel=1e-15)
+    solver_with_defaults.set_equality_saturation(False)
+    assert not solver_with_defaults.get_equality_saturation()
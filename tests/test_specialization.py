@@ -0,0 +1,94 @@
+# tests/test_specialization.py
+import pytest
+import math
+from solver import SolverException
+
+EXPRESSION = "a*x^2 + b*sin(x)*exp(c) + c*sqrt(a) + y"
+
+@pytest.fixture
+def parameters(solver_with_defaults):
+    for name, value in {"a": 2.0, "b": 0.0, "c": 3.0, "x": 1.5, "y": -1.0}.items():
+        solver_with_defaults.declare_variable(name, value)
+    return solver_with_defaults
+
+def test_specialized_matches_evaluate(parameters):
+    specialized = parameters.specialize(EXPRESSION, ["a", "b", "c"])
+    assert specialized.expression == EXPRESSION
+    assert specialized.fixed == ["a", "b", "c"]
+    assert sorted(specialized.variables) == ["x", "y"]
+    values = {"x": 1.5, "y": -1.0}
+    expected = parameters.evaluate(EXPRESSION)
+    assert specialized.evaluate([values[name] for name in specialized.variables]) == pytest.approx(expected, rel=1e-15)
+    assert specialized.evaluate(values) == pytest.approx(expected, rel=1e-15)
+
+def test_fixed_variables_are_folded(parameters):
+    parameters.set_fast_math(True)
+    specialized = parameters.specialize(EXPRESSION, ["a", "b", "c"])
+    # b = 0 drops the sin term (under fast math) and c*sqrt(a) is folded: 2*x*x + 5.24... + y
+    assert specialized.residual.instruction_count == 4
+    assert specialized.residual.instruction_count < parameters.compile(EXPRESSION).instruction_count
+    assert sorted(specialized.residual.variables) == ["x", "y"]
+
+def test_residual_reads_a_subset_of_the_inputs(parameters):
+    # a = 0 only drops a*x under fast math, since 0*x is NaN for infinite x
+    parameters.set_fast_math(True)
+    specialized = parameters.specialize("a*x + y", ["a"])
+    parameters.declare_variable("a", 0)
+    assert specialized.residual.variables == ["y"]
+    assert specialized.evaluate({"x": 5, "y": 2}) == 2
+    assert specialized.evaluate([5 if name == "x" else 2 for name in specialized.variables]) == 2
+
+def test_residual_is_rebuilt_when_a_fixed_variable_changes(parameters):
+    specialized = parameters.specialize(EXPRESSION, ["a", "b", "c"])
+    values = {"x": 0.7, "y": 2.0}
+    specialized.evaluate(values)
+    parameters.declare_variable("b", 1.0)
+    # Other variables and unchanged values keep the residual
+    parameters.declare_variable("c", 3.0)
+    parameters.declare_variable("x", 0.7)
+    parameters.declare_variable("y", 2.0)
+    assert specialized.evaluate(values) == pytest.approx(parameters.evaluate(EXPRESSION), rel=1e-15)
+    assert specialized.rebuild_count == 1
+    specialized.evaluate(values)
+    assert specialized.rebuild_count == 1
+
+def test_specialize_requires_declared_variables(parameters):
+    with pytest.raises(SolverException):
+        parameters.specialize(EXPRESSION, ["pi"])
+    with pytest.raises(SolverException):
+        parameters.specialize(EXPRESSION, ["undeclared"])
+    specialized = parameters.specialize("a * x", ["a"])
+    with pytest.raises(SolverException):
+        specialized.evaluate([1.0, 2.0])
+
+@pytest.mark.parametrize("engine", ["interpreter", "jit", "c", "batch"])
+def test_specialized_engines(parameters, engine):
+    specialized = parameters.specialize("f(a) * x + sin(c)", ["a", "c"], engine=engine)
+    assert specialized.engine == engine
+    assert specialized.residual.engine == engine
+    assert specialized.evaluate([0.5]) == pytest.approx(9 * 0.5 + math.sin(3), rel=1e-15)
+
+def test_negative_zero_is_a_different_value(parameters):
+    parameters.declare_variable("a", 0.0)
+    specialized = parameters.specialize("a * x", ["a"])
+    assert math.copysign(1, specialized.evaluate([1.0])) == 1
+    parameters.declare_variable("a", -0.0)
+    assert math.copysign(1, specialized.evaluate([1.0])) == -1
+    assert specialized.rebuild_count == 1
+
+def test_nothing_fixed(parameters):
+    specialized = parameters.specialize("x * y", [])
+    for x in [1.0, 2.0, 3.0]:
+        assert specialized.evaluate({"x": x, "y": -1.0}) == -x
+    assert specialized.rebuild_count == 0
+
+def test_failed_rebuild_is_retried(parameters):
+    specialized = parameters.specialize("x + a + 1/a", ["a"])
+    assert specialized.evaluate([1.0]) == 3.5
+    parameters.declare_variable("a", 0.0)
+    for _ in range(2):
+        with pytest.raises(SolverException, match="Division by zero"):
+            specialized.evaluate([1.0])
+    parameters.declare_variable("a", 4.0)
+    assert specialized.evaluate([1.0]) == 5.25
+    assert specialized.rebuild_count == 1
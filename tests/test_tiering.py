@@ -0,0 +1,133 @@
+# tests/test_tiering.py
+import gc
+import pytest
+import time
+import numpy as np
+from solver import Solver, SolverException
+
+EXPRESSION = "x*x*x + 0*y + (x + 1)*(x + 1) + sin(x)*2"
+
+@pytest.fixture
+def tiered(solver_with_defaults):
+    solver_with_defaults.use_cache(False)
+    solver_with_defaults.declare_variable("x", 1.5)
+    solver_with_defaults.declare_variable("y", 2.0)
+    solver_with_defaults.set_tiering(True, optimize_after=3, native_after=6, background=False)
+    return solver_with_defaults
+
+def test_tiering_is_off_by_default(solver_with_defaults):
+    solver_with_defaults.use_cache(False)
+    solver_with_defaults.declare_variable("x", 1.0)
+    assert not solver_with_defaults.get_tiering()
+    for _ in range(3):
+        solver_with_defaults.evaluate("x + 1")
+    assert solver_with_defaults.get_tier_info("x + 1") == {
+        "tier": "optimized", "executions": 3, "promoting": False, "pinned": False}
+
+def test_expressions_are_promoted_as_they_run(tiered):
+    expected = 1.5 ** 3 + 2.5 ** 2 + np.sin(1.5) * 2
+    assert tiered.get_tier_info(EXPRESSION)["tier"] == "baseline"
+    tiers = []
+    for _ in range(7):
+        assert tiered.evaluate(EXPRESSION) == pytest.approx(expected, rel=1e-15)
+        tiers.append(tiered.get_tier_info(EXPRESSION)["tier"])
+    assert tiers == ["baseline"] * 2 + ["optimized"] * 3 + ["native"] * 2
+    assert tiered.get_tier_info(EXPRESSION)["executions"] == 7
+
+def test_range_evaluations_count_every_point(tiered):
+    values = np.linspace(0, 1, 10)
+    out = tiered.evaluate_range("x", values, EXPRESSION)
+    assert tiered.get_tier_info(EXPRESSION) == {
+        "tier": "native", "executions": 10, "promoting": False, "pinned": False}
+    assert out == pytest.approx(values ** 3 + (values + 1) ** 2 + np.sin(values) * 2, rel=1e-15)
+
+def test_background_promotion_keeps_serving(tiered):
+    tiered.set_tiering(True, optimize_after=1, native_after=2, background=True)
+    expected = tiered.evaluate(EXPRESSION)
+    deadline = time.monotonic() + 30
+    while tiered.get_tier_info(EXPRESSION)["tier"] != "native" and time.monotonic() < deadline:
+        assert tiered.evaluate(EXPRESSION) == pytest.approx(expected, rel=1e-15)
+        time.sleep(0.01)
+    assert tiered.get_tier_info(EXPRESSION)["tier"] == "native"
+    assert tiered.evaluate(EXPRESSION) == pytest.approx(expected, rel=1e-15)
+
+def test_compile_is_always_optimized(tiered):
+    tiered.evaluate(EXPRESSION)
+    assert tiered.get_tier_info(EXPRESSION)["tier"] == "baseline"
+    instructions = tiered.compile(EXPRESSION).instruction_count
+    tiered.set_tiering(False)
+    assert tiered.compile(EXPRESSION).instruction_count == instructions
+
+def test_pinned_tiers(tiered):
+    tiered.pin_tier(EXPRESSION, "baseline")
+    for _ in range(10):
+        tiered.evaluate(EXPRESSION)
+    assert tiered.get_tier_info(EXPRESSION) == {
+        "tier": "baseline", "executions": 10, "promoting": False, "pinned": True}
+
+    # Pinning holds without tiering too
+    tiered.set_tiering(False)
+    tiered.pin_tier(EXPRESSION, "native")
+    tiered.evaluate(EXPRESSION)
+    assert tiered.get_tier_info(EXPRESSION)["tier"] == "native"
+
+    tiered.pin_tier(EXPRESSION, None)
+    assert tiered.get_tier_info(EXPRESSION) == {
+        "tier": "optimized", "executions": 0, "promoting": False, "pinned": False}
+    with pytest.raises(SolverException):
+        tiered.pin_tier(EXPRESSION, "fastest")
+
+def test_cached_results_count_as_runs(tiered):
+    tiered.use_cache(True)
+    for _ in range(7):
+        tiered.evaluate(EXPRESSION)
+    assert tiered.get_tier_info(EXPRESSION) == {
+        "tier": "native", "executions": 7, "promoting": False, "pinned": False}
+
+def test_dropped_promotions_are_not_waited_for(tiered):
+    tiered.set_tiering(True, optimize_after=1, native_after=2, native_engine="c", background=True)
+    tiered.set_program_cache_size(1)
+    expected = tiered.evaluate(EXPRESSION)
+    tiered.evaluate(EXPRESSION)
+    assert tiered.get_tier_info(EXPRESSION)["promoting"]
+    tiered.evaluate("x + y")  # evicts the promoting entry
+    tiered.evaluate(EXPRESSION)
+    tiered.clear_cache()
+    assert tiered.get_tier_info(EXPRESSION) == {
+        "tier": "baseline", "executions": 0, "promoting": False, "pinned": False}
+    assert tiered.evaluate(EXPRESSION) == pytest.approx(expected, rel=1e-15)
+
+def test_selected_engine_is_kept(tiered, cache_dir):
+    tiered.set_engine("c")
+    expected = tiered.evaluate(EXPRESSION, engine="interpreter")
+    assert tiered.evaluate(EXPRESSION) == expected
+    assert tiered.get_tier_info(EXPRESSION)["tier"] == "baseline"
+    assert list(cache_dir.glob("*.so"))
+
+def test_background_promotions_are_queued(tiered):
+    tiered.set_tiering(True, optimize_after=1, native_after=2, background=True)
+    expressions = [f"{EXPRESSION} + {i}" for i in range(20)]
+    for expression in expressions:
+        tiered.evaluate(expression)
+        tiered.evaluate(expression)
+    deadline = time.monotonic() + 30
+    pending = expressions
+    while pending and time.monotonic() < deadline:
+        for expression in pending:
+            tiered.evaluate(expression)
+        pending = [e for e in pending if tiered.get_tier_info(e)["tier"] != "native"]
+        time.sleep(0.01)
+    assert not pending
+
+def test_solver_is_deleted_during_a_promotion():
+    solver = Solver()
+    solver.declare_variable("x", 1.5)
+    solver.declare_variable("y", 2.0)
+    solver.set_tiering(True, optimize_after=1, native_after=2, native_engine="c", background=True)
+    for i in range(5):
+        solver.evaluate(f"{EXPRESSION} + {i}")
+        solver.evaluate(f"{EXPRESSION} + {i}")
+    assert solver.get_tier_info(f"{EXPRESSION} + 4")["promoting"]
+    # Waits for the promotion being built and drops the others
+    del solver
+    gc.collect()